@@ -0,0 +1,114 @@
+package main
+
+import (
+	"fmt"
+	"runtime"
+	"time"
+	"unsafe"
+
+	"github.com/goccy/go-jit"
+)
+
+// Accumulates statistics into the fields of a struct, the way code that
+// works on a struct through a pointer is emitted, with the loop tested at
+// the bottom as compilers lay it out.  With optimization the second load
+// of s.sum is replaced by the value stored just before, and that first
+// store is removed because s.sum is stored again before anything can read
+// it.  The loads at the top of the loop no longer read back what the
+// previous iteration stored: the fields are loaded once before the loop,
+// and their new values are carried into the next iteration in registers,
+// so the stores are no longer on the path from one iteration to the next.
+//
+// type stats struct {
+//   sum   int64
+//   sumSq int64
+// }
+//
+// func f(s *stats, n int64) {
+//   i := 0
+//   if i < n {
+//     for {
+//       s.sum += i
+//       s.sumSq += i * i
+//       s.sum += 1
+//       i++
+//       if i >= n {
+//         break
+//       }
+//     }
+//   }
+// }
+
+type stats struct {
+	sum   int64
+	sumSq int64
+}
+
+const (
+	count      = 4096
+	iterations = 20000
+)
+
+func build(ctx *jit.Context, level uint) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(level)
+	b := f.Builder()
+	s := b.Param(0)
+	n := b.Param(1)
+	sumOffset := int(unsafe.Offsetof(stats{}.sum))
+	sumSqOffset := int(unsafe.Offsetof(stats{}.sumSq))
+	i := b.CreateValue(jit.TypeInt)
+	b.Store(i, b.CreateIntValue(0))
+	top := b.NewLabel()
+	done := b.NewLabel()
+	b.BranchIfNot(b.Lt(i, n), done)
+	b.Label(top)
+	b.StoreRelative(s, sumOffset, b.Add(b.LoadRelative(s, sumOffset, jit.TypeInt), i))
+	b.StoreRelative(s, sumSqOffset, b.Add(b.LoadRelative(s, sumSqOffset, jit.TypeInt), b.Mul(i, i)))
+	b.StoreRelative(s, sumOffset, b.Add(b.LoadRelative(s, sumOffset, jit.TypeInt), b.CreateIntValue(1)))
+	b.Store(i, b.Add(i, b.CreateIntValue(1)))
+	b.BranchIf(b.Lt(i, n), top)
+	b.Label(done)
+	b.Return(b.CreateIntValue(0))
+	f.Compile()
+	return f
+}
+
+func want(n int64) stats {
+	var s stats
+	for i := int64(0); i < n; i++ {
+		s.sum += i
+		s.sumSq += i * i
+		s.sum += 1
+	}
+	return s
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	s := &stats{}
+	ptr := int64(uintptr(unsafe.Pointer(s)))
+
+	for _, level := range []uint{0, 1} {
+		call := jit.AsInt64x2(build(ctx, level))
+		for _, n := range []int64{0, 1, 100, count} {
+			*s = stats{}
+			call(ptr, n)
+			if *s != want(n) {
+				panic(fmt.Sprintf("level %d: f(s, %d) = %+v, want %+v", level, n, *s, want(n)))
+			}
+		}
+		// The fields are not loaded before a loop that does not run
+		call(0, 0)
+		start := time.Now()
+		for k := 0; k < iterations; k++ {
+			call(ptr, count)
+		}
+		elapsed := time.Since(start)
+		fmt.Printf("level %d: %v for %d iterations (%.2f ns/iteration)\n",
+			level, elapsed, count*iterations, float64(elapsed.Nanoseconds())/(count*iterations))
+	}
+	runtime.KeepAlive(s)
+}
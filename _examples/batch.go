@@ -0,0 +1,34 @@
+package main
+
+import (
+	"fmt"
+
+	"github.com/goccy/go-jit"
+)
+
+// func f(x, y int) int {
+//   return x * y + x
+// }
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	f, err := ctx.Build(func(ctx *jit.Context) (*jit.Function, error) {
+		f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+		x := f.Param(0)
+		y := f.Param(1)
+		f.Return(f.Add(f.Mul(x, y), x))
+		f.Compile()
+		return f, nil
+	})
+	if err != nil {
+		panic(err)
+	}
+	xs := []int{1, 2, 3, 4}
+	ys := []int{5, 6, 7, 8}
+	result := make([]int, len(xs))
+	if err := f.RunBatch(result, xs, ys); err != nil {
+		panic(err)
+	}
+	fmt.Println("result = ", result)
+}
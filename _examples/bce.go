@@ -0,0 +1,114 @@
+package main
+
+import (
+	"fmt"
+	"runtime"
+	"time"
+	"unsafe"
+
+	"github.com/goccy/go-jit"
+)
+
+// Sums a slice the way a compiler for a safe language would emit it:
+// every iteration checks the slice header for nil and the index against
+// both ends of the slice before it loads the element.  With optimization
+// the loop condition already tells that the index is below the length,
+// and the index starts at zero and only goes up while it is below the
+// length, so both bounds checks are removed.  The null check inside the
+// loop is dominated by the one before it and is removed too.
+//
+// type slice struct {
+//   data *int64
+//   len  int64
+// }
+//
+// func f(s *slice) int64 {
+//   sum := 0
+//   for i := 0; i < s.len; i++ {
+//     if i < 0 || i >= s.len {
+//       return -1
+//     }
+//     sum += s.data[i]
+//   }
+//   return sum
+// }
+
+type slice struct {
+	data *int64
+	len  int64
+}
+
+const (
+	elems      = 4096
+	iterations = 20000
+)
+
+func build(ctx *jit.Context, level uint) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(level)
+	b := f.Builder()
+	s := b.Param(0)
+	sum := b.CreateValue(jit.TypeInt)
+	i := b.CreateValue(jit.TypeInt)
+	b.Store(sum, b.CreateIntValue(0))
+	b.Store(i, b.CreateIntValue(0))
+	b.CheckNull(s)
+	n := b.LoadRelative(s, int(unsafe.Offsetof(slice{}.len)), jit.TypeInt)
+	top := b.NewLabel()
+	done := b.NewLabel()
+	fail := b.NewLabel()
+	b.Label(top)
+	b.BranchIfNot(b.Lt(i, n), done)
+	b.CheckNull(s)
+	b.BranchIf(b.Lt(i, b.CreateIntValue(0)), fail)
+	b.BranchIf(b.Ge(i, n), fail)
+	data := b.LoadRelative(s, int(unsafe.Offsetof(slice{}.data)), jit.TypeVoidPtr)
+	b.Store(sum, b.Add(sum, b.LoadElem(data, i, jit.TypeInt)))
+	b.Store(i, b.Add(i, b.CreateIntValue(1)))
+	b.Branch(top)
+	b.Label(fail)
+	b.Return(b.CreateIntValue(-1))
+	b.Label(done)
+	b.Return(sum)
+	f.Compile()
+	return f
+}
+
+func want(data []int64, n int64) int64 {
+	sum := int64(0)
+	for i := int64(0); i < n; i++ {
+		sum += data[i]
+	}
+	return sum
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	data := make([]int64, elems)
+	for i := range data {
+		data[i] = int64(i%89) - 40
+	}
+	s := &slice{data: &data[0]}
+	ptr := int64(uintptr(unsafe.Pointer(s)))
+
+	for _, level := range []uint{0, 1} {
+		call := jit.AsInt64x1(build(ctx, level))
+		for _, n := range []int64{0, 1, 100, elems} {
+			s.len = n
+			if got := call(ptr); got != want(data, n) {
+				panic(fmt.Sprintf("level %d: f(s) = %d with len %d, want %d", level, got, n, want(data, n)))
+			}
+		}
+		start := time.Now()
+		for k := 0; k < iterations; k++ {
+			call(ptr)
+		}
+		elapsed := time.Since(start)
+		fmt.Printf("level %d: %v for %d elements (%.2f ns/element)\n",
+			level, elapsed, elems*iterations, float64(elapsed.Nanoseconds())/(elems*iterations))
+	}
+	runtime.KeepAlive(s)
+	runtime.KeepAlive(data)
+}
@@ -0,0 +1,92 @@
+package main
+
+import (
+	"fmt"
+	"testing"
+
+	"github.com/goccy/go-jit"
+)
+
+// Builds the same function with the *Value API and with Builder handles,
+// and compares how fast each one emits instructions.
+//
+// func sq(x int64) int64 {
+//   return x * x
+// }
+//
+// func f(x, y int64) int64 {
+//   for i := 0; i < chain; i++ {
+//     x = x * y + x
+//   }
+//   return sq(x)
+// }
+
+const chain = 32
+
+// insns is the number of instructions emitted for f.
+const insns = chain*2 + 2
+
+func buildValues(ctx *jit.Context, sq *jit.Function) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	x := f.Param(0)
+	y := f.Param(1)
+	for i := 0; i < chain; i++ {
+		x = f.Add(f.Mul(x, y), x)
+	}
+	f.Return(f.Call("sq", sq, []*jit.Value{x}))
+	return f
+}
+
+func buildIDs(ctx *jit.Context, sq *jit.Function) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	y := b.Param(1)
+	for i := 0; i < chain; i++ {
+		x = b.Add(b.Mul(x, y), x)
+	}
+	b.Return(b.Call("sq", sq, x))
+	return f
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	ctx.BuildStart()
+	defer ctx.BuildEnd()
+
+	sq := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	b := sq.Builder()
+	b.Return(b.Mul(b.Param(0), b.Param(0)))
+	sq.Compile()
+
+	for _, build := range []func(*jit.Context, *jit.Function) *jit.Function{buildValues, buildIDs} {
+		f := build(ctx, sq)
+		f.Compile()
+		fmt.Println("f(3, 0) = ", jit.AsInt64x2(f)(3, 0))
+	}
+
+	// Builder only allocates once per function (signature and wrappers),
+	// not per instruction.
+	fmt.Println("insns/function = ", insns)
+	fmt.Println("allocs/function (Value)   = ", testing.AllocsPerRun(100, func() {
+		buildValues(ctx, sq).Abandon()
+	}))
+	fmt.Println("allocs/function (Builder) = ", testing.AllocsPerRun(100, func() {
+		buildIDs(ctx, sq).Abandon()
+	}))
+
+	for _, bench := range []struct {
+		name  string
+		build func(*jit.Context, *jit.Function) *jit.Function
+	}{{"Value:  ", buildValues}, {"Builder:", buildIDs}} {
+		r := testing.Benchmark(func(tb *testing.B) {
+			tb.ReportAllocs()
+			for i := 0; i < tb.N; i++ {
+				bench.build(ctx, sq).Abandon()
+			}
+		})
+		rate := float64(r.N*insns) / r.T.Seconds()
+		fmt.Printf("%s %.0f insns/sec %s\n", bench.name, rate, r.MemString())
+	}
+}
@@ -0,0 +1,123 @@
+package main
+
+import (
+	"fmt"
+	"runtime"
+	"time"
+	"unsafe"
+
+	"github.com/goccy/go-jit"
+)
+
+// Sums the elements of a slice that an index slice selects, throwing if
+// an index is out of range, the way a compiler for a safe language emits
+// a bounds check: the failure path comes right after the check.  With
+// optimization the block that throws moves to the end of the function,
+// the check branches to it only when it fails, and the loop header is
+// aligned.  The null check branches to code after the epilog instead of
+// calling out inline.
+//
+// type slice struct {
+//   data *int64
+//   len  int64
+// }
+//
+// func f(s *slice, idx *int64, n int64) int64 {
+//   sum := 0
+//   for k := 0; k < n; k++ {
+//     i := idx[k]
+//     if i >= s.len {
+//       throw
+//     }
+//     sum += s.data[i]
+//   }
+//   return sum
+// }
+
+type slice struct {
+	data *int64
+	len  int64
+}
+
+const (
+	elems      = 4096
+	iterations = 20000
+)
+
+func build(ctx *jit.Context, level uint) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(level)
+	b := f.Builder()
+	s := b.Param(0)
+	idx := b.Param(1)
+	n := b.Param(2)
+	sum := b.CreateValue(jit.TypeInt)
+	k := b.CreateValue(jit.TypeInt)
+	b.Store(sum, b.CreateIntValue(0))
+	b.Store(k, b.CreateIntValue(0))
+	top := b.NewLabel()
+	done := b.NewLabel()
+	b.Label(top)
+	b.BranchIfNot(b.Lt(k, n), done)
+	i := b.LoadElem(idx, k, jit.TypeInt)
+	b.CheckNull(s)
+	length := b.LoadRelative(s, int(unsafe.Offsetof(slice{}.len)), jit.TypeInt)
+	ok := b.NewLabel()
+	b.BranchIf(b.Lt(i, length), ok)
+	b.Throw(b.CreateNintConstant(jit.TypeVoidPtr, 1))
+	b.Label(ok)
+	data := b.LoadRelative(s, int(unsafe.Offsetof(slice{}.data)), jit.TypeVoidPtr)
+	elem := b.LoadElem(data, i, jit.TypeInt)
+	b.Store(sum, b.Add(sum, elem))
+	b.Store(k, b.Add(k, b.CreateIntValue(1)))
+	b.Branch(top)
+	b.Label(done)
+	b.Return(sum)
+	f.Compile()
+	return f
+}
+
+func want(data, idx []int64) int64 {
+	sum := int64(0)
+	for _, i := range idx {
+		sum += data[i]
+	}
+	return sum
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	data := make([]int64, elems)
+	idx := make([]int64, elems)
+	for i := range data {
+		data[i] = int64(i%89) - 40
+		idx[i] = int64(i*7) % elems
+	}
+	s := &slice{data: &data[0], len: elems}
+	ptr := int64(uintptr(unsafe.Pointer(s)))
+	idxPtr := int64(uintptr(unsafe.Pointer(&idx[0])))
+
+	for _, level := range []uint{0, 1} {
+		call := jit.AsInt64x3(build(ctx, level))
+		if got := call(ptr, idxPtr, elems); got != want(data, idx) {
+			panic(fmt.Sprintf("level %d: f(s, idx, n) = %d, want %d", level, got, want(data, idx)))
+		}
+		s.len = elems / 2
+		if got := call(ptr, idxPtr, elems); got != 0 {
+			panic(fmt.Sprintf("level %d: f(s, idx, n) = %d with an index out of range, want 0", level, got))
+		}
+		s.len = elems
+		start := time.Now()
+		for j := 0; j < iterations; j++ {
+			call(ptr, idxPtr, elems)
+		}
+		elapsed := time.Since(start)
+		fmt.Printf("level %d: %v for %d elements (%.2f ns/element)\n",
+			level, elapsed, elems*iterations, float64(elapsed.Nanoseconds())/(elems*iterations))
+	}
+	runtime.KeepAlive(s)
+	runtime.KeepAlive(data)
+	runtime.KeepAlive(idx)
+}
@@ -0,0 +1,110 @@
+package main
+
+import (
+	"fmt"
+	"runtime"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Builds many functions up front and compiles them on background threads,
+// calling some of them before their compilation has finished.
+//
+// func f_k(x int64) int64 {
+//   return x * k + k
+// }
+
+const functions = 2000
+
+func build(ctx *jit.Context, k int) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(jit.MaxOptimizationLevel())
+	b := f.Builder()
+	x := b.Param(0)
+	c := b.CreateIntValue(k)
+	for i := 0; i < 16; i++ {
+		x = b.Add(b.Mul(x, c), c)
+		x = b.Sub(x, c)
+		x = b.Div(x, c)
+	}
+	b.Return(b.Add(b.Mul(x, c), c))
+	return f
+}
+
+func buildAll(ctx *jit.Context) []*jit.Function {
+	fns := make([]*jit.Function, functions)
+	for k := 1; k <= functions; k++ {
+		fns[k-1] = build(ctx, k)
+	}
+	return fns
+}
+
+func check(fns []*jit.Function) {
+	for k := 1; k <= functions; k++ {
+		if got := jit.AsInt64x1(fns[k-1])(3); got != int64(3*k+k) {
+			panic(fmt.Sprintf("f_%d(3) = %d, want %d", k, got, 3*k+k))
+		}
+	}
+}
+
+func compileSync() time.Duration {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	fns := buildAll(ctx)
+
+	start := time.Now()
+	for _, f := range fns {
+		f.Compile()
+	}
+	elapsed := time.Since(start)
+	check(fns)
+	return elapsed
+}
+
+func compileAsync() (queued, done time.Duration, canceled bool) {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	fns := buildAll(ctx)
+
+	start := time.Now()
+	futures := make([]*jit.CompileFuture, functions)
+	for k, f := range fns {
+		// The last function is wanted first.
+		futures[k] = ctx.CompileAsyncPriority(f, k)
+	}
+	queued = time.Since(start)
+
+	// Calling a function that is still queued compiles it right away.
+	if got := jit.AsInt64x1(fns[0])(3); got != 4 {
+		panic(fmt.Sprintf("f_1(3) = %d, want 4", got))
+	}
+
+	extra := build(ctx, functions+1)
+	future := ctx.CompileAsync(extra)
+	canceled = future.Cancel()
+	if canceled {
+		if future.Wait() != jit.ErrCompileCanceled || extra.IsCompiled() {
+			panic("canceled function was compiled")
+		}
+	} else if err := future.Wait(); err != nil {
+		panic(err)
+	}
+
+	for _, future := range futures {
+		if err := future.Wait(); err != nil {
+			panic(err)
+		}
+	}
+	done = time.Since(start)
+	check(fns)
+	return queued, done, canceled
+}
+
+func main() {
+	fmt.Println("GOMAXPROCS =", runtime.GOMAXPROCS(0))
+	fmt.Printf("Compile:      %v for %d functions\n", compileSync().Round(time.Millisecond), functions)
+	queued, done, canceled := compileAsync()
+	fmt.Printf("CompileAsync: %v to queue, %v until done\n", queued.Round(time.Microsecond), done.Round(time.Millisecond))
+	fmt.Println("canceled = ", canceled)
+}
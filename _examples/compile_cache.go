@@ -0,0 +1,80 @@
+package main
+
+import (
+	"fmt"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Builds the same few filter expressions for many tenants and compiles
+// them with and without the compile cache, which shares the code of the
+// functions that were built the same way.
+//
+// func filter_k(x int64) int64 {
+//   if x * k + k > 1000 {
+//     return 1
+//   }
+//   return 0
+// }
+
+const (
+	tenants     = 2000
+	expressions = 20
+)
+
+func build(ctx *jit.Context, k int) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(jit.MaxOptimizationLevel())
+	b := f.Builder()
+	x := b.Param(0)
+	c := b.CreateIntValue(k)
+	for i := 0; i < 16; i++ {
+		x = b.Sub(b.Add(b.Mul(x, c), c), c)
+	}
+	b.Return(b.Gt(b.Add(b.Mul(b.Param(0), c), c), b.CreateIntValue(1000)))
+	return f
+}
+
+func run(cache bool) (time.Duration, uint64, uint64) {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	if cache {
+		ctx.EnableCompileCache()
+	}
+	fns := make([]*jit.Function, tenants)
+	for t := range fns {
+		fns[t] = build(ctx, t%expressions+1)
+	}
+	if fns[0].IRHash() != fns[expressions].IRHash() || fns[0].IRHash() == fns[1].IRHash() {
+		panic("unexpected IR hash")
+	}
+
+	start := time.Now()
+	for _, f := range fns {
+		f.Compile()
+	}
+	elapsed := time.Since(start)
+
+	for t, f := range fns {
+		k := int64(t%expressions + 1)
+		for _, x := range []int64{1, 100} {
+			want := int64(0)
+			if x*k+k > 1000 {
+				want = 1
+			}
+			if got := jit.AsInt64x1(f)(x); got != want {
+				panic(fmt.Sprintf("filter_%d(%d) = %d, want %d", k, x, got, want))
+			}
+		}
+	}
+	hits, misses := ctx.CompileCacheStats()
+	return elapsed, hits, misses
+}
+
+func main() {
+	elapsed, _, _ := run(false)
+	fmt.Printf("without cache: %v for %d functions\n", elapsed, tenants)
+	elapsed, hits, misses := run(true)
+	fmt.Printf("with cache:    %v for %d functions (hits = %d, misses = %d)\n", elapsed, tenants, hits, misses)
+}
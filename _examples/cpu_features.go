@@ -0,0 +1,127 @@
+package main
+
+import (
+	"fmt"
+	"math"
+	"runtime"
+	"time"
+	"unsafe"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compiles the same two functions for the baseline x86-64 instruction set
+// and for the extensions that the CPU has.  floors uses roundsd with
+// SSE4.1 instead of changing the x87 round mode around frndint for every
+// element, and mix uses the BMI2 shifts, which take the count in any
+// register instead of cl.
+//
+// func floors(x *float64, n int64) int64 {
+//   sum := 0.0
+//   for k := 0; k < n; k++ {
+//     sum += floor(x[k])
+//   }
+//   return int64(sum)
+// }
+//
+// func mix(x *int64, n int64) int64 {
+//   h := n
+//   for k := 0; k < n; k++ {
+//     h = (h << x[k]) ^ (h >> (x[k] + k)) ^ k
+//   }
+//   return h
+// }
+
+const (
+	elems      = 4096
+	iterations = 5000
+)
+
+func floors(ctx *jit.Context) func(int64, int64) int64 {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	n := b.Param(1)
+	sum := b.CreateValue(jit.TypeFloat64)
+	k := b.CreateValue(jit.TypeInt)
+	b.Store(sum, b.CreateFloat64Value(0))
+	b.Store(k, b.CreateIntValue(0))
+	top := b.NewLabel()
+	done := b.NewLabel()
+	b.Label(top)
+	b.BranchIfNot(b.Lt(k, n), done)
+	b.Store(sum, b.Add(sum, b.Floor(b.LoadElem(x, k, jit.TypeFloat64))))
+	b.Store(k, b.Add(k, b.CreateIntValue(1)))
+	b.Branch(top)
+	b.Label(done)
+	b.Return(b.Convert(sum, jit.TypeInt, 0))
+	f.Compile()
+	return jit.AsInt64x2(f)
+}
+
+func mix(ctx *jit.Context) func(int64, int64) int64 {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	n := b.Param(1)
+	h := b.CreateValue(jit.TypeInt)
+	k := b.CreateValue(jit.TypeInt)
+	b.Store(h, n)
+	b.Store(k, b.CreateIntValue(0))
+	top := b.NewLabel()
+	done := b.NewLabel()
+	b.Label(top)
+	b.BranchIfNot(b.Lt(k, n), done)
+	s := b.LoadElem(x, k, jit.TypeInt)
+	b.Store(h, b.Xor(b.Xor(b.Shl(h, s), b.Shr(h, b.Add(s, k))), k))
+	b.Store(k, b.Add(k, b.CreateIntValue(1)))
+	b.Branch(top)
+	b.Label(done)
+	b.Return(h)
+	f.Compile()
+	return jit.AsInt64x2(f)
+}
+
+func timeit(name string, call func()) {
+	start := time.Now()
+	for j := 0; j < iterations; j++ {
+		call()
+	}
+	elapsed := time.Since(start)
+	fmt.Printf("  %-6s %v (%.2f ns/element)\n",
+		name, elapsed, float64(elapsed.Nanoseconds())/(elems*iterations))
+}
+
+func main() {
+	xs := make([]float64, elems)
+	shifts := make([]int64, elems)
+	wantFloors := 0.0
+	for i := range xs {
+		xs[i] = float64(i%201-100) / 7
+		shifts[i] = int64(i*13) % 64
+		wantFloors += math.Floor(xs[i])
+	}
+	xsPtr := int64(uintptr(unsafe.Pointer(&xs[0])))
+	shiftsPtr := int64(uintptr(unsafe.Pointer(&shifts[0])))
+
+	var mixed []int64
+	for _, features := range []uint{0, ^uint(0)} {
+		ctx := jit.NewContext()
+		ctx.SetCPUFeatures(features)
+		fmt.Printf("features %#x:\n", ctx.CPUFeatures())
+		fl := floors(ctx)
+		mx := mix(ctx)
+		if got := fl(xsPtr, elems); got != int64(wantFloors) {
+			panic(fmt.Sprintf("floors(x, n) = %v, want %v", got, wantFloors))
+		}
+		mixed = append(mixed, mx(shiftsPtr, elems))
+		timeit("floors", func() { fl(xsPtr, elems) })
+		timeit("mix", func() { mx(shiftsPtr, elems) })
+		ctx.Close()
+	}
+	if mixed[0] != mixed[1] {
+		panic(fmt.Sprintf("mix(x, n) = %d with the extensions, %d without", mixed[1], mixed[0]))
+	}
+	runtime.KeepAlive(xs)
+	runtime.KeepAlive(shifts)
+}
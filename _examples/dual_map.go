@@ -0,0 +1,184 @@
+package main
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"strings"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compiles functions into a code cache that is mapped twice, writable at
+// one address and executable at another, checks that no mapping of the
+// process is writable and executable, and compares compile throughput
+// with a regular context.  The functions use constant data, a jump table
+// and a call, which all have to refer to where the code runs rather than
+// where it was written.  They are also saved to an ELF binary and loaded
+// into a regular context.
+//
+// func scale(x, y float64) float64 {
+//   return x * y + 1.5
+// }
+//
+// func pick(x int64) int64 {
+//   switch x {
+//   case 0: return 10
+//   case 1: return 20
+//   case 2: return 30
+//   }
+//   return 0
+// }
+//
+// func mix(x, y int64) int64 {
+//   return x * y + pick(x % y)
+// }
+
+const functions = 5000
+
+var signatures = map[string][]jit.Types{
+	"scale": {{jit.TypeFloat64, jit.TypeFloat64}, {jit.TypeFloat64}},
+	"pick":  {{jit.TypeInt}, {jit.TypeInt}},
+	"mix":   {{jit.TypeInt, jit.TypeInt}, {jit.TypeInt}},
+}
+
+func compile(ctx *jit.Context) map[string]*jit.Function {
+	fns := map[string]*jit.Function{}
+	_, err := ctx.Build(func(ctx *jit.Context) (*jit.Function, error) {
+		scale := ctx.CreateFunction(signatures["scale"][0], signatures["scale"][1][0])
+		scale.Return(scale.Add(scale.Mul(scale.Param(0), scale.Param(1)), scale.CreateFloat64Value(1.5)))
+		scale.Compile()
+		fns["scale"] = scale
+
+		pick := ctx.CreateFunction(signatures["pick"][0], signatures["pick"][1][0])
+		labels := jit.Labels{pick.ReserveLabel(), pick.ReserveLabel(), pick.ReserveLabel()}
+		pick.JumpTable(pick.Param(0), labels)
+		pick.Return(pick.CreateIntValue(0))
+		for i, label := range labels {
+			pick.Label(label)
+			pick.Return(pick.CreateIntValue((i + 1) * 10))
+		}
+		pick.Compile()
+		fns["pick"] = pick
+
+		mix := ctx.CreateFunction(signatures["mix"][0], signatures["mix"][1][0])
+		x := mix.Param(0)
+		picked := mix.Call("pick", pick, jit.Values{mix.Rem(x, mix.Param(1))})
+		mix.Return(mix.Add(mix.Mul(x, mix.Param(1)), picked))
+		mix.Compile()
+		fns["mix"] = mix
+		return nil, nil
+	})
+	if err != nil {
+		panic(err)
+	}
+	return fns
+}
+
+func check(fns map[string]*jit.Function) {
+	scale := jit.AsFloat64x2(fns["scale"])
+	pick := jit.AsInt64x1(fns["pick"])
+	mix := jit.AsInt64x2(fns["mix"])
+	if got := scale(2, 4); got != 9.5 {
+		panic(fmt.Sprintf("scale(2, 4) = %v", got))
+	}
+	for x := int64(-1); x <= 3; x++ {
+		want := int64(0)
+		if x >= 0 && x <= 2 {
+			want = (x + 1) * 10
+		}
+		if got := pick(x); got != want {
+			panic(fmt.Sprintf("pick(%d) = %d, want %d", x, got, want))
+		}
+	}
+	if got := mix(14, 3); got != 42+30 {
+		panic(fmt.Sprintf("mix(14, 3) = %d", got))
+	}
+}
+
+// writableExecutable counts the mappings of the process that are both
+// writable and executable.
+func writableExecutable() int {
+	maps, err := os.ReadFile("/proc/self/maps")
+	if err != nil {
+		return -1
+	}
+	n := 0
+	for _, line := range strings.Split(string(maps), "\n") {
+		fields := strings.Fields(line)
+		if len(fields) > 1 && strings.HasPrefix(fields[1], "rwx") {
+			n++
+		}
+	}
+	return n
+}
+
+func throughput(ctx *jit.Context) time.Duration {
+	start := time.Now()
+	for i := 0; i < functions; i++ {
+		f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+		b := f.Builder()
+		x := b.Param(0)
+		for k := 0; k < 8; k++ {
+			x = b.Add(b.Mul(x, b.CreateIntValue(3)), b.CreateIntValue(i+k))
+		}
+		b.Return(x)
+		f.Compile()
+	}
+	return time.Since(start)
+}
+
+func main() {
+	ctx := jit.NewDualMappedContext()
+	if ctx == nil {
+		fmt.Println("dual mapping is not supported here")
+		return
+	}
+	defer ctx.Close()
+	ctx.EnablePreCompile()
+	fns := compile(ctx)
+	check(fns)
+	fmt.Println("writable and executable mappings: ", writableExecutable())
+
+	dir, err := os.MkdirTemp("", "go-jit")
+	if err != nil {
+		panic(err)
+	}
+	defer os.RemoveAll(dir)
+	path := filepath.Join(dir, "cache.so")
+	w := jit.NewELFWriter("cache.so")
+	for _, name := range []string{"scale", "pick", "mix"} {
+		if !w.AddFunction(fns[name], name) {
+			panic("cannot add " + name)
+		}
+	}
+	if err := w.Write(path); err != nil {
+		panic(err)
+	}
+	w.Close()
+
+	loadCtx := jit.NewContext()
+	defer loadCtx.Close()
+	r, err := loadCtx.LoadELF(path)
+	if err != nil {
+		panic(err)
+	}
+	loaded := map[string]*jit.Function{}
+	for name, sig := range signatures {
+		f, err := r.Function(name, sig[0], sig[1][0])
+		if err != nil {
+			panic(err)
+		}
+		loaded[name] = f
+	}
+	check(loaded)
+	fmt.Println("reloaded mix(14, 3) = ", jit.AsInt64x2(loaded["mix"])(14, 3))
+
+	dual := jit.NewDualMappedContext()
+	defer dual.Close()
+	regular := jit.NewContext()
+	defer regular.Close()
+	fmt.Printf("compile %d functions: regular = %v, dual mapped = %v\n",
+		functions, throughput(regular), throughput(dual))
+}
@@ -0,0 +1,108 @@
+package main
+
+import (
+	"fmt"
+	"math/rand"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compiles more query functions than fit in a small code cache.  With
+// eviction, the least recently used ones are freed to make room and
+// compiled again when they are called next.  Without it, compilation
+// fails once the cache is full.
+//
+// func query_k(x int64) int64 {
+//   for i := 0; i < steps; i++ {
+//     x = (x * 3 + k + i) ^ (k * i)
+//   }
+//   return x
+// }
+
+const (
+	queries    = 200
+	hot        = 16
+	steps      = 48
+	calls      = 20000
+	cacheLimit = 128 * 1024
+)
+
+func buildQuery(k int) func(*jit.Function) error {
+	return func(f *jit.Function) error {
+		b := f.Builder()
+		x := b.Param(0)
+		three := b.CreateIntValue(3)
+		for i := 0; i < steps; i++ {
+			x = b.Mul(x, three)
+			x = b.Add(x, b.CreateIntValue(k+i))
+			x = b.Xor(x, b.CreateIntValue(k*i))
+		}
+		b.Return(x)
+		return nil
+	}
+}
+
+func want(k int, x int64) int64 {
+	for i := 0; i < steps; i++ {
+		x = (x*3 + int64(k+i)) ^ int64(k*i)
+	}
+	return x
+}
+
+func run(evict bool) {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	ctx.SetCacheLimit(cacheLimit)
+	if evict {
+		ctx.EnableEviction()
+	}
+
+	var funcs []*jit.Function
+	var fns []func(int64) int64
+	for k := 0; k < queries; k++ {
+		f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+		if f == nil {
+			break
+		}
+		if err := f.CompileEvictable(buildQuery(k)); err != nil {
+			break
+		}
+		funcs = append(funcs, f)
+		fns = append(fns, jit.AsInt64x1(f))
+	}
+	if len(fns) < queries {
+		fmt.Printf("without eviction: compiled %d of %d queries before the cache was full\n", len(fns), queries)
+		return
+	}
+
+	// Most calls go to a few hot queries, the rest to any of them.
+	rnd := rand.New(rand.NewSource(1))
+	start := time.Now()
+	for i := 0; i < calls; i++ {
+		k := rnd.Intn(hot)
+		if i%4 == 0 {
+			k = rnd.Intn(queries)
+		}
+		x := int64(i)
+		if got := fns[k](x); got != want(k, x) {
+			panic(fmt.Sprintf("query_%d(%d) = %d, want %d", k, x, got, want(k, x)))
+		}
+	}
+	fmt.Printf("with eviction: %d calls to %d queries in %v, %d evictions\n",
+		calls, queries, time.Since(start), ctx.NumEvictions())
+
+	// Code can also be freed explicitly.
+	k := hot - 1
+	if !funcs[k].IsCompiled() || !funcs[k].FreeCode() || funcs[k].IsCompiled() {
+		panic("cannot free the code of a hot query")
+	}
+	if got := fns[k](7); got != want(k, 7) {
+		panic(fmt.Sprintf("query_%d(7) = %d after FreeCode", k, got))
+	}
+}
+
+func main() {
+	run(false)
+	run(true)
+}
@@ -0,0 +1,110 @@
+package main
+
+import (
+	"fmt"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compiles many small functions and calls them round-robin from one
+// driver, with and without huge pages.  The functions take up more code
+// than the iTLB covers with 4KB pages, so every call can miss it.
+//
+// func step_k(x int64) int64 {
+//   for i := 0; i < steps; i++ {
+//     x = (x * 3 + k + i) ^ (k * i)
+//   }
+//   return x
+// }
+//
+// func driver(x, rounds int64) int64 {
+//   for r := 0; r < rounds; r++ {
+//     x = step_0(x)
+//     ...
+//     x = step_n(x)
+//   }
+//   return x
+// }
+
+const (
+	functions = 8000
+	steps     = 40
+	rounds    = 20
+)
+
+func buildStep(ctx *jit.Context, k int) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	three := b.CreateIntValue(3)
+	for i := 0; i < steps; i++ {
+		x = b.Mul(x, three)
+		x = b.Add(x, b.CreateIntValue(k+i))
+		x = b.Xor(x, b.CreateIntValue(k*i))
+	}
+	b.Return(x)
+	f.Compile()
+	return f
+}
+
+func buildDriver(ctx *jit.Context, fns []*jit.Function) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.CreateValue(jit.TypeInt)
+	r := b.CreateValue(jit.TypeInt)
+	b.Store(x, b.Param(0))
+	b.Store(r, b.CreateIntValue(0))
+	loop := b.NewLabel()
+	done := b.NewLabel()
+	b.Label(loop)
+	b.BranchIfNot(b.Lt(r, b.Param(1)), done)
+	for _, fn := range fns {
+		b.Store(x, b.Call("step", fn, x))
+	}
+	b.Store(r, b.Add(r, b.CreateIntValue(1)))
+	b.Branch(loop)
+	b.Label(done)
+	b.Return(x)
+	f.Compile()
+	return f
+}
+
+func want(x int64, n int) int64 {
+	for r := 0; r < n; r++ {
+		for k := 0; k < functions; k++ {
+			for i := 0; i < steps; i++ {
+				x = (x*3 + int64(k+i)) ^ int64(k*i)
+			}
+		}
+	}
+	return x
+}
+
+func run(huge bool) {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	if huge {
+		ctx.EnableHugePages()
+	}
+	fns := make([]*jit.Function, functions)
+	for k := range fns {
+		fns[k] = buildStep(ctx, k)
+	}
+	driver := jit.AsInt64x2(buildDriver(ctx, fns))
+	if got := driver(1, 1); got != want(1, 1) {
+		panic(fmt.Sprintf("driver(1, 1) = %d, want %d", got, want(1, 1)))
+	}
+
+	start := time.Now()
+	driver(1, rounds)
+	elapsed := time.Since(start)
+	calls := functions * rounds
+	fmt.Printf("huge pages = %-5v: %v for %d calls (%.1f ns/call), %d huge pages in use\n",
+		huge, elapsed, calls, float64(elapsed.Nanoseconds())/float64(calls), ctx.NumHugePages())
+}
+
+func main() {
+	run(false)
+	run(true)
+}
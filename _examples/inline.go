@@ -0,0 +1,143 @@
+package main
+
+import (
+	"fmt"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Calls two small helper functions from a loop, once in a context that
+// does not inline and once in a context that inlines functions of up to
+// 16 instructions.  When they are inlined, the constant bounds passed to
+// clamp are propagated into its branches and no call is made.
+//
+// func scale(x int64) int64 {
+//   return x * 3 + 1
+// }
+//
+// func clamp(x, lo, hi int64) int64 {
+//   if x < lo {
+//     return lo
+//   }
+//   if x > hi {
+//     return hi
+//   }
+//   return x
+// }
+//
+// func f(x, n int64) int64 {
+//   sum := 0
+//   for i := 0; i < n; i++ {
+//     sum += clamp(scale(i ^ x), 0, 1000)
+//   }
+//   return sum
+// }
+//
+// A function that may be recompiled is not inlined, so that its callers
+// see the new code once it is rebuilt.
+
+const iterations = 50000000
+
+func buildHelpers(ctx *jit.Context) (*jit.Function, *jit.Function) {
+	scale := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	b := scale.Builder()
+	b.Return(b.Add(b.Mul(b.Param(0), b.CreateIntValue(3)), b.CreateIntValue(1)))
+	scale.Compile()
+
+	clamp := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b = clamp.Builder()
+	x, lo, hi := b.Param(0), b.Param(1), b.Param(2)
+	above := b.NewLabel()
+	inside := b.NewLabel()
+	b.BranchIfNot(b.Lt(x, lo), above)
+	b.Return(lo)
+	b.Label(above)
+	b.BranchIfNot(b.Gt(x, hi), inside)
+	b.Return(hi)
+	b.Label(inside)
+	b.Return(x)
+	clamp.Compile()
+	return scale, clamp
+}
+
+func build(ctx *jit.Context) *jit.Function {
+	scale, clamp := buildHelpers(ctx)
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	n := b.Param(1)
+	sum := b.CreateValue(jit.TypeInt)
+	i := b.CreateValue(jit.TypeInt)
+	b.Store(sum, b.CreateIntValue(0))
+	b.Store(i, b.CreateIntValue(0))
+	top := b.NewLabel()
+	done := b.NewLabel()
+	b.Label(top)
+	b.BranchIfNot(b.Lt(i, n), done)
+	scaled := b.Call("scale", scale, b.Xor(i, x))
+	clamped := b.Call("clamp", clamp, scaled, b.CreateIntValue(0), b.CreateIntValue(1000))
+	b.Store(sum, b.Add(sum, clamped))
+	b.Store(i, b.Add(i, b.CreateIntValue(1)))
+	b.Branch(top)
+	b.Label(done)
+	b.Return(sum)
+	f.Compile()
+	return f
+}
+
+func want(x, n int64) int64 {
+	sum := int64(0)
+	for i := int64(0); i < n; i++ {
+		v := (i^x)*3 + 1
+		if v < 0 {
+			v = 0
+		} else if v > 1000 {
+			v = 1000
+		}
+		sum += v
+	}
+	return sum
+}
+
+// checkRecompile rebuilds a recompilable function that an earlier caller
+// calls, and checks that the caller runs the new code.
+func checkRecompile() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	ctx.SetInlineLimit(64)
+	callee := ctx.CreateFunction([]*jit.Type{}, jit.TypeInt)
+	callee.SetRecompilable()
+	callee.Return(callee.CreateIntValue(1))
+	callee.Compile()
+	caller := ctx.CreateFunction([]*jit.Type{}, jit.TypeInt)
+	caller.Return(caller.Call("callee", callee, nil))
+	caller.Compile()
+	callee.Return(callee.CreateIntValue(2))
+	callee.Compile()
+	if got := caller.Run(); got != 2 {
+		panic(fmt.Sprintf("caller of a recompiled function returned %v, want 2", got))
+	}
+}
+
+func main() {
+	checkRecompile()
+
+	for _, limit := range []uint{0, 16} {
+		ctx := jit.NewContext()
+		ctx.SetInlineLimit(limit)
+		call := jit.AsInt64x2(build(ctx))
+		for _, x := range []int64{-300, 0, 7, 200} {
+			if got := call(x, 1000); got != want(x, 1000) {
+				panic(fmt.Sprintf("inline limit %d: f(%d, 1000) = %d, want %d",
+					limit, x, got, want(x, 1000)))
+			}
+		}
+		start := time.Now()
+		call(5, iterations)
+		elapsed := time.Since(start)
+		fmt.Printf("inline limit %2d: %v for %d iterations (%.2f ns/iteration)\n",
+			limit, elapsed, iterations, float64(elapsed.Nanoseconds())/iterations)
+		ctx.Close()
+	}
+}
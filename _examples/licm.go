@@ -0,0 +1,120 @@
+package main
+
+import (
+	"fmt"
+	"runtime"
+	"time"
+	"unsafe"
+
+	"github.com/goccy/go-jit"
+)
+
+// Runs a row loop that, like generated code often does, reads the
+// description of its input from memory on every iteration: which column
+// to use, where the column is, and how to scale its values.  The loop
+// writes no memory, so with optimization these loads, the address
+// arithmetic on them and the conversion of the scale are moved out of
+// the loop, and only the load of the row remains.
+//
+// type table struct {
+//   cols  [2]*int64
+//   which int64
+//   scale float64
+//   bias  int64
+// }
+//
+// func f(t *table, n int64) int64 {
+//   sum := 0
+//   if n > 0 {
+//     i := 0
+//     for {
+//       sum += t.cols[t.which][i] * int64(t.scale) + t.bias
+//       i++
+//       if i >= n {
+//         break
+//       }
+//     }
+//   }
+//   return sum
+// }
+
+type table struct {
+	cols  [2]*int64
+	which int64
+	scale float64
+	bias  int64
+}
+
+const (
+	rows       = 4096
+	iterations = 20000
+)
+
+func build(ctx *jit.Context, level uint) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(level)
+	b := f.Builder()
+	t := b.Param(0)
+	n := b.Param(1)
+	sum := b.CreateValue(jit.TypeInt)
+	i := b.CreateValue(jit.TypeInt)
+	b.Store(sum, b.CreateIntValue(0))
+	b.Store(i, b.CreateIntValue(0))
+	top := b.NewLabel()
+	done := b.NewLabel()
+	b.BranchIf(b.Le(n, b.CreateIntValue(0)), done)
+	b.Label(top)
+	which := b.LoadRelative(t, int(unsafe.Offsetof(table{}.which)), jit.TypeInt)
+	col := b.LoadElem(t, which, jit.TypeVoidPtr)
+	row := b.LoadElem(col, i, jit.TypeInt)
+	scale := b.Convert(b.LoadRelative(t, int(unsafe.Offsetof(table{}.scale)), jit.TypeFloat64), jit.TypeInt, 0)
+	bias := b.LoadRelative(t, int(unsafe.Offsetof(table{}.bias)), jit.TypeInt)
+	b.Store(sum, b.Add(sum, b.Add(b.Mul(row, scale), bias)))
+	b.Store(i, b.Add(i, b.CreateIntValue(1)))
+	b.BranchIf(b.Lt(i, n), top)
+	b.Label(done)
+	b.Return(sum)
+	f.Compile()
+	return f
+}
+
+func want(t *table, col []int64, n int64) int64 {
+	sum := int64(0)
+	for i := int64(0); i < n; i++ {
+		sum += col[i]*int64(t.scale) + t.bias
+	}
+	return sum
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	col0 := make([]int64, rows)
+	col1 := make([]int64, rows)
+	for i := range col0 {
+		col0[i] = int64(i % 97)
+		col1[i] = int64(i % 13)
+	}
+	t := &table{cols: [2]*int64{&col0[0], &col1[0]}, which: 1, scale: 3.5, bias: -2}
+	ptr := int64(uintptr(unsafe.Pointer(t)))
+
+	for _, level := range []uint{0, 1} {
+		call := jit.AsInt64x2(build(ctx, level))
+		for _, n := range []int64{0, 1, 100, rows} {
+			if got := call(ptr, n); got != want(t, col1, n) {
+				panic(fmt.Sprintf("level %d: f(t, %d) = %d, want %d", level, n, got, want(t, col1, n)))
+			}
+		}
+		start := time.Now()
+		for k := 0; k < iterations; k++ {
+			call(ptr, rows)
+		}
+		elapsed := time.Since(start)
+		fmt.Printf("level %d: %v for %d rows (%.2f ns/row)\n",
+			level, elapsed, rows*iterations, float64(elapsed.Nanoseconds())/(rows*iterations))
+	}
+	runtime.KeepAlive(t)
+	runtime.KeepAlive(col0)
+	runtime.KeepAlive(col1)
+}
@@ -0,0 +1,107 @@
+package main
+
+import (
+	"fmt"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Runs a kernel whose two loops reuse the same scratch variables.  The
+// variables are live only inside each loop body, so once liveness is
+// computed across blocks the ones kept in the frame are no longer
+// stored at the end of every iteration.  Without optimization there is
+// no control flow graph, and every variable is stored at the end of
+// every block.
+//
+// func f(x, n int64) int64 {
+//   sum := 0
+//   for i := 0; i < n; i++ {
+//     s0 := i * x
+//     s1 := s0 ^ (i + 1)
+//     s2 := s1 ^ (i + 2)
+//     s3 := s2 ^ (i + 3)
+//     sum += s0 + s1 + s2 + s3
+//   }
+//   for i := 0; i < n; i++ {
+//     s0 := i * x
+//     s1 := s0 ^ (i + 3)
+//     s2 := s1 ^ (i + 6)
+//     s3 := s2 ^ (i + 9)
+//     sum += s0 + s1 + s2 + s3
+//   }
+//   return sum
+// }
+
+const iterations = 50000000
+
+func build(ctx *jit.Context, level uint) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(level)
+	b := f.Builder()
+	x := b.Param(0)
+	n := b.Param(1)
+	scratch := make([]jit.ValueID, 4)
+	for k := range scratch {
+		scratch[k] = b.CreateValue(jit.TypeInt)
+	}
+	sum := b.CreateValue(jit.TypeInt)
+	i := b.CreateValue(jit.TypeInt)
+	b.Store(sum, b.CreateIntValue(0))
+	for _, step := range []int{1, 3} {
+		b.Store(i, b.CreateIntValue(0))
+		top := b.NewLabel()
+		done := b.NewLabel()
+		b.Label(top)
+		b.BranchIfNot(b.Lt(i, n), done)
+		b.Store(scratch[0], b.Mul(i, x))
+		for k := 1; k < len(scratch); k++ {
+			b.Store(scratch[k], b.Xor(scratch[k-1], b.Add(i, b.CreateIntValue(step*k))))
+		}
+		acc := scratch[0]
+		for k := 1; k < len(scratch); k++ {
+			acc = b.Add(acc, scratch[k])
+		}
+		b.Store(sum, b.Add(sum, acc))
+		b.Store(i, b.Add(i, b.CreateIntValue(1)))
+		b.Branch(top)
+		b.Label(done)
+	}
+	b.Return(sum)
+	f.Compile()
+	return f
+}
+
+func want(x, n int64) int64 {
+	sum := int64(0)
+	for _, step := range []int64{1, 3} {
+		for i := int64(0); i < n; i++ {
+			s0 := i * x
+			s1 := s0 ^ (i + step)
+			s2 := s1 ^ (i + 2*step)
+			s3 := s2 ^ (i + 3*step)
+			sum += s0 + s1 + s2 + s3
+		}
+	}
+	return sum
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	for _, level := range []uint{0, 1} {
+		call := jit.AsInt64x2(build(ctx, level))
+		for _, x := range []int64{-3, 0, 11} {
+			if got := call(x, 1000); got != want(x, 1000) {
+				panic(fmt.Sprintf("level %d: f(%d, 1000) = %d, want %d",
+					level, x, got, want(x, 1000)))
+			}
+		}
+		start := time.Now()
+		call(5, iterations)
+		elapsed := time.Since(start)
+		fmt.Printf("level %d: %v for %d iterations (%.2f ns/iteration)\n",
+			level, elapsed, 2*iterations, float64(elapsed.Nanoseconds())/(2*iterations))
+	}
+}
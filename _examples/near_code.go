@@ -0,0 +1,87 @@
+package main
+
+import (
+	"fmt"
+	"os"
+	"runtime/debug"
+	"strconv"
+	"strings"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compiles a function in several contexts and checks that the code of
+// each lies within 1GB of the code of the program, which the runtime
+// helpers are part of, so that calls between them fit in a 32-bit
+// relative call.  A position independent program is loaded far above
+// 4GB, so run this with
+//
+//   go run -buildmode=pie _examples/near_code.go
+//
+// func f(x int64) int64 {
+//   return x * 3 + 1
+// }
+
+const (
+	contexts     = 6
+	reserveRange = 1 << 30
+)
+
+// programText returns the executable mapping of the program itself.
+func programText() (uintptr, uintptr) {
+	exe, err := os.Executable()
+	if err != nil {
+		panic(err)
+	}
+	maps, err := os.ReadFile("/proc/self/maps")
+	if err != nil {
+		panic(err)
+	}
+	for _, line := range strings.Split(string(maps), "\n") {
+		fields := strings.Fields(line)
+		if len(fields) < 6 || fields[5] != exe || !strings.HasPrefix(fields[1], "r-x") {
+			continue
+		}
+		bounds := strings.SplitN(fields[0], "-", 2)
+		start, _ := strconv.ParseUint(bounds[0], 16, 64)
+		end, _ := strconv.ParseUint(bounds[1], 16, 64)
+		return uintptr(start), uintptr(end)
+	}
+	panic("no executable mapping for " + exe)
+}
+
+func buildMode() string {
+	if info, ok := debug.ReadBuildInfo(); ok {
+		for _, s := range info.Settings {
+			if s.Key == "-buildmode" {
+				return s.Value
+			}
+		}
+	}
+	return "unknown"
+}
+
+func main() {
+	start, end := programText()
+	fmt.Printf("build mode %s, program code at %#x-%#x\n", buildMode(), start, end)
+
+	for i := 0; i < contexts; i++ {
+		ctx := jit.NewContext()
+		begin := time.Now()
+		f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+		b := f.Builder()
+		b.Return(b.Add(b.Mul(b.Param(0), b.CreateIntValue(3)), b.CreateIntValue(1)))
+		f.Compile()
+		elapsed := time.Since(begin)
+		if got := jit.AsInt64x1(f)(int64(i)); got != int64(i)*3+1 {
+			panic(fmt.Sprintf("f(%d) = %d", i, got))
+		}
+		code := uintptr(f.ToVtablePointer())
+		if code+reserveRange < start || code > end+reserveRange {
+			panic(fmt.Sprintf("context %d: code at %#x is more than 1GB from the program", i, code))
+		}
+		fmt.Printf("context %d: code at %#x, first function in %v\n", i, code, elapsed)
+		ctx.Close()
+	}
+}
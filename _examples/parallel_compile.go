@@ -0,0 +1,86 @@
+package main
+
+import (
+	"fmt"
+	"runtime"
+	"sync"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compiles functions of one context from several goroutines at once.
+//
+// func f_k(x int64) int64 {
+//   return x * k + k
+// }
+
+const functions = 4000
+
+func compile(ctx *jit.Context, k int) (*jit.Function, error) {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	err := f.Build(func(f *jit.Function) error {
+		b := f.Builder()
+		x := b.Param(0)
+		c := b.CreateIntValue(k)
+		for i := 0; i < 16; i++ {
+			x = b.Add(b.Mul(x, c), c)
+			x = b.Sub(x, c)
+			x = b.Div(x, c)
+		}
+		b.Return(b.Add(b.Mul(x, c), c))
+		if !f.Compile() {
+			return fmt.Errorf("failed to compile f_%d", k)
+		}
+		return nil
+	})
+	return f, err
+}
+
+func run(workers int) (time.Duration, error) {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	fns := make([]*jit.Function, functions)
+	errs := make(chan error, workers)
+	var wg sync.WaitGroup
+	start := time.Now()
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func(w int) {
+			defer wg.Done()
+			for k := w + 1; k <= functions; k += workers {
+				f, err := compile(ctx, k)
+				if err != nil {
+					errs <- err
+					return
+				}
+				fns[k-1] = f
+			}
+		}(w)
+	}
+	wg.Wait()
+	elapsed := time.Since(start)
+	close(errs)
+	if err := <-errs; err != nil {
+		return 0, err
+	}
+
+	for k := 1; k <= functions; k++ {
+		if got := jit.AsInt64x1(fns[k-1])(3); got != int64(3*k+k) {
+			return 0, fmt.Errorf("f_%d(3) = %d, want %d", k, got, 3*k+k)
+		}
+	}
+	return elapsed, nil
+}
+
+func main() {
+	fmt.Println("GOMAXPROCS =", runtime.GOMAXPROCS(0))
+	for _, workers := range []int{1, 2, 4, 8} {
+		elapsed, err := run(workers)
+		if err != nil {
+			panic(err)
+		}
+		fmt.Printf("workers=%d: %.0f functions/sec\n", workers, float64(functions)/elapsed.Seconds())
+	}
+}
@@ -0,0 +1,67 @@
+package main
+
+import (
+	"fmt"
+	"runtime"
+	"testing"
+
+	"github.com/goccy/go-jit"
+)
+
+// Calls compiled functions from many goroutines at once.  Every call
+// pushes and pops the exception and backtrace state of the calling thread,
+// so the results would get mixed up if that state was shared.
+//
+// func mulAdd(x, y int64) int64 {
+//   return x * y + x
+// }
+//
+// func twice(x, y int64) int64 {
+//   return mulAdd(x, y) + mulAdd(y, x)
+// }
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	var mulAdd, twice *jit.Function
+	_, err := ctx.Build(func(ctx *jit.Context) (*jit.Function, error) {
+		mulAdd = ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+		b := mulAdd.Builder()
+		b.Return(b.Add(b.Mul(b.Param(0), b.Param(1)), b.Param(0)))
+		mulAdd.Compile()
+
+		twice = ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+		b = twice.Builder()
+		x, y := b.Param(0), b.Param(1)
+		b.Return(b.Add(b.Call("mulAdd", mulAdd, x, y), b.Call("mulAdd", mulAdd, y, x)))
+		twice.Compile()
+		return twice, nil
+	})
+	if err != nil {
+		panic(err)
+	}
+
+	call := jit.AsInt64x2(twice)
+	fmt.Println("GOMAXPROCS =", runtime.GOMAXPROCS(0))
+	for _, parallelism := range []int{1, 2, 4, 8} {
+		r := testing.Benchmark(func(b *testing.B) {
+			b.SetParallelism(parallelism)
+			b.RunParallel(func(pb *testing.PB) {
+				x := int64(0)
+				for pb.Next() {
+					x++
+					if got, want := call(x, 3), 4*x+3+3*x; got != want {
+						panic(fmt.Sprintf("twice(%d, 3) = %d, want %d", x, got, want))
+					}
+					if x%64 == 0 {
+						if got := twice.Run(int(x), 3).(int); int64(got) != 7*x+3 {
+							panic(fmt.Sprintf("Run(%d, 3) = %d", x, got))
+						}
+					}
+				}
+			})
+		})
+		fmt.Printf("goroutines=%d: %s\n", parallelism*runtime.GOMAXPROCS(0), r)
+	}
+}
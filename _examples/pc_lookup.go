@@ -0,0 +1,97 @@
+package main
+
+import (
+	"fmt"
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"time"
+	"unsafe"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compiles many small functions and maps the addresses of their code
+// back to them, the way a sampling profiler or an exception unwinder
+// does, while other goroutines keep compiling and freeing functions.
+//
+// func add_k(x int64) int64 {
+//   return x + k
+// }
+
+const (
+	functions = 100000
+	lookups   = 1000000
+)
+
+func build(ctx *jit.Context, k int) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	b.Return(b.Add(b.Param(0), b.CreateIntValue(k)))
+	f.Compile()
+	return f
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	start := time.Now()
+	fns := make([]*jit.Function, functions)
+	pcs := make([]unsafe.Pointer, functions)
+	for k := range fns {
+		fns[k] = build(ctx, k)
+		pcs[k] = fns[k].ToClosure()
+	}
+	fmt.Printf("compile %d functions: %v\n", functions, time.Since(start))
+
+	start = time.Now()
+	for i := 0; i < lookups; i++ {
+		k := (i * 7919) % functions
+		if f := ctx.FunctionFromPC(pcs[k]); f == nil || f.ToClosure() != pcs[k] {
+			panic(fmt.Sprintf("lookup of add_%d failed", k))
+		}
+	}
+	elapsed := time.Since(start)
+	fmt.Printf("lookup: %.1f ns/op\n", float64(elapsed.Nanoseconds())/lookups)
+
+	// Look up from several goroutines while another one compiles new
+	// functions and frees the code of old ones.
+	var done int32
+	var wg sync.WaitGroup
+	wg.Add(1)
+	go func() {
+		defer wg.Done()
+		for k := 0; atomic.LoadInt32(&done) == 0; k++ {
+			build(ctx, functions+k).FreeCode()
+		}
+	}()
+	readers := runtime.GOMAXPROCS(0)
+	var total int64
+	start = time.Now()
+	for r := 0; r < readers; r++ {
+		wg.Add(1)
+		go func(r int) {
+			defer wg.Done()
+			for i := 0; i < lookups/readers; i++ {
+				k := (i*7919 + r) % functions
+				if f := ctx.FunctionFromPC(pcs[k]); f == nil || f.ToClosure() != pcs[k] {
+					panic(fmt.Sprintf("lookup of add_%d failed", k))
+				}
+				atomic.AddInt64(&total, 1)
+			}
+		}(r)
+	}
+	for atomic.LoadInt64(&total) < int64(lookups/readers*readers) {
+		time.Sleep(time.Millisecond)
+	}
+	elapsed = time.Since(start)
+	atomic.StoreInt32(&done, 1)
+	wg.Wait()
+	fmt.Printf("lookup while compiling, %d goroutines: %.1f ns/op\n",
+		readers, float64(elapsed.Nanoseconds())/float64(total))
+
+	if got := jit.AsInt64x1(fns[12345])(1); got != 12346 {
+		panic(fmt.Sprintf("add_12345(1) = %d", got))
+	}
+}
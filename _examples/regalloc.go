@@ -0,0 +1,143 @@
+package main
+
+import (
+	"fmt"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Runs a kernel with more hot variables than there are global registers.
+// The k variables are used more often than any other, but only outside
+// the loops.  Without optimization the global registers go to the most
+// used variables for the whole function, so they go to the k variables
+// and every variable of the loops lives in the frame.  With optimization
+// the registers are allocated over live ranges weighted by loop depth,
+// and a change in a loop weighs more than a read: the variables that the
+// loops carry from one iteration to the next get them, and the two loops
+// share them.  x and n, which the loops only read, get a copy for each
+// loop and stay in the frame.
+//
+// func f(x, n int64) int64 {
+//   k0 := x + 1; k1 := x + 2; k2 := x + 3; k3 := x + 4; k4 := x + 5
+//   sum := 0
+//   a, b, c, d := 0, 0, 0, 0
+//   for i := 0; i < n; i++ {
+//     a += i * x; b ^= a; c += b >> 3; d ^= c
+//   }
+//   sum += a + b + c + d
+//   e, g, h, m := 0, 0, 0, 0
+//   for j := 0; j < n; j++ {
+//     e ^= j + x; g += e; h ^= g >> 5; m += h
+//   }
+//   sum += e + g + h + m
+//   return sum + (k0*k1 ^ k2*k3 ^ k4*k0) + (k1^k2) + (k3^k4) + (k0^k2) + (k1^k3) + (k4^k2)
+// }
+
+const iterations = 50000000
+
+func build(ctx *jit.Context, level uint) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(level)
+	b := f.Builder()
+	x := b.Param(0)
+	n := b.Param(1)
+	zero := b.CreateIntValue(0)
+	one := b.CreateIntValue(1)
+
+	k := make([]jit.ValueID, 5)
+	for i := range k {
+		k[i] = b.CreateValue(jit.TypeInt)
+		b.Store(k[i], b.Add(x, b.CreateIntValue(i+1)))
+	}
+	vars := make([]jit.ValueID, 8)
+	for i := range vars {
+		vars[i] = b.CreateValue(jit.TypeInt)
+	}
+	i := b.CreateValue(jit.TypeInt)
+	sum := b.CreateValue(jit.TypeInt)
+
+	loop := func(vars []jit.ValueID, body func()) {
+		for _, v := range vars {
+			b.Store(v, zero)
+		}
+		b.Store(i, zero)
+		top := b.NewLabel()
+		done := b.NewLabel()
+		b.Label(top)
+		b.BranchIfNot(b.Lt(i, n), done)
+		body()
+		b.Store(i, b.Add(i, one))
+		b.Branch(top)
+		b.Label(done)
+	}
+
+	b.Store(sum, zero)
+	a, bb, c, d := vars[0], vars[1], vars[2], vars[3]
+	loop(vars[:4], func() {
+		b.Store(a, b.Add(a, b.Mul(i, x)))
+		b.Store(bb, b.Xor(bb, a))
+		b.Store(c, b.Add(c, b.Sshr(bb, b.CreateIntValue(3))))
+		b.Store(d, b.Xor(d, c))
+	})
+	b.Store(sum, b.Add(sum, b.Add(b.Add(a, bb), b.Add(c, d))))
+
+	e, g, h, m := vars[4], vars[5], vars[6], vars[7]
+	loop(vars[4:], func() {
+		b.Store(e, b.Xor(e, b.Add(i, x)))
+		b.Store(g, b.Add(g, e))
+		b.Store(h, b.Xor(h, b.Sshr(g, b.CreateIntValue(5))))
+		b.Store(m, b.Add(m, h))
+	})
+	b.Store(sum, b.Add(sum, b.Add(b.Add(e, g), b.Add(h, m))))
+
+	ks := b.Xor(b.Xor(b.Mul(k[0], k[1]), b.Mul(k[2], k[3])), b.Mul(k[4], k[0]))
+	for _, pair := range [][2]int{{1, 2}, {3, 4}, {0, 2}, {1, 3}, {4, 2}} {
+		ks = b.Add(ks, b.Xor(k[pair[0]], k[pair[1]]))
+	}
+	b.Return(b.Add(sum, ks))
+	f.Compile()
+	return f
+}
+
+func want(x, n int64) int64 {
+	k0, k1, k2, k3, k4 := x+1, x+2, x+3, x+4, x+5
+	sum := int64(0)
+	var a, b, c, d int64
+	for i := int64(0); i < n; i++ {
+		a += i * x
+		b ^= a
+		c += b >> 3
+		d ^= c
+	}
+	sum += a + b + c + d
+	var e, g, h, m int64
+	for j := int64(0); j < n; j++ {
+		e ^= j + x
+		g += e
+		h ^= g >> 5
+		m += h
+	}
+	sum += e + g + h + m
+	return sum + (k0*k1 ^ k2*k3 ^ k4*k0) + (k1 ^ k2) + (k3 ^ k4) + (k0 ^ k2) + (k1 ^ k3) + (k4 ^ k2)
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	for _, level := range []uint{0, 1} {
+		call := jit.AsInt64x2(build(ctx, level))
+		for _, x := range []int64{-3, 0, 11} {
+			if got := call(x, 1000); got != want(x, 1000) {
+				panic(fmt.Sprintf("level %d: f(%d, 1000) = %d, want %d",
+					level, x, got, want(x, 1000)))
+			}
+		}
+		start := time.Now()
+		call(5, iterations)
+		elapsed := time.Since(start)
+		fmt.Printf("level %d: %v for %d iterations (%.2f ns/iteration)\n",
+			level, elapsed, 2*iterations, float64(elapsed.Nanoseconds())/(2*iterations))
+	}
+}
@@ -0,0 +1,215 @@
+package main
+
+import (
+	"fmt"
+	"math"
+	"runtime"
+	"time"
+	"unsafe"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compares scalar loops with the same loops written with 128-bit vectors,
+// which process two float64 or four float32/int32 lanes per instruction.
+//
+// func sum(x *float64, n int64) float64 {
+//   s := 0.0
+//   for k := 0; k < n; k++ {
+//     s += x[k]
+//   }
+//   return s
+// }
+//
+// func saxpy(a float32, x, y *float32, n int64) {
+//   for k := 0; k < n; k++ {
+//     y[k] += a * x[k]
+//   }
+// }
+//
+// func clampMax(x *int32, n int64, lo, hi int32) int32 {
+//   m := lo
+//   for k := 0; k < n; k++ {
+//     m = max(m, min(max(x[k], lo), hi))
+//   }
+//   return m
+// }
+
+const (
+	elems      = 4096
+	iterations = 5000
+)
+
+// loop emits "for k := 0; k < n; k += step { body(k) }".
+func loop(b *jit.Builder, n jit.ValueID, step int, body func(k jit.ValueID)) {
+	k := b.CreateValue(jit.TypeInt)
+	b.Store(k, b.CreateIntValue(0))
+	top := b.NewLabel()
+	done := b.NewLabel()
+	b.Label(top)
+	b.BranchIfNot(b.Lt(k, n), done)
+	body(k)
+	b.Store(k, b.Add(k, b.CreateIntValue(step)))
+	b.Branch(top)
+	b.Label(done)
+}
+
+func sumScalar(ctx *jit.Context) func(int64, int64) int64 {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	s := b.CreateValue(jit.TypeFloat64)
+	b.Store(s, b.CreateFloat64Value(0))
+	loop(b, b.Param(1), 1, func(k jit.ValueID) {
+		b.Store(s, b.Add(s, b.LoadElem(x, k, jit.TypeFloat64)))
+	})
+	b.Return(b.Convert(s, jit.TypeInt, 0))
+	f.Compile()
+	return jit.AsInt64x2(f)
+}
+
+func sumVector(ctx *jit.Context) func(int64, int64) int64 {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	s0 := b.CreateValue(jit.TypeV2F64)
+	s1 := b.CreateValue(jit.TypeV2F64)
+	b.Store(s0, b.VBroadcast(b.CreateFloat64Value(0), jit.TypeV2F64))
+	b.Store(s1, s0)
+	loop(b, b.Param(1), 4, func(k jit.ValueID) {
+		b.Store(s0, b.VAdd(s0, b.VLoad(x, k, jit.TypeV2F64)))
+		b.Store(s1, b.VAdd(s1, b.VLoad(x, b.Add(k, b.CreateIntValue(2)), jit.TypeV2F64)))
+	})
+	b.Return(b.Convert(b.VReduceAdd(b.VAdd(s0, s1)), jit.TypeInt, 0))
+	f.Compile()
+	return jit.AsInt64x2(f)
+}
+
+func saxpyScalar(ctx *jit.Context) func(int64, int64, int64) int64 {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	y := b.Param(1)
+	a := b.CreateFloat32Value(0.5)
+	loop(b, b.Param(2), 1, func(k jit.ValueID) {
+		xk := b.LoadElem(x, k, jit.TypeFloat32)
+		yk := b.LoadElem(y, k, jit.TypeFloat32)
+		b.StoreElem(y, k, b.Add(yk, b.Mul(a, xk)))
+	})
+	b.Return(b.CreateIntValue(0))
+	f.Compile()
+	return jit.AsInt64x3(f)
+}
+
+func saxpyVector(ctx *jit.Context) func(int64, int64, int64) int64 {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	y := b.Param(1)
+	a := b.VBroadcast(b.CreateFloat32Value(0.5), jit.TypeV4F32)
+	loop(b, b.Param(2), 4, func(k jit.ValueID) {
+		xk := b.VLoad(x, k, jit.TypeV4F32)
+		yk := b.VLoad(y, k, jit.TypeV4F32)
+		b.VStore(y, k, b.VAdd(yk, b.VMul(a, xk)))
+	})
+	b.Return(b.CreateIntValue(0))
+	f.Compile()
+	return jit.AsInt64x3(f)
+}
+
+// clampMax uses compares and blends instead of min and max to show
+// VSelect; lo and hi are 32-bit lanes of the broadcast arguments.
+func clampMax(ctx *jit.Context) func(int64, int64, int64, int64) int64 {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt, jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	b := f.Builder()
+	x := b.Param(0)
+	lo := b.VBroadcast(b.Param(2), jit.TypeV4I32)
+	hi := b.VBroadcast(b.Param(3), jit.TypeV4I32)
+	m := b.CreateValue(jit.TypeV4I32)
+	b.Store(m, lo)
+	loop(b, b.Param(1), 4, func(k jit.ValueID) {
+		v := b.VLoad(x, k, jit.TypeV4I32)
+		v = b.VSelect(b.VLt(v, lo), lo, v)
+		v = b.VSelect(b.VGt(v, hi), hi, v)
+		b.Store(m, b.VSelect(b.VGt(v, m), v, m))
+	})
+	b.Return(b.Convert(b.VReduceMax(m), jit.TypeInt, 0))
+	f.Compile()
+	return jit.AsInt64x4(f)
+}
+
+func timeit(name string, call func()) {
+	start := time.Now()
+	for j := 0; j < iterations; j++ {
+		call()
+	}
+	elapsed := time.Since(start)
+	fmt.Printf("  %-6s %v (%.2f ns/element)\n",
+		name, elapsed, float64(elapsed.Nanoseconds())/(elems*iterations))
+}
+
+func main() {
+	xs := make([]float64, elems)
+	fx := make([]float32, elems)
+	fy := make([]float32, elems)
+	ix := make([]int32, elems)
+	wantSum := 0.0
+	wantClamp := int32(-100)
+	for i := range xs {
+		xs[i] = float64(i % 97)
+		fx[i] = float32(i%13) - 6
+		ix[i] = int32(i*7919%2001) - 1000
+		wantSum += xs[i]
+		c := ix[i]
+		if c > 700 {
+			c = 700
+		}
+		if c > wantClamp {
+			wantClamp = c
+		}
+	}
+	xsPtr := int64(uintptr(unsafe.Pointer(&xs[0])))
+	fxPtr := int64(uintptr(unsafe.Pointer(&fx[0])))
+	fyPtr := int64(uintptr(unsafe.Pointer(&fy[0])))
+	ixPtr := int64(uintptr(unsafe.Pointer(&ix[0])))
+
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	ss, sv := sumScalar(ctx), sumVector(ctx)
+	as, av := saxpyScalar(ctx), saxpyVector(ctx)
+	cm := clampMax(ctx)
+
+	if got := ss(xsPtr, elems); got != int64(wantSum) {
+		panic(fmt.Sprintf("scalar sum(x, n) = %v, want %v", got, wantSum))
+	}
+	if got := sv(xsPtr, elems); got != int64(wantSum) {
+		panic(fmt.Sprintf("vector sum(x, n) = %v, want %v", got, wantSum))
+	}
+	if got := cm(ixPtr, elems, -100, 700); got != int64(wantClamp) {
+		panic(fmt.Sprintf("clampMax(x, n) = %v, want %v", got, wantClamp))
+	}
+	for _, fn := range []func(int64, int64, int64) int64{as, av} {
+		for i := range fy {
+			fy[i] = 1
+		}
+		fn(fxPtr, fyPtr, elems)
+		for i := range fy {
+			if want := 1 + 0.5*fx[i]; math.Abs(float64(fy[i]-want)) > 1e-6 {
+				panic(fmt.Sprintf("saxpy: y[%d] = %v, want %v", i, fy[i], want))
+			}
+		}
+	}
+
+	fmt.Println("sum:")
+	timeit("scalar", func() { ss(xsPtr, elems) })
+	timeit("vector", func() { sv(xsPtr, elems) })
+	fmt.Println("saxpy:")
+	timeit("scalar", func() { as(fxPtr, fyPtr, elems) })
+	timeit("vector", func() { av(fxPtr, fyPtr, elems) })
+	fmt.Println("clamp max:")
+	timeit("vector", func() { cm(ixPtr, elems, -100, 700) })
+	runtime.KeepAlive(xs)
+	runtime.KeepAlive(fx)
+	runtime.KeepAlive(fy)
+	runtime.KeepAlive(ix)
+}
@@ -0,0 +1,188 @@
+package main
+
+import (
+	"fmt"
+	"math"
+	"os"
+	"os/exec"
+	"strings"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compiles the same functions at the normal optimization level and at the
+// SSA level, which propagates constants through branches, reuses repeated
+// computations and propagates copies across blocks.
+//
+// func f(x, n int64) int64 {
+//   debug := 0
+//   scale := 3
+//   s := 0
+//   for i := 0; i < n; i++ {
+//     if debug != 0 {
+//       s = s * 7 + x
+//     }
+//     a := x * scale + i
+//     b := x * scale + i
+//     s = s + (a ^ b) + a
+//   }
+//   return s
+// }
+//
+// func g(x int64) int64 {
+//   m := 2
+//   if x > 0 {
+//     m = 4
+//   } else {
+//     m = 4
+//   }
+//   y := x
+//   return x * m + y * m
+// }
+//
+// func div(x int64) int64 {
+//   a := 5; b := 0        // and a := math.MinInt64; b := -1
+//   return x + a / b      // throws, even when a and b are propagated
+// }
+
+const iterations = 100000000
+
+func buildF(ctx *jit.Context, level uint) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(level)
+	b := f.Builder()
+	x := b.Param(0)
+	debug := b.CreateValue(jit.TypeInt)
+	scale := b.CreateValue(jit.TypeInt)
+	s := b.CreateValue(jit.TypeInt)
+	i := b.CreateValue(jit.TypeInt)
+	b.Store(debug, b.CreateIntValue(0))
+	b.Store(scale, b.CreateIntValue(3))
+	b.Store(s, b.CreateIntValue(0))
+	b.Store(i, b.CreateIntValue(0))
+	loop := b.NewLabel()
+	skip := b.NewLabel()
+	done := b.NewLabel()
+	b.Label(loop)
+	b.BranchIfNot(b.Lt(i, b.Param(1)), done)
+	b.BranchIfNot(b.Ne(debug, b.CreateIntValue(0)), skip)
+	b.Store(s, b.Add(b.Mul(s, b.CreateIntValue(7)), x))
+	b.Label(skip)
+	a := b.Add(b.Mul(x, scale), i)
+	c := b.Add(b.Mul(x, scale), i)
+	b.Store(s, b.Add(b.Add(s, b.Xor(a, c)), a))
+	b.Store(i, b.Add(i, b.CreateIntValue(1)))
+	b.Branch(loop)
+	b.Label(done)
+	b.Return(s)
+	return f
+}
+
+func buildG(ctx *jit.Context, level uint) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(level)
+	b := f.Builder()
+	x := b.Param(0)
+	m := b.CreateValue(jit.TypeInt)
+	y := b.CreateValue(jit.TypeInt)
+	b.Store(m, b.CreateIntValue(2))
+	other := b.NewLabel()
+	join := b.NewLabel()
+	b.BranchIfNot(b.Gt(x, b.CreateIntValue(0)), other)
+	b.Store(m, b.CreateIntValue(4))
+	b.Branch(join)
+	b.Label(other)
+	b.Store(m, b.CreateIntValue(4))
+	b.Label(join)
+	b.Store(y, x)
+	b.Return(b.Add(b.Mul(x, m), b.Mul(y, m)))
+	return f
+}
+
+func buildDiv(ctx *jit.Context, level uint, a, b int64) *jit.Function {
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	f.SetOptimizationLevel(level)
+	bld := f.Builder()
+	va := bld.CreateValue(jit.TypeInt)
+	vb := bld.CreateValue(jit.TypeInt)
+	bld.Store(va, bld.CreateIntValue(int(a)))
+	bld.Store(vb, bld.CreateIntValue(int(b)))
+	bld.Return(bld.Add(bld.Param(0), bld.Div(va, vb)))
+	f.Compile()
+	return f
+}
+
+func wantF(x, n int64) int64 {
+	s := int64(0)
+	for i := int64(0); i < n; i++ {
+		s += x*3 + i
+	}
+	return s
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+
+	// A child process that runs one division that must throw
+	if ops := os.Getenv("SSA_DIV"); ops != "" {
+		var level uint
+		var a, b int64
+		fmt.Sscan(ops, &level, &a, &b)
+		div := buildDiv(ctx, level, a, b)
+		fmt.Printf("level %d: 1 + %d / %d = %d\n", level, a, b, jit.AsInt64x1(div)(1))
+		return
+	}
+
+	normal := uint(1)
+	ssa := jit.MaxOptimizationLevel()
+	fmt.Printf("optimization levels: normal = %d, ssa = %d\n", normal, ssa)
+
+	// Show what the SSA level does to g
+	g := buildG(ctx, ssa)
+	g.Optimize()
+	g.Dump("g", os.Stdout)
+	g.Compile()
+	callG := jit.AsInt64x1(g)
+	for _, x := range []int64{-5, 0, 7} {
+		if got := callG(x); got != x*8 {
+			panic(fmt.Sprintf("g(%d) = %d, want %d", x, got, x*8))
+		}
+	}
+
+	// Division by zero and overflowing division must still throw when
+	// their operands are constants.  An exception that nothing catches
+	// ends the process, so each one runs in a process of its own
+	exe, err := os.Executable()
+	if err != nil {
+		panic(err)
+	}
+	for _, level := range []uint{normal, ssa} {
+		for _, ops := range [][2]int64{{5, 0}, {math.MinInt64, -1}} {
+			cmd := exec.Command(exe)
+			cmd.Env = append(os.Environ(), fmt.Sprintf("SSA_DIV=%d %d %d", level, ops[0], ops[1]))
+			out, err := cmd.CombinedOutput()
+			if err == nil || !strings.Contains(string(out), "exception") {
+				panic(fmt.Sprintf("level %d: %d / %d did not throw: %s", level, ops[0], ops[1], out))
+			}
+		}
+	}
+
+	for _, level := range []uint{normal, ssa} {
+		f := buildF(ctx, level)
+		f.Compile()
+		call := jit.AsInt64x2(f)
+		for _, x := range []int64{-3, 0, 11} {
+			if got := call(x, 1000); got != wantF(x, 1000) {
+				panic(fmt.Sprintf("level %d: f(%d, 1000) = %d, want %d",
+					level, x, got, wantF(x, 1000)))
+			}
+		}
+		start := time.Now()
+		call(5, iterations)
+		elapsed := time.Since(start)
+		fmt.Printf("level %d: %v for %d iterations (%.2f ns/iteration)\n",
+			level, elapsed, iterations, float64(elapsed.Nanoseconds())/iterations)
+	}
+}
@@ -0,0 +1,93 @@
+package main
+
+import (
+	"fmt"
+	"time"
+
+	"github.com/goccy/go-jit"
+)
+
+// Compiles a function in the cheap first tier, calls it until it is hot,
+// and checks that callers switch to the optimized code.
+//
+// func f(x int64) int64 {
+//   for i := 0; i < chain; i++ {
+//     x = x * 3 + 1 - 1
+//   }
+//   return x
+// }
+//
+// func g(x int64) int64 {
+//   return f(x) + 1
+// }
+
+const (
+	chain     = 8
+	threshold = 100
+)
+
+func buildF(f *jit.Function) error {
+	b := f.Builder()
+	x := b.Param(0)
+	one := b.CreateIntValue(1)
+	three := b.CreateIntValue(3)
+	for i := 0; i < chain; i++ {
+		x = b.Sub(b.Add(b.Mul(x, three), one), one)
+	}
+	b.Return(x)
+	return nil
+}
+
+func want(x int64) int64 {
+	for i := 0; i < chain; i++ {
+		x *= 3
+	}
+	return x
+}
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	ctx.SetTierUpThreshold(threshold)
+
+	f := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	if err := f.CompileTiered(buildF); err != nil {
+		panic(err)
+	}
+
+	g := ctx.CreateFunction([]*jit.Type{jit.TypeInt}, jit.TypeInt)
+	err := g.Build(func(g *jit.Function) error {
+		b := g.Builder()
+		b.Return(b.Add(b.Call("f", f, b.Param(0)), b.CreateIntValue(1)))
+		g.Compile()
+		return nil
+	})
+	if err != nil {
+		panic(err)
+	}
+
+	callF := jit.AsInt64x1(f)
+	callG := jit.AsInt64x1(g)
+	start := time.Now()
+	calls := 0
+	for x := int64(1); f.IsRecompilable(); x++ {
+		if got := callF(x); got != want(x) {
+			panic(fmt.Sprintf("f(%d) = %d, want %d", x, got, want(x)))
+		}
+		if got := callG(x); got != want(x)+1 {
+			panic(fmt.Sprintf("g(%d) = %d, want %d", x, got, want(x)+1))
+		}
+		calls++
+		if time.Since(start) > 10*time.Second {
+			panic("f was not promoted")
+		}
+	}
+	fmt.Println("calls until promoted = ", calls)
+	for x := int64(1); x <= 100; x++ {
+		if callF(x) != want(x) || callG(x) != want(x)+1 {
+			panic(fmt.Sprintf("wrong result after promotion for %d", x))
+		}
+	}
+	fmt.Println("optimization level = ", f.OptimizationLevel())
+	fmt.Println("g(2) = ", callG(2))
+}
@@ -0,0 +1,78 @@
+package main
+
+import (
+	"fmt"
+	"testing"
+
+	"github.com/goccy/go-jit"
+)
+
+// func f(x, y int64) int64 {
+//   return x * y + x
+// }
+//
+// func g(x, y float64) float64 {
+//   return x * y
+// }
+
+func main() {
+	ctx := jit.NewContext()
+	defer ctx.Close()
+	f, err := ctx.Build(func(ctx *jit.Context) (*jit.Function, error) {
+		f := ctx.CreateFunction([]*jit.Type{jit.TypeInt, jit.TypeInt}, jit.TypeInt)
+		x := f.Param(0)
+		y := f.Param(1)
+		f.Return(f.Add(f.Mul(x, y), x))
+		f.Compile()
+		return f, nil
+	})
+	if err != nil {
+		panic(err)
+	}
+	g, err := ctx.Build(func(ctx *jit.Context) (*jit.Function, error) {
+		g := ctx.CreateFunction([]*jit.Type{jit.TypeFloat64, jit.TypeFloat64}, jit.TypeFloat64)
+		g.Return(g.Mul(g.Param(0), g.Param(1)))
+		g.Compile()
+		return g, nil
+	})
+	if err != nil {
+		panic(err)
+	}
+
+	mulAdd := jit.AsInt64x2(f)
+	mul := jit.AsFloat64x2(g)
+	fmt.Println("mulAdd(6, 7) = ", mulAdd(6, 7))
+	fmt.Println("mul(1.5, 4) = ", mul(1.5, 4))
+
+	fmt.Println("allocs/op (typed) = ", testing.AllocsPerRun(1000, func() { mulAdd(6, 7) }))
+	fmt.Println("allocs/op (Run)   = ", testing.AllocsPerRun(1000, func() { f.Run(6, 7) }))
+
+	typed := testing.Benchmark(func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			mulAdd(int64(i), 7)
+		}
+	})
+	run := testing.Benchmark(func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			f.Run(i, 7)
+		}
+	})
+	fmt.Println("typed: ", typed, typed.MemString())
+	fmt.Println("Run:   ", run, run.MemString())
+
+	// f neither calls out nor throws, so it can also be entered directly
+	// without a cgo transition.
+	leafMulAdd, err := jit.AsLeafInt64x2(f)
+	if err != nil {
+		panic(err)
+	}
+	leaf := testing.Benchmark(func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			leafMulAdd(int64(i), 7)
+		}
+	})
+	fmt.Println("leaf:  ", leaf, leaf.MemString())
+}
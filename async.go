@@ -0,0 +1,30 @@
+package jit
+
+import (
+	"github.com/goccy/go-jit/internal/ccall"
+)
+
+var (
+	ErrCompileCanceled = ccall.ErrCompileCanceled
+	ErrCompileFailed   = ccall.ErrCompileFailed
+)
+
+// CompileFuture is the result of Context.CompileAsync.
+type CompileFuture = ccall.CompileFuture
+
+// CompileAsync queues f to be compiled by a pool of background compiler
+// threads and returns immediately.  f must be completely built, and the
+// caller must not hold its build lock.
+//
+// f can be called before the future is done: a call that races with the
+// worker compiling f waits for it, and a call made while f is still queued
+// compiles f on the calling thread.
+func (c *Context) CompileAsync(f *Function) *CompileFuture {
+	return c.Context.CompileAsync(f.Function, 0)
+}
+
+// CompileAsyncPriority is like CompileAsync, but queued functions with a
+// higher priority are compiled first.
+func (c *Context) CompileAsyncPriority(f *Function, priority int) *CompileFuture {
+	return c.Context.CompileAsync(f.Function, priority)
+}
@@ -0,0 +1,92 @@
+package jit
+
+import (
+	"unsafe"
+
+	"github.com/goccy/go-jit/internal/ccall"
+)
+
+// ValueID is a handle to a value of the function being built by a Builder.
+// The zero ValueID means that no value was created.
+type ValueID = ccall.ValueID
+
+// LabelID is a label reserved with Builder.NewLabel.
+type LabelID = ccall.LabelID
+
+// Builder emits instructions into a function like the methods of Function,
+// but values and labels are integer handles instead of *Value and *Label,
+// so building does not allocate per instruction.
+type Builder struct {
+	*ccall.Builder
+}
+
+func (f *Function) Builder() *Builder {
+	return &Builder{f.Function.Builder()}
+}
+
+func (b *Builder) Value(id ValueID) *Value {
+	return toValue(b.Builder.Value(id))
+}
+
+func (b *Builder) CreateValue(typ *Type) ValueID {
+	return b.Builder.CreateValue(typ.Type)
+}
+
+func (b *Builder) CreateNintConstant(typ *Type, constValue int) ValueID {
+	return b.Builder.CreateNintConstant(typ.Type, constValue)
+}
+
+func (b *Builder) CreateLongConstant(typ *Type, constValue int64) ValueID {
+	return b.Builder.CreateLongConstant(typ.Type, constValue)
+}
+
+func (b *Builder) CreateFloat32Value(constValue float32) ValueID {
+	return b.Builder.CreateFloat32Constant(ccall.TypeFloat32, constValue)
+}
+
+func (b *Builder) CreateFloat64Value(constValue float64) ValueID {
+	return b.Builder.CreateFloat64Constant(ccall.TypeFloat64, constValue)
+}
+
+func (b *Builder) LoadRelative(value ValueID, offset int, typ *Type) ValueID {
+	return b.Builder.LoadRelative(value, offset, typ.Type)
+}
+
+func (b *Builder) LoadElem(baseAddr, index ValueID, elemType *Type) ValueID {
+	return b.Builder.LoadElem(baseAddr, index, elemType.Type)
+}
+
+func (b *Builder) LoadElemAddress(baseAddr, index ValueID, elemType *Type) ValueID {
+	return b.Builder.LoadElemAddress(baseAddr, index, elemType.Type)
+}
+
+func (b *Builder) VLoad(baseAddr, index ValueID, typ *Type) ValueID {
+	return b.Builder.VLoad(baseAddr, index, typ.Type)
+}
+
+func (b *Builder) VBroadcast(value ValueID, typ *Type) ValueID {
+	return b.Builder.VBroadcast(value, typ.Type)
+}
+
+func (b *Builder) Convert(value ValueID, typ *Type, overflowCheck int) ValueID {
+	return b.Builder.Convert(value, typ.Type, overflowCheck)
+}
+
+func (b *Builder) Call(name string, fn *Function, args ...ValueID) ValueID {
+	return b.Builder.Call(name, fn.Function, args...)
+}
+
+func (b *Builder) CallIndirect(value ValueID, signature *Type, args ...ValueID) ValueID {
+	return b.Builder.CallIndirect(value, signature.Type, args...)
+}
+
+func (b *Builder) CallNative(name string, nativeFunc unsafe.Pointer, signature *Type, args ...ValueID) ValueID {
+	return b.Builder.CallNative(name, nativeFunc, signature.Type, args...)
+}
+
+// CallNativePure calls a native function that neither reads nor writes
+// memory that the function being built can access, so loads before the
+// call may be reused after it.
+func (b *Builder) CallNativePure(name string, nativeFunc unsafe.Pointer, signature *Type, args ...ValueID) ValueID {
+	return b.Builder.CallNativePure(name, nativeFunc, signature.Type, args...)
+}
@@ -1,6 +1,9 @@
 package jit
 
 import (
+	"runtime"
+	"unsafe"
+
 	"github.com/goccy/go-jit/internal/ccall"
 )
 
@@ -8,10 +11,40 @@ type Context struct {
 	*ccall.Context
 }
 
+// Instruction set extensions that the code generator may use for a
+// context.  They are detected when the context is created; CPUFeatures
+// reports them and SetCPUFeatures limits them.
+var (
+	CPUSSE3   = ccall.JIT_CPU_SSE3
+	CPUSSE4_1 = ccall.JIT_CPU_SSE4_1
+	CPUSSE4_2 = ccall.JIT_CPU_SSE4_2
+	CPUPOPCNT = ccall.JIT_CPU_POPCNT
+	CPULZCNT  = ccall.JIT_CPU_LZCNT
+	CPUBMI1   = ccall.JIT_CPU_BMI1
+	CPUBMI2   = ccall.JIT_CPU_BMI2
+	CPUAVX    = ccall.JIT_CPU_AVX
+	CPUAVX2   = ccall.JIT_CPU_AVX2
+	CPUFMA    = ccall.JIT_CPU_FMA
+)
+
 func NewContext() *Context {
 	return &Context{ccall.CreateContext()}
 }
 
+// NewDualMappedContext creates a context whose code cache is mapped
+// twice, executable at one address and writable at another, so that no
+// page is ever writable and executable at once.  It returns nil where
+// that is not supported, which is anywhere but x86-64 Linux.
+func NewDualMappedContext() *Context {
+	c := ccall.CreateContextWithOptions(map[int]uint{
+		ccall.JIT_OPTION_CACHE_DUAL_MAP: 1,
+	})
+	if c == nil {
+		return nil
+	}
+	return &Context{c}
+}
+
 func toContext(c *ccall.Context) *Context {
 	return &Context{c}
 }
@@ -20,16 +53,55 @@ func (c *Context) Close() {
 	c.Destroy()
 }
 
+// Build runs cb while holding the build lock of the context, which
+// excludes all other builders of the context.
 func (c *Context) Build(cb func(*Context) (*Function, error)) (*Function, error) {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
 	c.BuildStart()
+	defer c.BuildEnd()
 	fn, err := cb(c)
 	if err != nil {
 		return nil, err
 	}
-	c.BuildEnd()
 	return fn, nil
 }
 
+// EnableCompileCache makes functions that are built with the same
+// instructions, types and constants share the code of the first one that
+// was compiled, instead of being optimized and compiled again.  Hits and
+// misses are reported by CompileCacheStats.
+func (c *Context) EnableCompileCache() {
+	c.SetMetaNumeric(ccall.JIT_OPTION_COMPILE_CACHE, 1)
+}
+
+// EnableHugePages backs the pages that the code cache allocates from now
+// on with 2MB huge pages where the system supports them, so that a large
+// amount of generated code needs fewer iTLB entries.  NumHugePages reports
+// how many are in use.
+func (c *Context) EnableHugePages() {
+	c.SetMetaNumeric(ccall.JIT_OPTION_CACHE_HUGE_PAGES, 1)
+}
+
+// SetInlineLimit makes calls to functions with at most insns instructions
+// copy the instructions of the callee into the caller, so that they are
+// optimized together.  The callee must be compiled before the caller is
+// built, must not call other functions, and must not be recompilable or
+// evictable.  Zero, the default, disables inlining.
+func (c *Context) SetInlineLimit(insns uint) {
+	c.SetMetaNumeric(ccall.JIT_OPTION_INLINE_LIMIT, insns)
+}
+
+// FunctionFromPC returns the function whose compiled code contains pc,
+// or nil if there is none.  It does not lock the context.
+func (c *Context) FunctionFromPC(pc unsafe.Pointer) *Function {
+	f := c.Context.FunctionFromPC(pc)
+	if f == nil {
+		return nil
+	}
+	return toFunction(f)
+}
+
 func (c *Context) CreateFunction(argtypes Types, rtype *Type) *Function {
 	signature := CreateSignature(argtypes, rtype)
 	defer signature.Free()
@@ -0,0 +1,84 @@
+package jit
+
+import (
+	"errors"
+
+	"github.com/goccy/go-jit/internal/ccall"
+)
+
+var (
+	ErrELFCannotOpen = ccall.ErrELFCannotOpen
+	ErrELFNotELF     = ccall.ErrELFNotELF
+	ErrELFWrongArch  = ccall.ErrELFWrongArch
+	ErrELFBadFormat  = ccall.ErrELFBadFormat
+	ErrELFMemory     = ccall.ErrELFMemory
+	ErrELFUnresolved = errors.New("elf: unresolved symbols")
+	ErrELFNoSymbol   = errors.New("elf: symbol not found")
+)
+
+// ELFWriter saves compiled functions to an ELF binary, which can be loaded
+// by a later process with Context.LoadELF instead of compiling them again.
+type ELFWriter struct {
+	*ccall.ELFWriter
+}
+
+// NewELFWriter creates a writer for a binary called libraryName.
+func NewELFWriter(libraryName string) *ELFWriter {
+	w := ccall.CreateELFWriter(libraryName)
+	if w == nil {
+		return nil
+	}
+	return &ELFWriter{w}
+}
+
+// AddFunction adds the code of f and exports it as name.  f must be
+// compiled in a context that was set up with EnablePreCompile.  Calls
+// from f must be to other functions of the same binary or to native
+// functions called by name.
+func (w *ELFWriter) AddFunction(f *Function, name string) bool {
+	return w.ELFWriter.AddFunction(f.Function, name)
+}
+
+func (w *ELFWriter) Close() {
+	w.Destroy()
+}
+
+// ELFReader is an ELF binary that was loaded into a context.
+type ELFReader struct {
+	*ccall.ELFReader
+	ctx *Context
+}
+
+// EnablePreCompile makes the functions compiled in the context keep what
+// ELFWriter needs to save them.  It must be called before they are
+// compiled.
+func (c *Context) EnablePreCompile() {
+	c.SetMetaNumeric(ccall.JIT_OPTION_PRE_COMPILE, 1)
+}
+
+// LoadELF loads an ELF binary written by ELFWriter into the context and
+// resolves its references with the symbols registered on the context.
+// The binary is unloaded when the context is closed.
+func (c *Context) LoadELF(filename string) (*ELFReader, error) {
+	r, err := ccall.OpenELF(filename, 0)
+	if err != nil {
+		return nil, err
+	}
+	r.AddToContext(c.Context)
+	if !c.ResolveAll(false) {
+		return nil, ErrELFUnresolved
+	}
+	return &ELFReader{ELFReader: r, ctx: c}, nil
+}
+
+// Function returns a function with the given signature that runs the code
+// exported as name.
+func (r *ELFReader) Function(name string, argtypes Types, rtype *Type) (*Function, error) {
+	entry := r.Symbol(name)
+	if entry == nil {
+		return nil, ErrELFNoSymbol
+	}
+	f := r.ctx.CreateFunction(argtypes, rtype)
+	f.SetupEntry(entry)
+	return f, nil
+}
@@ -0,0 +1,21 @@
+package jit
+
+import (
+	"github.com/goccy/go-jit/internal/ccall"
+)
+
+// CompileEvictable builds f with build and compiles it, and allows the
+// code of f to be freed when the code cache of its context is full (see
+// Context.EnableEviction).  The next call after that runs build again and
+// compiles f on demand.
+//
+// build is called with the build lock of f held, so it must not lock f
+// itself.  The code of f may be evicted whenever another function of the
+// context is compiled, but its memory is only reused once no call into
+// compiled code that was running then is still running.  f must not be
+// called through its closure (see Function.ToClosure) from native code.
+func (f *Function) CompileEvictable(build func(*Function) error) error {
+	return f.Function.CompileEvictable(func(*ccall.Function) error {
+		return build(f)
+	})
+}
@@ -2,6 +2,7 @@ package jit
 
 import (
 	"io"
+	"runtime"
 	"unsafe"
 
 	"github.com/goccy/go-jit/internal/ccall"
@@ -291,6 +292,110 @@ func (f *Function) Sign(value1 *Value) *Value {
 	return toValue(f.Function.Sign(value1.Value))
 }
 
+func (f *Function) VLoad(baseAddr, index *Value, typ *Type) *Value {
+	return toValue(f.Function.VLoad(baseAddr.Value, index.Value, typ.Type))
+}
+
+func (f *Function) VStore(baseAddr, index, value *Value) bool {
+	return f.Function.VStore(baseAddr.Value, index.Value, value.Value)
+}
+
+func (f *Function) VAdd(value1, value2 *Value) *Value {
+	return toValue(f.Function.VAdd(value1.Value, value2.Value))
+}
+
+func (f *Function) VSub(value1, value2 *Value) *Value {
+	return toValue(f.Function.VSub(value1.Value, value2.Value))
+}
+
+func (f *Function) VMul(value1, value2 *Value) *Value {
+	return toValue(f.Function.VMul(value1.Value, value2.Value))
+}
+
+func (f *Function) VDiv(value1, value2 *Value) *Value {
+	return toValue(f.Function.VDiv(value1.Value, value2.Value))
+}
+
+func (f *Function) VMin(value1, value2 *Value) *Value {
+	return toValue(f.Function.VMin(value1.Value, value2.Value))
+}
+
+func (f *Function) VMax(value1, value2 *Value) *Value {
+	return toValue(f.Function.VMax(value1.Value, value2.Value))
+}
+
+func (f *Function) VAnd(value1, value2 *Value) *Value {
+	return toValue(f.Function.VAnd(value1.Value, value2.Value))
+}
+
+func (f *Function) VOr(value1, value2 *Value) *Value {
+	return toValue(f.Function.VOr(value1.Value, value2.Value))
+}
+
+func (f *Function) VXor(value1, value2 *Value) *Value {
+	return toValue(f.Function.VXor(value1.Value, value2.Value))
+}
+
+func (f *Function) VAndNot(value1, value2 *Value) *Value {
+	return toValue(f.Function.VAndNot(value1.Value, value2.Value))
+}
+
+func (f *Function) VEq(value1, value2 *Value) *Value {
+	return toValue(f.Function.VEq(value1.Value, value2.Value))
+}
+
+func (f *Function) VNe(value1, value2 *Value) *Value {
+	return toValue(f.Function.VNe(value1.Value, value2.Value))
+}
+
+func (f *Function) VLt(value1, value2 *Value) *Value {
+	return toValue(f.Function.VLt(value1.Value, value2.Value))
+}
+
+func (f *Function) VLe(value1, value2 *Value) *Value {
+	return toValue(f.Function.VLe(value1.Value, value2.Value))
+}
+
+func (f *Function) VGt(value1, value2 *Value) *Value {
+	return toValue(f.Function.VGt(value1.Value, value2.Value))
+}
+
+func (f *Function) VGe(value1, value2 *Value) *Value {
+	return toValue(f.Function.VGe(value1.Value, value2.Value))
+}
+
+func (f *Function) VSqrt(value *Value) *Value {
+	return toValue(f.Function.VSqrt(value.Value))
+}
+
+func (f *Function) VSelect(mask, value1, value2 *Value) *Value {
+	return toValue(f.Function.VSelect(mask.Value, value1.Value, value2.Value))
+}
+
+func (f *Function) VShuffle(value *Value, order int) *Value {
+	return toValue(f.Function.VShuffle(value.Value, order))
+}
+
+func (f *Function) VBroadcast(value *Value, typ *Type) *Value {
+	return toValue(f.Function.VBroadcast(value.Value, typ.Type))
+}
+
+func (f *Function) VExtract(value *Value, lane uint) *Value {
+	return toValue(f.Function.VExtract(value.Value, lane))
+}
+
+func (f *Function) VReduceAdd(value *Value) *Value {
+	return toValue(f.Function.VReduceAdd(value.Value))
+}
+
+func (f *Function) VReduceMin(value *Value) *Value {
+	return toValue(f.Function.VReduceMin(value.Value))
+}
+
+func (f *Function) VReduceMax(value *Value) *Value {
+	return toValue(f.Function.VReduceMax(value.Value))
+}
+
 func (f *Function) Branch(label *Label) bool {
 	return f.Function.Branch(label.Label)
 }
@@ -399,6 +504,17 @@ func (f *Function) Abandon() {
 	f.Function.Abandon()
 }
 
+// Build runs cb while holding the build lock of f.  Unlike Context.Build
+// it only excludes other builders of the same function, so functions of
+// one context can be built and compiled from several goroutines at once.
+func (f *Function) Build(cb func(*Function) error) error {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	f.BuildStart()
+	defer f.BuildEnd()
+	return cb(f)
+}
+
 func (f *Function) Context() *Context {
 	return toContext(f.Function.Context())
 }
@@ -558,3 +674,12 @@ func (f *Function) GoCall(fn interface{}, args Values) ([]*Value, error) {
 	}
 	return toValues(values), nil
 }
+
+// RunBatch calls f once for every row of the argument columns and stores the
+// return values into result.  Columns are slices of []int, []int64, []int32,
+// []float32 or []float64 matching the signature of f, one per parameter.
+// The whole batch is executed by a JIT-generated loop with a single cgo call.
+// For functions returning void, result must be nil.
+func (f *Function) RunBatch(result interface{}, args ...interface{}) error {
+	return f.Function.ApplyBatch(result, args)
+}
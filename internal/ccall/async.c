@@ -0,0 +1,63 @@
+#include "jit-internal.h"
+
+/*
+ * Background compilation from Go.
+ *
+ * A function queued for background compilation is already fully built,
+ * so its on-demand compiler has nothing left to do: returning OK makes
+ * "_jit_function_compile_on_demand" compile the pending body itself.  A
+ * thread that calls the function before a worker gets to it therefore
+ * compiles it on the spot, and a thread that calls it while a worker is
+ * compiling it waits on the build lock of the function and then uses the
+ * worker's code.
+ *
+ * The on-demand compiler is swapped under the build lock, which is also
+ * the lock that "_jit_function_compile_on_demand" reads it under.
+ */
+
+static int async_compile_on_demand(jit_function_t func)
+{
+	return JIT_RESULT_OK;
+}
+
+jit_on_demand_func async_queue(jit_nuint handle)
+{
+	jit_function_t func = (jit_function_t)handle;
+	jit_on_demand_func prev;
+
+	jit_function_build_start(func);
+	prev = func->on_demand;
+	if(!func->is_compiled)
+	{
+		func->on_demand = async_compile_on_demand;
+	}
+	jit_function_build_end(func);
+	return prev;
+}
+
+void async_unqueue(jit_nuint handle, jit_on_demand_func prev)
+{
+	jit_function_t func = (jit_function_t)handle;
+
+	jit_function_build_start(func);
+	if(func->on_demand == async_compile_on_demand)
+	{
+		func->on_demand = prev;
+	}
+	jit_function_build_end(func);
+}
+
+int async_compile(jit_nuint handle, jit_on_demand_func prev)
+{
+	jit_function_t func = (jit_function_t)handle;
+	int result;
+
+	jit_function_build_start(func);
+	if(func->on_demand == async_compile_on_demand)
+	{
+		func->on_demand = prev;
+	}
+	result = jit_compile(func);
+	jit_function_build_end(func);
+	return result;
+}
@@ -0,0 +1,233 @@
+package ccall
+
+/*
+#cgo CFLAGS: -I../
+#cgo CFLAGS: -Iinclude
+
+#include <jit/jit.h>
+
+extern jit_on_demand_func async_queue(jit_nuint);
+extern void async_unqueue(jit_nuint, jit_on_demand_func);
+extern int async_compile(jit_nuint, jit_on_demand_func);
+*/
+import "C"
+import (
+	"container/heap"
+	"errors"
+	"runtime"
+	"sync"
+)
+
+var (
+	ErrCompileCanceled = errors.New("compile: canceled before it started")
+	ErrCompileFailed   = errors.New("compile: failed to compile function")
+)
+
+// CompileFuture is the result of a background compilation.
+type CompileFuture struct {
+	f        *Function
+	q        *compileQueue
+	priority int
+	seq      uint64
+	index    int
+	prev     C.jit_on_demand_func
+	rebuild  func(*Function) error
+	done     chan struct{}
+	err      error
+}
+
+// Done returns a channel that is closed when the compilation has finished
+// or was canceled.
+func (cf *CompileFuture) Done() <-chan struct{} {
+	return cf.done
+}
+
+// Wait blocks until the compilation has finished and returns its error.
+func (cf *CompileFuture) Wait() error {
+	<-cf.done
+	return cf.err
+}
+
+// Cancel removes the function from the queue if no worker has started to
+// compile it yet, and reports whether it did.  A canceled function is left
+// uncompiled.
+func (cf *CompileFuture) Cancel() bool {
+	q := cf.q
+	q.mu.Lock()
+	defer q.mu.Unlock()
+	if cf.index < 0 {
+		return false
+	}
+	heap.Remove(&q.jobs, cf.index)
+	C.async_unqueue(cf.f.handle(), cf.prev)
+	cf.finish(ErrCompileCanceled)
+	return true
+}
+
+func (cf *CompileFuture) finish(err error) {
+	cf.err = err
+	close(cf.done)
+}
+
+// compileJobs orders the queued compilations by priority, then by the
+// order in which they were queued.
+type compileJobs []*CompileFuture
+
+func (h compileJobs) Len() int { return len(h) }
+
+func (h compileJobs) Less(i, j int) bool {
+	if h[i].priority != h[j].priority {
+		return h[i].priority > h[j].priority
+	}
+	return h[i].seq < h[j].seq
+}
+
+func (h compileJobs) Swap(i, j int) {
+	h[i], h[j] = h[j], h[i]
+	h[i].index = i
+	h[j].index = j
+}
+
+func (h *compileJobs) Push(x interface{}) {
+	cf := x.(*CompileFuture)
+	cf.index = len(*h)
+	*h = append(*h, cf)
+}
+
+func (h *compileJobs) Pop() interface{} {
+	old := *h
+	cf := old[len(old)-1]
+	old[len(old)-1] = nil
+	cf.index = -1
+	*h = old[:len(old)-1]
+	return cf
+}
+
+// compileQueue is the background compiler of a context.  Workers are
+// started on demand up to maxWorkers, and each one keeps its own OS thread
+// so that it writes code to its own region of the code cache.
+type compileQueue struct {
+	mu              sync.Mutex
+	cond            sync.Cond
+	jobs            compileJobs
+	seq             uint64
+	workers         int
+	maxWorkers      int
+	tierUpThreshold uint
+	closed          bool
+	wg              sync.WaitGroup
+}
+
+var (
+	compilersMu  sync.Mutex
+	compilersMap = map[C.jit_context_t]*compileQueue{}
+)
+
+func contextCompiler(ctx C.jit_context_t) *compileQueue {
+	compilersMu.Lock()
+	defer compilersMu.Unlock()
+	q, ok := compilersMap[ctx]
+	if !ok {
+		q = &compileQueue{maxWorkers: runtime.GOMAXPROCS(0), tierUpThreshold: defaultTierUpThreshold}
+		q.cond.L = &q.mu
+		compilersMap[ctx] = q
+	}
+	return q
+}
+
+// SetCompileWorkers sets the number of threads that compile the functions
+// queued with CompileAsync.  It defaults to GOMAXPROCS.
+func (c *Context) SetCompileWorkers(n int) {
+	if n < 1 {
+		n = 1
+	}
+	q := contextCompiler(c.c)
+	q.mu.Lock()
+	q.maxWorkers = n
+	q.mu.Unlock()
+	q.cond.Broadcast()
+}
+
+// CompileAsync queues f to be compiled by a background worker.  Functions
+// with a higher priority are compiled first.  f must be completely built,
+// and its build lock must not be held by the caller.
+//
+// f can be called before the compilation has finished: if a worker is
+// compiling it, the caller waits for the result, and otherwise the caller
+// compiles it right away.
+func (c *Context) CompileAsync(f *Function, priority int) *CompileFuture {
+	return contextCompiler(c.c).push(f, priority, nil)
+}
+
+func (q *compileQueue) push(f *Function, priority int, rebuild func(*Function) error) *CompileFuture {
+	cf := &CompileFuture{f: f, q: q, priority: priority, index: -1, rebuild: rebuild, done: make(chan struct{})}
+	q.mu.Lock()
+	defer q.mu.Unlock()
+	if q.closed {
+		cf.finish(ErrCompileCanceled)
+		return cf
+	}
+	cf.prev = C.async_queue(f.handle())
+	cf.seq = q.seq
+	q.seq++
+	heap.Push(&q.jobs, cf)
+	if q.workers < q.maxWorkers && q.workers < len(q.jobs) {
+		q.workers++
+		q.wg.Add(1)
+		go q.work()
+	} else {
+		q.cond.Signal()
+	}
+	return cf
+}
+
+func (q *compileQueue) work() {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	defer q.wg.Done()
+	q.mu.Lock()
+	for {
+		for len(q.jobs) == 0 && !q.closed && q.workers <= q.maxWorkers {
+			q.cond.Wait()
+		}
+		if len(q.jobs) == 0 || q.workers > q.maxWorkers {
+			q.workers--
+			q.mu.Unlock()
+			return
+		}
+		cf := heap.Pop(&q.jobs).(*CompileFuture)
+		q.mu.Unlock()
+
+		var err error
+		if cf.rebuild != nil {
+			err = cf.f.promote(cf.rebuild)
+		} else if C.async_compile(cf.f.handle(), cf.prev) != C.JIT_RESULT_OK {
+			err = ErrCompileFailed
+		}
+		cf.finish(err)
+
+		q.mu.Lock()
+	}
+}
+
+// releaseCompiler cancels the queued compilations of the context and waits
+// for the running ones to finish.
+func releaseCompiler(ctx C.jit_context_t) {
+	compilersMu.Lock()
+	q, ok := compilersMap[ctx]
+	delete(compilersMap, ctx)
+	compilersMu.Unlock()
+	if !ok {
+		return
+	}
+	q.mu.Lock()
+	q.closed = true
+	for len(q.jobs) > 0 {
+		cf := heap.Pop(&q.jobs).(*CompileFuture)
+		C.async_unqueue(cf.f.handle(), cf.prev)
+		cf.finish(ErrCompileCanceled)
+	}
+	q.mu.Unlock()
+	q.cond.Broadcast()
+	q.wg.Wait()
+}
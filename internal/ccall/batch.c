@@ -0,0 +1,150 @@
+#include "jit-internal.h"
+
+/*
+ * Batch execution of compiled functions from Go.
+ *
+ * A batch driver is a JIT function that applies a function to every row
+ * of a set of columns:
+ *
+ *	void driver(void **columns, void *result, jit_nint rows)
+ *	{
+ *		for(i = 0; i < rows; ++i)
+ *			result[i] = func(columns[0][i], columns[1][i], ...);
+ *	}
+ *
+ * so that a whole batch runs with a single transition from Go.  The driver
+ * is built on first use and kept in the metadata of the function.
+ */
+
+static jit_function_t build_batch_driver(jit_function_t func)
+{
+	jit_type_t signature = func->signature;
+	jit_type_t rtype = jit_type_get_return(signature);
+	unsigned int num_params = jit_type_num_params(signature);
+	jit_type_t driver_params[3];
+	jit_type_t driver_signature;
+	jit_function_t driver;
+	jit_value_t columns, result, rows, index, value, one;
+	jit_value_t *column_ptrs, *args;
+	jit_label_t loop_label = jit_label_undefined;
+	jit_label_t check_label = jit_label_undefined;
+	unsigned int param;
+
+	driver_params[0] = jit_type_void_ptr;
+	driver_params[1] = jit_type_void_ptr;
+	driver_params[2] = jit_type_nint;
+	driver_signature = jit_type_create_signature
+		(jit_abi_cdecl, jit_type_void, driver_params, 3, 1);
+	if(!driver_signature)
+	{
+		return 0;
+	}
+	driver = jit_function_create(func->context, driver_signature);
+	jit_type_free(driver_signature);
+	if(!driver)
+	{
+		return 0;
+	}
+
+	column_ptrs = jit_malloc(sizeof(jit_value_t) * 2 * (num_params + 1));
+	if(!column_ptrs)
+	{
+		jit_function_abandon(driver);
+		return 0;
+	}
+	args = column_ptrs + num_params + 1;
+
+	columns = jit_value_get_param(driver, 0);
+	result = jit_value_get_param(driver, 1);
+	rows = jit_value_get_param(driver, 2);
+
+	/* Load the column base pointers once, outside of the loop */
+	for(param = 0; param < num_params; ++param)
+	{
+		column_ptrs[param] = jit_insn_load_relative
+			(driver, columns, (jit_nint)(param * sizeof(void *)),
+			 jit_type_void_ptr);
+	}
+
+	index = jit_value_create(driver, jit_type_nint);
+	one = jit_value_create_nint_constant(driver, jit_type_nint, 1);
+	jit_insn_store(driver, index,
+		       jit_value_create_nint_constant(driver, jit_type_nint, 0));
+	jit_insn_branch(driver, &check_label);
+
+	jit_insn_label(driver, &loop_label);
+	for(param = 0; param < num_params; ++param)
+	{
+		args[param] = jit_insn_load_elem
+			(driver, column_ptrs[param], index,
+			 jit_type_get_param(signature, param));
+	}
+	value = jit_insn_call(driver, 0, func, signature, args, num_params, 0);
+	if(jit_type_get_kind(rtype) != JIT_TYPE_VOID)
+	{
+		jit_insn_store_elem(driver, result, index, value);
+	}
+	jit_insn_store(driver, index, jit_insn_add(driver, index, one));
+
+	jit_insn_label(driver, &check_label);
+	jit_insn_branch_if(driver, jit_insn_lt(driver, index, rows), &loop_label);
+	jit_insn_default_return(driver);
+	jit_free(column_ptrs);
+
+	if(!jit_function_compile(driver))
+	{
+		jit_function_abandon(driver);
+		return 0;
+	}
+	return driver;
+}
+
+static jit_function_t batch_driver(jit_function_t func)
+{
+	jit_function_t driver;
+
+	driver = (jit_function_t)jit_function_get_meta(func, JIT_META_BATCH_DRIVER);
+	if(driver)
+	{
+		return driver;
+	}
+
+	jit_function_build_start(func);
+	driver = (jit_function_t)jit_function_get_meta(func, JIT_META_BATCH_DRIVER);
+	if(!driver)
+	{
+		driver = build_batch_driver(func);
+		if(driver && !jit_function_set_meta(func, JIT_META_BATCH_DRIVER, driver, 0, 0))
+		{
+			driver = 0;
+		}
+	}
+	jit_function_build_end(func);
+	return driver;
+}
+
+/*
+ * Run "func" over "rows" rows.  "columns" points to one array per
+ * parameter, and "result" to an array that receives the return values.
+ * Returns zero if the driver could not be built or an exception occurred.
+ */
+int batch_apply(jit_nuint handle, jit_nuint columns, jit_nuint result, jit_nint rows)
+{
+	jit_function_t func = (jit_function_t)handle;
+	jit_function_t driver;
+	void *args[3];
+
+	if(!func || func->nested_parent)
+	{
+		return 0;
+	}
+	driver = batch_driver(func);
+	if(!driver)
+	{
+		return 0;
+	}
+	args[0] = &columns;
+	args[1] = &result;
+	args[2] = &rows;
+	return jit_function_apply(driver, args, 0);
+}
@@ -0,0 +1,112 @@
+package ccall
+
+/*
+#cgo CFLAGS: -I../
+#cgo CFLAGS: -Iinclude
+
+#include <stdlib.h>
+#include <jit/jit.h>
+
+extern int batch_apply(jit_nuint, jit_nuint, jit_nuint, jit_nint);
+*/
+import "C"
+import (
+	"errors"
+	"runtime"
+	"unsafe"
+)
+
+var (
+	ErrBatchArgs   = errors.New("batch: number of columns does not match the signature")
+	ErrBatchType   = errors.New("batch: column type does not match the signature")
+	ErrBatchLength = errors.New("batch: column is shorter than the result")
+	ErrBatchFailed = errors.New("batch: exception occurred while running the batch")
+)
+
+// column returns the data pointer and length of a column slice, and whether
+// its element type has the same representation as typ.
+func column(col interface{}, typ *Type) (unsafe.Pointer, int, bool) {
+	kind := typ.Normalize().Kind()
+	var (
+		ptr unsafe.Pointer
+		n   int
+		ok  bool
+	)
+	switch c := col.(type) {
+	case []int:
+		n, ok = len(c), (kind == JIT_TYPE_LONG || kind == JIT_TYPE_ULONG) && unsafe.Sizeof(int(0)) == 8
+		if n > 0 {
+			ptr = unsafe.Pointer(&c[0])
+		}
+	case []int64:
+		n, ok = len(c), kind == JIT_TYPE_LONG || kind == JIT_TYPE_ULONG
+		if n > 0 {
+			ptr = unsafe.Pointer(&c[0])
+		}
+	case []int32:
+		n, ok = len(c), kind == JIT_TYPE_INT || kind == JIT_TYPE_UINT
+		if n > 0 {
+			ptr = unsafe.Pointer(&c[0])
+		}
+	case []float32:
+		n, ok = len(c), kind == JIT_TYPE_FLOAT32
+		if n > 0 {
+			ptr = unsafe.Pointer(&c[0])
+		}
+	case []float64:
+		n, ok = len(c), kind == JIT_TYPE_FLOAT64
+		if n > 0 {
+			ptr = unsafe.Pointer(&c[0])
+		}
+	}
+	return ptr, n, ok
+}
+
+// ApplyBatch calls the function once per row of the argument columns and
+// stores the return values into result.  The rows are processed by a JIT
+// driver loop, so the whole batch costs a single cgo call.
+func (f *Function) ApplyBatch(result interface{}, args []interface{}) error {
+	sig := f.Signature()
+	if uint(len(args)) != sig.NumParams() {
+		return ErrBatchArgs
+	}
+	rows := -1
+	var resultPtr unsafe.Pointer
+	if rtype := sig.Return(); rtype.Kind() != JIT_TYPE_VOID {
+		ptr, n, ok := column(result, rtype)
+		if !ok {
+			return ErrBatchType
+		}
+		resultPtr, rows = ptr, n
+	}
+	for idx, arg := range args {
+		_, n, ok := column(arg, sig.Param(uint(idx)))
+		if !ok {
+			return ErrBatchType
+		}
+		if rows < 0 {
+			rows = n
+		}
+		if n < rows {
+			return ErrBatchLength
+		}
+	}
+	if rows <= 0 {
+		return nil
+	}
+
+	columns := C.malloc(C.size_t(len(args)+1) * C.size_t(ptrsize))
+	defer C.free(columns)
+	ptrs := (*[1 << 20]uintptr)(columns)[: len(args)+1 : len(args)+1]
+	for idx, arg := range args {
+		ptr, _, _ := column(arg, sig.Param(uint(idx)))
+		ptrs[idx] = uintptr(ptr)
+	}
+	ok := C.batch_apply(f.handle(), C.jit_nuint(uintptr(columns)), C.jit_nuint(uintptr(resultPtr)), C.jit_nint(rows))
+	runtime.KeepAlive(args)
+	runtime.KeepAlive(result)
+	if ok == 0 {
+		return ErrBatchFailed
+	}
+	return nil
+}
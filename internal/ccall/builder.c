@@ -0,0 +1,347 @@
+#include "jit-internal.h"
+#include "builder.h"
+
+/*
+ * Handle based instruction builder for Go.
+ *
+ * Every helper takes the function, values, types and labels as integers
+ * and returns the new value as an integer, so that cgo neither checks nor
+ * heap allocates anything on the way in or out.  Argument vectors for
+ * calls and jump tables are passed in the scratch buffer of the function,
+ * which is kept in its metadata and released together with the function.
+ */
+
+static void free_scratch(void *data)
+{
+	build_scratch *scratch = (build_scratch *)data;
+
+	jit_free(scratch->args);
+	jit_free(scratch);
+}
+
+build_scratch *build_get_scratch(jit_nuint func)
+{
+	build_scratch *scratch;
+
+	scratch = (build_scratch *)jit_function_get_meta
+		((jit_function_t)func, JIT_META_BUILD_SCRATCH);
+	if(scratch)
+	{
+		return scratch;
+	}
+	scratch = jit_cnew(build_scratch);
+	if(!scratch)
+	{
+		return 0;
+	}
+	if(!jit_function_set_meta((jit_function_t)func, JIT_META_BUILD_SCRATCH,
+				  scratch, free_scratch, 0))
+	{
+		jit_free(scratch);
+		return 0;
+	}
+	return scratch;
+}
+
+int build_grow_scratch(build_scratch *scratch, unsigned int size)
+{
+	jit_nuint *args;
+
+	if(size <= scratch->size)
+	{
+		return 1;
+	}
+	if(size < scratch->size * 2)
+	{
+		size = scratch->size * 2;
+	}
+	args = jit_realloc(scratch->args, sizeof(jit_nuint) * size);
+	if(!args)
+	{
+		return 0;
+	}
+	scratch->args = args;
+	scratch->size = size;
+	return 1;
+}
+
+#define F	((jit_function_t)func)
+#define V(x)	((jit_value_t)(x))
+#define T(x)	((jit_type_t)(x))
+
+#define BUILD_UNARY(name)						\
+jit_nuint build_##name(jit_nuint func, jit_nuint value1)		\
+{									\
+	return (jit_nuint)jit_insn_##name(F, V(value1));		\
+}
+
+#define BUILD_BINARY(name)						\
+jit_nuint build_##name(jit_nuint func, jit_nuint value1, jit_nuint value2) \
+{									\
+	return (jit_nuint)jit_insn_##name(F, V(value1), V(value2));	\
+}
+
+jit_nuint build_param(jit_nuint func, unsigned int param)
+{
+	return (jit_nuint)jit_value_get_param(F, param);
+}
+
+jit_nuint build_create_value(jit_nuint func, jit_nuint type)
+{
+	return (jit_nuint)jit_value_create(F, T(type));
+}
+
+jit_nuint build_nint_constant(jit_nuint func, jit_nuint type, jit_nint value)
+{
+	return (jit_nuint)jit_value_create_nint_constant(F, T(type), value);
+}
+
+jit_nuint build_long_constant(jit_nuint func, jit_nuint type, jit_long value)
+{
+	return (jit_nuint)jit_value_create_long_constant(F, T(type), value);
+}
+
+jit_nuint build_float32_constant(jit_nuint func, jit_nuint type, jit_float32 value)
+{
+	return (jit_nuint)jit_value_create_float32_constant(F, T(type), value);
+}
+
+jit_nuint build_float64_constant(jit_nuint func, jit_nuint type, jit_float64 value)
+{
+	return (jit_nuint)jit_value_create_float64_constant(F, T(type), value);
+}
+
+int build_store(jit_nuint func, jit_nuint dest, jit_nuint value)
+{
+	return jit_insn_store(F, V(dest), V(value));
+}
+
+jit_nuint build_load_relative(jit_nuint func, jit_nuint value, jit_nint offset, jit_nuint type)
+{
+	return (jit_nuint)jit_insn_load_relative(F, V(value), offset, T(type));
+}
+
+int build_store_relative(jit_nuint func, jit_nuint dest, jit_nint offset, jit_nuint value)
+{
+	return jit_insn_store_relative(F, V(dest), offset, V(value));
+}
+
+jit_nuint build_add_relative(jit_nuint func, jit_nuint value, jit_nint offset)
+{
+	return (jit_nuint)jit_insn_add_relative(F, V(value), offset);
+}
+
+jit_nuint build_load_elem(jit_nuint func, jit_nuint base, jit_nuint index, jit_nuint type)
+{
+	return (jit_nuint)jit_insn_load_elem(F, V(base), V(index), T(type));
+}
+
+jit_nuint build_load_elem_address(jit_nuint func, jit_nuint base, jit_nuint index, jit_nuint type)
+{
+	return (jit_nuint)jit_insn_load_elem_address(F, V(base), V(index), T(type));
+}
+
+int build_store_elem(jit_nuint func, jit_nuint base, jit_nuint index, jit_nuint value)
+{
+	return jit_insn_store_elem(F, V(base), V(index), V(value));
+}
+
+int build_check_null(jit_nuint func, jit_nuint value)
+{
+	return jit_insn_check_null(F, V(value));
+}
+
+jit_nuint build_convert(jit_nuint func, jit_nuint value, jit_nuint type, int overflow_check)
+{
+	return (jit_nuint)jit_insn_convert(F, V(value), T(type), overflow_check);
+}
+
+BUILD_UNARY(load)
+BUILD_UNARY(dup)
+BUILD_UNARY(address_of)
+BUILD_UNARY(neg)
+BUILD_UNARY(not)
+BUILD_UNARY(to_bool)
+BUILD_UNARY(to_not_bool)
+BUILD_UNARY(acos)
+BUILD_UNARY(asin)
+BUILD_UNARY(atan)
+BUILD_UNARY(ceil)
+BUILD_UNARY(cos)
+BUILD_UNARY(cosh)
+BUILD_UNARY(exp)
+BUILD_UNARY(floor)
+BUILD_UNARY(log)
+BUILD_UNARY(log10)
+BUILD_UNARY(rint)
+BUILD_UNARY(round)
+BUILD_UNARY(sin)
+BUILD_UNARY(sinh)
+BUILD_UNARY(sqrt)
+BUILD_UNARY(tan)
+BUILD_UNARY(tanh)
+BUILD_UNARY(trunc)
+BUILD_UNARY(is_nan)
+BUILD_UNARY(is_finite)
+BUILD_UNARY(is_inf)
+BUILD_UNARY(abs)
+BUILD_UNARY(sign)
+
+BUILD_BINARY(add)
+BUILD_BINARY(add_ovf)
+BUILD_BINARY(sub)
+BUILD_BINARY(sub_ovf)
+BUILD_BINARY(mul)
+BUILD_BINARY(mul_ovf)
+BUILD_BINARY(div)
+BUILD_BINARY(rem)
+BUILD_BINARY(rem_ieee)
+BUILD_BINARY(and)
+BUILD_BINARY(or)
+BUILD_BINARY(xor)
+BUILD_BINARY(shl)
+BUILD_BINARY(shr)
+BUILD_BINARY(ushr)
+BUILD_BINARY(sshr)
+BUILD_BINARY(eq)
+BUILD_BINARY(ne)
+BUILD_BINARY(lt)
+BUILD_BINARY(le)
+BUILD_BINARY(gt)
+BUILD_BINARY(ge)
+BUILD_BINARY(cmpl)
+BUILD_BINARY(cmpg)
+BUILD_BINARY(atan2)
+BUILD_BINARY(pow)
+BUILD_BINARY(min)
+BUILD_BINARY(max)
+
+BUILD_UNARY(vsqrt)
+BUILD_UNARY(vreduce_add)
+BUILD_UNARY(vreduce_min)
+BUILD_UNARY(vreduce_max)
+
+BUILD_BINARY(vadd)
+BUILD_BINARY(vsub)
+BUILD_BINARY(vmul)
+BUILD_BINARY(vdiv)
+BUILD_BINARY(vmin)
+BUILD_BINARY(vmax)
+BUILD_BINARY(vand)
+BUILD_BINARY(vor)
+BUILD_BINARY(vxor)
+BUILD_BINARY(vandnot)
+BUILD_BINARY(veq)
+BUILD_BINARY(vne)
+BUILD_BINARY(vlt)
+BUILD_BINARY(vle)
+BUILD_BINARY(vgt)
+BUILD_BINARY(vge)
+
+jit_nuint build_vload(jit_nuint func, jit_nuint base, jit_nuint index, jit_nuint type)
+{
+	return (jit_nuint)jit_insn_vload(F, V(base), V(index), T(type));
+}
+
+int build_vstore(jit_nuint func, jit_nuint base, jit_nuint index, jit_nuint value)
+{
+	return jit_insn_vstore(F, V(base), V(index), V(value));
+}
+
+jit_nuint build_vselect(jit_nuint func, jit_nuint mask, jit_nuint value1, jit_nuint value2)
+{
+	return (jit_nuint)jit_insn_vselect(F, V(mask), V(value1), V(value2));
+}
+
+jit_nuint build_vshuffle(jit_nuint func, jit_nuint value, jit_nint order)
+{
+	return (jit_nuint)jit_insn_vshuffle(F, V(value), order);
+}
+
+jit_nuint build_vbroadcast(jit_nuint func, jit_nuint value, jit_nuint type)
+{
+	return (jit_nuint)jit_insn_vbroadcast(F, V(value), T(type));
+}
+
+jit_nuint build_vextract(jit_nuint func, jit_nuint value, unsigned int lane)
+{
+	return (jit_nuint)jit_insn_vextract(F, V(value), lane);
+}
+
+/*
+ * Labels are reserved up front with "jit_function_reserve_label", so the
+ * instruction functions never have to write a new label number back.
+ */
+
+jit_nuint build_reserve_label(jit_nuint func)
+{
+	return (jit_nuint)jit_function_reserve_label(F);
+}
+
+int build_label(jit_nuint func, jit_nuint label)
+{
+	jit_label_t l = (jit_label_t)label;
+	return jit_insn_label(F, &l);
+}
+
+int build_branch(jit_nuint func, jit_nuint label)
+{
+	jit_label_t l = (jit_label_t)label;
+	return jit_insn_branch(F, &l);
+}
+
+int build_branch_if(jit_nuint func, jit_nuint value, jit_nuint label)
+{
+	jit_label_t l = (jit_label_t)label;
+	return jit_insn_branch_if(F, V(value), &l);
+}
+
+int build_branch_if_not(jit_nuint func, jit_nuint value, jit_nuint label)
+{
+	jit_label_t l = (jit_label_t)label;
+	return jit_insn_branch_if_not(F, V(value), &l);
+}
+
+int build_jump_table(jit_nuint func, jit_nuint value, jit_nuint labels, unsigned int num_labels)
+{
+	return jit_insn_jump_table(F, V(value), (jit_label_t *)labels, num_labels);
+}
+
+jit_nuint build_call(jit_nuint func, jit_nuint name, jit_nuint callee,
+		     jit_nuint args, unsigned int num_args, int flags)
+{
+	return (jit_nuint)jit_insn_call
+		(F, (const char *)name, (jit_function_t)callee, 0,
+		 (jit_value_t *)args, num_args, flags);
+}
+
+jit_nuint build_call_indirect(jit_nuint func, jit_nuint value, jit_nuint signature,
+			      jit_nuint args, unsigned int num_args, int flags)
+{
+	return (jit_nuint)jit_insn_call_indirect
+		(F, V(value), T(signature), (jit_value_t *)args, num_args, flags);
+}
+
+jit_nuint build_call_native(jit_nuint func, jit_nuint name, jit_nuint native_func,
+			    jit_nuint signature, jit_nuint args,
+			    unsigned int num_args, int flags)
+{
+	return (jit_nuint)jit_insn_call_native
+		(F, (const char *)name, (void *)native_func, T(signature),
+		 (jit_value_t *)args, num_args, flags);
+}
+
+int build_return(jit_nuint func, jit_nuint value)
+{
+	return jit_insn_return(F, V(value));
+}
+
+int build_throw(jit_nuint func, jit_nuint value)
+{
+	return jit_insn_throw(F, V(value));
+}
+
+int build_default_return(jit_nuint func)
+{
+	return jit_insn_default_return(F);
+}
@@ -0,0 +1,723 @@
+package ccall
+
+/*
+#cgo CFLAGS: -I../
+#cgo CFLAGS: -Iinclude
+
+#include <stdlib.h>
+#include <jit/jit.h>
+#include "builder.h"
+
+extern jit_nuint build_param(jit_nuint, unsigned int);
+extern jit_nuint build_create_value(jit_nuint, jit_nuint);
+extern jit_nuint build_nint_constant(jit_nuint, jit_nuint, jit_nint);
+extern jit_nuint build_long_constant(jit_nuint, jit_nuint, jit_long);
+extern jit_nuint build_float32_constant(jit_nuint, jit_nuint, jit_float32);
+extern jit_nuint build_float64_constant(jit_nuint, jit_nuint, jit_float64);
+extern int build_store(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_load_relative(jit_nuint, jit_nuint, jit_nint, jit_nuint);
+extern int build_store_relative(jit_nuint, jit_nuint, jit_nint, jit_nuint);
+extern jit_nuint build_add_relative(jit_nuint, jit_nuint, jit_nint);
+extern jit_nuint build_load_elem(jit_nuint, jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_load_elem_address(jit_nuint, jit_nuint, jit_nuint, jit_nuint);
+extern int build_store_elem(jit_nuint, jit_nuint, jit_nuint, jit_nuint);
+extern int build_check_null(jit_nuint, jit_nuint);
+extern jit_nuint build_convert(jit_nuint, jit_nuint, jit_nuint, int);
+extern jit_nuint build_load(jit_nuint, jit_nuint);
+extern jit_nuint build_dup(jit_nuint, jit_nuint);
+extern jit_nuint build_address_of(jit_nuint, jit_nuint);
+extern jit_nuint build_neg(jit_nuint, jit_nuint);
+extern jit_nuint build_not(jit_nuint, jit_nuint);
+extern jit_nuint build_to_bool(jit_nuint, jit_nuint);
+extern jit_nuint build_to_not_bool(jit_nuint, jit_nuint);
+extern jit_nuint build_acos(jit_nuint, jit_nuint);
+extern jit_nuint build_asin(jit_nuint, jit_nuint);
+extern jit_nuint build_atan(jit_nuint, jit_nuint);
+extern jit_nuint build_ceil(jit_nuint, jit_nuint);
+extern jit_nuint build_cos(jit_nuint, jit_nuint);
+extern jit_nuint build_cosh(jit_nuint, jit_nuint);
+extern jit_nuint build_exp(jit_nuint, jit_nuint);
+extern jit_nuint build_floor(jit_nuint, jit_nuint);
+extern jit_nuint build_log(jit_nuint, jit_nuint);
+extern jit_nuint build_log10(jit_nuint, jit_nuint);
+extern jit_nuint build_rint(jit_nuint, jit_nuint);
+extern jit_nuint build_round(jit_nuint, jit_nuint);
+extern jit_nuint build_sin(jit_nuint, jit_nuint);
+extern jit_nuint build_sinh(jit_nuint, jit_nuint);
+extern jit_nuint build_sqrt(jit_nuint, jit_nuint);
+extern jit_nuint build_tan(jit_nuint, jit_nuint);
+extern jit_nuint build_tanh(jit_nuint, jit_nuint);
+extern jit_nuint build_trunc(jit_nuint, jit_nuint);
+extern jit_nuint build_is_nan(jit_nuint, jit_nuint);
+extern jit_nuint build_is_finite(jit_nuint, jit_nuint);
+extern jit_nuint build_is_inf(jit_nuint, jit_nuint);
+extern jit_nuint build_abs(jit_nuint, jit_nuint);
+extern jit_nuint build_sign(jit_nuint, jit_nuint);
+extern jit_nuint build_add(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_add_ovf(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_sub(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_sub_ovf(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_mul(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_mul_ovf(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_div(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_rem(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_rem_ieee(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_and(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_or(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_xor(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_shl(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_shr(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_ushr(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_sshr(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_eq(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_ne(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_lt(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_le(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_gt(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_ge(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_cmpl(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_cmpg(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_atan2(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_pow(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_min(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_max(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vsqrt(jit_nuint, jit_nuint);
+extern jit_nuint build_vreduce_add(jit_nuint, jit_nuint);
+extern jit_nuint build_vreduce_min(jit_nuint, jit_nuint);
+extern jit_nuint build_vreduce_max(jit_nuint, jit_nuint);
+extern jit_nuint build_vadd(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vsub(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vmul(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vdiv(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vmin(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vmax(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vand(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vor(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vxor(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vandnot(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_veq(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vne(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vlt(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vle(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vgt(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vge(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vload(jit_nuint, jit_nuint, jit_nuint, jit_nuint);
+extern int build_vstore(jit_nuint, jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vselect(jit_nuint, jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vshuffle(jit_nuint, jit_nuint, jit_nint);
+extern jit_nuint build_vbroadcast(jit_nuint, jit_nuint, jit_nuint);
+extern jit_nuint build_vextract(jit_nuint, jit_nuint, unsigned int);
+extern jit_nuint build_reserve_label(jit_nuint);
+extern int build_label(jit_nuint, jit_nuint);
+extern int build_branch(jit_nuint, jit_nuint);
+extern int build_branch_if(jit_nuint, jit_nuint, jit_nuint);
+extern int build_branch_if_not(jit_nuint, jit_nuint, jit_nuint);
+extern int build_jump_table(jit_nuint, jit_nuint, jit_nuint, unsigned int);
+extern jit_nuint build_call(jit_nuint, jit_nuint, jit_nuint, jit_nuint, unsigned int, int);
+extern jit_nuint build_call_indirect(jit_nuint, jit_nuint, jit_nuint, jit_nuint, unsigned int, int);
+extern jit_nuint build_call_native(jit_nuint, jit_nuint, jit_nuint, jit_nuint, jit_nuint, unsigned int, int);
+extern int build_return(jit_nuint, jit_nuint);
+extern int build_throw(jit_nuint, jit_nuint);
+extern int build_default_return(jit_nuint);
+*/
+import "C"
+import (
+	"sync"
+	"unsafe"
+)
+
+// ValueID is a handle to a value of the function being built.
+// The zero ValueID means that no value was created.
+type ValueID uintptr
+
+// LabelID is a label reserved with Builder.NewLabel.
+type LabelID uintptr
+
+// Builder emits instructions like the methods of Function, but takes and
+// returns values and labels as integer handles.  Nothing is allocated on
+// the Go heap per instruction: handles are passed to C as integers,
+// argument vectors are copied into a scratch buffer owned by the function
+// and call-site names are interned once per context.
+type Builder struct {
+	f       C.jit_nuint
+	names   *nameTable
+	scratch *C.build_scratch
+}
+
+func (f *Function) Builder() *Builder {
+	return &Builder{
+		f:       f.handle(),
+		names:   contextNames(C.jit_function_get_context(f.c)),
+		scratch: C.build_get_scratch(f.handle()),
+	}
+}
+
+func (v *Value) ID() ValueID {
+	return ValueID(uintptr(unsafe.Pointer(v.c)))
+}
+
+func (b *Builder) Value(id ValueID) *Value {
+	return toValue(*(*C.jit_value_t)(unsafe.Pointer(&id)))
+}
+
+func (t *Type) handle() C.jit_nuint {
+	return C.jit_nuint(uintptr(unsafe.Pointer(t.c)))
+}
+
+// args copies ids into the scratch buffer and returns its address.
+func (b *Builder) args(ids []ValueID) (C.jit_nuint, bool) {
+	if len(ids) == 0 {
+		return 0, true
+	}
+	if b.scratch == nil {
+		return 0, false
+	}
+	if int(b.scratch.size) < len(ids) && C.build_grow_scratch(b.scratch, C.uint(len(ids))) == 0 {
+		return 0, false
+	}
+	buf := (*[1 << 28]C.jit_nuint)(unsafe.Pointer(b.scratch.args))[:len(ids):len(ids)]
+	for i, id := range ids {
+		buf[i] = C.jit_nuint(id)
+	}
+	return C.jit_nuint(uintptr(unsafe.Pointer(b.scratch.args))), true
+}
+
+func (b *Builder) Param(param uint) ValueID {
+	return ValueID(C.build_param(b.f, C.uint(param)))
+}
+
+func (b *Builder) CreateValue(typ *Type) ValueID {
+	return ValueID(C.build_create_value(b.f, typ.handle()))
+}
+
+func (b *Builder) CreatePtrValue(ptr unsafe.Pointer) ValueID {
+	return ValueID(C.build_nint_constant(b.f, TypeVoidPtr.handle(), C.jit_nint(uintptr(ptr))))
+}
+
+func (b *Builder) CreateNintConstant(typ *Type, constValue int) ValueID {
+	return ValueID(C.build_nint_constant(b.f, typ.handle(), C.jit_nint(constValue)))
+}
+
+func (b *Builder) CreateLongConstant(typ *Type, constValue int64) ValueID {
+	return ValueID(C.build_long_constant(b.f, typ.handle(), C.jit_long(constValue)))
+}
+
+func (b *Builder) CreateFloat32Constant(typ *Type, constValue float32) ValueID {
+	return ValueID(C.build_float32_constant(b.f, typ.handle(), C.jit_float32(constValue)))
+}
+
+func (b *Builder) CreateFloat64Constant(typ *Type, constValue float64) ValueID {
+	return ValueID(C.build_float64_constant(b.f, typ.handle(), C.jit_float64(constValue)))
+}
+
+func (b *Builder) CreateIntValue(value int) ValueID {
+	return b.CreateNintConstant(TypeGoInt, value)
+}
+
+func (b *Builder) Store(dest, value ValueID) bool {
+	return int(C.build_store(b.f, C.jit_nuint(dest), C.jit_nuint(value))) == 1
+}
+
+func (b *Builder) LoadRelative(value ValueID, offset int, typ *Type) ValueID {
+	return ValueID(C.build_load_relative(b.f, C.jit_nuint(value), C.jit_nint(offset), typ.handle()))
+}
+
+func (b *Builder) StoreRelative(dest ValueID, offset int, value ValueID) bool {
+	return int(C.build_store_relative(b.f, C.jit_nuint(dest), C.jit_nint(offset), C.jit_nuint(value))) == 1
+}
+
+func (b *Builder) AddRelative(value ValueID, offset int) ValueID {
+	return ValueID(C.build_add_relative(b.f, C.jit_nuint(value), C.jit_nint(offset)))
+}
+
+func (b *Builder) LoadElem(baseAddr, index ValueID, elemType *Type) ValueID {
+	return ValueID(C.build_load_elem(b.f, C.jit_nuint(baseAddr), C.jit_nuint(index), elemType.handle()))
+}
+
+func (b *Builder) LoadElemAddress(baseAddr, index ValueID, elemType *Type) ValueID {
+	return ValueID(C.build_load_elem_address(b.f, C.jit_nuint(baseAddr), C.jit_nuint(index), elemType.handle()))
+}
+
+func (b *Builder) StoreElem(baseAddr, index, value ValueID) bool {
+	return int(C.build_store_elem(b.f, C.jit_nuint(baseAddr), C.jit_nuint(index), C.jit_nuint(value))) == 1
+}
+
+func (b *Builder) CheckNull(value ValueID) bool {
+	return int(C.build_check_null(b.f, C.jit_nuint(value))) == 1
+}
+
+func (b *Builder) Convert(value ValueID, typ *Type, overflowCheck int) ValueID {
+	return ValueID(C.build_convert(b.f, C.jit_nuint(value), typ.handle(), C.int(overflowCheck)))
+}
+
+func (b *Builder) Load(value1 ValueID) ValueID {
+	return ValueID(C.build_load(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Dup(value1 ValueID) ValueID {
+	return ValueID(C.build_dup(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) AddressOf(value1 ValueID) ValueID {
+	return ValueID(C.build_address_of(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Neg(value1 ValueID) ValueID {
+	return ValueID(C.build_neg(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Not(value1 ValueID) ValueID {
+	return ValueID(C.build_not(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) ToBool(value1 ValueID) ValueID {
+	return ValueID(C.build_to_bool(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) ToNotBool(value1 ValueID) ValueID {
+	return ValueID(C.build_to_not_bool(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Acos(value1 ValueID) ValueID {
+	return ValueID(C.build_acos(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Asin(value1 ValueID) ValueID {
+	return ValueID(C.build_asin(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Atan(value1 ValueID) ValueID {
+	return ValueID(C.build_atan(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Ceil(value1 ValueID) ValueID {
+	return ValueID(C.build_ceil(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Cos(value1 ValueID) ValueID {
+	return ValueID(C.build_cos(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Cosh(value1 ValueID) ValueID {
+	return ValueID(C.build_cosh(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Exp(value1 ValueID) ValueID {
+	return ValueID(C.build_exp(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Floor(value1 ValueID) ValueID {
+	return ValueID(C.build_floor(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Log(value1 ValueID) ValueID {
+	return ValueID(C.build_log(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Log10(value1 ValueID) ValueID {
+	return ValueID(C.build_log10(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Rint(value1 ValueID) ValueID {
+	return ValueID(C.build_rint(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Round(value1 ValueID) ValueID {
+	return ValueID(C.build_round(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Sin(value1 ValueID) ValueID {
+	return ValueID(C.build_sin(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Sinh(value1 ValueID) ValueID {
+	return ValueID(C.build_sinh(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Sqrt(value1 ValueID) ValueID {
+	return ValueID(C.build_sqrt(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Tan(value1 ValueID) ValueID {
+	return ValueID(C.build_tan(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Tanh(value1 ValueID) ValueID {
+	return ValueID(C.build_tanh(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Trunc(value1 ValueID) ValueID {
+	return ValueID(C.build_trunc(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) IsNan(value1 ValueID) ValueID {
+	return ValueID(C.build_is_nan(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) IsFinite(value1 ValueID) ValueID {
+	return ValueID(C.build_is_finite(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) IsInf(value1 ValueID) ValueID {
+	return ValueID(C.build_is_inf(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Abs(value1 ValueID) ValueID {
+	return ValueID(C.build_abs(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Sign(value1 ValueID) ValueID {
+	return ValueID(C.build_sign(b.f, C.jit_nuint(value1)))
+}
+
+func (b *Builder) Add(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_add(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) AddOvf(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_add_ovf(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Sub(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_sub(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) SubOvf(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_sub_ovf(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Mul(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_mul(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) MulOvf(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_mul_ovf(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Div(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_div(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Rem(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_rem(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) RemIEEE(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_rem_ieee(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) And(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_and(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Or(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_or(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Xor(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_xor(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Shl(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_shl(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Shr(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_shr(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Ushr(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_ushr(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Sshr(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_sshr(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Eq(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_eq(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Ne(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_ne(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Lt(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_lt(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Le(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_le(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Gt(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_gt(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Ge(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_ge(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Cmpl(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_cmpl(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Cmpg(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_cmpg(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Atan2(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_atan2(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Pow(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_pow(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Min(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_min(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) Max(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_max(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VLoad(baseAddr, index ValueID, typ *Type) ValueID {
+	return ValueID(C.build_vload(b.f, C.jit_nuint(baseAddr), C.jit_nuint(index), typ.handle()))
+}
+
+func (b *Builder) VStore(baseAddr, index, value ValueID) bool {
+	return int(C.build_vstore(b.f, C.jit_nuint(baseAddr), C.jit_nuint(index), C.jit_nuint(value))) == 1
+}
+
+func (b *Builder) VAdd(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vadd(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VSub(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vsub(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VMul(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vmul(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VDiv(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vdiv(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VMin(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vmin(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VMax(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vmax(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VAnd(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vand(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VOr(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vor(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VXor(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vxor(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VAndNot(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vandnot(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VEq(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_veq(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VNe(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vne(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VLt(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vlt(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VLe(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vle(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VGt(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vgt(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VGe(value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vge(b.f, C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VSqrt(value ValueID) ValueID {
+	return ValueID(C.build_vsqrt(b.f, C.jit_nuint(value)))
+}
+
+func (b *Builder) VSelect(mask, value1, value2 ValueID) ValueID {
+	return ValueID(C.build_vselect(b.f, C.jit_nuint(mask), C.jit_nuint(value1), C.jit_nuint(value2)))
+}
+
+func (b *Builder) VShuffle(value ValueID, order int) ValueID {
+	return ValueID(C.build_vshuffle(b.f, C.jit_nuint(value), C.jit_nint(order)))
+}
+
+func (b *Builder) VBroadcast(value ValueID, typ *Type) ValueID {
+	return ValueID(C.build_vbroadcast(b.f, C.jit_nuint(value), typ.handle()))
+}
+
+func (b *Builder) VExtract(value ValueID, lane uint) ValueID {
+	return ValueID(C.build_vextract(b.f, C.jit_nuint(value), C.uint(lane)))
+}
+
+func (b *Builder) VReduceAdd(value ValueID) ValueID {
+	return ValueID(C.build_vreduce_add(b.f, C.jit_nuint(value)))
+}
+
+func (b *Builder) VReduceMin(value ValueID) ValueID {
+	return ValueID(C.build_vreduce_min(b.f, C.jit_nuint(value)))
+}
+
+func (b *Builder) VReduceMax(value ValueID) ValueID {
+	return ValueID(C.build_vreduce_max(b.f, C.jit_nuint(value)))
+}
+
+func (b *Builder) NewLabel() LabelID {
+	return LabelID(C.build_reserve_label(b.f))
+}
+
+func (b *Builder) Label(label LabelID) bool {
+	return int(C.build_label(b.f, C.jit_nuint(label))) == 1
+}
+
+func (b *Builder) Branch(label LabelID) bool {
+	return int(C.build_branch(b.f, C.jit_nuint(label))) == 1
+}
+
+func (b *Builder) BranchIf(value ValueID, label LabelID) bool {
+	return int(C.build_branch_if(b.f, C.jit_nuint(value), C.jit_nuint(label))) == 1
+}
+
+func (b *Builder) BranchIfNot(value ValueID, label LabelID) bool {
+	return int(C.build_branch_if_not(b.f, C.jit_nuint(value), C.jit_nuint(label))) == 1
+}
+
+func (b *Builder) JumpTable(value ValueID, labels ...LabelID) bool {
+	// jit_label_t and jit_value_t are both word sized, so the labels share
+	// the argument scratch buffer.
+	ids := *(*[]ValueID)(unsafe.Pointer(&labels))
+	buf, ok := b.args(ids)
+	if !ok {
+		return false
+	}
+	return int(C.build_jump_table(b.f, C.jit_nuint(value), buf, C.uint(len(labels)))) == 1
+}
+
+func (b *Builder) Call(name string, fn *Function, args ...ValueID) ValueID {
+	buf, ok := b.args(args)
+	if !ok {
+		return 0
+	}
+	return ValueID(C.build_call(b.f, C.jit_nuint(uintptr(unsafe.Pointer(b.names.intern(name)))), fn.handle(), buf, C.uint(len(args)), C.JIT_CALL_NOTHROW))
+}
+
+func (b *Builder) CallIndirect(value ValueID, signature *Type, args ...ValueID) ValueID {
+	buf, ok := b.args(args)
+	if !ok {
+		return 0
+	}
+	return ValueID(C.build_call_indirect(b.f, C.jit_nuint(value), signature.handle(), buf, C.uint(len(args)), C.JIT_CALL_NOTHROW))
+}
+
+func (b *Builder) CallNative(name string, nativeFunc unsafe.Pointer, signature *Type, args ...ValueID) ValueID {
+	buf, ok := b.args(args)
+	if !ok {
+		return 0
+	}
+	return ValueID(C.build_call_native(b.f, C.jit_nuint(uintptr(unsafe.Pointer(b.names.intern(name)))), C.jit_nuint(uintptr(nativeFunc)), signature.handle(), buf, C.uint(len(args)), C.JIT_CALL_NOTHROW))
+}
+
+// CallNativePure calls a native function that neither reads nor writes
+// memory that the function being built can access, so loads before the
+// call may be reused after it.
+func (b *Builder) CallNativePure(name string, nativeFunc unsafe.Pointer, signature *Type, args ...ValueID) ValueID {
+	buf, ok := b.args(args)
+	if !ok {
+		return 0
+	}
+	return ValueID(C.build_call_native(b.f, C.jit_nuint(uintptr(unsafe.Pointer(b.names.intern(name)))), C.jit_nuint(uintptr(nativeFunc)), signature.handle(), buf, C.uint(len(args)), C.JIT_CALL_NOTHROW|C.JIT_CALL_PURE))
+}
+
+func (b *Builder) Return(value ValueID) bool {
+	return int(C.build_return(b.f, C.jit_nuint(value))) == 1
+}
+
+// Throw ends the current block by throwing value as an exception.  A call
+// from Go that the exception escapes from returns the zero value.  The
+// optimizer moves the code that only leads to a throw out of the hot path.
+func (b *Builder) Throw(value ValueID) bool {
+	return int(C.build_throw(b.f, C.jit_nuint(value))) == 1
+}
+
+func (b *Builder) DefaultReturn() bool {
+	return int(C.build_default_return(b.f)) == 1
+}
+
+// nameTable holds the C copies of call-site names.  libjit keeps a pointer
+// to the name in the call instruction, so the strings live as long as the
+// context does.
+type nameTable struct {
+	mu    sync.Mutex
+	names map[string]*C.char
+}
+
+var (
+	namesMu  sync.Mutex
+	namesMap = map[C.jit_context_t]*nameTable{}
+)
+
+func contextNames(ctx C.jit_context_t) *nameTable {
+	namesMu.Lock()
+	defer namesMu.Unlock()
+	t, ok := namesMap[ctx]
+	if !ok {
+		t = &nameTable{names: map[string]*C.char{}}
+		namesMap[ctx] = t
+	}
+	return t
+}
+
+func (t *nameTable) intern(name string) *C.char {
+	if name == "" {
+		return nil
+	}
+	t.mu.Lock()
+	s, ok := t.names[name]
+	if !ok {
+		s = C.CString(name)
+		t.names[name] = s
+	}
+	t.mu.Unlock()
+	return s
+}
+
+func releaseNames(ctx C.jit_context_t) {
+	namesMu.Lock()
+	t, ok := namesMap[ctx]
+	delete(namesMap, ctx)
+	namesMu.Unlock()
+	if !ok {
+		return
+	}
+	for _, s := range t.names {
+		C.free(unsafe.Pointer(s))
+	}
+}
+
+func (f *Function) internName(name string) *C.char {
+	return contextNames(C.jit_function_get_context(f.c)).intern(name)
+}
@@ -0,0 +1,20 @@
+#ifndef	_GO_JIT_BUILDER_H
+#define	_GO_JIT_BUILDER_H
+
+#include <jit/jit.h>
+
+/*
+ * Argument buffer shared by all builders of a function.  The structure
+ * itself never moves; only "args" is reallocated when it has to grow.
+ */
+typedef struct
+{
+	unsigned int	size;
+	jit_nuint	*args;
+
+} build_scratch;
+
+build_scratch *build_get_scratch(jit_nuint func);
+int build_grow_scratch(build_scratch *scratch, unsigned int size);
+
+#endif	/* _GO_JIT_BUILDER_H */
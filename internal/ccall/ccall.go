@@ -3,6 +3,7 @@ package ccall
 /*
 #cgo CFLAGS: -I../
 #cgo CFLAGS: -Iinclude
+#cgo linux LDFLAGS: -lm -ldl -lpthread
 
 #include <jit/jit.h>
 */
@@ -11,5 +12,6 @@ import "C"
 var (
 	JIT_OPTLEVEL_NONE   = C.JIT_OPTLEVEL_NONE
 	JIT_OPTLEVEL_NORMAL = C.JIT_OPTLEVEL_NORMAL
+	JIT_OPTLEVEL_SSA    = C.JIT_OPTLEVEL_SSA
 	JIT_NO_OFFSET       = C.JIT_NO_OFFSET
 )
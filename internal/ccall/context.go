@@ -10,6 +10,7 @@ extern void *get_crosscall2addr();
 extern void *get_cgo_wait_runtime_init_done_addr();
 */
 import "C"
+import "unsafe"
 
 var (
 	JIT_OPTION_CACHE_LIMIT           = C.JIT_OPTION_CACHE_LIMIT
@@ -18,6 +19,25 @@ var (
 	JIT_OPTION_DONT_FOLD             = C.JIT_OPTION_DONT_FOLD
 	JIT_OPTION_POSITION_INDEPENDENT  = C.JIT_OPTION_POSITION_INDEPENDENT
 	JIT_OPTION_CACHE_MAX_PAGE_FACTOR = C.JIT_OPTION_CACHE_MAX_PAGE_FACTOR
+	JIT_OPTION_COMPILE_CACHE         = C.JIT_OPTION_COMPILE_CACHE
+	JIT_OPTION_CACHE_EVICT           = C.JIT_OPTION_CACHE_EVICT
+	JIT_OPTION_CACHE_RESERVE         = C.JIT_OPTION_CACHE_RESERVE
+	JIT_OPTION_CACHE_HUGE_PAGES      = C.JIT_OPTION_CACHE_HUGE_PAGES
+	JIT_OPTION_CACHE_DUAL_MAP        = C.JIT_OPTION_CACHE_DUAL_MAP
+	JIT_OPTION_INLINE_LIMIT          = C.JIT_OPTION_INLINE_LIMIT
+)
+
+var (
+	JIT_CPU_SSE3   = uint(C.JIT_CPU_SSE3)
+	JIT_CPU_SSE4_1 = uint(C.JIT_CPU_SSE4_1)
+	JIT_CPU_SSE4_2 = uint(C.JIT_CPU_SSE4_2)
+	JIT_CPU_POPCNT = uint(C.JIT_CPU_POPCNT)
+	JIT_CPU_LZCNT  = uint(C.JIT_CPU_LZCNT)
+	JIT_CPU_BMI1   = uint(C.JIT_CPU_BMI1)
+	JIT_CPU_BMI2   = uint(C.JIT_CPU_BMI2)
+	JIT_CPU_AVX    = uint(C.JIT_CPU_AVX)
+	JIT_CPU_AVX2   = uint(C.JIT_CPU_AVX2)
+	JIT_CPU_FMA    = uint(C.JIT_CPU_FMA)
 )
 
 type Context struct {
@@ -31,14 +51,79 @@ func toContext(c C.jit_context_t) *Context {
 }
 
 func CreateContext() *Context {
+	return CreateContextWithOptions(nil)
+}
+
+// CreateContextWithOptions creates a context with numeric options that
+// are set before its first function is created, which is when the code
+// cache is created and reads options such as JIT_OPTION_CACHE_RESERVE.
+// It returns nil if the code cache cannot be created with them.
+func CreateContextWithOptions(options map[int]uint) *Context {
 	ctx := toContext(C.jit_context_create())
+	for typ, value := range options {
+		ctx.SetMetaNumeric(typ, value)
+	}
 	ctx.crosscall2 = ctx.createCrossCall2()
+	if ctx.crosscall2.c == nil {
+		C.jit_context_destroy(ctx.c)
+		return nil
+	}
 	ctx.cgo_wait_runtime_init_done = ctx.createCgoWaitRuntimeInitDone()
 	return ctx
 }
 
 func (c *Context) Destroy() {
+	releaseTiers(c.c)
+	releaseEvictables(c.c)
+	releaseCompiler(c.c)
 	C.jit_context_destroy(c.c)
+	releaseNames(c.c)
+}
+
+// CompileCacheStats returns the number of compilations that reused the
+// code of a function with the same IR, and the number that did not.
+func (c *Context) CompileCacheStats() (uint64, uint64) {
+	var hits, misses C.jit_nuint
+	C.jit_context_get_compile_cache_stats(c.c, &hits, &misses)
+	return uint64(hits), uint64(misses)
+}
+
+// NumEvictions returns the number of times that the code of a function
+// was freed to make room in the code cache.
+func (c *Context) NumEvictions() uint64 {
+	return uint64(C.jit_context_get_num_evictions(c.c))
+}
+
+// NumHugePages returns the number of huge pages that currently back the
+// code cache.
+func (c *Context) NumHugePages() uint64 {
+	return uint64(C.jit_context_get_num_huge_pages(c.c))
+}
+
+// CPUFeatures returns the instruction set extensions, as JIT_CPU_* flags,
+// that the code generator uses for functions of the context.
+func (c *Context) CPUFeatures() uint {
+	return uint(C.jit_context_get_cpu_features(c.c))
+}
+
+// SetCPUFeatures limits the instruction set extensions that the code
+// generator uses to those in features that the CPU has.
+func (c *Context) SetCPUFeatures(features uint) {
+	C.jit_context_set_cpu_features(c.c, C.jit_uint(features))
+}
+
+// FunctionFromPC returns the function whose compiled code contains pc,
+// or nil if there is none.  It takes no lock, so it can be called often,
+// e.g. from a sampling profiler, while other goroutines compile.
+func (c *Context) FunctionFromPC(pc unsafe.Pointer) *Function {
+	f := C.jit_function_from_pc(c.c, pc, nil)
+	if f == nil {
+		return nil
+	}
+	fn := toFunction(f)
+	fn.crosscall2 = c.crosscall2
+	fn.cgo_wait_runtime_init_done = c.cgo_wait_runtime_init_done
+	return fn
 }
 
 func (c *Context) BuildStart() {
@@ -0,0 +1,164 @@
+package ccall
+
+/*
+#cgo CFLAGS: -I../
+#cgo CFLAGS: -Iinclude
+
+#include <stdlib.h>
+#include <jit/jit.h>
+*/
+import "C"
+import (
+	"errors"
+	"unsafe"
+)
+
+var (
+	ErrELFCannotOpen = errors.New("elf: cannot open file")
+	ErrELFNotELF     = errors.New("elf: not an ELF binary")
+	ErrELFWrongArch  = errors.New("elf: binary is for another architecture")
+	ErrELFBadFormat  = errors.New("elf: corrupted binary")
+	ErrELFMemory     = errors.New("elf: out of memory")
+)
+
+// ELFWriter writes compiled functions to an ELF binary.
+type ELFWriter struct {
+	c C.jit_writeelf_t
+}
+
+// CreateELFWriter creates a writer for a binary with the library name
+// libraryName.
+func CreateELFWriter(libraryName string) *ELFWriter {
+	name := C.CString(libraryName)
+	defer C.free(unsafe.Pointer(name))
+	w := C.jit_writeelf_create(name)
+	if w == nil {
+		return nil
+	}
+	return &ELFWriter{c: w}
+}
+
+func (w *ELFWriter) Destroy() {
+	C.jit_writeelf_destroy(w.c)
+}
+
+// AddFunction adds the code of f, which must have been compiled in a
+// context with JIT_OPTION_PRE_COMPILE, and exports it as name.
+func (w *ELFWriter) AddFunction(f *Function, name string) bool {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	return C.jit_writeelf_add_function(w.c, f.c, s) != 0
+}
+
+func (w *ELFWriter) AddNeeded(libraryName string) bool {
+	name := C.CString(libraryName)
+	defer C.free(unsafe.Pointer(name))
+	return C.jit_writeelf_add_needed(w.c, name) != 0
+}
+
+func (w *ELFWriter) WriteSection(name string, typ int, buf []byte, discardable bool) bool {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	var data unsafe.Pointer
+	if len(buf) > 0 {
+		data = C.CBytes(buf)
+		defer C.free(data)
+	}
+	return C.jit_writeelf_write_section(w.c, s, C.jit_int(typ), data, C.uint(len(buf)), boolToInt(discardable)) != 0
+}
+
+// Write writes the binary to filename.
+func (w *ELFWriter) Write(filename string) error {
+	s := C.CString(filename)
+	defer C.free(unsafe.Pointer(s))
+	if ok, err := C.jit_writeelf_write(w.c, s); ok == 0 {
+		return err
+	}
+	return nil
+}
+
+// ELFReader is an ELF binary that was loaded into memory.
+type ELFReader struct {
+	c C.jit_readelf_t
+}
+
+// OpenELF loads the ELF binary in filename.
+func OpenELF(filename string, flags int) (*ELFReader, error) {
+	s := C.CString(filename)
+	defer C.free(unsafe.Pointer(s))
+	var r C.jit_readelf_t
+	switch C.jit_readelf_open(&r, s, C.int(flags)) {
+	case C.JIT_READELF_OK:
+		return &ELFReader{c: r}, nil
+	case C.JIT_READELF_CANNOT_OPEN:
+		return nil, ErrELFCannotOpen
+	case C.JIT_READELF_NOT_ELF:
+		return nil, ErrELFNotELF
+	case C.JIT_READELF_WRONG_ARCH:
+		return nil, ErrELFWrongArch
+	case C.JIT_READELF_BAD_FORMAT:
+		return nil, ErrELFBadFormat
+	}
+	return nil, ErrELFMemory
+}
+
+// Close unloads the binary.  It must not be called once the binary has
+// been added to a context, which closes it when it is destroyed.
+func (r *ELFReader) Close() {
+	C.jit_readelf_close(r.c)
+}
+
+func (r *ELFReader) Name() string {
+	return C.GoString(C.jit_readelf_get_name(r.c))
+}
+
+// Symbol returns the address of the symbol name, or nil.
+func (r *ELFReader) Symbol(name string) unsafe.Pointer {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	return C.jit_readelf_get_symbol(r.c, s)
+}
+
+// Section returns the contents of the section name, or nil.
+func (r *ELFReader) Section(name string) []byte {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	var size C.jit_nuint
+	data := C.jit_readelf_get_section(r.c, s, &size)
+	if data == nil {
+		return nil
+	}
+	return C.GoBytes(data, C.int(size))
+}
+
+func (r *ELFReader) AddToContext(ctx *Context) {
+	C.jit_readelf_add_to_context(r.c, ctx.c)
+}
+
+// ResolveAll applies the relocations of the binaries that were added to
+// the context since the last call.
+func (c *Context) ResolveAll(printFailures bool) bool {
+	return C.jit_readelf_resolve_all(c.c, boolToInt(printFailures)) != 0
+}
+
+// RegisterSymbol makes the binaries of the context resolve name to value.
+func (c *Context) RegisterSymbol(name string, value unsafe.Pointer, after bool) bool {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	return C.jit_readelf_register_symbol(c.c, s, value, boolToInt(after)) != 0
+}
+
+func (c *Context) SetMetaNumeric(typ int, value uint) bool {
+	return C.jit_context_set_meta_numeric(c.c, C.int(typ), C.jit_nuint(value)) != 0
+}
+
+func (c *Context) MetaNumeric(typ int) uint {
+	return uint(C.jit_context_get_meta_numeric(c.c, C.int(typ)))
+}
+
+func boolToInt(b bool) C.int {
+	if b {
+		return 1
+	}
+	return 0
+}
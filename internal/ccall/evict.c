@@ -0,0 +1,25 @@
+#include "jit-internal.h"
+#include "_cgo_export.h"
+
+/*
+ * Evictable functions from Go.
+ *
+ * The code of an evictable function may be freed when the code cache of
+ * its context is full.  Its redirector then sends the next call to the
+ * on-demand compiler, which hands the function back to Go to be built
+ * again.  "_jit_function_compile_on_demand" compiles the new body, with
+ * the build lock of the function held.
+ */
+
+static int evict_compile_on_demand(jit_function_t func)
+{
+	return goEvictRebuild((jit_nuint)func);
+}
+
+void evict_start(jit_nuint handle)
+{
+	jit_function_t func = (jit_function_t)handle;
+
+	jit_function_set_evictable(func);
+	jit_function_set_on_demand_compiler(func, evict_compile_on_demand);
+}
@@ -0,0 +1,90 @@
+package ccall
+
+/*
+#cgo CFLAGS: -I../
+#cgo CFLAGS: -Iinclude
+
+#include <jit/jit.h>
+
+extern void evict_start(jit_nuint);
+*/
+import "C"
+import (
+	"runtime"
+	"sync"
+)
+
+type evictableFunction struct {
+	f     *Function
+	ctx   C.jit_context_t
+	build func(*Function) error
+}
+
+var (
+	evictablesMu  sync.Mutex
+	evictablesMap = map[C.jit_nuint]*evictableFunction{}
+)
+
+// SetCacheLimit limits the code cache of the context to about bytes.
+// It must be called before the first function of the context is created.
+func (c *Context) SetCacheLimit(bytes uint) {
+	c.SetMetaNumeric(JIT_OPTION_CACHE_LIMIT, bytes)
+}
+
+// EnableEviction makes the context free the code of the least recently
+// used functions compiled with CompileEvictable when the cache limit is
+// hit, instead of failing to compile.  The memory of evicted code is
+// reused once no goroutine is in a call into compiled code that started
+// before the eviction.  Until then it does not count towards the limit,
+// so the cache can grow past the limit by that much, or further while a
+// function is compiled on demand from compiled code.
+func (c *Context) EnableEviction() {
+	c.SetMetaNumeric(JIT_OPTION_CACHE_EVICT, 1)
+}
+
+// CompileEvictable builds f with build and compiles it.  If the code of f
+// is evicted later, the next call runs build again and compiles f on
+// demand.
+func (f *Function) CompileEvictable(build func(*Function) error) error {
+	ctx := C.jit_function_get_context(f.c)
+
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	f.BuildStart()
+	defer f.BuildEnd()
+	C.evict_start(f.handle())
+	evictablesMu.Lock()
+	evictablesMap[f.handle()] = &evictableFunction{f: f, ctx: ctx, build: build}
+	evictablesMu.Unlock()
+	if err := build(f); err != nil {
+		return err
+	}
+	if !f.Compile() {
+		return ErrCompileFailed
+	}
+	return nil
+}
+
+//export goEvictRebuild
+func goEvictRebuild(handle C.jit_nuint) C.int {
+	evictablesMu.Lock()
+	e := evictablesMap[handle]
+	evictablesMu.Unlock()
+	if e == nil {
+		return C.JIT_RESULT_COMPILE_ERROR
+	}
+	if err := e.build(e.f); err != nil {
+		return C.JIT_RESULT_COMPILE_ERROR
+	}
+	return C.JIT_RESULT_OK
+}
+
+func releaseEvictables(ctx C.jit_context_t) {
+	evictablesMu.Lock()
+	defer evictablesMu.Unlock()
+	for handle, e := range evictablesMap {
+		if e.ctx == ctx {
+			delete(evictablesMap, handle)
+		}
+	}
+}
@@ -4,6 +4,7 @@ package ccall
 #cgo CFLAGS: -I../
 #cgo CFLAGS: -Iinclude
 
+#include <stdlib.h>
 #include <jit/jit.h>
 */
 import "C"
@@ -303,6 +304,110 @@ func (f *Function) Sign(value1 *Value) *Value {
 	return toValue(C.jit_insn_sign(f.c, value1.c))
 }
 
+func (f *Function) VLoad(baseAddr, index *Value, typ *Type) *Value {
+	return toValue(C.jit_insn_vload(f.c, baseAddr.c, index.c, typ.c))
+}
+
+func (f *Function) VStore(baseAddr, index, value *Value) bool {
+	return int(C.jit_insn_vstore(f.c, baseAddr.c, index.c, value.c)) == 1
+}
+
+func (f *Function) VAdd(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vadd(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VSub(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vsub(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VMul(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vmul(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VDiv(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vdiv(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VMin(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vmin(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VMax(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vmax(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VAnd(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vand(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VOr(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vor(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VXor(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vxor(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VAndNot(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vandnot(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VEq(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_veq(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VNe(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vne(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VLt(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vlt(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VLe(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vle(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VGt(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vgt(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VGe(value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vge(f.c, value1.c, value2.c))
+}
+
+func (f *Function) VSqrt(value *Value) *Value {
+	return toValue(C.jit_insn_vsqrt(f.c, value.c))
+}
+
+func (f *Function) VSelect(mask, value1, value2 *Value) *Value {
+	return toValue(C.jit_insn_vselect(f.c, mask.c, value1.c, value2.c))
+}
+
+func (f *Function) VShuffle(value *Value, order int) *Value {
+	return toValue(C.jit_insn_vshuffle(f.c, value.c, C.jit_nint(order)))
+}
+
+func (f *Function) VBroadcast(value *Value, typ *Type) *Value {
+	return toValue(C.jit_insn_vbroadcast(f.c, value.c, typ.c))
+}
+
+func (f *Function) VExtract(value *Value, lane uint) *Value {
+	return toValue(C.jit_insn_vextract(f.c, value.c, C.uint(lane)))
+}
+
+func (f *Function) VReduceAdd(value *Value) *Value {
+	return toValue(C.jit_insn_vreduce_add(f.c, value.c))
+}
+
+func (f *Function) VReduceMin(value *Value) *Value {
+	return toValue(C.jit_insn_vreduce_min(f.c, value.c))
+}
+
+func (f *Function) VReduceMax(value *Value) *Value {
+	return toValue(C.jit_insn_vreduce_max(f.c, value.c))
+}
+
 func (f *Function) Branch(label *Label) bool {
 	return int(C.jit_insn_branch(f.c, &label.c)) == 1
 }
@@ -332,7 +437,7 @@ func (f *Function) Convert(value *Value, typ *Type, overflowCheck int) *Value {
 }
 
 func (f *Function) Call(name string, fn *Function, args Values) *Value {
-	return toValue(C.jit_insn_call(f.c, C.CString(name), fn.c, nil, args.c(), C.uint(len(args)), C.JIT_CALL_NOTHROW))
+	return toValue(C.jit_insn_call(f.c, f.internName(name), fn.c, nil, args.c(), C.uint(len(args)), C.JIT_CALL_NOTHROW))
 }
 
 func (f *Function) CallIndirect(fn *Function, value *Value, signature *Type, args Values) *Value {
@@ -348,7 +453,7 @@ func (f *Function) CallIndirectVtable(fn *Function, value *Value, signature *Typ
 }
 
 func (f *Function) CallNative(fn *Function, name string, nativeFunc unsafe.Pointer, signature *Type, args Values) *Value {
-	return toValue(C.jit_insn_call_native(f.c, C.CString(name), nativeFunc, signature.c, args.c(), C.uint(len(args)), C.JIT_CALL_NOTHROW))
+	return toValue(C.jit_insn_call_native(f.c, f.internName(name), nativeFunc, signature.c, args.c(), C.uint(len(args)), C.JIT_CALL_NOTHROW))
 }
 
 //func (f *Function) CallIntrinsic(fn *Function, name string, intrinsicFunc unsafe.Pointer, desc *IntrinsicDescriptor, arg1, arg2 *Value) *Value {
@@ -411,6 +516,14 @@ func (f *Function) Abandon() {
 	C.jit_function_abandon(f.c)
 }
 
+func (f *Function) BuildStart() {
+	C.jit_function_build_start(f.c)
+}
+
+func (f *Function) BuildEnd() {
+	C.jit_function_build_end(f.c)
+}
+
 func (f *Function) Context() *Context {
 	return toContext(C.jit_function_get_context(f.c))
 }
@@ -419,11 +532,23 @@ func (f *Function) Signature() *Type {
 	return toType(C.jit_function_get_signature(f.c))
 }
 
+// Metadata types below zero are used by this package, and types of 10000
+// or greater are reserved by libjit, so Meta and FreeMeta ignore them.
+func isUserMeta(typ int) bool {
+	return typ >= 0 && typ < 10000
+}
+
 func (f *Function) Meta(typ int) unsafe.Pointer {
+	if !isUserMeta(typ) {
+		return nil
+	}
 	return C.jit_function_get_meta(f.c, C.int(typ))
 }
 
 func (f *Function) FreeMeta(typ int) {
+	if !isUserMeta(typ) {
+		return
+	}
 	C.jit_function_free_meta(f.c, C.int(typ))
 }
 
@@ -463,6 +588,21 @@ func (f *Function) IsRecompilable() bool {
 	return int(C.jit_function_is_recompilable(f.c)) == 1
 }
 
+func (f *Function) SetEvictable() {
+	C.jit_function_set_evictable(f.c)
+}
+
+func (f *Function) IsEvictable() bool {
+	return int(C.jit_function_is_evictable(f.c)) == 1
+}
+
+// FreeCode frees the compiled code of f.  The next call compiles f again
+// with its on-demand compiler.  The memory is reused once no call into
+// compiled code that may run f is in progress.
+func (f *Function) FreeCode() bool {
+	return int(C.jit_function_free_code(f.c)) == 1
+}
+
 func (f *Function) SetupEntry(entryPoint unsafe.Pointer) {
 	C.jit_function_setup_entry(f.c, entryPoint)
 }
@@ -481,15 +621,35 @@ type interfaceHeader struct {
 }
 
 func (f *Function) Apply(args []interface{}) interface{} {
-	params := make([]unsafe.Pointer, len(args))
+	// Copy the arguments out of Go memory so that no Go pointers are
+	// handed to C through the argument vector.
+	sig := C.jit_function_get_signature(f.c)
+	size := uintptr(len(args)) * uintptr(ptrsize)
+	for idx := range args {
+		size += uintptr(C.jit_type_get_size(C.jit_type_get_param(sig, C.uint(idx))))
+	}
+	buf := C.malloc(C.size_t(size))
+	defer C.free(buf)
+	params := (*[1 << 20]unsafe.Pointer)(buf)[:len(args):len(args)]
+	offset := uintptr(len(args)) * uintptr(ptrsize)
 	for idx, arg := range args {
 		header := (*interfaceHeader)(unsafe.Pointer(&arg))
-		params[idx] = header.ptr
+		n := uintptr(C.jit_type_get_size(C.jit_type_get_param(sig, C.uint(idx))))
+		data := unsafe.Pointer(uintptr(buf) + offset)
+		copy((*[1 << 30]byte)(data)[:n:n], (*[1 << 30]byte)(header.ptr)[:n:n])
+		params[idx] = data
+		offset += n
 	}
-	cparams := (*unsafe.Pointer)(unsafe.Pointer((*reflect.SliceHeader)(unsafe.Pointer(&params)).Data))
-	var result int
+	cparams := (*unsafe.Pointer)(buf)
+	var result [2]uint64
 	C.jit_function_apply(f.c, cparams, unsafe.Pointer(&result))
-	return result
+	switch int(C.jit_type_get_kind(C.jit_type_normalize(C.jit_type_get_return(sig)))) {
+	case JIT_TYPE_FLOAT32:
+		return *(*float32)(unsafe.Pointer(&result))
+	case JIT_TYPE_FLOAT64:
+		return *(*float64)(unsafe.Pointer(&result))
+	}
+	return *(*int)(unsafe.Pointer(&result))
 }
 
 func (f *Function) SetOptimizationLevel(level uint) {
@@ -500,6 +660,12 @@ func (f *Function) OptimizationLevel() uint {
 	return uint(C.jit_function_get_optimization_level(f.c))
 }
 
+// IRHash returns the hash of the instructions built so far, which is the
+// same for functions that were built the same way.
+func (f *Function) IRHash() uint64 {
+	return uint64(C.jit_function_get_ir_hash(f.c))
+}
+
 func MaxOptimizationLevel() uint {
 	return uint(C.jit_function_get_max_optimization_level())
 }
@@ -51,6 +51,13 @@ void *jit_context_get_meta(jit_context_t context, int type) JIT_NOTHROW;
 jit_nuint jit_context_get_meta_numeric
 	(jit_context_t context, int type) JIT_NOTHROW;
 void jit_context_free_meta(jit_context_t context, int type) JIT_NOTHROW;
+void jit_context_get_compile_cache_stats
+	(jit_context_t context, jit_nuint *hits, jit_nuint *misses) JIT_NOTHROW;
+jit_nuint jit_context_get_num_evictions(jit_context_t context) JIT_NOTHROW;
+jit_nuint jit_context_get_num_huge_pages(jit_context_t context) JIT_NOTHROW;
+jit_uint jit_context_get_cpu_features(jit_context_t context) JIT_NOTHROW;
+void jit_context_set_cpu_features
+	(jit_context_t context, jit_uint features) JIT_NOTHROW;
 
 /*
  * Standard meta values for builtin configurable options.
@@ -61,6 +68,26 @@ void jit_context_free_meta(jit_context_t context, int type) JIT_NOTHROW;
 #define	JIT_OPTION_DONT_FOLD		10003
 #define JIT_OPTION_POSITION_INDEPENDENT	10004
 #define JIT_OPTION_CACHE_MAX_PAGE_FACTOR	10005
+#define JIT_OPTION_COMPILE_CACHE	10006
+#define JIT_OPTION_CACHE_EVICT		10007
+#define JIT_OPTION_CACHE_RESERVE	10008
+#define JIT_OPTION_CACHE_HUGE_PAGES	10009
+#define JIT_OPTION_CACHE_DUAL_MAP	10010
+#define JIT_OPTION_INLINE_LIMIT		10011
+
+/*
+ * Instruction set extensions that the code generator may use.
+ */
+#define JIT_CPU_SSE3			(1 << 0)
+#define JIT_CPU_SSE4_1			(1 << 1)
+#define JIT_CPU_SSE4_2			(1 << 2)
+#define JIT_CPU_POPCNT			(1 << 3)
+#define JIT_CPU_LZCNT			(1 << 4)
+#define JIT_CPU_BMI1			(1 << 5)
+#define JIT_CPU_BMI2			(1 << 6)
+#define JIT_CPU_AVX			(1 << 7)
+#define JIT_CPU_AVX2			(1 << 8)
+#define JIT_CPU_FMA			(1 << 9)
 
 #ifdef	__cplusplus
 };
@@ -30,6 +30,7 @@ extern	"C" {
 /* Optimization levels */
 #define JIT_OPTLEVEL_NONE	0
 #define JIT_OPTLEVEL_NORMAL	1
+#define JIT_OPTLEVEL_SSA	2
 
 jit_function_t jit_function_create
 	(jit_context_t context, jit_type_t signature) JIT_NOTHROW;
@@ -37,6 +38,8 @@ jit_function_t jit_function_create_nested
 	(jit_context_t context, jit_type_t signature,
 	 jit_function_t parent) JIT_NOTHROW;
 void jit_function_abandon(jit_function_t func) JIT_NOTHROW;
+void jit_function_build_start(jit_function_t func) JIT_NOTHROW;
+void jit_function_build_end(jit_function_t func) JIT_NOTHROW;
 jit_context_t jit_function_get_context(jit_function_t func) JIT_NOTHROW;
 jit_type_t jit_function_get_signature(jit_function_t func) JIT_NOTHROW;
 int jit_function_set_meta
@@ -55,9 +58,14 @@ void jit_function_set_parent_frame(jit_function_t func,
 	jit_value_t parent_frame) JIT_NOTHROW;
 int jit_function_compile(jit_function_t func) JIT_NOTHROW;
 int jit_function_is_compiled(jit_function_t func) JIT_NOTHROW;
+jit_nint jit_function_get_leaf_stack_size(jit_function_t func) JIT_NOTHROW;
+jit_ulong jit_function_get_ir_hash(jit_function_t func) JIT_NOTHROW;
 void jit_function_set_recompilable(jit_function_t func) JIT_NOTHROW;
 void jit_function_clear_recompilable(jit_function_t func) JIT_NOTHROW;
 int jit_function_is_recompilable(jit_function_t func) JIT_NOTHROW;
+void jit_function_set_evictable(jit_function_t func) JIT_NOTHROW;
+int jit_function_is_evictable(jit_function_t func) JIT_NOTHROW;
+int jit_function_free_code(jit_function_t func) JIT_NOTHROW;
 int jit_function_compile_entry(jit_function_t func, void **entry_point) JIT_NOTHROW;
 void jit_function_setup_entry(jit_function_t func, void *entry_point) JIT_NOTHROW;
 void *jit_function_to_closure(jit_function_t func) JIT_NOTHROW;
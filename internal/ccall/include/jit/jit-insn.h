@@ -56,6 +56,7 @@ typedef struct
 #define	JIT_CALL_NOTHROW		(1 << 0)
 #define	JIT_CALL_NORETURN		(1 << 1)
 #define	JIT_CALL_TAIL			(1 << 2)
+#define	JIT_CALL_PURE			(1 << 3)
 
 int jit_insn_get_opcode(jit_insn_t insn) JIT_NOTHROW;
 jit_value_t jit_insn_get_dest(jit_insn_t insn) JIT_NOTHROW;
@@ -207,6 +208,61 @@ jit_value_t jit_insn_max
 	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
 jit_value_t jit_insn_sign
 	(jit_function_t func, jit_value_t value1) JIT_NOTHROW;
+jit_value_t jit_insn_vload
+	(jit_function_t func, jit_value_t base_addr,
+	 jit_value_t index, jit_type_t type) JIT_NOTHROW;
+int jit_insn_vstore
+	(jit_function_t func, jit_value_t base_addr,
+	 jit_value_t index, jit_value_t value) JIT_NOTHROW;
+jit_value_t jit_insn_vadd
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vsub
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vmul
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vdiv
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vmin
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vmax
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vsqrt
+	(jit_function_t func, jit_value_t value1) JIT_NOTHROW;
+jit_value_t jit_insn_vand
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vor
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vxor
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vandnot
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_veq
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vne
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vlt
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vle
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vgt
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vge
+	(jit_function_t func, jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vselect
+	(jit_function_t func, jit_value_t mask,
+	 jit_value_t value1, jit_value_t value2) JIT_NOTHROW;
+jit_value_t jit_insn_vshuffle
+	(jit_function_t func, jit_value_t value, jit_nint order) JIT_NOTHROW;
+jit_value_t jit_insn_vbroadcast
+	(jit_function_t func, jit_value_t value, jit_type_t type) JIT_NOTHROW;
+jit_value_t jit_insn_vextract
+	(jit_function_t func, jit_value_t value, unsigned int lane) JIT_NOTHROW;
+jit_value_t jit_insn_vreduce_add
+	(jit_function_t func, jit_value_t value) JIT_NOTHROW;
+jit_value_t jit_insn_vreduce_min
+	(jit_function_t func, jit_value_t value) JIT_NOTHROW;
+jit_value_t jit_insn_vreduce_max
+	(jit_function_t func, jit_value_t value) JIT_NOTHROW;
 int jit_insn_branch
 	(jit_function_t func, jit_label_t *label) JIT_NOTHROW;
 int jit_insn_branch_if
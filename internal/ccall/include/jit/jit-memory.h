@@ -68,6 +68,18 @@ struct jit_memory_manager
 	void (*free_closure)(jit_memory_context_t memctx, void *ptr);
 
 	void * (*alloc_data)(jit_memory_context_t memctx, jit_size_t size, jit_size_t align);
+
+	/* Optional, may be null if the code of functions cannot be freed */
+	void (*free_code)(jit_memory_context_t memctx, jit_function_info_t info);
+
+	/* Optional, may be null if the memory manager does not use huge pages */
+	jit_nuint (*get_num_huge_pages)(jit_memory_context_t memctx);
+
+	/* Optional, may be null if code is written to the address it runs at.
+	   Otherwise returns the offset from the address that code runs at to
+	   the address that it is written to, which must be the same for all
+	   code, data, trampolines and closures */
+	jit_nint (*get_write_offset)(jit_memory_context_t memctx);
 };
 
 jit_memory_manager_t jit_default_memory_manager(void) JIT_NOTHROW;
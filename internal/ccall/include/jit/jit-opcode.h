@@ -466,7 +466,62 @@ extern	"C" {
 #define	JIT_OP_MARK_OFFSET					0x01B2
 #define	JIT_OP_MARK_BREAKPOINT					0x01B3
 #define	JIT_OP_JUMP_TABLE					0x01B4
-#define	JIT_OP_NUM_OPCODES					0x01B5
+#define	JIT_OP_COPY_VECTOR					0x01B5
+#define	JIT_OP_LOAD_RELATIVE_VECTOR			0x01B6
+#define	JIT_OP_STORE_RELATIVE_VECTOR		0x01B7
+#define	JIT_OP_VIADD						0x01B8
+#define	JIT_OP_VISUB						0x01B9
+#define	JIT_OP_VIMUL						0x01BA
+#define	JIT_OP_VLADD						0x01BB
+#define	JIT_OP_VLSUB						0x01BC
+#define	JIT_OP_VFADD						0x01BD
+#define	JIT_OP_VFSUB						0x01BE
+#define	JIT_OP_VFMUL						0x01BF
+#define	JIT_OP_VFDIV						0x01C0
+#define	JIT_OP_VFMIN						0x01C1
+#define	JIT_OP_VFMAX						0x01C2
+#define	JIT_OP_VFSQRT						0x01C3
+#define	JIT_OP_VDADD						0x01C4
+#define	JIT_OP_VDSUB						0x01C5
+#define	JIT_OP_VDMUL						0x01C6
+#define	JIT_OP_VDDIV						0x01C7
+#define	JIT_OP_VDMIN						0x01C8
+#define	JIT_OP_VDMAX						0x01C9
+#define	JIT_OP_VDSQRT						0x01CA
+#define	JIT_OP_VAND							0x01CB
+#define	JIT_OP_VOR							0x01CC
+#define	JIT_OP_VXOR							0x01CD
+#define	JIT_OP_VANDNOT						0x01CE
+#define	JIT_OP_VIEQ							0x01CF
+#define	JIT_OP_VIGT							0x01D0
+#define	JIT_OP_VLEQ							0x01D1
+#define	JIT_OP_VLGT							0x01D2
+#define	JIT_OP_VFEQ							0x01D3
+#define	JIT_OP_VFNE							0x01D4
+#define	JIT_OP_VFLT							0x01D5
+#define	JIT_OP_VFLE							0x01D6
+#define	JIT_OP_VDEQ							0x01D7
+#define	JIT_OP_VDNE							0x01D8
+#define	JIT_OP_VDLT							0x01D9
+#define	JIT_OP_VDLE							0x01DA
+#define	JIT_OP_VSHUFFLE						0x01DB
+#define	JIT_OP_VIBROADCAST					0x01DC
+#define	JIT_OP_VLBROADCAST					0x01DD
+#define	JIT_OP_VFBROADCAST					0x01DE
+#define	JIT_OP_VDBROADCAST					0x01DF
+#define	JIT_OP_VIEXTRACT					0x01E0
+#define	JIT_OP_VLEXTRACT					0x01E1
+#define	JIT_OP_VFEXTRACT					0x01E2
+#define	JIT_OP_VDEXTRACT					0x01E3
+#define	JIT_OP_VIREDUCE_ADD					0x01E4
+#define	JIT_OP_VLREDUCE_ADD					0x01E5
+#define	JIT_OP_VFREDUCE_ADD					0x01E6
+#define	JIT_OP_VDREDUCE_ADD					0x01E7
+#define	JIT_OP_VFREDUCE_MIN					0x01E8
+#define	JIT_OP_VFREDUCE_MAX					0x01E9
+#define	JIT_OP_VDREDUCE_MIN					0x01EA
+#define	JIT_OP_VDREDUCE_MAX					0x01EB
+#define	JIT_OP_NUM_OPCODES					0x01EC
 
 /*
  * Opcode information.
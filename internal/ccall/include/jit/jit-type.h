@@ -46,6 +46,14 @@ JIT_EXPORT_DATA jit_type_t const jit_type_float64;
 JIT_EXPORT_DATA jit_type_t const jit_type_nfloat;
 JIT_EXPORT_DATA jit_type_t const jit_type_void_ptr;
 
+/*
+ * Type descriptors for the 128-bit packed vector types.
+ */
+JIT_EXPORT_DATA jit_type_t const jit_type_v4i32;
+JIT_EXPORT_DATA jit_type_t const jit_type_v2i64;
+JIT_EXPORT_DATA jit_type_t const jit_type_v4f32;
+JIT_EXPORT_DATA jit_type_t const jit_type_v2f64;
+
 /*
  * Type descriptors for the system "char", "int", "long", etc types.
  * These are defined to one of the above values.
@@ -89,6 +97,7 @@ JIT_EXPORT_DATA jit_type_t const jit_type_sys_long_double;
 #define	JIT_TYPE_UNION				15
 #define	JIT_TYPE_SIGNATURE			16
 #define	JIT_TYPE_PTR				17
+#define	JIT_TYPE_VECTOR				18
 #define	JIT_TYPE_FIRST_TAGGED		32
 
 /*
@@ -188,6 +197,8 @@ int jit_type_is_union(jit_type_t type) JIT_NOTHROW;
 int jit_type_is_signature(jit_type_t type) JIT_NOTHROW;
 int jit_type_is_pointer(jit_type_t type) JIT_NOTHROW;
 int jit_type_is_tagged(jit_type_t type) JIT_NOTHROW;
+int jit_type_is_vector(jit_type_t type) JIT_NOTHROW;
+jit_type_t jit_type_get_lane_type(jit_type_t type) JIT_NOTHROW;
 jit_type_t jit_type_remove_tags(jit_type_t type) JIT_NOTHROW;
 jit_type_t jit_type_normalize(jit_type_t type) JIT_NOTHROW;
 jit_type_t jit_type_promote_int(jit_type_t type) JIT_NOTHROW;
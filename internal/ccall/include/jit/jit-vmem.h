@@ -43,6 +43,7 @@ jit_nuint jit_vmem_round_up(jit_nuint value);
 jit_nuint jit_vmem_round_down(jit_nuint value);
 
 void *jit_vmem_reserve(jit_uint size);
+void *jit_vmem_reserve_near(void *near, jit_uint size, jit_nuint range);
 void *jit_vmem_reserve_committed(jit_uint size, jit_prot_t prot);
 int jit_vmem_release(void *addr, jit_uint size);
 
@@ -51,6 +52,16 @@ int jit_vmem_decommit(void *addr, jit_uint size);
 
 int jit_vmem_protect(void *addr, jit_uint size, jit_prot_t prot);
 
+jit_nuint jit_vmem_huge_page_size(void);
+int jit_vmem_commit_huge(void *addr, jit_uint size, jit_prot_t prot);
+int jit_vmem_advise_huge(void *addr, jit_uint size);
+jit_nuint jit_vmem_count_huge(void *addr, jit_nuint size);
+
+int jit_vmem_shared_create(jit_nuint size);
+void jit_vmem_shared_destroy(int fd);
+int jit_vmem_commit_shared(void *addr, jit_uint size, jit_prot_t prot, int fd, jit_nuint offset);
+int jit_vmem_discard_shared(void *addr, jit_uint size);
+
 #ifdef	__cplusplus
 }
 #endif
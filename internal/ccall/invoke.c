@@ -0,0 +1,127 @@
+#include "jit-internal.h"
+#include "jit-setjmp.h"
+
+/*
+ * Typed entry points for calling compiled functions from Go.
+ *
+ * Each helper receives its arguments in registers and calls the native
+ * entry point of the function with a C function pointer of the matching
+ * type, so there is no argument vector to build and no "jit_apply"
+ * marshaling.  Like "jit_function_apply", the call acts as an exception
+ * blocker: if an exception escapes from the function, the zero value of
+ * the return type is returned.  The call also holds an epoch section, so
+ * that code which is evicted while it runs is not freed under it.
+ *
+ * The function handle and pointer values are passed as integers so that
+ * cgo does not have to check (and heap allocate) them on every call.
+ */
+
+static void *invoke_entry(jit_function_t func)
+{
+	if(!func)
+	{
+		jit_exception_builtin(JIT_RESULT_NULL_FUNCTION);
+		return 0;
+	}
+	if(func->nested_parent)
+	{
+		jit_exception_builtin(JIT_RESULT_CALLED_NESTED);
+		return 0;
+	}
+	_jit_function_touch(func);
+	if(!func->is_compiled)
+	{
+		(*func->context->on_demand_driver)(func);
+	}
+
+	/* Code that is freed from here on is kept until the call returns.
+	   If the code was freed since it was compiled, the entry point is
+	   the redirector, which compiles it again */
+	_jit_epoch_enter();
+	return func->entry_point;
+}
+
+#define INVOKE_BEGIN(rtype)						\
+	struct jit_backtrace call_trace;				\
+	jit_jmp_buf jbuf;						\
+	void *entry;							\
+	jit_function_t func = (jit_function_t)handle;			\
+	rtype result;							\
+	_jit_unwind_push_setjmp(&jbuf);					\
+	if(setjmp(jbuf.buf))						\
+	{								\
+		_jit_unwind_pop_setjmp();				\
+		return (rtype)0;					\
+	}								\
+	_jit_backtrace_push(&call_trace, 0);				\
+	entry = invoke_entry(func);					\
+	jit_exception_clear_last()
+
+#define INVOKE_END()							\
+	_jit_epoch_leave();						\
+	_jit_unwind_pop_setjmp();					\
+	return result
+
+#define INVOKE0(name, rtype)						\
+rtype name(jit_nuint handle)						\
+{									\
+	INVOKE_BEGIN(rtype);						\
+	result = ((rtype (*)(void))entry)();				\
+	INVOKE_END();							\
+}
+
+#define INVOKE1(name, rtype, atype)					\
+rtype name(jit_nuint handle, atype a1)				\
+{									\
+	INVOKE_BEGIN(rtype);						\
+	result = ((rtype (*)(atype))entry)(a1);				\
+	INVOKE_END();							\
+}
+
+#define INVOKE2(name, rtype, atype)					\
+rtype name(jit_nuint handle, atype a1, atype a2)			\
+{									\
+	INVOKE_BEGIN(rtype);						\
+	result = ((rtype (*)(atype, atype))entry)(a1, a2);		\
+	INVOKE_END();							\
+}
+
+#define INVOKE3(name, rtype, atype)					\
+rtype name(jit_nuint handle, atype a1, atype a2, atype a3)		\
+{									\
+	INVOKE_BEGIN(rtype);						\
+	result = ((rtype (*)(atype, atype, atype))entry)(a1, a2, a3);	\
+	INVOKE_END();							\
+}
+
+#define INVOKE4(name, rtype, atype)					\
+rtype name(jit_nuint handle, atype a1, atype a2, atype a3, atype a4) \
+{									\
+	INVOKE_BEGIN(rtype);						\
+	result = ((rtype (*)(atype, atype, atype, atype))entry)(a1, a2, a3, a4); \
+	INVOKE_END();							\
+}
+
+INVOKE0(invoke_long0, jit_long)
+INVOKE1(invoke_long1, jit_long, jit_long)
+INVOKE2(invoke_long2, jit_long, jit_long)
+INVOKE3(invoke_long3, jit_long, jit_long)
+INVOKE4(invoke_long4, jit_long, jit_long)
+
+INVOKE0(invoke_float32_0, jit_float32)
+INVOKE1(invoke_float32_1, jit_float32, jit_float32)
+INVOKE2(invoke_float32_2, jit_float32, jit_float32)
+INVOKE3(invoke_float32_3, jit_float32, jit_float32)
+INVOKE4(invoke_float32_4, jit_float32, jit_float32)
+
+INVOKE0(invoke_float64_0, jit_float64)
+INVOKE1(invoke_float64_1, jit_float64, jit_float64)
+INVOKE2(invoke_float64_2, jit_float64, jit_float64)
+INVOKE3(invoke_float64_3, jit_float64, jit_float64)
+INVOKE4(invoke_float64_4, jit_float64, jit_float64)
+
+INVOKE0(invoke_ptr0, void *)
+INVOKE1(invoke_ptr1, void *, jit_nuint)
+INVOKE2(invoke_ptr2, void *, jit_nuint)
+INVOKE3(invoke_ptr3, void *, jit_nuint)
+INVOKE4(invoke_ptr4, void *, jit_nuint)
@@ -0,0 +1,175 @@
+package ccall
+
+/*
+#cgo CFLAGS: -I../
+#cgo CFLAGS: -Iinclude
+
+#include <jit/jit.h>
+
+extern jit_long invoke_long0(jit_nuint);
+extern jit_long invoke_long1(jit_nuint, jit_long);
+extern jit_long invoke_long2(jit_nuint, jit_long, jit_long);
+extern jit_long invoke_long3(jit_nuint, jit_long, jit_long, jit_long);
+extern jit_long invoke_long4(jit_nuint, jit_long, jit_long, jit_long, jit_long);
+
+extern jit_float32 invoke_float32_0(jit_nuint);
+extern jit_float32 invoke_float32_1(jit_nuint, jit_float32);
+extern jit_float32 invoke_float32_2(jit_nuint, jit_float32, jit_float32);
+extern jit_float32 invoke_float32_3(jit_nuint, jit_float32, jit_float32, jit_float32);
+extern jit_float32 invoke_float32_4(jit_nuint, jit_float32, jit_float32, jit_float32, jit_float32);
+
+extern jit_float64 invoke_float64_0(jit_nuint);
+extern jit_float64 invoke_float64_1(jit_nuint, jit_float64);
+extern jit_float64 invoke_float64_2(jit_nuint, jit_float64, jit_float64);
+extern jit_float64 invoke_float64_3(jit_nuint, jit_float64, jit_float64, jit_float64);
+extern jit_float64 invoke_float64_4(jit_nuint, jit_float64, jit_float64, jit_float64, jit_float64);
+
+extern void *invoke_ptr0(jit_nuint);
+extern void *invoke_ptr1(jit_nuint, jit_nuint);
+extern void *invoke_ptr2(jit_nuint, jit_nuint, jit_nuint);
+extern void *invoke_ptr3(jit_nuint, jit_nuint, jit_nuint, jit_nuint);
+extern void *invoke_ptr4(jit_nuint, jit_nuint, jit_nuint, jit_nuint, jit_nuint);
+*/
+import "C"
+import (
+	"runtime"
+	"unsafe"
+)
+
+// Value kinds accepted by the typed invocation helpers.
+const (
+	InvokeInt64 = iota
+	InvokeFloat32
+	InvokeFloat64
+	InvokePointer
+)
+
+func isInvokeKind(t *Type, kind int) bool {
+	if t.IsPointer() {
+		return kind == InvokePointer
+	}
+	switch t.Normalize().Kind() {
+	case JIT_TYPE_LONG, JIT_TYPE_ULONG:
+		return kind == InvokeInt64 || kind == InvokePointer
+	case JIT_TYPE_FLOAT32:
+		return kind == InvokeFloat32
+	case JIT_TYPE_FLOAT64:
+		return kind == InvokeFloat64
+	}
+	return false
+}
+
+// IsInvokeSignature reports whether the function takes numParams parameters
+// of the given kind and returns a value of the same kind.
+func (f *Function) IsInvokeSignature(kind int, numParams uint) bool {
+	sig := f.Signature()
+	if sig.NumParams() != numParams || !isInvokeKind(sig.Return(), kind) {
+		return false
+	}
+	for i := uint(0); i < numParams; i++ {
+		if !isInvokeKind(sig.Param(i), kind) {
+			return false
+		}
+	}
+	return true
+}
+
+// handle passes the function to the invoke helpers as an integer, which
+// keeps cgo from checking and heap allocating the argument on each call.
+func (f *Function) handle() C.jit_nuint {
+	return C.jit_nuint(uintptr(unsafe.Pointer(f.c)))
+}
+
+func (f *Function) InvokeInt64x0() int64 {
+	return int64(C.invoke_long0(f.handle()))
+}
+
+func (f *Function) InvokeInt64x1(a1 int64) int64 {
+	return int64(C.invoke_long1(f.handle(), C.jit_long(a1)))
+}
+
+func (f *Function) InvokeInt64x2(a1, a2 int64) int64 {
+	return int64(C.invoke_long2(f.handle(), C.jit_long(a1), C.jit_long(a2)))
+}
+
+func (f *Function) InvokeInt64x3(a1, a2, a3 int64) int64 {
+	return int64(C.invoke_long3(f.handle(), C.jit_long(a1), C.jit_long(a2), C.jit_long(a3)))
+}
+
+func (f *Function) InvokeInt64x4(a1, a2, a3, a4 int64) int64 {
+	return int64(C.invoke_long4(f.handle(), C.jit_long(a1), C.jit_long(a2), C.jit_long(a3), C.jit_long(a4)))
+}
+
+func (f *Function) InvokeFloat32x0() float32 {
+	return float32(C.invoke_float32_0(f.handle()))
+}
+
+func (f *Function) InvokeFloat32x1(a1 float32) float32 {
+	return float32(C.invoke_float32_1(f.handle(), C.jit_float32(a1)))
+}
+
+func (f *Function) InvokeFloat32x2(a1, a2 float32) float32 {
+	return float32(C.invoke_float32_2(f.handle(), C.jit_float32(a1), C.jit_float32(a2)))
+}
+
+func (f *Function) InvokeFloat32x3(a1, a2, a3 float32) float32 {
+	return float32(C.invoke_float32_3(f.handle(), C.jit_float32(a1), C.jit_float32(a2), C.jit_float32(a3)))
+}
+
+func (f *Function) InvokeFloat32x4(a1, a2, a3, a4 float32) float32 {
+	return float32(C.invoke_float32_4(f.handle(), C.jit_float32(a1), C.jit_float32(a2), C.jit_float32(a3), C.jit_float32(a4)))
+}
+
+func (f *Function) InvokeFloat64x0() float64 {
+	return float64(C.invoke_float64_0(f.handle()))
+}
+
+func (f *Function) InvokeFloat64x1(a1 float64) float64 {
+	return float64(C.invoke_float64_1(f.handle(), C.jit_float64(a1)))
+}
+
+func (f *Function) InvokeFloat64x2(a1, a2 float64) float64 {
+	return float64(C.invoke_float64_2(f.handle(), C.jit_float64(a1), C.jit_float64(a2)))
+}
+
+func (f *Function) InvokeFloat64x3(a1, a2, a3 float64) float64 {
+	return float64(C.invoke_float64_3(f.handle(), C.jit_float64(a1), C.jit_float64(a2), C.jit_float64(a3)))
+}
+
+func (f *Function) InvokeFloat64x4(a1, a2, a3, a4 float64) float64 {
+	return float64(C.invoke_float64_4(f.handle(), C.jit_float64(a1), C.jit_float64(a2), C.jit_float64(a3), C.jit_float64(a4)))
+}
+
+func (f *Function) InvokePointerx0() unsafe.Pointer {
+	return C.invoke_ptr0(f.handle())
+}
+
+func (f *Function) InvokePointerx1(a1 unsafe.Pointer) unsafe.Pointer {
+	r := C.invoke_ptr1(f.handle(), C.jit_nuint(uintptr(a1)))
+	runtime.KeepAlive(a1)
+	return r
+}
+
+func (f *Function) InvokePointerx2(a1, a2 unsafe.Pointer) unsafe.Pointer {
+	r := C.invoke_ptr2(f.handle(), C.jit_nuint(uintptr(a1)), C.jit_nuint(uintptr(a2)))
+	runtime.KeepAlive(a1)
+	runtime.KeepAlive(a2)
+	return r
+}
+
+func (f *Function) InvokePointerx3(a1, a2, a3 unsafe.Pointer) unsafe.Pointer {
+	r := C.invoke_ptr3(f.handle(), C.jit_nuint(uintptr(a1)), C.jit_nuint(uintptr(a2)), C.jit_nuint(uintptr(a3)))
+	runtime.KeepAlive(a1)
+	runtime.KeepAlive(a2)
+	runtime.KeepAlive(a3)
+	return r
+}
+
+func (f *Function) InvokePointerx4(a1, a2, a3, a4 unsafe.Pointer) unsafe.Pointer {
+	r := C.invoke_ptr4(f.handle(), C.jit_nuint(uintptr(a1)), C.jit_nuint(uintptr(a2)), C.jit_nuint(uintptr(a3)), C.jit_nuint(uintptr(a4)))
+	runtime.KeepAlive(a1)
+	runtime.KeepAlive(a2)
+	runtime.KeepAlive(a3)
+	runtime.KeepAlive(a4)
+	return r
+}
@@ -0,0 +1,890 @@
+/*
+ * jit-access.c - Redundant load and dead store elimination.
+ *
+ * This file is part of the libjit library.
+ *
+ * The libjit library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * The libjit library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the libjit library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "jit-internal.h"
+#include "jit-rules.h"
+
+/*
+ * Loads and stores at a constant offset from a pointer are followed
+ * through each block, and on into a block that only the previous block
+ * leads to.  This is not memory SSA: what is known is not merged where
+ * paths join.  A memory location is known by its base pointer, its offset
+ * and its size.  The address of a constant pointer is added to the
+ * offset, so that locations at fixed addresses are told apart as well.
+ * Locations at different base pointers may overlap.
+ *
+ * A load from a location whose value is known, because it was loaded or
+ * stored before, becomes a copy of that value.  A store is deleted when
+ * the same location is stored again in the same block, with nothing in
+ * between that may read the location or throw.  An access through the
+ * same base pointer is taken not to fault once the store through it did
+ * not, but an access at a fixed address may.  Every location is
+ * forgotten at an instruction that may write memory other than a store
+ * at a known location, except for a call to a function that is marked
+ * pure.  The same goes for any instruction that uses a volatile value
+ * or a value whose address is taken, because such values live in memory
+ * that pointers may reach.
+ *
+ * The one join that is handled is the header of a loop whose blocks
+ * follow it in a line, once the loop pass has given it a preheader.  A
+ * load in the header that runs before anything may write its location,
+ * leave the loop or fault, reads what the preheader or the end of the
+ * previous iteration left there.  If the end of the iteration knows that
+ * value, it is copied to a new variable there, the preheader loads the
+ * variable for the first iteration, and the load becomes a copy of it.
+ * Loops that test their condition before the loads are not handled,
+ * because the load would run in the preheader when the loop does not.
+ */
+
+/*
+ * Number of locations that are kept track of at once.
+ */
+#define	MAX_ACCESSES		32
+
+/*
+ * Memory location with the value that it holds.
+ */
+typedef struct
+{
+	/* The base pointer, or NULL for a fixed address */
+	jit_value_t		base;
+	jit_nint		offset;
+	int			size;
+
+	/* The load or store that accessed the location last, the value
+	   that it loaded or stored, and the block of that instruction */
+	int			opcode;
+	jit_value_t		value;
+	jit_block_t		block;
+
+	/* Position of a store in the current block that nothing may have
+	   read yet, or -1 */
+	int			store;
+
+} _jit_access_t;
+
+typedef struct
+{
+	_jit_access_t		accesses[MAX_ACCESSES];
+	int			num_accesses;
+
+} _jit_access_state_t;
+
+/*
+ * Get the number of bytes that a relative load or store accesses, or
+ * zero if it is not such an instruction or the size is not known.
+ */
+static int
+access_size(int opcode)
+{
+	switch(opcode)
+	{
+	case JIT_OP_LOAD_RELATIVE_SBYTE:
+	case JIT_OP_LOAD_RELATIVE_UBYTE:
+	case JIT_OP_STORE_RELATIVE_BYTE:
+		return 1;
+
+	case JIT_OP_LOAD_RELATIVE_SHORT:
+	case JIT_OP_LOAD_RELATIVE_USHORT:
+	case JIT_OP_STORE_RELATIVE_SHORT:
+		return 2;
+
+	case JIT_OP_LOAD_RELATIVE_INT:
+	case JIT_OP_STORE_RELATIVE_INT:
+	case JIT_OP_LOAD_RELATIVE_FLOAT32:
+	case JIT_OP_STORE_RELATIVE_FLOAT32:
+		return 4;
+
+	case JIT_OP_LOAD_RELATIVE_LONG:
+	case JIT_OP_STORE_RELATIVE_LONG:
+	case JIT_OP_LOAD_RELATIVE_FLOAT64:
+	case JIT_OP_STORE_RELATIVE_FLOAT64:
+		return 8;
+
+	case JIT_OP_LOAD_RELATIVE_NFLOAT:
+	case JIT_OP_STORE_RELATIVE_NFLOAT:
+		return sizeof(jit_nfloat);
+	}
+	return 0;
+}
+
+/*
+ * Determine if an opcode neither reads nor writes memory that pointers
+ * may reach, and cannot throw.
+ */
+static int
+is_transparent(int opcode)
+{
+	switch(opcode)
+	{
+	case JIT_OP_NOP:
+	case JIT_OP_MARK_OFFSET:
+	case JIT_OP_ADDRESS_OF:
+	case JIT_OP_INCOMING_REG:
+	case JIT_OP_INCOMING_FRAME_POSN:
+	case JIT_OP_OUTGOING_REG:
+	case JIT_OP_RETURN_REG:
+	case JIT_OP_RETRIEVE_FRAME_POINTER:
+	case JIT_OP_POP_STACK:
+	case JIT_OP_PUSH_RETURN_AREA_PTR:
+		return 1;
+	}
+	return _jit_opcode_is_pure(opcode)
+		|| (opcode >= JIT_OP_BR && opcode <= JIT_OP_BR_NFGE_INV)
+		|| (opcode >= JIT_OP_COPY_LOAD_SBYTE && opcode <= JIT_OP_COPY_STORE_SHORT)
+		|| (opcode >= JIT_OP_PUSH_INT && opcode <= JIT_OP_PUSH_NFLOAT)
+		|| (opcode >= JIT_OP_SET_PARAM_INT && opcode <= JIT_OP_SET_PARAM_NFLOAT);
+}
+
+/*
+ * Determine if an instruction may read memory or throw, but does not
+ * write memory that pointers may reach.
+ */
+static int
+is_read_only(jit_insn_t insn)
+{
+	int opcode = insn->opcode;
+
+	if(opcode >= JIT_OP_CALL && opcode <= JIT_OP_CALL_EXTERNAL_TAIL)
+	{
+		return (insn->flags & JIT_INSN_CALL_IS_PURE) != 0;
+	}
+	return opcode == JIT_OP_CHECK_NULL
+		|| (opcode >= JIT_OP_TRUNC_SBYTE && opcode <= JIT_OP_LSHR_UN)
+		|| (opcode >= JIT_OP_ICMP && opcode <= JIT_OP_NFSIGN)
+		|| (opcode >= JIT_OP_RETURN && opcode <= JIT_OP_RETURN_SMALL_STRUCT)
+		|| (opcode >= JIT_OP_LOAD_RELATIVE_SBYTE && opcode <= JIT_OP_LOAD_RELATIVE_STRUCT)
+		|| (opcode >= JIT_OP_LOAD_ELEMENT_SBYTE && opcode <= JIT_OP_LOAD_ELEMENT_NFLOAT)
+		|| opcode == JIT_OP_LOAD_RELATIVE_VECTOR
+		|| opcode == JIT_OP_PUSH_STRUCT
+		|| opcode == JIT_OP_SET_PARAM_STRUCT;
+}
+
+/*
+ * Determine if an instruction uses or defines a value that lives in
+ * memory that pointers may reach.
+ */
+static int
+uses_memory_value(jit_insn_t insn)
+{
+	jit_value_t value;
+
+	if((insn->flags & JIT_INSN_DEST_OTHER_FLAGS) == 0)
+	{
+		value = insn->dest;
+		if(value && (value->is_volatile || value->is_addressable))
+		{
+			return 1;
+		}
+	}
+	if((insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0)
+	{
+		value = insn->value1;
+		if(value && (value->is_volatile || value->is_addressable))
+		{
+			return 1;
+		}
+	}
+	if((insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0)
+	{
+		value = insn->value2;
+		if(value && (value->is_volatile || value->is_addressable))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Get the location that a relative load or store accesses from its base
+ * pointer and offset.  Returns zero if the base pointer is a constant
+ * that is not an address.
+ */
+static int
+get_location(jit_value_t base_value, jit_value_t offset_value,
+	     jit_value_t *base, jit_nint *offset)
+{
+	*offset = jit_value_get_nint_constant(offset_value);
+	if(!base_value->is_constant)
+	{
+		*base = base_value;
+		return 1;
+	}
+	if(!base_value->is_nint_constant)
+	{
+		return 0;
+	}
+	*base = 0;
+	*offset += jit_value_get_nint_constant(base_value);
+	return 1;
+}
+
+/*
+ * Determine if a known location may overlap another location.
+ */
+static int
+may_overlap(_jit_access_t *access, jit_value_t base, jit_nint offset, int size)
+{
+	return access->base != base
+		|| (access->offset < offset + size && offset < access->offset + access->size);
+}
+
+/*
+ * Get the opcode that computes the value that a load would load from a
+ * known location out of the value that the location holds, or zero if
+ * there is none.
+ */
+static int
+forward_opcode(_jit_access_t *access, jit_insn_t load)
+{
+	if(access->opcode == load->opcode)
+	{
+		return _jit_store_opcode(JIT_OP_COPY_INT, JIT_OP_COPY_STORE_BYTE, load->dest->type);
+	}
+	switch(access->opcode)
+	{
+	case JIT_OP_STORE_RELATIVE_BYTE:
+		if(load->opcode == JIT_OP_LOAD_RELATIVE_SBYTE)
+		{
+			return JIT_OP_TRUNC_SBYTE;
+		}
+		if(load->opcode == JIT_OP_LOAD_RELATIVE_UBYTE)
+		{
+			return JIT_OP_TRUNC_UBYTE;
+		}
+		break;
+
+	case JIT_OP_STORE_RELATIVE_SHORT:
+		if(load->opcode == JIT_OP_LOAD_RELATIVE_SHORT)
+		{
+			return JIT_OP_TRUNC_SHORT;
+		}
+		if(load->opcode == JIT_OP_LOAD_RELATIVE_USHORT)
+		{
+			return JIT_OP_TRUNC_USHORT;
+		}
+		break;
+
+	case JIT_OP_STORE_RELATIVE_INT:
+	case JIT_OP_STORE_RELATIVE_LONG:
+	case JIT_OP_STORE_RELATIVE_FLOAT32:
+	case JIT_OP_STORE_RELATIVE_FLOAT64:
+	case JIT_OP_STORE_RELATIVE_NFLOAT:
+		/* Stores and loads of full values are in the same order */
+		if(load->opcode - JIT_OP_LOAD_RELATIVE_INT
+		   == access->opcode - JIT_OP_STORE_RELATIVE_INT)
+		{
+			return _jit_store_opcode(JIT_OP_COPY_INT, JIT_OP_COPY_STORE_BYTE,
+						 load->dest->type);
+		}
+		break;
+	}
+	return 0;
+}
+
+static _jit_access_t *
+find_access(_jit_access_state_t *state, jit_value_t base, jit_nint offset, int size)
+{
+	int index;
+
+	for(index = 0; index < state->num_accesses; index++)
+	{
+		if(state->accesses[index].base == base
+		   && state->accesses[index].offset == offset
+		   && state->accesses[index].size == size)
+		{
+			return &state->accesses[index];
+		}
+	}
+	return 0;
+}
+
+static void
+add_access(_jit_access_state_t *state, jit_value_t base, jit_nint offset, int size,
+	   jit_insn_t insn, jit_value_t value, jit_block_t block, int store)
+{
+	_jit_access_t *access;
+
+	if(state->num_accesses == MAX_ACCESSES)
+	{
+		/* Forget the oldest location */
+		jit_memmove(&state->accesses[0], &state->accesses[1],
+			    (MAX_ACCESSES - 1) * sizeof(_jit_access_t));
+		--(state->num_accesses);
+	}
+	access = &state->accesses[(state->num_accesses)++];
+	access->base = base;
+	access->offset = offset;
+	access->size = size;
+	access->opcode = insn->opcode;
+	access->value = value;
+	access->block = block;
+	access->store = store;
+}
+
+/*
+ * Forget the locations that "keep" tells to forget, keeping the others
+ * in order.
+ */
+static void
+remove_accesses(_jit_access_state_t *state, int (*keep)(_jit_access_t *, void *), void *data)
+{
+	int index, num;
+
+	num = 0;
+	for(index = 0; index < state->num_accesses; index++)
+	{
+		if(keep(&state->accesses[index], data))
+		{
+			state->accesses[num++] = state->accesses[index];
+		}
+	}
+	state->num_accesses = num;
+}
+
+static int
+keep_unrelated(_jit_access_t *access, void *data)
+{
+	return access->base != (jit_value_t) data && access->value != (jit_value_t) data;
+}
+
+/*
+ * Forget the locations at a pointer or holding a value that changes.
+ */
+static void
+forget_value(_jit_access_state_t *state, jit_value_t value)
+{
+	remove_accesses(state, keep_unrelated, value);
+}
+
+static int
+keep_separate(_jit_access_t *access, void *data)
+{
+	_jit_access_t *location = (_jit_access_t *) data;
+
+	return !may_overlap(access, location->base, location->offset, location->size);
+}
+
+/*
+ * Forget the locations that a store may overwrite.
+ */
+static void
+forget_overlapping(_jit_access_state_t *state, jit_value_t base, jit_nint offset, int size)
+{
+	_jit_access_t location;
+
+	location.base = base;
+	location.offset = offset;
+	location.size = size;
+	remove_accesses(state, keep_separate, &location);
+}
+
+/*
+ * Record that the stores so far may be read, or that something may
+ * throw after them, so that none of them is deleted.
+ */
+static void
+keep_stores(_jit_access_state_t *state)
+{
+	int index;
+
+	for(index = 0; index < state->num_accesses; index++)
+	{
+		state->accesses[index].store = -1;
+	}
+}
+
+/*
+ * Record that the stores that an access may read, or that may be seen
+ * when it faults, may be read.
+ */
+static void
+keep_stores_before(_jit_access_state_t *state, jit_value_t base, jit_nint offset, int size)
+{
+	int index;
+
+	for(index = 0; index < state->num_accesses; index++)
+	{
+		if(!state->accesses[index].base
+		   || may_overlap(&state->accesses[index], base, offset, size))
+		{
+			state->accesses[index].store = -1;
+		}
+	}
+}
+
+/*
+ * Make a value that is used in another block than the one that defines
+ * it a local variable.
+ */
+static void
+make_local(jit_value_t value)
+{
+	if(value->is_temporary)
+	{
+		value->is_temporary = 0;
+		value->is_local = 1;
+		if(_jit_gen_is_global_candidate(value->type))
+		{
+			value->global_candidate = 1;
+		}
+	}
+}
+
+static void
+optimize_load(_jit_access_state_t *state, jit_block_t block, jit_insn_t insn)
+{
+	_jit_access_t *access;
+	jit_value_t base, value;
+	jit_nint offset;
+	int size, opcode;
+
+	size = access_size(insn->opcode);
+	if(!get_location(insn->value1, insn->value2, &base, &offset))
+	{
+		keep_stores(state);
+		forget_value(state, insn->dest);
+		return;
+	}
+
+	access = find_access(state, base, offset, size);
+	if(access && (opcode = forward_opcode(access, insn)) != 0)
+	{
+		value = access->value;
+		if(value == insn->dest && access->opcode == insn->opcode)
+		{
+			/* The value is loaded again into the same variable */
+			insn->opcode = JIT_OP_NOP;
+			return;
+		}
+
+		/* The value is now used in another block than the one that
+		   defines it */
+		if(access->block != block)
+		{
+			make_local(value);
+		}
+		insn->opcode = (short) opcode;
+		insn->value1 = value;
+		insn->value2 = 0;
+		forget_value(state, insn->dest);
+		return;
+	}
+
+	keep_stores_before(state, base, offset, size);
+	forget_value(state, insn->dest);
+	if(insn->dest != insn->value1)
+	{
+		add_access(state, base, offset, size, insn, insn->dest, block, -1);
+	}
+}
+
+static void
+optimize_store(_jit_access_state_t *state, jit_block_t block, int posn)
+{
+	jit_insn_t insn = &block->insns[posn];
+	_jit_access_t *access;
+	jit_value_t base;
+	jit_nint offset;
+	int size;
+
+	size = access_size(insn->opcode);
+	if(!get_location(insn->dest, insn->value2, &base, &offset))
+	{
+		state->num_accesses = 0;
+		return;
+	}
+
+	/* A store that nothing read is overwritten */
+	access = find_access(state, base, offset, size);
+	if(access && access->store >= 0)
+	{
+		block->insns[access->store].opcode = JIT_OP_NOP;
+		access->store = -1;
+	}
+
+	keep_stores_before(state, base, offset, size);
+	forget_overlapping(state, base, offset, size);
+	add_access(state, base, offset, size, insn, insn->value1, block, posn);
+}
+
+static void
+optimize_block(_jit_access_state_t *state, jit_block_t block)
+{
+	jit_insn_t insn;
+	jit_value_t value;
+	int posn;
+
+	for(posn = 0; posn < block->num_insns; posn++)
+	{
+		insn = &block->insns[posn];
+		if(insn->opcode == JIT_OP_NOP)
+		{
+			continue;
+		}
+		if(uses_memory_value(insn))
+		{
+			state->num_accesses = 0;
+			continue;
+		}
+		if(access_size(insn->opcode) != 0)
+		{
+			if(insn->opcode >= JIT_OP_STORE_RELATIVE_BYTE
+			   && insn->opcode <= JIT_OP_STORE_RELATIVE_STRUCT)
+			{
+				optimize_store(state, block, posn);
+			}
+			else
+			{
+				optimize_load(state, block, insn);
+			}
+			continue;
+		}
+
+		value = _jit_insn_get_def(insn);
+		if(value)
+		{
+			forget_value(state, value);
+		}
+		if(is_transparent(insn->opcode))
+		{
+			continue;
+		}
+		if(is_read_only(insn))
+		{
+			keep_stores(state);
+			continue;
+		}
+		state->num_accesses = 0;
+	}
+}
+
+void
+_jit_function_optimize_accesses(jit_function_t func)
+{
+	_jit_access_state_t state;
+	jit_block_t block, prev;
+
+	/* Exceptions go where the control flow graph does not show */
+	if(func->has_try)
+	{
+		return;
+	}
+
+	state.num_accesses = 0;
+	prev = 0;
+	for(block = func->builder->entry_block; block; block = block->next)
+	{
+		/* What is known at the end of a block holds at the start of a
+		   block that only it leads to, but a store can only be deleted
+		   by another store in its own block */
+		if(!prev || block->address_of || block->num_preds != 1
+		   || block->preds[0]->src != prev)
+		{
+			state.num_accesses = 0;
+		}
+		keep_stores(&state);
+		optimize_block(&state, block);
+		prev = block;
+	}
+}
+
+/*
+ * Determine if a location may overlap one of the known locations.
+ */
+static int
+overlaps_any(_jit_access_state_t *state, jit_value_t base, jit_nint offset, int size)
+{
+	int index;
+
+	for(index = 0; index < state->num_accesses; index++)
+	{
+		if(may_overlap(&state->accesses[index], base, offset, size))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Determine if a value is changed by an instruction in the blocks from
+ * "first" to "last".
+ */
+static int
+is_changed_in(jit_block_t first, jit_block_t last, jit_value_t value)
+{
+	jit_block_t block;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+
+	for(block = first; ; block = block->next)
+	{
+		jit_insn_iter_init(&iter, block);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			if(_jit_insn_get_def(insn) == value)
+			{
+				return 1;
+			}
+		}
+		if(block == last)
+		{
+			return 0;
+		}
+	}
+}
+
+/*
+ * Find the block that ends the iteration of a loop whose blocks follow
+ * its header in a line, each of which only the block before it leads
+ * to.  Returns NULL if the loop has another shape.
+ */
+static jit_block_t
+find_latch(jit_block_t preheader, jit_block_t header)
+{
+	jit_block_t block;
+	int index;
+
+	if(header->num_preds != 2 || header->address_of
+	   || (header->preds[0]->src != preheader && header->preds[1]->src != preheader))
+	{
+		return 0;
+	}
+	for(block = header; block; block = block->next)
+	{
+		if(block != header
+		   && (block->num_preds != 1 || block->preds[0]->src != block->prev
+		       || block->address_of))
+		{
+			return 0;
+		}
+		for(index = 0; index < block->num_succs; index++)
+		{
+			if(block->succs[index]->dst == header)
+			{
+				return block;
+			}
+		}
+	}
+	return 0;
+}
+
+void
+_jit_function_forward_loop_accesses(jit_function_t func, jit_block_t preheader,
+				    jit_block_t header)
+{
+	_jit_access_state_t state;
+	_jit_access_state_t stores;
+	_jit_access_state_t loads;
+	_jit_access_t *access;
+	jit_block_t latch, block;
+	jit_insn_t insn, load;
+	jit_value_t base, value, safe_base, temp;
+	jit_nint offset;
+	int posn, size, index, opcode, located, clobbered, leaves;
+
+	if(func->has_try)
+	{
+		return;
+	}
+	latch = find_latch(preheader, header);
+	if(!latch)
+	{
+		return;
+	}
+
+	/* Follow the locations through one iteration.  A load in the header
+	   reads what the location held on entry to the header if nothing
+	   before it may have written the location, and it may run in the
+	   preheader instead if nothing before it may leave the loop or
+	   fault, other than an access through the same base pointer */
+	state.num_accesses = 0;
+	stores.num_accesses = 0;
+	loads.num_accesses = 0;
+	clobbered = 0;
+	leaves = 0;
+	safe_base = 0;
+	for(block = header; ; block = block->next)
+	{
+		for(posn = 0; posn < block->num_insns; posn++)
+		{
+			insn = &block->insns[posn];
+			if(insn->opcode == JIT_OP_NOP)
+			{
+				continue;
+			}
+			if(uses_memory_value(insn))
+			{
+				state.num_accesses = 0;
+				clobbered = 1;
+				leaves = 1;
+				continue;
+			}
+			size = access_size(insn->opcode);
+			if(size == 0)
+			{
+				value = _jit_insn_get_def(insn);
+				if(value)
+				{
+					forget_value(&state, value);
+				}
+				if(is_transparent(insn->opcode))
+				{
+					continue;
+				}
+				leaves = 1;
+				if(!is_read_only(insn))
+				{
+					state.num_accesses = 0;
+					clobbered = 1;
+				}
+				continue;
+			}
+
+			if(insn->opcode >= JIT_OP_STORE_RELATIVE_BYTE
+			   && insn->opcode <= JIT_OP_STORE_RELATIVE_STRUCT)
+			{
+				located = get_location(insn->dest, insn->value2, &base, &offset);
+				if(!located)
+				{
+					state.num_accesses = 0;
+					clobbered = 1;
+				}
+				else
+				{
+					forget_overlapping(&state, base, offset, size);
+					add_access(&state, base, offset, size, insn, insn->value1, block, -1);
+					if(stores.num_accesses == MAX_ACCESSES)
+					{
+						clobbered = 1;
+					}
+					else
+					{
+						add_access(&stores, base, offset, size, insn,
+							   insn->value1, block, posn);
+					}
+				}
+			}
+			else
+			{
+				located = get_location(insn->value1, insn->value2, &base, &offset);
+				if(located)
+				{
+					access = find_access(&state, base, offset, size);
+					if(!access || !forward_opcode(access, insn))
+					{
+						if(block == header && base && !clobbered && !leaves
+						   && (!safe_base || safe_base == base)
+						   && insn->dest != base
+						   && loads.num_accesses < MAX_ACCESSES
+						   && !overlaps_any(&stores, base, offset, size)
+						   && !find_access(&loads, base, offset, size))
+						{
+							add_access(&loads, base, offset, size, insn,
+								   insn->dest, block, posn);
+						}
+						forget_value(&state, insn->dest);
+						if(insn->dest != insn->value1)
+						{
+							add_access(&state, base, offset, size, insn, insn->dest, block, -1);
+						}
+					}
+					else
+					{
+						forget_value(&state, insn->dest);
+					}
+				}
+				else
+				{
+					forget_value(&state, insn->dest);
+				}
+			}
+
+			/* Accesses through other pointers may fault first */
+			if(!located || !base || (safe_base && safe_base != base))
+			{
+				leaves = 1;
+			}
+			safe_base = located ? base : 0;
+		}
+		if(block == latch)
+		{
+			break;
+		}
+	}
+
+	/* The value that the location holds at the end of the iteration is
+	   carried into the next one in a new variable, which the preheader
+	   loads for the first iteration */
+	for(index = 0; index < loads.num_accesses; index++)
+	{
+		posn = loads.accesses[index].store;
+		access = find_access(&state, loads.accesses[index].base,
+				     loads.accesses[index].offset, loads.accesses[index].size);
+		load = &header->insns[posn];
+		if(!access || (opcode = forward_opcode(access, load)) == 0
+		   || is_changed_in(header, latch, loads.accesses[index].base))
+		{
+			continue;
+		}
+		temp = jit_value_create(func, load->dest->type);
+		if(!temp)
+		{
+			return;
+		}
+		make_local(temp);
+		if(access->block != latch)
+		{
+			make_local(access->value);
+		}
+
+		/* Count the uses like the builder does, so that the variable
+		   may get a global register */
+		temp->usage_count = 3;
+		++(loads.accesses[index].base->usage_count);
+		++(access->value->usage_count);
+
+		insn = _jit_block_add_insn_before_branch(preheader);
+		if(!insn)
+		{
+			return;
+		}
+		load = &header->insns[posn];
+		*insn = *load;
+		insn->dest = temp;
+
+		insn = _jit_block_add_insn_before_branch(latch);
+		if(!insn)
+		{
+			return;
+		}
+		load = &header->insns[posn];
+		insn->opcode = (short) opcode;
+		insn->dest = temp;
+		insn->value1 = access->value;
+
+		load->opcode = (short) _jit_store_opcode(JIT_OP_COPY_INT, JIT_OP_COPY_STORE_BYTE,
+							 load->dest->type);
+		load->value1 = temp;
+		load->value2 = 0;
+	}
+}
@@ -26,8 +26,13 @@
 
 #include "jit-gen-arm.h"
 
+/*
+ * The memory manager only maps code twice for the x86-64 back end, so
+ * "exec_offset" is always zero here.
+ */
+
 void _jit_create_closure(unsigned char *buf, void *func,
-                         void *closure, void *_type)
+                         void *closure, void *_type, jit_nint exec_offset)
 {
 	arm_inst_buf inst;
 
@@ -59,7 +64,7 @@ void _jit_create_closure(unsigned char *buf, void *func,
 }
 
 void *_jit_create_redirector(unsigned char *buf, void *func,
-							 void *user_data, int abi)
+							 void *user_data, int abi, jit_nint exec_offset)
 {
 	arm_inst_buf inst;
 
@@ -102,7 +107,8 @@ void *_jit_create_redirector(unsigned char *buf, void *func,
  * compilation of a method the first time that it is executed and its direct execution
  * the following times
  */
-void *_jit_create_indirector(unsigned char *buf, void **entry)
+void *_jit_create_indirector(unsigned char *buf, void **entry,
+							 jit_nint exec_offset)
 {
 	arm_inst_buf inst;
 	void *start = (void *)buf;
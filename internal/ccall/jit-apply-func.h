@@ -91,13 +91,18 @@
 		} while (0)
 #endif
 
+/*
+ * The stubs below are written to "buf", but run at "buf + exec_offset",
+ * which differs from "buf" if the memory manager maps code twice.
+ */
+
 /*
  * Create a closure for the underlying platform in the given buffer.
  * The closure must arrange to call "func" with two arguments:
  * "closure" and a pointer to an apply structure.
  */
 void _jit_create_closure(unsigned char *buf, void *func,
-                         void *closure, void *type);
+                         void *closure, void *type, jit_nint exec_offset);
 
 /*
  * Create a redirector stub for the underlying platform in the given buffer.
@@ -107,13 +112,14 @@ void _jit_create_closure(unsigned char *buf, void *func,
  * which may be different than "buf" if alignment occurred.
  */
 void *_jit_create_redirector(unsigned char *buf, void *func,
-							 void *user_data, int abi);
+							 void *user_data, int abi, jit_nint exec_offset);
 
 
 /*
  * Create the indirector for the function.
  */
-void *_jit_create_indirector(unsigned char *buf, void **entry);
+void *_jit_create_indirector(unsigned char *buf, void **entry,
+							 jit_nint exec_offset);
 
 /*
  * Pad a buffer with NOP instructions.  Used to align code.
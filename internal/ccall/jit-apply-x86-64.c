@@ -44,7 +44,7 @@
 
 
 void _jit_create_closure(unsigned char *buf, void *func,
-                         void *closure, void *_type)
+                         void *closure, void *_type, jit_nint exec_offset)
 {
 	jit_nint offset;
 
@@ -79,7 +79,7 @@ void _jit_create_closure(unsigned char *buf, void *func,
 	x86_64_mov_reg_reg_size(buf, X86_64_RSI, X86_64_RSP, 8);
 
 	/* Call the closure handling function */
-	offset = (jit_nint)func - ((jit_nint)buf + 5);
+	offset = (jit_nint)func - ((jit_nint)buf + exec_offset + 5);
 	if((offset < jit_min_int) || (offset > jit_max_int))
 	{
 		/* offset is outside the 32 bit offset range */
@@ -103,7 +103,7 @@ void _jit_create_closure(unsigned char *buf, void *func,
 }
 
 void *_jit_create_redirector(unsigned char *buf, void *func,
-							 void *user_data, int abi)
+							 void *user_data, int abi, jit_nint exec_offset)
 {
 	jit_nint offset;
 	void *start = (void *)buf;
@@ -138,7 +138,7 @@ void *_jit_create_redirector(unsigned char *buf, void *func,
 	x86_64_mov_reg_imm_size(buf, X86_64_RDI, (jit_nint)user_data, 8);
 
 	/* Call "func" (the pointer result will be in RAX) */
-	offset = (jit_nint)func - ((jit_nint)buf + 5);
+	offset = (jit_nint)func - ((jit_nint)buf + exec_offset + 5);
 	if((offset < jit_min_int) || (offset > jit_max_int))
 	{
 		/* offset is outside the 32 bit offset range */
@@ -183,7 +183,8 @@ void *_jit_create_redirector(unsigned char *buf, void *func,
 	return start;
 }
 
-void *_jit_create_indirector(unsigned char *buf, void **entry)
+void *_jit_create_indirector(unsigned char *buf, void **entry,
+							 jit_nint exec_offset)
 {
 	void *start = (void *)buf;
 
@@ -195,7 +196,7 @@ void *_jit_create_indirector(unsigned char *buf, void **entry)
 	}
 	else
 	{
-		jit_nint offset = (jit_nint)entry - ((jit_nint)buf + 6);
+		jit_nint offset = (jit_nint)entry - ((jit_nint)buf + exec_offset + 6);
 
 		if((offset >= jit_min_int) && (offset <= jit_max_int))
 		{
@@ -216,31 +217,27 @@ void *_jit_create_indirector(unsigned char *buf, void **entry)
 
 void _jit_pad_buffer(unsigned char *buf, int len)
 {
-	while(len >= 6)
+	/* The multi-byte NOPs recommended by the processor manuals, which
+	   do not touch any register */
+	static const unsigned char nops[9][9] = {
+		{0x90},
+		{0x66, 0x90},
+		{0x0F, 0x1F, 0x00},
+		{0x0F, 0x1F, 0x40, 0x00},
+		{0x0F, 0x1F, 0x44, 0x00, 0x00},
+		{0x66, 0x0F, 0x1F, 0x44, 0x00, 0x00},
+		{0x0F, 0x1F, 0x80, 0x00, 0x00, 0x00, 0x00},
+		{0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+		{0x66, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00}
+	};
+	int size;
+
+	while(len > 0)
 	{
-		/* "leal 0(%esi), %esi" with 32-bit displacement */
-		*buf++ = (unsigned char)0x8D;
-		x86_address_byte(buf, 2, X86_ESI, X86_ESI);
-		x86_imm_emit32(buf, 0);
-		len -= 6;
-	}
-	if(len >= 3)
-	{
-		/* "leal 0(%esi), %esi" with 8-bit displacement */
-		*buf++ = (unsigned char)0x8D;
-		x86_address_byte(buf, 1, X86_ESI, X86_ESI);
-		x86_imm_emit8(buf, 0);
-		len -= 3;
-	}
-	if(len == 1)
-	{
-		/* Traditional x86 NOP */
-		x86_nop(buf);
-	}
-	else if(len == 2)
-	{
-		/* movl %esi, %esi */
-		x86_mov_reg_reg(buf, X86_ESI, X86_ESI, 4);
+		size = (len > 9 ? 9 : len);
+		jit_memcpy(buf, nops[size - 1], size);
+		buf += size;
+		len -= size;
 	}
 }
 
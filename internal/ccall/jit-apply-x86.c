@@ -29,7 +29,7 @@
 #include "jit-gen-x86.h"
 
 void _jit_create_closure(unsigned char *buf, void *func,
-                         void *closure, void *_type)
+                         void *closure, void *_type, jit_nint exec_offset)
 {
 	jit_type_t signature = (jit_type_t)_type;
 	jit_type_t type;
@@ -60,7 +60,7 @@ void _jit_create_closure(unsigned char *buf, void *func,
 	x86_push_imm(buf, (int)closure);
 
 	/* Call the closure handling function */
-	x86_call_code(buf, func);
+	x86_call_code(buf, (unsigned char *)func - exec_offset);
 
 	/* Determine the number of bytes to pop when we return */
 #if JIT_APPLY_X86_FASTCALL == 1
@@ -168,7 +168,7 @@ void _jit_create_closure(unsigned char *buf, void *func,
 }
 
 void *_jit_create_redirector(unsigned char *buf, void *func,
-							 void *user_data, int abi)
+							 void *user_data, int abi, jit_nint exec_offset)
 {
 	void *start = (void *)buf;
 
@@ -185,7 +185,7 @@ void *_jit_create_redirector(unsigned char *buf, void *func,
 	x86_push_imm(buf, (int)user_data);
 
 	/* Call "func" (the pointer result will be in EAX) */
-	x86_call_code(buf, func);
+	x86_call_code(buf, (unsigned char *)func - exec_offset);
 
 	/* Remove the user data from the stack */
 	x86_pop_reg(buf, X86_ECX);
@@ -206,7 +206,8 @@ void *_jit_create_redirector(unsigned char *buf, void *func,
 	return start;
 }
 
-void *_jit_create_indirector(unsigned char *buf, void **entry)
+void *_jit_create_indirector(unsigned char *buf, void **entry,
+							 jit_nint exec_offset)
 {
 	void *start = (void *)buf;
 
@@ -790,6 +790,7 @@ jit_closure_create(jit_context_t context, jit_type_t signature, jit_closure_func
 {
 #ifdef jit_closure_size
 	jit_closure_t closure;
+	jit_closure_t writable;
 
 	/* Validate the parameters */
 	if(!context || !signature || !func)
@@ -813,11 +814,14 @@ jit_closure_create(jit_context_t context, jit_type_t signature, jit_closure_func
 		return 0;
 	}
 
-	/* Fill in the closure fields */
-	_jit_create_closure(closure->buf, (void *)closure_handler, closure, signature);
-	closure->signature = signature;
-	closure->func = func;
-	closure->user_data = user_data;
+	/* Fill in the closure fields, which may have to be written at a
+	   different address than the closure runs at */
+	writable = (jit_closure_t) _jit_memory_writable(context, closure);
+	_jit_create_closure(writable->buf, (void *)closure_handler, closure,
+			    signature, -(context->write_offset));
+	writable->signature = signature;
+	writable->func = func;
+	writable->user_data = user_data;
 
 	/* Release the memory context, as we are finished with it */
 	_jit_memory_unlock(context);
@@ -23,6 +23,12 @@
 #include "jit-internal.h"
 #include "jit-bitset.h"
 
+/*
+ * Get the number of words that hold the bits of a bitset.
+ */
+#define num_words(bs)	\
+	(((bs)->size + _JIT_BITSET_WORD_BITS - 1) / _JIT_BITSET_WORD_BITS)
+
 void
 _jit_bitset_init(_jit_bitset_t *bs)
 {
@@ -40,7 +46,7 @@ _jit_bitset_allocate(_jit_bitset_t *bs, int size)
 		bs->bits = jit_calloc(size, sizeof(_jit_bitset_word_t));
 		if(!bs->bits)
 		{
-			jit_free(bs);
+			bs->size = 0;
 			return 0;
 		}
 	}
@@ -74,7 +80,7 @@ _jit_bitset_set_bit(_jit_bitset_t *bs, int bit)
 	int word;
 	word = bit / _JIT_BITSET_WORD_BITS;
 	bit = bit % _JIT_BITSET_WORD_BITS;
-	bs->bits[word] |= bit;
+	bs->bits[word] |= ((_jit_bitset_word_t) 1) << bit;
 }
 
 void
@@ -83,7 +89,7 @@ _jit_bitset_clear_bit(_jit_bitset_t *bs, int bit)
 	int word;
 	word = bit / _JIT_BITSET_WORD_BITS;
 	bit = bit % _JIT_BITSET_WORD_BITS;
-	bs->bits[word] &= ~bit;
+	bs->bits[word] &= ~(((_jit_bitset_word_t) 1) << bit);
 }
 
 int
@@ -92,14 +98,14 @@ _jit_bitset_test_bit(_jit_bitset_t *bs, int bit)
 	int word;
 	word = bit / _JIT_BITSET_WORD_BITS;
 	bit = bit % _JIT_BITSET_WORD_BITS;
-	return (bs->bits[word] & bit) != 0;
+	return (bs->bits[word] & (((_jit_bitset_word_t) 1) << bit)) != 0;
 }
 
 void
 _jit_bitset_clear(_jit_bitset_t *bs)
 {
 	int i;
-	for(i = 0; i < bs->size; i++)
+	for(i = 0; i < num_words(bs); i++)
 	{
 		bs->bits[i] = 0;
 	}
@@ -109,7 +115,7 @@ int
 _jit_bitset_empty(_jit_bitset_t *bs)
 {
 	int i;
-	for(i = 0; i < bs->size; i++)
+	for(i = 0; i < num_words(bs); i++)
 	{
 		if(bs->bits[i])
 		{
@@ -123,7 +129,7 @@ void
 _jit_bitset_add(_jit_bitset_t *dest, _jit_bitset_t *src)
 {
 	int i;
-	for(i = 0; i < dest->size; i++)
+	for(i = 0; i < num_words(dest); i++)
 	{
 		dest->bits[i] |= src->bits[i];
 	}
@@ -133,7 +139,7 @@ void
 _jit_bitset_sub(_jit_bitset_t *dest, _jit_bitset_t *src)
 {
 	int i;
-	for(i = 0; i < dest->size; i++)
+	for(i = 0; i < num_words(dest); i++)
 	{
 		dest->bits[i] &= ~src->bits[i];
 	}
@@ -146,7 +152,7 @@ _jit_bitset_copy(_jit_bitset_t *dest, _jit_bitset_t *src)
 	int changed;
 
 	changed = 0;
-	for(i = 0; i < dest->size; i++)
+	for(i = 0; i < num_words(dest); i++)
 	{
 		if(dest->bits[i] != src->bits[i])
 		{
@@ -161,7 +167,7 @@ int
 _jit_bitset_equal(_jit_bitset_t *bs1, _jit_bitset_t *bs2)
 {
 	int i;
-	for(i = 0; i < bs1->size; i++)
+	for(i = 0; i < num_words(bs1); i++)
 	{
 		if(bs1->bits[i] != bs2->bits[i])
 		{
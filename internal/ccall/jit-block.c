@@ -818,6 +818,10 @@ _jit_invert_condition (int opcode)
 	case JIT_OP_BR_NFLE_INV:	opcode = JIT_OP_BR_NFGT; break;
 	case JIT_OP_BR_NFGT_INV:	opcode = JIT_OP_BR_NFLE; break;
 	case JIT_OP_BR_NFGE_INV:	opcode = JIT_OP_BR_NFLT; break;
+	case JIT_OP_BR_IFALSE:	opcode = JIT_OP_BR_ITRUE;    break;
+	case JIT_OP_BR_ITRUE:	opcode = JIT_OP_BR_IFALSE;   break;
+	case JIT_OP_BR_LFALSE:	opcode = JIT_OP_BR_LTRUE;    break;
+	case JIT_OP_BR_LTRUE:	opcode = JIT_OP_BR_LFALSE;   break;
 	default:		abort();
 	}
 	return opcode;
@@ -998,7 +1002,6 @@ _jit_block_clean_cfg(jit_function_t func)
 		{
 			jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
 		}
-		clear_visited(func);
 		goto loop;
 	}
 }
@@ -1014,6 +1017,7 @@ _jit_block_compute_postorder(jit_function_t func)
 	{
 		free_order(func);
 	}
+	clear_visited(func);
 
 	num_blocks = count_blocks(func);
 
@@ -1235,6 +1239,30 @@ _jit_block_add_insn(jit_block_t block)
 	return &block->insns[block->num_insns++];
 }
 
+jit_insn_t
+_jit_block_add_insn_before_branch(jit_block_t block)
+{
+	jit_insn_t last, slot;
+
+	slot = _jit_block_add_insn(block);
+	if(!slot)
+	{
+		return 0;
+	}
+	if(block->num_insns > 1)
+	{
+		last = &block->insns[block->num_insns - 2];
+		if((last->opcode >= JIT_OP_BR && last->opcode <= JIT_OP_BR_NFGE_INV)
+		   || last->opcode == JIT_OP_JUMP_TABLE)
+		{
+			*slot = *last;
+			slot = last;
+			jit_memzero(slot, sizeof(struct _jit_insn));
+		}
+	}
+	return slot;
+}
+
 jit_insn_t
 _jit_block_get_last(jit_block_t block)
 {
@@ -1261,6 +1289,286 @@ _jit_block_is_final(jit_block_t block)
 	return 1;
 }
 
+void
+_jit_block_fold_branch(jit_block_t block, int taken)
+{
+	jit_insn_t insn;
+
+	/* The branch edge comes first and the fallthrough edge second */
+	insn = _jit_block_get_last(block);
+	if(taken)
+	{
+		insn->opcode = JIT_OP_BR;
+		insn->value1 = 0;
+		insn->value2 = 0;
+		block->ends_in_dead = 1;
+		delete_edge(block->func, block->succs[1]);
+	}
+	else
+	{
+		insn->opcode = JIT_OP_NOP;
+		delete_edge(block->func, block->succs[0]);
+	}
+}
+
+jit_block_t
+_jit_block_split_edges(jit_function_t func, jit_block_t block,
+		       _jit_edge_t *edges, int num_edges)
+{
+	jit_block_t new_block;
+	jit_label_t label;
+	jit_insn_t insn;
+	_jit_edge_t *preds;
+	int index;
+
+	/* The block that falls through to "block" falls through to the new
+	   block instead, so its edge must be among the given ones */
+	new_block = _jit_block_create(func);
+	if(!new_block)
+	{
+		jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+	}
+	_jit_block_attach_before(block, new_block, new_block);
+	label = (func->builder->next_label)++;
+	if(!_jit_block_record_label(new_block, label))
+	{
+		jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+	}
+
+	for(index = 0; index < num_edges; index++)
+	{
+		if(edges[index]->flags == _JIT_EDGE_BRANCH)
+		{
+			insn = _jit_block_get_last(edges[index]->src);
+			insn->dest = (jit_value_t) label;
+		}
+		detach_edge_dst(edges[index]);
+		attach_edge_dst(edges[index], new_block);
+	}
+
+	new_block->succs = (_jit_edge_t *) jit_malloc(sizeof(_jit_edge_t));
+	preds = (_jit_edge_t *) jit_realloc(block->preds,
+					    (block->num_preds + 1) * sizeof(_jit_edge_t));
+	if(!new_block->succs || !preds)
+	{
+		jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+	}
+	block->preds = preds;
+	create_edge(func, new_block, block, _JIT_EDGE_FALLTHRU, 1);
+	return new_block;
+}
+
+/* Get a label of the block that branches may use, making one if the
+   block has none or only address_of labels */
+static jit_label_t
+get_branch_label(jit_function_t func, jit_block_t block)
+{
+	jit_label_t label;
+
+	for(label = block->label; label != jit_label_undefined;
+	    label = func->builder->label_info[label].alias)
+	{
+		if((func->builder->label_info[label].flags & JIT_LABEL_ADDRESS_OF) == 0)
+		{
+			return label;
+		}
+	}
+
+	label = (func->builder->next_label)++;
+	if(!_jit_block_record_label(block, label))
+	{
+		jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+	}
+	return label;
+}
+
+/* Mark the blocks that only lead to an exception being thrown, which
+   are not expected to run, as visited */
+static void
+mark_cold(jit_function_t func)
+{
+	jit_block_t block;
+	_jit_edge_t edge;
+	int index, changed;
+
+	clear_visited(func);
+	do
+	{
+		changed = 0;
+		for(block = func->builder->exit_block->prev;
+		    block != func->builder->entry_block; block = block->prev)
+		{
+			if(block->visited || block->num_succs == 0)
+			{
+				continue;
+			}
+			for(index = 0; index < block->num_succs; index++)
+			{
+				edge = block->succs[index];
+				if(edge->flags != _JIT_EDGE_EXCEPT && !edge->dst->visited)
+				{
+					break;
+				}
+			}
+			if(index == block->num_succs)
+			{
+				block->visited = 1;
+				changed = 1;
+			}
+		}
+	}
+	while(changed);
+}
+
+/* Make the fallthrough edge of the block, if it has one, lead to the block
+   that now follows it */
+static void
+fix_fallthru(jit_function_t func, jit_block_t block)
+{
+	_jit_edge_t edge, fallthru_edge;
+	jit_block_t new_block;
+	jit_insn_t insn;
+	_jit_edge_t *preds;
+	int index;
+
+	fallthru_edge = 0;
+	for(index = 0; index < block->num_succs; index++)
+	{
+		if(block->succs[index]->flags == _JIT_EDGE_FALLTHRU)
+		{
+			fallthru_edge = block->succs[index];
+		}
+	}
+
+	insn = _jit_block_get_last(block);
+	if(!fallthru_edge)
+	{
+		/* A branch to the next block is not needed any more */
+		if(insn && insn->opcode == JIT_OP_BR
+		   && block->succs[0]->dst == block->next)
+		{
+			insn->opcode = JIT_OP_NOP;
+			block->ends_in_dead = 0;
+			block->succs[0]->flags = _JIT_EDGE_FALLTHRU;
+		}
+		return;
+	}
+	if(fallthru_edge->dst == block->next)
+	{
+		return;
+	}
+
+	if(insn && insn->opcode > JIT_OP_BR && insn->opcode <= JIT_OP_BR_NFGE_INV
+	   && block->succs[0]->dst == block->next)
+	{
+		/* Branch to the block that used to follow on the opposite
+		   condition and fall through to the branch target */
+		insn->opcode = _jit_invert_condition(insn->opcode);
+		insn->dest = (jit_value_t) get_branch_label(func, fallthru_edge->dst);
+		edge = block->succs[0];
+		edge->flags = _JIT_EDGE_FALLTHRU;
+		fallthru_edge->flags = _JIT_EDGE_BRANCH;
+		block->succs[0] = fallthru_edge;
+		block->succs[1] = edge;
+		return;
+	}
+
+	if(block->num_succs == 1)
+	{
+		/* Nothing else ends the block, so branch at its end */
+		insn = _jit_block_add_insn(block);
+		if(!insn)
+		{
+			jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+		}
+		insn->opcode = JIT_OP_BR;
+		insn->flags = JIT_INSN_DEST_IS_LABEL;
+		insn->dest = (jit_value_t) get_branch_label(func, fallthru_edge->dst);
+		block->ends_in_dead = 1;
+		fallthru_edge->flags = _JIT_EDGE_BRANCH;
+		return;
+	}
+
+	/* Fall through to a new block that branches to the old target */
+	new_block = _jit_block_create(func);
+	if(!new_block)
+	{
+		jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+	}
+	_jit_block_attach_after(block, new_block, new_block);
+	insn = _jit_block_add_insn(new_block);
+	new_block->succs = (_jit_edge_t *) jit_malloc(sizeof(_jit_edge_t));
+	new_block->preds = (_jit_edge_t *) jit_malloc(sizeof(_jit_edge_t));
+	preds = (_jit_edge_t *) jit_realloc(fallthru_edge->dst->preds,
+					    (fallthru_edge->dst->num_preds + 1)
+					    * sizeof(_jit_edge_t));
+	if(!insn || !new_block->succs || !new_block->preds || !preds)
+	{
+		jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+	}
+	fallthru_edge->dst->preds = preds;
+	insn->opcode = JIT_OP_BR;
+	insn->flags = JIT_INSN_DEST_IS_LABEL;
+	insn->dest = (jit_value_t) get_branch_label(func, fallthru_edge->dst);
+	new_block->ends_in_dead = 1;
+	new_block->loop_depth = block->loop_depth;
+	create_edge(func, new_block, fallthru_edge->dst, _JIT_EDGE_BRANCH, 1);
+	detach_edge_dst(fallthru_edge);
+	fallthru_edge->dst = new_block;
+	new_block->preds[new_block->num_preds++] = fallthru_edge;
+}
+
+void
+_jit_block_layout(jit_function_t func)
+{
+	jit_block_t block, next, cold_first, cold_last;
+
+	/* Exceptions go where the control flow graph does not show */
+	if(func->has_try)
+	{
+		return;
+	}
+
+	/* Move the cold blocks to the end of the function, keeping the
+	   order of the blocks on either side */
+	mark_cold(func);
+	cold_first = 0;
+	cold_last = 0;
+	block = func->builder->entry_block->next;
+	while(block != func->builder->exit_block)
+	{
+		next = block->next;
+		if(block->visited)
+		{
+			_jit_block_detach(block, block);
+			block->prev = cold_last;
+			block->next = 0;
+			if(cold_last)
+			{
+				cold_last->next = block;
+			}
+			else
+			{
+				cold_first = block;
+			}
+			cold_last = block;
+		}
+		block = next;
+	}
+	if(cold_first)
+	{
+		_jit_block_attach_before(func->builder->exit_block, cold_first, cold_last);
+	}
+	clear_visited(func);
+
+	/* Let the hot successor of each block follow it without a branch */
+	for(block = func->builder->entry_block;
+	    block != func->builder->exit_block; block = block->next)
+	{
+		fix_fallthru(func, block);
+	}
+}
+
 /*@
  * @deftypefun jit_function_t jit_block_get_function (jit_block_t @var{block})
  * Get the function that a particular @var{block} belongs to.
@@ -43,6 +43,8 @@ typedef struct
 	int			restart;
 	int			page_factor;
 
+	_jit_compile_key_t	key;
+
 	struct jit_gencode	gen;
 
 } _jit_compile_t;
@@ -77,6 +79,24 @@ optimize(jit_function_t func)
 	/* Eliminate useless control flow */
 	_jit_block_clean_cfg(func);
 
+	/* Propagate constants and eliminate redundant computations, then
+	   remove the control flow that became useless */
+	if(func->optimization_level >= JIT_OPTLEVEL_SSA
+	   && _jit_function_optimize_ssa(func))
+	{
+		_jit_block_clean_cfg(func);
+	}
+
+	/* Reuse values loaded from or stored to memory */
+	_jit_function_optimize_accesses(func);
+
+	/* Remove redundant checks and move loop-invariant computations
+	   out of loops */
+	_jit_function_optimize_loops(func);
+
+	/* Move the code that is not expected to run out of the hot path */
+	_jit_block_layout(func);
+
 	/* Optimization is done */
 	func->is_optimized = 1;
 }
@@ -402,6 +422,13 @@ memory_acquire(_jit_compile_t *state)
 	{
 		jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
 	}
+
+	/* A concurrent memory manager only needs the lock to be created */
+	if(_jit_memory_is_concurrent(state->gen.context))
+	{
+		_jit_memory_unlock(state->gen.context);
+		state->memory_locked = 0;
+	}
 }
 
 /*
@@ -438,7 +465,7 @@ memory_align(_jit_compile_t *state, int align, int diff, int nop)
 	/* Determine the location of the next alignment boundary */
 	p = (jit_nuint) state->gen.ptr;
 	n = (p + (jit_nuint) align - 1) & ~((jit_nuint) align - 1);
-	if(p == n || (p - n) >= (jit_nuint) diff)
+	if(p == n || (n - p) >= (jit_nuint) diff)
 	{
 		return;
 	}
@@ -452,6 +479,7 @@ memory_align(_jit_compile_t *state, int align, int diff, int nop)
 #ifdef jit_should_pad
 	/* Use CPU-specific padding, because it may be more efficient */
 	_jit_pad_buffer(state->gen.ptr, align);
+	state->gen.ptr += align;
 #else
 	jit_memset(state->gen.ptr, nop, align);
 	state->gen.ptr += align;
@@ -467,9 +495,11 @@ memory_start(_jit_compile_t *state)
 	/* Remember the memory context state */
 	state->memory_started = 1;
 
-	/* Store the bounds of the available space */
+	/* Store the bounds of the available space, which are the addresses
+	   that the code is written to.  It may run at a different address */
 	state->gen.mem_start = _jit_memory_get_break(state->gen.context);
 	state->gen.mem_limit = _jit_memory_get_limit(state->gen.context);
+	state->gen.exec_offset = -(state->gen.context->write_offset);
 
 	/* Align the function code start as required */
 	state->gen.ptr = state->gen.mem_start;
@@ -477,6 +507,27 @@ memory_start(_jit_compile_t *state)
 
 	/* Prepare the bytecode offset encoder */
 	_jit_varint_init_encoder(&state->gen.offset_encoder);
+
+	/* Forget the data and relocations of an earlier attempt */
+	if(state->gen.image)
+	{
+		_jit_image_reset(state->gen.image);
+	}
+}
+
+/*
+ * Free the code of other functions if the cache is full and the
+ * context allows it.  Returns non-zero if any code was freed.
+ */
+static int
+memory_evict(_jit_compile_t *state)
+{
+	if(state->memory_locked
+	   || !jit_context_get_meta_numeric(state->gen.context, JIT_OPTION_CACHE_EVICT))
+	{
+		return 0;
+	}
+	return _jit_context_evict_code(state->gen.context, state->func);
 }
 
 /*
@@ -487,14 +538,18 @@ memory_alloc(_jit_compile_t *state)
 {
 	int result;
 
-	/* Try to allocate within the current memory limit */
-	result = _jit_memory_start_function(state->gen.context, state->func);
-	if(result == JIT_MEMORY_RESTART)
+	do
 	{
-		/* Not enough space. Request to extend the limit and retry */
-		_jit_memory_extend_limit(state->gen.context, state->page_factor++);
+		/* Try to allocate within the current memory limit */
 		result = _jit_memory_start_function(state->gen.context, state->func);
+		if(result == JIT_MEMORY_RESTART)
+		{
+			/* Not enough space. Request to extend the limit and retry */
+			_jit_memory_extend_limit(state->gen.context, state->page_factor++);
+			result = _jit_memory_start_function(state->gen.context, state->func);
+		}
 	}
+	while(result != JIT_MEMORY_OK && memory_evict(state));
 	if(result != JIT_MEMORY_OK)
 	{
 		/* Failed to allocate any space */
@@ -542,7 +597,7 @@ memory_flush(_jit_compile_t *state)
 
 #ifndef JIT_BACKEND_INTERP
 		/* On success perform a CPU cache flush, to make the code executable */
-		_jit_flush_exec(state->gen.code_start,
+		_jit_flush_exec(state->gen.code_start + state->gen.exec_offset,
 			        state->gen.code_end - state->gen.code_start);
 #endif
 
@@ -552,7 +607,59 @@ memory_flush(_jit_compile_t *state)
 			jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
 		}
 		state->func->bytecode_offset = _jit_varint_get_data(&state->gen.offset_encoder);
+
+		/* Remember where the code of the image is */
+		if(state->gen.image)
+		{
+			state->gen.image->code_start = state->gen.code_start;
+			state->gen.image->code_end = state->gen.code_end;
+			state->gen.image->exec_offset = state->gen.exec_offset;
+		}
+	}
+}
+
+/*
+ * Keep a relocatable image of the code if the context is used for
+ * pre-compilation, so that the ELF writer can save the function.
+ */
+static void
+image_start(_jit_compile_t *state)
+{
+	if(jit_context_get_meta_numeric(state->func->context, JIT_OPTION_PRE_COMPILE))
+	{
+		state->gen.image = _jit_image_create();
+		if(!state->gen.image)
+		{
+			jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+		}
+	}
+}
+
+/*
+ * Attach the image to the function once it is compiled, or discard it.
+ */
+static void
+image_end(_jit_compile_t *state, int result)
+{
+	if(result == JIT_RESULT_OK && state->gen.image)
+	{
+		_jit_image_free(state->func->image);
+		state->func->image = state->gen.image;
+	}
+	else
+	{
+		_jit_image_free(state->gen.image);
 	}
+	state->gen.image = 0;
+}
+
+/*
+ * Get the address that the compiled code runs at.
+ */
+static void *
+memory_entry(_jit_compile_t *state)
+{
+	return state->gen.code_start + state->gen.exec_offset;
 }
 
 /*
@@ -585,8 +692,13 @@ memory_realloc(_jit_compile_t *state)
 	memory_abort(state);
 
 	/* Request to extend memory limit and retry space allocation */
-	_jit_memory_extend_limit(state->gen.context, state->page_factor++);
-	result = _jit_memory_start_function(state->gen.context, state->func);
+	do
+	{
+		_jit_memory_extend_limit(state->gen.context, state->page_factor);
+		result = _jit_memory_start_function(state->gen.context, state->func);
+	}
+	while(result != JIT_MEMORY_OK && memory_evict(state));
+	state->page_factor++;
 	if(result != JIT_MEMORY_OK)
 	{
 		/* Failed to allocate enough space */
@@ -597,6 +709,54 @@ memory_realloc(_jit_compile_t *state)
 	memory_start(state);
 }
 
+/*
+ * Determine if the code of a function is a leaf that never calls out,
+ * not even to throw an exception, and whose frame size is fixed.
+ */
+static int
+is_leaf_function(jit_function_t func)
+{
+	jit_block_t block;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+
+	if(func->builder->non_leaf || func->builder->may_throw
+	   || func->has_try || func->nested_parent)
+	{
+		return 0;
+	}
+
+	block = 0;
+	while((block = jit_block_next(func, block)) != 0)
+	{
+		jit_insn_iter_init(&iter, block);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			switch(insn->opcode)
+			{
+			case JIT_OP_MEMCPY:
+			case JIT_OP_MEMMOVE:
+			case JIT_OP_MEMSET:
+			case JIT_OP_ALLOCA:
+				/* These may call out or grow the frame */
+				return 0;
+			}
+
+			/* Structure copies may call "jit_memcpy" */
+			if((insn->dest && (insn->flags & JIT_INSN_DEST_OTHER_FLAGS) == 0
+			    && jit_type_is_struct(jit_type_normalize(insn->dest->type)))
+			   || (insn->value1 && (insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0
+			       && jit_type_is_struct(jit_type_normalize(insn->value1->type)))
+			   || (insn->value2 && (insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0
+			       && jit_type_is_struct(jit_type_normalize(insn->value2->type))))
+			{
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
 /*
  * Prepare function info needed for code generation.
  */
@@ -613,6 +773,11 @@ codegen_prepare(_jit_compile_t *state)
 		state->func->no_return = 1;
 	}
 
+	/* Check if the function can be called as a leaf.  The back end
+	   records the stack size when it generates the prolog */
+	state->func->is_leaf = is_leaf_function(state->func);
+	state->func->leaf_stack_size = 0;
+
 	/* Compute liveness and "next use" information for this function */
 	_jit_function_compute_liveness(state->func);
 
@@ -646,6 +811,15 @@ codegen(_jit_compile_t *state)
 	block = 0;
 	while((block = jit_block_next(func, block)) != 0)
 	{
+#ifdef JIT_LOOP_ALIGNMENT
+		/* Align the header of a loop, which every iteration branches to,
+		   unless that takes too much padding */
+		if(block->loop_header)
+		{
+			memory_align(state, JIT_LOOP_ALIGNMENT, JIT_LOOP_MAX_PADDING + 1, 0);
+		}
+#endif
+
 		/* Notify the back end that the block is starting */
 		_jit_gen_start_block(gen, block);
 
@@ -703,6 +877,15 @@ compile(_jit_compile_t *state, jit_function_t func)
 	jit_memzero(state, sizeof(_jit_compile_t));
 	state->func = func;
 
+	/* Reuse the code of an earlier function with the same IR */
+	if(_jit_compile_cache_lookup(func, &state->key,
+				     (void **)&state->gen.code_start))
+	{
+		func->last_use = ++(func->context->use_clock);
+		_jit_function_save_inline_body(func);
+		return JIT_RESULT_OK;
+	}
+
 	/* Replace user's exception handler with internal handler */
 	handler = jit_exception_set_handler(internal_exception_handler);
 
@@ -735,8 +918,12 @@ compile(_jit_compile_t *state, jit_function_t func)
 		/* Perform machine-independent optimizations */
 		optimize(state->func);
 
+		/* Keep the instructions of small functions for inlining */
+		_jit_function_save_inline_body(state->func);
+
 		/* Prepare data needed for code generation */
 		codegen_prepare(state);
+		image_start(state);
 
 		/* Allocate some space */
 		memory_acquire(state);
@@ -785,11 +972,21 @@ compile(_jit_compile_t *state, jit_function_t func)
 
 	/* Compilation done, no exceptions occurred */
 	result = JIT_RESULT_OK;
+	func->last_use = ++(func->context->use_clock);
+
+	/* Share the code with later functions that have the same IR */
+	_jit_compile_cache_insert(func, &state->key, memory_entry(state));
 
  exit:
+	/* The cache keeps the key of the code that it shares */
+	_jit_compile_key_free(&state->key);
+
 	/* Release the memory context */
 	memory_release(state);
 
+	/* Keep or discard the code image */
+	image_end(state, result);
+
 	/* Restore the "setjmp" context */
 	_jit_unwind_pop_setjmp();
 
@@ -846,7 +1043,7 @@ jit_compile(jit_function_t func)
 	result = compile(&state, func);
 	if(result == JIT_RESULT_OK)
 	{
-		func->entry_point = state.gen.code_start;
+		func->entry_point = memory_entry(&state);
 		func->is_compiled = 1;
 
 		/* Free the builder structure, which we no longer require */
@@ -905,7 +1102,7 @@ jit_compile_entry(jit_function_t func, void **entry_point)
 	result = compile(&state, func);
 	if(result == JIT_RESULT_OK)
 	{
-		*entry_point = state.gen.code_start;
+		*entry_point = memory_entry(&state);
 	}
 
 	return result;
@@ -978,13 +1175,13 @@ _jit_function_compile_on_demand(jit_function_t func)
 	_jit_compile_t state;
 	int result;
 
-	/* Lock down the context */
-	jit_context_build_start(func->context);
+	/* Lock down the function */
+	jit_function_build_start(func);
 
 	/* Fast return if we are already compiled */
 	if(func->is_compiled)
 	{
-		jit_context_build_end(func->context);
+		jit_function_build_end(func);
 		return func->entry_point;
 	}
 
@@ -1004,15 +1201,15 @@ _jit_function_compile_on_demand(jit_function_t func)
 			result = compile(&state, func);
 			if(result == JIT_RESULT_OK)
 			{
-				func->entry_point = state.gen.code_start;
+				func->entry_point = memory_entry(&state);
 				func->is_compiled = 1;
 			}
 		}
 		_jit_function_free_builder(func);
 	}
 
-	/* Unlock the context and report the result */
-	jit_context_build_end(func->context);
+	/* Unlock the function and report the result */
+	jit_function_build_end(func);
 	if(result != JIT_RESULT_OK)
 	{
 		jit_exception_builtin(result);
@@ -49,6 +49,14 @@
 # define JIT_THREADS_SUPPORTED	0
 #endif
 
+/*
+ * Determine if the per-thread control block can be kept in a
+ * "__thread" variable instead of thread-specific data.
+ */
+#if defined(JIT_THREADS_PTHREAD) && defined(__GNUC__)
+# define JIT_THREADS_TLS	1
+#endif
+
 /*
  * Determine the type of virtual memory API that we are using.
  */
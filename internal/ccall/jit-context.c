@@ -21,6 +21,13 @@
  */
 
 #include "jit-internal.h"
+#if defined(__i386) || defined(__i386__) || defined(_M_IX86) || \
+	defined(__x86_64) || defined(__x86_64__)
+#include "jit-cpuid-x86.h"
+#define	JIT_DETECT_CPU_FEATURES()	_jit_cpuid_x86_features()
+#else
+#define	JIT_DETECT_CPU_FEATURES()	0
+#endif
 
 /*@
 
@@ -88,10 +95,12 @@ jit_context_create(void)
 	/* Initialize the context and return it */
 	jit_mutex_create(&context->memory_lock);
 	jit_mutex_create(&context->builder_lock);
+	jit_mutex_create(&context->compile_cache_lock);
 	context->functions = 0;
 	context->last_function = 0;
 	context->on_demand_driver = _jit_function_compile_on_demand;
 	context->memory_manager = jit_default_memory_manager();
+	context->cpu_features = JIT_DETECT_CPU_FEATURES();
 	return context;
 }
 
@@ -123,10 +132,13 @@ jit_context_destroy(jit_context_t context)
 		_jit_function_destroy(context->functions);
 	}
 
+	_jit_compile_cache_destroy(context);
+	_jit_context_reclaim_code(context, 1);
 	_jit_memory_destroy(context);
 
 	jit_mutex_destroy(&context->memory_lock);
 	jit_mutex_destroy(&context->builder_lock);
+	jit_mutex_destroy(&context->compile_cache_lock);
 
 	jit_free(context);
 }
@@ -270,7 +282,8 @@ jit_context_set_meta(jit_context_t context, int type, void *data, jit_meta_free_
  * @item JIT_OPTION_CACHE_LIMIT
  * A numeric option that indicates the maximum size in bytes of the function
  * cache.  If set to zero (the default), the function cache is unlimited
- * in size.
+ * in size.  The limit may be changed at any time, and applies to the
+ * pages that are allocated after that.
  *
  * @vindex JIT_OPTION_CACHE_PAGE_SIZE
  * @item JIT_OPTION_CACHE_PAGE_SIZE
@@ -283,10 +296,12 @@ jit_context_set_meta(jit_context_t context, int type, void *data, jit_meta_free_
  * @vindex JIT_OPTION_PRE_COMPILE
  * @item JIT_OPTION_PRE_COMPILE
  * A numeric option that indicates that this context is being used
- * for pre-compilation if it is set to a non-zero value.  Code within
- * pre-compiled contexts cannot be executed directly.  Instead, they
- * can be written out to disk in ELF format to be reloaded at
- * some future time.
+ * for pre-compilation if it is set to a non-zero value.  Functions that
+ * are compiled within pre-compiled contexts keep the information that is
+ * needed to relocate their code, so that they can be written out to disk
+ * in ELF format with @code{jit_writeelf_add_function} to be reloaded at
+ * some future time.  They can still be executed directly, but all calls
+ * to other functions go through a register.
  *
  * @vindex JIT_OPTION_DONT_FOLD
  * @item JIT_OPTION_DONT_FOLD
@@ -299,6 +314,102 @@ jit_context_set_meta(jit_context_t context, int type, void *data, jit_meta_free_
  * A numeric option that forces generation of position-independent code (PIC)
  * if it is set to a non-zero value. This may be mainly useful for pre-compiled
  * contexts.
+ *
+ * @vindex JIT_OPTION_COMPILE_CACHE
+ * @item JIT_OPTION_COMPILE_CACHE
+ * A numeric option that makes functions share their compiled code if it
+ * is set to a non-zero value.  A function whose instructions, types and
+ * constants are the same as those of a function that was compiled before
+ * in the same context skips optimization and code generation, and uses
+ * the entry point of the earlier function.  The hash of the IR only
+ * selects the candidates; the whole IR is compared before the code is
+ * shared.  Recompilable, nested and
+ * pre-compiled functions, and functions with exception handlers, are
+ * always compiled.  @code{jit_function_from_pc} returns the earlier
+ * function for the shared code.  The number of hits and misses is
+ * reported by @code{jit_context_get_compile_cache_stats}.  Functions
+ * that are evictable never share their code.
+ *
+ * @vindex JIT_OPTION_CACHE_EVICT
+ * @item JIT_OPTION_CACHE_EVICT
+ * A numeric option that frees the code of functions when the cache limit
+ * set with @code{JIT_OPTION_CACHE_LIMIT} is hit, if it is set to a
+ * non-zero value.  Instead of failing, the compilation of a function
+ * first frees the code of the least recently used functions that are
+ * marked with @code{jit_function_set_evictable}, and they are compiled
+ * again on demand when they are called next.  Uses are recorded when a
+ * function is compiled and when it is called through
+ * @code{jit_function_apply}, but not when it is called from other
+ * JIT code.  The number of evicted functions is reported by
+ * @code{jit_context_get_num_evictions}.
+ *
+ * Evicted code is not reused while a thread may still run it.  Calls
+ * through @code{jit_function_apply} hold an epoch section for as long as
+ * they run, including the calls that they make to other JIT code, and the
+ * memory of the evicted code is only given back once every thread that
+ * was in a section has left it.  Until then it does not count towards
+ * the limit, so the cache may grow past the limit by as much code as is
+ * waiting to be reused.  A function that is compiled on demand from JIT
+ * code is not held to the limit at all while there is such code, because
+ * its thread is in a section itself.  Evictable functions must not be
+ * entered through their closures from outside of JIT code, as those
+ * calls are not tracked.
+ *
+ * @vindex JIT_OPTION_CACHE_RESERVE
+ * @item JIT_OPTION_CACHE_RESERVE
+ * A numeric option that indicates the size in bytes of the address space
+ * that is reserved for the function cache when it is created.  The pages
+ * of the cache are committed from this space as they are needed, so that
+ * functions, trampolines and closures stay close to each other and to
+ * the code of the library, and call each other with relative call
+ * instructions.  If set to zero, a default of 128M is reserved.  If set
+ * to less than the cache page size, nothing is reserved.  Pages that do
+ * not fit in the reserved space are allocated anywhere.  The option must
+ * be set before the first function of the context is created.
+ *
+ * @vindex JIT_OPTION_CACHE_HUGE_PAGES
+ * @item JIT_OPTION_CACHE_HUGE_PAGES
+ * A numeric option that backs new pages of the function cache with huge
+ * pages (2M on Linux) if it is set to a non-zero value, so that code
+ * needs fewer iTLB entries.  Such pages are taken from the pool of
+ * explicit huge pages of the system if it has any, and are otherwise
+ * committed with small pages and given to the system as candidates
+ * for transparent huge pages.  Each thread writes functions one after
+ * another into its own huge page, so the functions that are compiled
+ * together, such as those promoted by tiered compilation on the same
+ * thread, are packed together.  The option is ignored if the system
+ * has no huge pages, if the cache has no reserved address space (see
+ * @code{JIT_OPTION_CACHE_RESERVE}), or if a whole huge page would
+ * exceed the cache limit.  The number of huge pages in use is reported
+ * by @code{jit_context_get_num_huge_pages}.
+ *
+ * @vindex JIT_OPTION_CACHE_DUAL_MAP
+ * @item JIT_OPTION_CACHE_DUAL_MAP
+ * A numeric option that maps the function cache twice if it is set to a
+ * non-zero value: once read-execute, where code runs, and once
+ * read-write, where the compiler writes it.  No page of the cache is
+ * ever writable and executable at the same address, and no page
+ * protection changes while compiling.  Both views share one anonymous
+ * file at a constant distance from each other, so the space of the
+ * cache is limited to its reserved address space.  This is supported on
+ * x86-64 Linux only.  Elsewhere, or if the second view cannot be set
+ * up, creating the cache fails rather than falling back to writable and
+ * executable pages.  Huge pages are not used in this mode.  The option
+ * must be set before the first function of the context is created.
+ *
+ * @vindex JIT_OPTION_INLINE_LIMIT
+ * @item JIT_OPTION_INLINE_LIMIT
+ * A numeric option that makes calls to small functions copy their
+ * instructions into the caller, if it is set to a non-zero value.
+ * A function with at most this many instructions keeps a copy of them
+ * when it is compiled.  A function that is built after that and calls it
+ * with @code{jit_insn_call} gets the instructions in place of the call,
+ * with the arguments in place of the parameters, so they are optimized
+ * together with the caller.  Functions that call other functions, have
+ * exception handlers, take addresses, pass or return structures, or
+ * may be recompiled or evicted are not inlined, nor are calls from functions with the optimization level
+ * @code{JIT_OPTLEVEL_NONE}.  If set to zero (the default), nothing is
+ * inlined.
  * @end table
  *
  * Metadata type values of 10000 or greater are reserved for internal use.
@@ -346,3 +457,62 @@ jit_context_free_meta(jit_context_t context, int type)
 {
 	jit_meta_free(&(context->meta), type);
 }
+
+/*@
+ * @deftypefun jit_nuint jit_context_get_num_huge_pages (jit_context_t @var{context})
+ * Get the number of huge pages that currently back the function cache
+ * of @var{context}.  This is zero unless the
+ * @code{JIT_OPTION_CACHE_HUGE_PAGES} option is set and the system has
+ * huge pages to give.
+ * @end deftypefun
+@*/
+jit_nuint
+jit_context_get_num_huge_pages(jit_context_t context)
+{
+	jit_nuint num = 0;
+
+	if(context)
+	{
+		_jit_memory_lock(context);
+		if(context->memory_context)
+		{
+			num = _jit_memory_get_num_huge_pages(context);
+		}
+		_jit_memory_unlock(context);
+	}
+	return num;
+}
+
+/*@
+ * @deftypefun jit_uint jit_context_get_cpu_features (jit_context_t @var{context})
+ * Get the instruction set extensions that the code generator uses for
+ * functions of @var{context}, as a mask of @code{JIT_CPU_*} flags.  This
+ * is what the CPU supports, as detected when the context was created,
+ * limited by @code{jit_context_set_cpu_features}.  Detected extensions
+ * that the back end has no use for are reported all the same.
+ * @end deftypefun
+@*/
+jit_uint
+jit_context_get_cpu_features(jit_context_t context)
+{
+	return context ? context->cpu_features : 0;
+}
+
+/*@
+ * @deftypefun void jit_context_set_cpu_features (jit_context_t @var{context}, jit_uint @var{features})
+ * Limit the instruction set extensions that the code generator uses for
+ * functions of @var{context} to those in @var{features} that the CPU
+ * supports.  Pinning a baseline, such as zero for plain x86-64, makes
+ * the generated code the same on every machine that has the baseline.
+ * Functions that are already compiled keep their code, so this should be
+ * called before the first function is compiled.
+ * @end deftypefun
+@*/
+void
+jit_context_set_cpu_features(jit_context_t context, jit_uint features)
+{
+	if(context)
+	{
+		context->cpu_features = features & JIT_DETECT_CPU_FEATURES();
+	}
+}
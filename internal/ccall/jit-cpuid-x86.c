@@ -20,6 +20,7 @@
  * <http://www.gnu.org/licenses/>.
  */
 
+#include "jit-internal.h"
 #include "jit-cpuid-x86.h"
 
 #if defined(__i386) || defined(__i386__) || defined(_M_IX86)
@@ -77,6 +78,58 @@ static void cpuid_query(unsigned int index, jit_cpuid_x86_t *info)
 #endif
 }
 
+#elif defined(__x86_64) || defined(__x86_64__)
+
+/*
+ * Every x86-64 cpu has the "cpuid" instruction.
+ */
+static int cpuid_present(void)
+{
+	return 1;
+}
+
+/*
+ * Issue a "cpuid" query for sub-leaf zero and get the result.
+ */
+static void cpuid_query(unsigned int index, jit_cpuid_x86_t *info)
+{
+#if defined(__GNUC__)
+	__asm__ __volatile__ (
+		"\tcpuid\n"
+		: "=a"(info->eax), "=b"(info->ebx), "=c"(info->ecx), "=d"(info->edx)
+		: "a"(index), "c"(0)
+	);
+#else
+	info->eax = 0;
+	info->ebx = 0;
+	info->ecx = 0;
+	info->edx = 0;
+#endif
+}
+
+/*
+ * Get the state components that the operating system saves on context
+ * switches, from extended control register zero.
+ */
+static unsigned int xgetbv_low(void)
+{
+#if defined(__GNUC__)
+	unsigned int eax, edx;
+	__asm__ __volatile__ (
+		"\t.byte 0x0F, 0x01, 0xD0\n"	/* xgetbv, safe against old assemblers */
+		: "=a"(eax), "=d"(edx) : "c"(0)
+	);
+	return eax;
+#else
+	return 0;
+#endif
+}
+
+#endif /* x86-64 */
+
+#if defined(__i386) || defined(__i386__) || defined(_M_IX86) || \
+	defined(__x86_64) || defined(__x86_64__)
+
 int _jit_cpuid_x86_get(unsigned int index, jit_cpuid_x86_t *info)
 {
 	/* Determine if this cpu has the "cpuid" instruction */
@@ -128,4 +181,78 @@ unsigned int _jit_cpuid_x86_line_size(void)
 	return ((info.ebx & 0x0000FF00) >> 5);
 }
 
-#endif /* i386 */
+unsigned int _jit_cpuid_x86_features(void)
+{
+	static unsigned int features = 0;
+	static int detected = 0;
+	jit_cpuid_x86_t info;
+	unsigned int result = 0;
+
+	if(detected)
+	{
+		return features;
+	}
+	if(_jit_cpuid_x86_get(JIT_X86CPUID_FEATURES, &info))
+	{
+		if(info.ecx & JIT_X86FEATURE2_SSE3)
+		{
+			result |= JIT_CPU_SSE3;
+		}
+		if(info.ecx & JIT_X86FEATURE2_SSE4_1)
+		{
+			result |= JIT_CPU_SSE4_1;
+		}
+		if(info.ecx & JIT_X86FEATURE2_SSE4_2)
+		{
+			result |= JIT_CPU_SSE4_2;
+		}
+		if(info.ecx & JIT_X86FEATURE2_POPCNT)
+		{
+			result |= JIT_CPU_POPCNT;
+		}
+#if defined(__x86_64) || defined(__x86_64__)
+		/* The AVX registers are only usable if the operating system
+		   saves them, which it reports in XCR0 */
+		if((info.ecx & JIT_X86FEATURE2_OSXSAVE) != 0 &&
+		   (info.ecx & JIT_X86FEATURE2_AVX) != 0 &&
+		   (xgetbv_low() & 0x06) == 0x06)
+		{
+			result |= JIT_CPU_AVX;
+			if(info.ecx & JIT_X86FEATURE2_FMA)
+			{
+				result |= JIT_CPU_FMA;
+			}
+		}
+#endif
+	}
+	if(_jit_cpuid_x86_get(JIT_X86CPUID_EXTENDED_FEATURES, &info))
+	{
+		if(info.ebx & JIT_X86FEATURE7_BMI1)
+		{
+			result |= JIT_CPU_BMI1;
+		}
+		if(info.ebx & JIT_X86FEATURE7_BMI2)
+		{
+			result |= JIT_CPU_BMI2;
+		}
+		if((info.ebx & JIT_X86FEATURE7_AVX2) != 0 &&
+		   (result & JIT_CPU_AVX) != 0)
+		{
+			result |= JIT_CPU_AVX2;
+		}
+	}
+	if(_jit_cpuid_x86_get(JIT_X86CPUID_EXT_FEATURES, &info))
+	{
+		if(info.ecx & JIT_X86FEATURE81_LZCNT)
+		{
+			result |= JIT_CPU_LZCNT;
+		}
+	}
+
+	/* Racing threads store the same value */
+	features = result;
+	detected = 1;
+	return result;
+}
+
+#endif /* i386 || x86-64 */
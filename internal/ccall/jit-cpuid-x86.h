@@ -45,6 +45,8 @@ typedef struct
 #define	JIT_X86CPUID_FEATURES			1
 #define	JIT_X86CPUID_CACHE_TLB			2
 #define	JIT_X86CPUID_SERIAL_NUMBER		3
+#define	JIT_X86CPUID_EXTENDED_FEATURES	7
+#define	JIT_X86CPUID_EXT_FEATURES		0x80000001
 
 /*
  * Feature information.
@@ -82,6 +84,30 @@ typedef struct
 #define	JIT_X86FEATURE_RESERVED_4		0x40000000
 #define	JIT_X86FEATURE_RESERVED_5		0x80000000
 
+/*
+ * Feature information that is returned in ecx.
+ */
+#define	JIT_X86FEATURE2_SSE3			0x00000001
+#define	JIT_X86FEATURE2_SSSE3			0x00000200
+#define	JIT_X86FEATURE2_FMA				0x00001000
+#define	JIT_X86FEATURE2_SSE4_1			0x00080000
+#define	JIT_X86FEATURE2_SSE4_2			0x00100000
+#define	JIT_X86FEATURE2_POPCNT			0x00800000
+#define	JIT_X86FEATURE2_OSXSAVE			0x08000000
+#define	JIT_X86FEATURE2_AVX				0x10000000
+
+/*
+ * Extended feature information that is returned in ebx.
+ */
+#define	JIT_X86FEATURE7_BMI1			0x00000008
+#define	JIT_X86FEATURE7_AVX2			0x00000020
+#define	JIT_X86FEATURE7_BMI2			0x00000100
+
+/*
+ * Extended processor information that is returned in ecx.
+ */
+#define	JIT_X86FEATURE81_LZCNT			0x00000020
+
 /*
  * Get CPU identification information.  Returns zero if the requested
  * information is not available.
@@ -98,6 +124,12 @@ int _jit_cpuid_x86_has_feature(unsigned int feature);
  */
 unsigned int _jit_cpuid_x86_line_size(void);
 
+/*
+ * Get the instruction set extensions of the CPU as a mask of
+ * JIT_CPU_* flags.  The result is computed on the first call.
+ */
+unsigned int _jit_cpuid_x86_features(void);
+
 #ifdef	__cplusplus
 };
 #endif
@@ -92,6 +92,16 @@ void jit_dump_type(FILE *stream, jit_type_t type)
 
 		case JIT_TYPE_SIGNATURE:	name = "signature"; break;
 		case JIT_TYPE_PTR:		name = "ptr"; break;
+
+		case JIT_TYPE_VECTOR:
+		{
+			fputs("vector<", stream);
+			jit_dump_type(stream, jit_type_get_lane_type(type));
+			fputs(">", stream);
+			return;
+		}
+		/* Not reached */
+
 		default: 			name = "<unknown-type>"; break;
 	}
 	fputs(name, stream);
@@ -265,6 +275,7 @@ void jit_dump_value(FILE *stream, jit_function_t func, jit_value_t value, const
 			case JIT_TYPE_NFLOAT:		prefix = "D"; break;
 			case JIT_TYPE_STRUCT:		prefix = "s"; break;
 			case JIT_TYPE_UNION:		prefix = "u"; break;
+			case JIT_TYPE_VECTOR:		prefix = "v"; break;
 			default:					prefix = "?"; break;
 		}
 	}
@@ -882,12 +893,20 @@ void jit_dump_function(FILE *stream, jit_function_t func, const char *name)
 	}
 	else if(func->is_compiled)
 	{
-		void *start = func->entry_point;
-		void *info = _jit_memory_find_function_info(func->context, start);
-		void *end = _jit_memory_get_function_end(func->context, info);
+		void *start;
+		void *info;
+		void *end;
 #if defined(JIT_BACKEND_INTERP)
-		/* Dump the interpreter's bytecode representation */
 		jit_function_interp_t interp;
+#endif
+
+		/* Keep the code from being freed while it is dumped */
+		_jit_epoch_enter();
+		start = func->entry_point;
+		info = _jit_memory_find_function_info(func->context, start);
+		end = _jit_memory_get_function_end(func->context, info);
+#if defined(JIT_BACKEND_INTERP)
+		/* Dump the interpreter's bytecode representation */
 		interp = (jit_function_interp_t)(func->entry_point);
 		fprintf(stream, "\t%08lX: prolog(0x%lX, %d, %d, %d)\n",
 				(long)(jit_nint)interp, (long)(jit_nint)func,
@@ -897,6 +916,7 @@ void jit_dump_function(FILE *stream, jit_function_t func, const char *name)
 #else
 		dump_object_code(stream, start, end);
 #endif
+		_jit_epoch_leave();
 	}
 
 	/* Output the function footer */
@@ -1961,6 +1961,44 @@ static int arm_reloc(jit_readelf_t readelf, void *address, int type,
 
 #endif /* arm */
 
+#if defined(__x86_64) || defined(__x86_64__)
+
+/*
+ * Apply relocations for x86_64 platforms.
+ */
+static int x86_64_reloc(jit_readelf_t readelf, void *address, int type,
+					    jit_nuint value, int has_addend, jit_nuint addend)
+{
+	if(type == R_X86_64_64)
+	{
+		if(has_addend)
+		{
+			*((jit_nuint *)address) = value + addend;
+		}
+		else
+		{
+			*((jit_nuint *)address) += value;
+		}
+		return 1;
+	}
+	else if(type == R_X86_64_PC32)
+	{
+		value -= (jit_nuint)address;
+		if(has_addend)
+		{
+			*((jit_uint *)address) = (jit_uint)(value + addend);
+		}
+		else
+		{
+			*((jit_uint *)address) += (jit_uint)value;
+		}
+		return 1;
+	}
+	return 0;
+}
+
+#endif /* x86_64 */
+
 /*
  * Apply relocations for the interpreted platform.
  */
@@ -1995,6 +2033,12 @@ static jit_reloc_func get_reloc(unsigned int machine)
 	{
 		return arm_reloc;
 	}
+#endif
+#if defined(__x86_64) || defined(__x86_64__)
+	if(machine == EM_X86_64)
+	{
+		return x86_64_reloc;
+	}
 #endif
 	if(machine == 0x4C6A)		/* "Lj" for the libjit interpreter */
 	{
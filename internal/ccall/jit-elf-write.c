@@ -23,6 +23,9 @@
 #include "jit-internal.h"
 #include "jit-elf-defs.h"
 #include "jit-rules.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
 
 /*@
 
@@ -44,6 +47,9 @@
 	typedef Elf32_Off   Elf_Off;
 	typedef Elf32_Dyn   Elf_Dyn;
 	typedef Elf32_Sym   Elf_Sym;
+	typedef Elf32_Rela  Elf_Rela;
+	#define ELF_R_INFO(sym, type)	ELF32_R_INFO((sym), (type))
+	#define ELF_ST_INFO(bind, type)	ELF32_ST_INFO((bind), (type))
 #else
 	typedef Elf64_Ehdr  Elf_Ehdr;
 	typedef Elf64_Shdr  Elf_Shdr;
@@ -55,6 +61,9 @@
 	typedef Elf64_Off   Elf_Off;
 	typedef Elf64_Dyn   Elf_Dyn;
 	typedef Elf64_Sym   Elf_Sym;
+	typedef Elf64_Rela  Elf_Rela;
+	#define ELF_R_INFO(sym, type)	ELF64_R_INFO((sym), (type))
+	#define ELF_ST_INFO(bind, type)	ELF64_ST_INFO((bind), (type))
 #endif
 
 /*
@@ -68,6 +77,44 @@ struct jit_section
 	unsigned int		data_len;
 };
 
+/*
+ * A function that was added to the ELF binary.
+ */
+typedef struct
+{
+	Elf_Word			name;
+	Elf_Addr			offset;
+	Elf_Addr			size;
+
+} jit_writeelf_func_t;
+
+/*
+ * A range of addresses that was copied into the ".text" section: the
+ * code of a function or one of its constant data blocks.  Trampolines
+ * of a function are one byte ranges that map to its entry point.
+ */
+typedef struct
+{
+	unsigned char	   *start;
+	unsigned char	   *end;
+	Elf_Addr			offset;
+	int					func;
+
+} jit_writeelf_range_t;
+
+/*
+ * A location in the ".text" section that refers to "target", which is
+ * an address in the process that wrote the code.
+ */
+typedef struct
+{
+	Elf_Addr			offset;
+	int					type;
+	unsigned char	   *target;
+	char			   *name;
+
+} jit_writeelf_reloc_t;
+
 /*
  * Control structure for writing an ELF binary.
  */
@@ -78,8 +125,26 @@ struct jit_writeelf
 	int					num_sections;
 	int					regular_string_section;
 	int					dynamic_string_section;
+	jit_writeelf_func_t *functions;
+	int					num_functions;
+	jit_writeelf_range_t *ranges;
+	int					num_ranges;
+	jit_writeelf_reloc_t *relocs;
+	int					num_relocs;
 };
 
+/*
+ * Import the internal symbol table from "jit-symbol.c".
+ */
+typedef struct
+{
+	const char *name;
+	void       *value;
+
+} jit_internalsym;
+extern jit_internalsym const _jit_internal_symbols[];
+extern int const _jit_num_internal_symbols;
+
 /*
  * Get a string from the regular string section.
  */
@@ -293,6 +358,286 @@ static int add_dyn_info
 	return add_to_section(section, &dyn, sizeof(dyn));
 }
 
+/*
+ * Find a string that is already in the dynamic string section.
+ * Returns zero if it is not present.
+ */
+static Elf_Word find_dyn_string(jit_writeelf_t writeelf, const char *name)
+{
+	jit_section_t section;
+	unsigned int posn;
+	section = &(writeelf->sections[writeelf->dynamic_string_section]);
+	posn = 1;
+	while(posn < section->data_len)
+	{
+		if(!jit_strcmp(section->data + posn, name))
+		{
+			return (Elf_Word)posn;
+		}
+		posn += jit_strlen(section->data + posn) + 1;
+	}
+	return 0;
+}
+
+/*
+ * Append zero bytes to a section.
+ */
+static int pad_section(jit_section_t section, unsigned int len)
+{
+	char *data = (char *)jit_realloc(section->data, section->data_len + len);
+	if(!data)
+	{
+		return 0;
+	}
+	section->data = data;
+	jit_memzero(data + section->data_len, len);
+	section->data_len += len;
+	return 1;
+}
+
+/*
+ * Copy code or data from "start" to "end" into the ".text" section.
+ * The copy keeps the alignment of the original within the function
+ * alignment, which the ".text" section itself is aligned to.
+ */
+static int add_range
+	(jit_writeelf_t writeelf, jit_section_t text, unsigned char *start,
+	 unsigned char *end, int func)
+{
+	jit_writeelf_range_t *range;
+	unsigned int pad;
+	pad = (unsigned int)(((jit_nuint)start - text->data_len) %
+						 JIT_FUNCTION_ALIGNMENT);
+	if(!pad_section(text, pad))
+	{
+		return 0;
+	}
+	range = (jit_writeelf_range_t *)jit_realloc
+		(writeelf->ranges,
+		 (writeelf->num_ranges + 1) * sizeof(jit_writeelf_range_t));
+	if(!range)
+	{
+		return 0;
+	}
+	writeelf->ranges = range;
+	range += writeelf->num_ranges;
+	range->start = start;
+	range->end = end;
+	range->offset = (Elf_Addr)(text->data_len);
+	range->func = func;
+	++(writeelf->num_ranges);
+	if(start == end)
+	{
+		return 1;
+	}
+	return add_to_section(text, start, (unsigned int)(end - start));
+}
+
+/*
+ * Add an alias for the range at "index", which is where its bytes run
+ * when the code cache maps them at a second address.  Nothing is copied.
+ */
+static int add_alias(jit_writeelf_t writeelf, int index, jit_nint offset)
+{
+	jit_writeelf_range_t *range;
+	if(!offset)
+	{
+		return 1;
+	}
+	range = (jit_writeelf_range_t *)jit_realloc
+		(writeelf->ranges,
+		 (writeelf->num_ranges + 1) * sizeof(jit_writeelf_range_t));
+	if(!range)
+	{
+		return 0;
+	}
+	writeelf->ranges = range;
+	range[writeelf->num_ranges].start = range[index].start + offset;
+	range[writeelf->num_ranges].end = range[index].end + offset;
+	range[writeelf->num_ranges].offset = range[index].offset;
+	range[writeelf->num_ranges].func = range[index].func;
+	++(writeelf->num_ranges);
+	return 1;
+}
+
+/*
+ * Add a trampoline of a function, which is an alias for its entry point.
+ */
+static int add_trampoline
+	(jit_writeelf_t writeelf, unsigned char *trampoline, int func)
+{
+	jit_writeelf_range_t *range;
+	if(!trampoline)
+	{
+		return 1;
+	}
+	range = (jit_writeelf_range_t *)jit_realloc
+		(writeelf->ranges,
+		 (writeelf->num_ranges + 1) * sizeof(jit_writeelf_range_t));
+	if(!range)
+	{
+		return 0;
+	}
+	writeelf->ranges = range;
+	range += writeelf->num_ranges;
+	range->start = trampoline;
+	range->end = trampoline + 1;
+	range->offset = writeelf->functions[func].offset;
+	range->func = func;
+	++(writeelf->num_ranges);
+	return 1;
+}
+
+/*
+ * Compare two ranges by their start address, for "qsort".
+ */
+static int range_compare(const void *e1, const void *e2)
+{
+	const jit_writeelf_range_t *r1 = (const jit_writeelf_range_t *)e1;
+	const jit_writeelf_range_t *r2 = (const jit_writeelf_range_t *)e2;
+	if(r1->start < r2->start)
+	{
+		return -1;
+	}
+	else if(r1->start > r2->start)
+	{
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Find the range that contains "address".  The ranges must be sorted.
+ */
+static jit_writeelf_range_t *find_range
+	(jit_writeelf_t writeelf, unsigned char *address)
+{
+	int left = 0;
+	int right = writeelf->num_ranges - 1;
+	int middle;
+	jit_writeelf_range_t *range;
+	while(left <= right)
+	{
+		middle = (left + right) / 2;
+		range = &(writeelf->ranges[middle]);
+		if(address < range->start)
+		{
+			right = middle - 1;
+		}
+		else if(address >= range->end)
+		{
+			left = middle + 1;
+		}
+		else
+		{
+			return range;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Find the name of a libjit intrinsic from its address.
+ */
+static const char *find_internal_symbol(unsigned char *address)
+{
+	int index;
+	for(index = 0; index < _jit_num_internal_symbols; ++index)
+	{
+		if(_jit_internal_symbols[index].value == (void *)address)
+		{
+			return _jit_internal_symbols[index].name;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Compute the ELF hash of a symbol name, as "jit_readelf_get_symbol" does.
+ */
+static unsigned long elf_hash(const char *name)
+{
+	unsigned long hash = 0;
+	unsigned long temp;
+	while(*name != 0)
+	{
+		hash = (hash << 4) + (unsigned long)(*name & 0xFF);
+		temp = (hash & 0xF0000000);
+		if(temp != 0)
+		{
+			hash ^= temp | (temp >> 24);
+		}
+		++name;
+	}
+	return hash;
+}
+
+/*
+ * Get the machine-specific type of a relocation that is recorded by
+ * the back end as a JIT_RELOC_* type.  Returns zero if the relocation
+ * cannot be expressed for the machine.
+ */
+static int get_reloc_type(jit_writeelf_t writeelf, int type)
+{
+	if(type == JIT_RELOC_ABSOLUTE)
+	{
+		switch(writeelf->ehdr.e_machine)
+		{
+			case EM_386:	return R_386_32;
+			case EM_X86_64:	return R_X86_64_64;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Get or add an undefined symbol for "name" to the dynamic symbol
+ * section.  Returns zero if out of memory.
+ */
+static Elf_Word get_external_symbol
+	(jit_writeelf_t writeelf, jit_section_t symtab, const char *name)
+{
+	Elf_Sym *sym;
+	Elf_Sym new_sym;
+	Elf_Word index;
+	Elf_Word name_index;
+	Elf_Word num_syms = (Elf_Word)(symtab->data_len / sizeof(Elf_Sym));
+
+	/* Look for an existing symbol for the name */
+	name_index = find_dyn_string(writeelf, name);
+	sym = (Elf_Sym *)(symtab->data);
+	if(name_index)
+	{
+		for(index = (Elf_Word)(writeelf->num_functions + 1);
+			index < num_syms; ++index)
+		{
+			if(sym[index].st_name == name_index)
+			{
+				return index;
+			}
+		}
+	}
+	else
+	{
+		name_index = add_dyn_string(writeelf, name);
+		if(!name_index)
+		{
+			return 0;
+		}
+	}
+
+	/* Add a new undefined symbol */
+	jit_memzero(&new_sym, sizeof(new_sym));
+	new_sym.st_name = name_index;
+	new_sym.st_info = ELF_ST_INFO(STB_GLOBAL, STT_NOTYPE);
+	new_sym.st_shndx = SHN_UNDEF;
+	if(!add_to_section(symtab, &new_sym, sizeof(new_sym)))
+	{
+		return 0;
+	}
+	return num_syms;
+}
+
 /*@
  * @deftypefun jit_writeelf_t jit_writeelf_create (const char *@var{library_name})
  * Create an object to assist with the process of writing an ELF binary.
@@ -336,7 +681,8 @@ jit_writeelf_t jit_writeelf_create(const char *library_name)
 		return 0;
 	}
 	writeelf->dynamic_string_section = writeelf->num_sections - 1;
-	if(!add_dyn_string(writeelf, ""))
+	if(!add_to_section(&(writeelf->sections[writeelf->dynamic_string_section]),
+					   "", 1))
 	{
 		jit_writeelf_destroy(writeelf);
 		return 0;
@@ -412,19 +758,386 @@ void jit_writeelf_destroy(jit_writeelf_t writeelf)
 		jit_free(writeelf->sections[index].data);
 	}
 	jit_free(writeelf->sections);
+	for(index = 0; index < writeelf->num_relocs; ++index)
+	{
+		jit_free(writeelf->relocs[index].name);
+	}
+	jit_free(writeelf->relocs);
+	jit_free(writeelf->ranges);
+	jit_free(writeelf->functions);
 	jit_free(writeelf);
 }
 
+/*
+ * Build the dynamic symbol, hash and relocation sections from the
+ * functions that were added.  The symbol values and relocation offsets
+ * are relative to the start of the ".text" section until the sections
+ * are laid out.  Returns zero if out of memory, or with "errno" set to
+ * EINVAL if the code refers to something that cannot be relocated.
+ */
+static int build_dynamic_sections(jit_writeelf_t writeelf)
+{
+	jit_section_t text;
+	jit_section_t symtab;
+	jit_section_t hash;
+	jit_section_t rela;
+	jit_section_t dynamic;
+	jit_writeelf_reloc_t *reloc;
+	jit_writeelf_range_t *range;
+	Elf_Sym sym;
+	Elf_Rela entry;
+	Elf_Word *table;
+	Elf_Word num_syms;
+	Elf_Word num_buckets;
+	Elf_Word sym_index;
+	Elf_Addr target;
+	jit_int disp;
+	const char *name;
+	int reloc_type;
+	int index;
+
+	symtab = get_section(writeelf, ".dynsym", SHT_DYNSYM, SHF_ALLOC,
+						 sizeof(Elf_Sym), sizeof(Elf_Addr));
+	hash = get_section(writeelf, ".hash", SHT_HASH, SHF_ALLOC,
+					   sizeof(Elf_Word), sizeof(Elf_Word));
+	rela = get_section(writeelf, ".rela.dyn", SHT_RELA, SHF_ALLOC,
+					   sizeof(Elf_Rela), sizeof(Elf_Addr));
+	if(!symtab || !hash || !rela)
+	{
+		return 0;
+	}
+
+	/* Creating sections may have moved the existing ones */
+	text = get_section(writeelf, ".text", SHT_PROGBITS,
+					   SHF_ALLOC | SHF_EXECINSTR, 0, JIT_FUNCTION_ALIGNMENT);
+	symtab = get_section(writeelf, ".dynsym", SHT_DYNSYM, SHF_ALLOC,
+						 sizeof(Elf_Sym), sizeof(Elf_Addr));
+	hash = get_section(writeelf, ".hash", SHT_HASH, SHF_ALLOC,
+					   sizeof(Elf_Word), sizeof(Elf_Word));
+	symtab->data_len = 0;
+	hash->data_len = 0;
+	rela->data_len = 0;
+
+	/* The first symbol is always the undefined symbol, followed by
+	   one symbol for each function */
+	jit_memzero(&sym, sizeof(sym));
+	if(!add_to_section(symtab, &sym, sizeof(sym)))
+	{
+		return 0;
+	}
+	for(index = 0; index < writeelf->num_functions; ++index)
+	{
+		sym.st_name = writeelf->functions[index].name;
+		sym.st_info = ELF_ST_INFO(STB_GLOBAL, STT_FUNC);
+		sym.st_shndx = (Elf_Half)(text - writeelf->sections + 1);
+		sym.st_value = writeelf->functions[index].offset;
+		sym.st_size = writeelf->functions[index].size;
+		if(!add_to_section(symtab, &sym, sizeof(sym)))
+		{
+			return 0;
+		}
+	}
+
+	/* Resolve the relocations.  References within the binary are either
+	   patched in place or made relative to the symbol of the function
+	   they refer to.  Anything else must be a named symbol */
+	qsort(writeelf->ranges, writeelf->num_ranges,
+		  sizeof(jit_writeelf_range_t), range_compare);
+	for(index = 0; index < writeelf->num_relocs; ++index)
+	{
+		reloc = &(writeelf->relocs[index]);
+		range = find_range(writeelf, reloc->target);
+		if(range)
+		{
+			target = range->offset + (Elf_Addr)(reloc->target - range->start);
+			if(reloc->type == JIT_RELOC_RELATIVE32)
+			{
+				disp = (jit_int)(target - (reloc->offset + 4));
+				jit_memcpy(text->data + reloc->offset, &disp, sizeof(disp));
+				continue;
+			}
+			sym_index = (Elf_Word)(range->func + 1);
+			entry.r_addend = (Elf_Addr)
+				(target - writeelf->functions[range->func].offset);
+		}
+		else
+		{
+			name = reloc->name;
+			if(!name)
+			{
+				name = find_internal_symbol(reloc->target);
+			}
+			if(!name || reloc->type != JIT_RELOC_ABSOLUTE)
+			{
+				errno = EINVAL;
+				return 0;
+			}
+			sym_index = get_external_symbol(writeelf, symtab, name);
+			if(!sym_index)
+			{
+				return 0;
+			}
+			entry.r_addend = 0;
+		}
+		reloc_type = get_reloc_type(writeelf, reloc->type);
+		if(!reloc_type)
+		{
+			errno = EINVAL;
+			return 0;
+		}
+		jit_memzero(text->data + reloc->offset, sizeof(void *));
+		entry.r_offset = reloc->offset;
+		entry.r_info = ELF_R_INFO(sym_index, reloc_type);
+		if(!add_to_section(rela, &entry, sizeof(entry)))
+		{
+			return 0;
+		}
+	}
+
+	/* Build the symbol hash table, which has one chain per symbol */
+	num_syms = (Elf_Word)(symtab->data_len / sizeof(Elf_Sym));
+	num_buckets = num_syms / 2 + 1;
+	if(!pad_section(hash, (2 + num_buckets + num_syms) * sizeof(Elf_Word)))
+	{
+		return 0;
+	}
+	table = (Elf_Word *)(hash->data);
+	table[0] = num_buckets;
+	table[1] = num_syms;
+	for(sym_index = num_syms - 1; sym_index > 0; --sym_index)
+	{
+		name = get_dyn_string
+			(writeelf, ((Elf_Sym *)(symtab->data))[sym_index].st_name);
+		target = (Elf_Addr)(elf_hash(name) % num_buckets);
+		table[2 + num_buckets + sym_index] = table[2 + target];
+		table[2 + target] = sym_index;
+	}
+
+	/* Add the dynamic entries that point at the sections.  Their values
+	   are filled in once the sections are laid out */
+	dynamic = get_section(writeelf, ".dynamic", SHT_DYNAMIC,
+						  SHF_WRITE | SHF_ALLOC,
+						  sizeof(Elf_Dyn), sizeof(Elf_Dyn));
+	if(!dynamic)
+	{
+		return 0;
+	}
+	if(dynamic->data_len >= sizeof(Elf_Dyn) &&
+	   ((Elf_Dyn *)(dynamic->data + dynamic->data_len))[-1].d_tag == DT_NULL)
+	{
+		dynamic->data_len -= sizeof(Elf_Dyn);
+	}
+	if(!add_dyn_info(writeelf, DT_HASH, 0, 1) ||
+	   !add_dyn_info(writeelf, DT_STRTAB, 0, 1) ||
+	   !add_dyn_info(writeelf, DT_SYMTAB, 0, 1) ||
+	   !add_dyn_info(writeelf, DT_STRSZ, 0, 1) ||
+	   !add_dyn_info(writeelf, DT_SYMENT, sizeof(Elf_Sym), 1) ||
+	   !add_dyn_info(writeelf, DT_RELA, 0, 1) ||
+	   !add_dyn_info(writeelf, DT_RELASZ, 0, 1) ||
+	   !add_dyn_info(writeelf, DT_RELAENT, sizeof(Elf_Rela), 1) ||
+	   !add_dyn_info(writeelf, DT_NULL, 0, 0))
+	{
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * Write "len" bytes to "file" at "offset", padding with zeroes.
+ */
+static int write_at(FILE *file, long *posn, Elf_Off offset,
+					const void *buf, unsigned int len)
+{
+	while(*posn < (long)offset)
+	{
+		if(putc(0, file) == EOF)
+		{
+			return 0;
+		}
+		++(*posn);
+	}
+	if(len > 0 && fwrite(buf, 1, len, file) != len)
+	{
+		return 0;
+	}
+	*posn += (long)len;
+	return 1;
+}
+
 /*@
  * @deftypefun int jit_writeelf_write (jit_writeelf_t @var{writeelf}, const char *@var{filename})
  * Write a fully-built ELF binary to @var{filename}.  Returns zero
- * if an error occurred (reason in @code{errno}).
+ * if an error occurred (reason in @code{errno}).  The error is
+ * @code{EINVAL} if a function refers to code that is not in the
+ * binary, or to a native function that does not have a symbol name.
+ *
+ * The functions and the sections that are not discardable are placed
+ * in one loadable segment, which is relocated with the symbols and
+ * libraries that are registered with the context that loads it.
  * @end deftypefun
 @*/
 int jit_writeelf_write(jit_writeelf_t writeelf, const char *filename)
 {
-	/* TODO */
-	return 1;
+	jit_section_t text;
+	jit_section_t section;
+	Elf_Phdr phdr;
+	Elf_Shdr shdr;
+	Elf_Off offset;
+	Elf_Off align;
+	Elf_Addr text_addr;
+	Elf_Sym *sym;
+	Elf_Rela *rela;
+	Elf_Word symtab_index;
+	FILE *file;
+	long posn;
+	int index;
+	int ok;
+
+	if(!writeelf || !filename)
+	{
+		errno = EINVAL;
+		return 0;
+	}
+
+	/* Build the sections that describe the functions */
+	errno = ENOMEM;
+	if(!get_section(writeelf, ".text", SHT_PROGBITS,
+					SHF_ALLOC | SHF_EXECINSTR, 0, JIT_FUNCTION_ALIGNMENT) ||
+	   !build_dynamic_sections(writeelf))
+	{
+		return 0;
+	}
+	text = get_section(writeelf, ".text", SHT_PROGBITS,
+					   SHF_ALLOC | SHF_EXECINSTR, 0, JIT_FUNCTION_ALIGNMENT);
+
+	/* Lay out the file.  The headers and the allocated sections form
+	   one segment that is loaded at virtual address zero, so that file
+	   offsets and virtual addresses are the same.  The segment is
+	   writable because the loader applies the relocations in place */
+	offset = sizeof(Elf_Ehdr) + sizeof(Elf_Phdr);
+	for(index = 0; index < writeelf->num_sections; ++index)
+	{
+		section = &(writeelf->sections[index]);
+		if((section->shdr.sh_flags & SHF_ALLOC) == 0)
+		{
+			continue;
+		}
+		align = section->shdr.sh_addralign;
+		if(align > 1 && (offset % align) != 0)
+		{
+			offset += align - (offset % align);
+		}
+		section->shdr.sh_offset = offset;
+		section->shdr.sh_addr = (Elf_Addr)offset;
+		section->shdr.sh_size = section->data_len;
+		offset += section->data_len;
+	}
+	jit_memzero(&phdr, sizeof(phdr));
+	phdr.p_type = PT_LOAD;
+	phdr.p_flags = PF_R | PF_W | PF_X;
+	phdr.p_filesz = offset;
+	phdr.p_memsz = offset;
+	phdr.p_align = jit_vmem_page_size();
+	for(index = 0; index < writeelf->num_sections; ++index)
+	{
+		section = &(writeelf->sections[index]);
+		if((section->shdr.sh_flags & SHF_ALLOC) != 0)
+		{
+			continue;
+		}
+		section->shdr.sh_offset = offset;
+		section->shdr.sh_addr = 0;
+		section->shdr.sh_size = section->data_len;
+		offset += section->data_len;
+	}
+	if((offset % sizeof(Elf_Addr)) != 0)
+	{
+		offset += sizeof(Elf_Addr) - (offset % sizeof(Elf_Addr));
+	}
+
+	/* Now that the address of ".text" is known, finish the symbols,
+	   relocations and dynamic entries */
+	text_addr = text->shdr.sh_addr;
+	section = get_section(writeelf, ".dynsym", SHT_DYNSYM, SHF_ALLOC,
+						  sizeof(Elf_Sym), sizeof(Elf_Addr));
+	sym = (Elf_Sym *)(section->data);
+	for(index = 1; index <= writeelf->num_functions; ++index)
+	{
+		sym[index].st_value += text_addr;
+	}
+	section->shdr.sh_link = (Elf_Word)(writeelf->dynamic_string_section + 1);
+	section->shdr.sh_info = 1;
+	symtab_index = (Elf_Word)(section - writeelf->sections + 1);
+	add_dyn_info(writeelf, DT_SYMTAB, section->shdr.sh_addr, 1);
+	section = get_section(writeelf, ".hash", SHT_HASH, SHF_ALLOC,
+						  sizeof(Elf_Word), sizeof(Elf_Word));
+	section->shdr.sh_link = symtab_index;
+	add_dyn_info(writeelf, DT_HASH, section->shdr.sh_addr, 1);
+	section = get_section(writeelf, ".rela.dyn", SHT_RELA, SHF_ALLOC,
+						  sizeof(Elf_Rela), sizeof(Elf_Addr));
+	rela = (Elf_Rela *)(section->data);
+	for(index = 0; index < (int)(section->data_len / sizeof(Elf_Rela));
+		++index)
+	{
+		rela[index].r_offset += text_addr;
+	}
+	section->shdr.sh_link = symtab_index;
+	add_dyn_info(writeelf, DT_RELA, section->shdr.sh_addr, 1);
+	add_dyn_info(writeelf, DT_RELASZ, section->data_len, 1);
+	section = &(writeelf->sections[writeelf->dynamic_string_section]);
+	add_dyn_info(writeelf, DT_STRTAB, section->shdr.sh_addr, 1);
+	add_dyn_info(writeelf, DT_STRSZ, section->data_len, 1);
+	section = get_section(writeelf, ".dynamic", SHT_DYNAMIC,
+						  SHF_WRITE | SHF_ALLOC,
+						  sizeof(Elf_Dyn), sizeof(Elf_Dyn));
+	section->shdr.sh_link = (Elf_Word)(writeelf->dynamic_string_section + 1);
+
+	/* Fill in the rest of the ELF header */
+	writeelf->ehdr.e_type = ET_DYN;
+	writeelf->ehdr.e_entry = 0;
+	writeelf->ehdr.e_phoff = sizeof(Elf_Ehdr);
+	writeelf->ehdr.e_shoff = offset;
+	writeelf->ehdr.e_phentsize = sizeof(Elf_Phdr);
+	writeelf->ehdr.e_phnum = 1;
+	writeelf->ehdr.e_shentsize = sizeof(Elf_Shdr);
+	writeelf->ehdr.e_shnum = (Elf_Half)(writeelf->num_sections + 1);
+	writeelf->ehdr.e_shstrndx =
+		(Elf_Half)(writeelf->regular_string_section + 1);
+
+	/* Write the headers, the sections in the order that they were laid
+	   out in, and the section header table, which starts with the null
+	   section */
+	file = fopen(filename, "wb");
+	if(!file)
+	{
+		return 0;
+	}
+	posn = 0;
+	ok = write_at(file, &posn, 0, &(writeelf->ehdr), sizeof(Elf_Ehdr)) &&
+		 write_at(file, &posn, sizeof(Elf_Ehdr), &phdr, sizeof(Elf_Phdr));
+	for(index = 0; ok && index < 2 * writeelf->num_sections; ++index)
+	{
+		section = &(writeelf->sections[index % writeelf->num_sections]);
+		if(((section->shdr.sh_flags & SHF_ALLOC) != 0) ==
+		   (index >= writeelf->num_sections))
+		{
+			continue;
+		}
+		ok = write_at(file, &posn, section->shdr.sh_offset,
+					  section->data, section->data_len);
+	}
+	jit_memzero(&shdr, sizeof(shdr));
+	ok = ok && write_at(file, &posn, offset, &shdr, sizeof(shdr));
+	for(index = 0; ok && index < writeelf->num_sections; ++index)
+	{
+		ok = write_at(file, &posn, posn,
+					  &(writeelf->sections[index].shdr), sizeof(Elf_Shdr));
+	}
+	if(fclose(file) != 0)
+	{
+		ok = 0;
+	}
+	return ok;
 }
 
 /*@
@@ -434,12 +1147,171 @@ int jit_writeelf_write(jit_writeelf_t writeelf, const char *filename)
  * context must have the @code{JIT_OPTION_PRE_COMPILE} option set
  * to a non-zero value.  Returns zero if out of memory or the
  * parameters are invalid.
+ *
+ * The code is written together with its constant data, and is exported
+ * as the symbol @var{name}.  Calls to other functions must be to functions
+ * that are also added to @var{writeelf}, or to native functions that have
+ * a name, which are resolved when the binary is loaded.  Pointer constants
+ * that are embedded in the code are written as they are.
  * @end deftypefun
 @*/
 int jit_writeelf_add_function
 	(jit_writeelf_t writeelf, jit_function_t func, const char *name)
 {
-	/* TODO */
+	jit_writeelf_func_t *function;
+	jit_writeelf_reloc_t *reloc;
+	jit_section_t text;
+	_jit_image_t image;
+	unsigned char *address;
+	jit_nuint target;
+	jit_int disp;
+	Elf_Word name_index;
+	int first_range;
+	int last_range;
+	int range;
+	int index;
+
+	/* Bail out if the function was not compiled for pre-compilation */
+	if(!writeelf || !func || !name || !(func->is_compiled))
+	{
+		return 0;
+	}
+	image = func->image;
+	if(!image || !(image->code_start))
+	{
+		return 0;
+	}
+
+	/* Symbol names must be unique */
+	name_index = find_dyn_string(writeelf, name);
+	for(index = 0; name_index && index < writeelf->num_functions; ++index)
+	{
+		if(writeelf->functions[index].name == name_index)
+		{
+			return 0;
+		}
+	}
+	if(!name_index)
+	{
+		name_index = add_dyn_string(writeelf, name);
+		if(!name_index)
+		{
+			return 0;
+		}
+	}
+	function = (jit_writeelf_func_t *)jit_realloc
+		(writeelf->functions,
+		 (writeelf->num_functions + 1) * sizeof(jit_writeelf_func_t));
+	if(!function)
+	{
+		return 0;
+	}
+	writeelf->functions = function;
+
+	/* Copy the code and its constant data into the ".text" section */
+	text = get_section(writeelf, ".text", SHT_PROGBITS,
+					   SHF_ALLOC | SHF_EXECINSTR, 0, JIT_FUNCTION_ALIGNMENT);
+	if(!text)
+	{
+		return 0;
+	}
+	first_range = writeelf->num_ranges;
+	if(!add_range(writeelf, text, image->code_start, image->code_end,
+				  writeelf->num_functions))
+	{
+		return 0;
+	}
+	for(index = 0; index < image->num_blocks; ++index)
+	{
+		if(!add_range(writeelf, text, image->blocks[index].address,
+					  image->blocks[index].address +
+					  image->blocks[index].size, writeelf->num_functions))
+		{
+			return 0;
+		}
+	}
+
+	/* The code was written at one address but runs at another when the
+	   cache maps it twice.  Jump tables and calls hold the latter */
+	last_range = writeelf->num_ranges;
+	for(range = first_range; range < last_range; ++range)
+	{
+		if(!add_alias(writeelf, range, image->exec_offset))
+		{
+			return 0;
+		}
+	}
+	function += writeelf->num_functions;
+	function->name = name_index;
+	function->offset = writeelf->ranges[first_range].offset;
+	function->size = (Elf_Addr)(image->code_end - image->code_start);
+
+	/* Calls to the function that were compiled before it was may go
+	   through its trampolines */
+#if !defined(JIT_BACKEND_INTERP)
+# if defined(jit_redirector_size)
+	if(!add_trampoline(writeelf, func->redirector, writeelf->num_functions))
+	{
+		return 0;
+	}
+# endif
+	if(!add_trampoline(writeelf, func->indirector, writeelf->num_functions))
+	{
+		return 0;
+	}
+#endif
+	++(writeelf->num_functions);
+
+	/* Record the relocations with their targets.  They are resolved
+	   when the binary is written, once all functions are known */
+	for(index = 0; index < image->num_relocs; ++index)
+	{
+		address = image->relocs[index].address;
+		for(range = first_range; range < writeelf->num_ranges; ++range)
+		{
+			if(address >= writeelf->ranges[range].start &&
+			   address < writeelf->ranges[range].end)
+			{
+				break;
+			}
+		}
+		if(range >= writeelf->num_ranges)
+		{
+			return 0;
+		}
+		if(image->relocs[index].type == JIT_RELOC_RELATIVE32)
+		{
+			jit_memcpy(&disp, address, sizeof(disp));
+			target = (jit_nuint)(address + image->exec_offset + 4 + disp);
+		}
+		else
+		{
+			jit_memcpy(&target, address, sizeof(target));
+		}
+		reloc = (jit_writeelf_reloc_t *)jit_realloc
+			(writeelf->relocs,
+			 (writeelf->num_relocs + 1) * sizeof(jit_writeelf_reloc_t));
+		if(!reloc)
+		{
+			return 0;
+		}
+		writeelf->relocs = reloc;
+		reloc += writeelf->num_relocs;
+		reloc->offset = writeelf->ranges[range].offset +
+			(Elf_Addr)(address - writeelf->ranges[range].start);
+		reloc->type = image->relocs[index].type;
+		reloc->target = (unsigned char *)target;
+		reloc->name = 0;
+		if(image->relocs[index].name)
+		{
+			reloc->name = jit_strdup(image->relocs[index].name);
+			if(!(reloc->name))
+			{
+				return 0;
+			}
+		}
+		++(writeelf->num_relocs);
+	}
 	return 1;
 }
 
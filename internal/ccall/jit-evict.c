@@ -0,0 +1,294 @@
+/*
+ * jit-evict.c - Freeing and eviction of compiled code.
+ *
+ * This file is part of the libjit library.
+ *
+ * The libjit library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * The libjit library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the libjit library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "jit-internal.h"
+#include "jit-varint.h"
+
+#include <stdlib.h>
+
+/*
+ * One in this many of the evictable functions of a context is evicted
+ * at once, so that a full cache does not evict a function for every
+ * function that is compiled.
+ */
+#define	EVICT_BATCH_DIVISOR	4
+
+/*
+ * Function that may be evicted, with the time of its last use.
+ */
+typedef struct
+{
+	jit_function_t		func;
+	jit_nuint		last_use;
+
+} evict_candidate_t;
+
+void
+_jit_context_reclaim_code(jit_context_t context, int all)
+{
+	_jit_retired_code_t *link = &context->retired_code;
+	_jit_retired_code_t retired;
+
+	/* The list is ordered from the newest entry to the oldest */
+	while(!all && *link && !_jit_epoch_is_safe((*link)->epoch))
+	{
+		link = &((*link)->next);
+	}
+	while((retired = *link) != 0)
+	{
+		*link = retired->next;
+		_jit_varint_free_data(retired->bytecode_offset);
+		_jit_image_free(retired->image);
+		jit_free(retired);
+	}
+}
+
+int
+_jit_function_free_code(jit_function_t func)
+{
+	jit_context_t context = func->context;
+	jit_function_info_t info;
+	_jit_retired_code_t retired;
+
+	if(!func->is_compiled)
+	{
+		return 0;
+	}
+
+	/* Code that is shared through the compile cache, or that was not
+	   written to the memory context, is left alone.  The build lock of
+	   the function is held, so no other thread frees the info found */
+	info = 0;
+	if(!func->shares_code)
+	{
+		info = _jit_memory_find_function_info(context, func->entry_point);
+		if(info && _jit_memory_get_function(context, info) != func)
+		{
+			info = 0;
+		}
+		if(info && !context->memory_manager->free_code)
+		{
+			return 0;
+		}
+	}
+
+	/* Lookups on other threads may still read the bytecode offsets */
+	retired = 0;
+	if(func->bytecode_offset || func->image)
+	{
+		retired = jit_cnew(struct _jit_retired_code);
+		if(!retired)
+		{
+			return 0;
+		}
+	}
+
+	/* Send new calls to the on-demand compiler before the code goes */
+#if !defined(JIT_BACKEND_INTERP) && defined(jit_redirector_size)
+	func->entry_point = func->redirector;
+#else
+	func->entry_point = 0;
+#endif
+	func->is_compiled = 0;
+	func->shares_code = 0;
+
+	if(info)
+	{
+		_jit_memory_free_code(context, info);
+	}
+	if(retired)
+	{
+		retired->bytecode_offset = func->bytecode_offset;
+		retired->image = func->image;
+		retired->epoch = _jit_epoch_get();
+		retired->next = context->retired_code;
+		context->retired_code = retired;
+		func->bytecode_offset = 0;
+		func->image = 0;
+	}
+	_jit_context_reclaim_code(context, 0);
+	return 1;
+}
+
+/*@
+ * @deftypefun int jit_function_free_code (jit_function_t @var{func})
+ * Free the compiled code of @var{func} and return the function to the
+ * state it was in before it was compiled.  The next call through its
+ * closure or @code{jit_function_apply} compiles it again with its
+ * on-demand compiler.  Returns zero if @var{func} is not compiled or if
+ * the memory manager of the context cannot free code.
+ *
+ * The memory is not reused while a thread may still run the code: calls
+ * made with @code{jit_function_apply}, and lookups by address, hold an
+ * epoch section, and the code is only given back once every thread that
+ * was in one when the code was freed has left it.  Code that is entered
+ * through a closure from outside of JIT code is not covered, so pointers
+ * to the code itself must not be used any more.  This includes closures
+ * of functions that are neither recompilable nor evictable, which point
+ * straight at the code.  Code that @var{func} shares with other
+ * functions through the @code{JIT_OPTION_COMPILE_CACHE} option is not
+ * freed.
+ * @end deftypefun
+@*/
+int
+jit_function_free_code(jit_function_t func)
+{
+	int result;
+
+	if(!func)
+	{
+		return 0;
+	}
+	jit_function_build_start(func);
+	_jit_memory_lock(func->context);
+	result = _jit_function_free_code(func);
+	_jit_memory_unlock(func->context);
+	jit_function_build_end(func);
+	return result;
+}
+
+/*
+ * Order candidates from the least recently used to the most.
+ */
+static int
+compare_candidates(const void *p1, const void *p2)
+{
+	const evict_candidate_t *c1 = (const evict_candidate_t *) p1;
+	const evict_candidate_t *c2 = (const evict_candidate_t *) p2;
+
+	if(c1->last_use < c2->last_use)
+	{
+		return -1;
+	}
+	if(c1->last_use > c2->last_use)
+	{
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Determine if the code of "func" may be evicted.
+ */
+static int
+is_candidate(jit_function_t func, jit_function_t except)
+{
+	return func != except && func->is_evictable && func->is_compiled
+		&& !func->builder && !func->shares_code;
+}
+
+/*
+ * The functions are not sorted by use, so this collects the evictable
+ * ones and sorts them, and then frees the code of the oldest batch.  A
+ * function whose build lock is held, because it is being compiled or
+ * called for the first time, is skipped.
+ *
+ * The code is only retired, and its memory is reused once no thread
+ * that may run it is in compiled code.  Until then the cache does not
+ * count it towards the limit, so the caller can allocate again either way.
+ */
+int
+_jit_context_evict_code(jit_context_t context, jit_function_t func)
+{
+	evict_candidate_t *candidates;
+	jit_function_t current;
+	unsigned int num;
+	unsigned int index;
+	unsigned int batch;
+	unsigned int evicted;
+
+	_jit_memory_lock(context);
+
+	num = 0;
+	for(current = context->functions; current; current = current->next)
+	{
+		if(is_candidate(current, func))
+		{
+			++num;
+		}
+	}
+	if(num == 0)
+	{
+		_jit_memory_unlock(context);
+		return 0;
+	}
+	candidates = (evict_candidate_t *) jit_malloc(num * sizeof(evict_candidate_t));
+	if(!candidates)
+	{
+		_jit_memory_unlock(context);
+		return 0;
+	}
+	num = 0;
+	for(current = context->functions; current; current = current->next)
+	{
+		if(is_candidate(current, func))
+		{
+			candidates[num].func = current;
+			candidates[num].last_use = current->last_use;
+			++num;
+		}
+	}
+	qsort(candidates, num, sizeof(evict_candidate_t), compare_candidates);
+
+	batch = num / EVICT_BATCH_DIVISOR;
+	if(batch == 0)
+	{
+		batch = 1;
+	}
+	evicted = 0;
+	for(index = 0; index < num && evicted < batch; ++index)
+	{
+		current = candidates[index].func;
+		if(!jit_mutex_trylock(&current->builder_lock))
+		{
+			continue;
+		}
+		if(is_candidate(current, func) && _jit_function_free_code(current))
+		{
+			++evicted;
+		}
+		jit_function_build_end(current);
+	}
+	context->num_evictions += evicted;
+
+	_jit_memory_unlock(context);
+	jit_free(candidates);
+	return evicted != 0;
+}
+
+/*@
+ * @deftypefun jit_nuint jit_context_get_num_evictions (jit_context_t @var{context})
+ * Get the number of times that the code of a function of @var{context}
+ * was evicted because of the @code{JIT_OPTION_CACHE_EVICT} option.
+ * @end deftypefun
+@*/
+jit_nuint
+jit_context_get_num_evictions(jit_context_t context)
+{
+	jit_nuint num = 0;
+
+	if(context)
+	{
+		_jit_memory_lock(context);
+		num = context->num_evictions;
+		_jit_memory_unlock(context);
+	}
+	return num;
+}
@@ -131,7 +131,9 @@ void jit_exception_throw(void *object)
 		control->last_exception = object;
 		if(control->setjmp_head)
 		{
+			/* Leave the calls into compiled code that are unwound */
 			control->backtrace_head = control->setjmp_head->trace;
+			_jit_epoch_restore(control->setjmp_head->epoch_depth);
 			longjmp(control->setjmp_head->buf, 1);
 		}
 	}
@@ -397,11 +399,7 @@ jit_stack_trace_get_function(jit_context_t context, jit_stack_trace_t trace, uns
 {
 	if(trace && posn < trace->size)
 	{
-		void *func_info = _jit_memory_find_function_info(context, trace->items[posn]);
-		if(func_info)
-		{
-			return _jit_memory_get_function(context, func_info);
-		}
+		return _jit_memory_find_function(context, trace->items[posn]);
 	}
 	return 0;
 }
@@ -438,24 +436,24 @@ jit_stack_trace_get_offset(jit_context_t context, jit_stack_trace_t trace, unsig
 {
 	void *func_info;
 	jit_function_t func;
+	unsigned int offset = JIT_NO_OFFSET;
 
 	if(!trace || posn >= trace->size)
 	{
 		return JIT_NO_OFFSET;
 	}
 
+	/* The code may be freed by another thread, but not while the
+	   offset is being read */
+	_jit_epoch_enter();
 	func_info = _jit_memory_find_function_info(context, trace->items[posn]);
-	if(!func_info)
+	func = func_info ? _jit_memory_get_function(context, func_info) : 0;
+	if(func)
 	{
-		return JIT_NO_OFFSET;
+		offset = _jit_function_get_bytecode(func, func_info, trace->items[posn], 0);
 	}
-	func = _jit_memory_get_function(context, func_info);
-	if(!func)
-	{
-		return JIT_NO_OFFSET;
-	}
-
-	return _jit_function_get_bytecode(func, func_info, trace->items[posn], 0);
+	_jit_epoch_leave();
+	return offset;
 }
 
 /*@
@@ -526,6 +524,7 @@ void _jit_unwind_push_setjmp(jit_jmp_buf *jbuf)
 		jbuf->trace = control->backtrace_head;
 		jbuf->catch_pc = 0;
 		jbuf->parent = control->setjmp_head;
+		jbuf->epoch_depth = control->epoch_depth;
 		control->setjmp_head = jbuf;
 	}
 }
@@ -41,6 +41,11 @@
  * @code{jit_context_build_end} after you have called
  * @code{jit_function_compile}.  This will protect the JIT's internal
  * data structures within a multi-threaded environment.
+ *
+ * Different functions of a context may also be built and compiled by
+ * several threads at the same time.  In that case, each function is
+ * protected with @code{jit_function_build_start} and
+ * @code{jit_function_build_end} instead of the context-wide lock.
  * @end deftypefun
 @*/
 jit_function_t
@@ -49,6 +54,7 @@ jit_function_create(jit_context_t context, jit_type_t signature)
 	jit_function_t func;
 #if !defined(JIT_BACKEND_INTERP) && (defined(jit_redirector_size) || defined(jit_indirector_size))
 	unsigned char *trampoline;
+	int evicted;
 #endif
 
 	/* Acquire the memory context */
@@ -69,6 +75,18 @@ jit_function_create(jit_context_t context, jit_type_t signature)
 
 #if !defined(JIT_BACKEND_INTERP) && (defined(jit_redirector_size) || defined(jit_indirector_size))
 	trampoline = (unsigned char *) _jit_memory_alloc_trampoline(context);
+	while(!trampoline && jit_context_get_meta_numeric(context, JIT_OPTION_CACHE_EVICT))
+	{
+		/* Make room by evicting code, which takes the memory lock */
+		_jit_memory_unlock(context);
+		evicted = _jit_context_evict_code(context, 0);
+		_jit_memory_lock(context);
+		if(!evicted)
+		{
+			break;
+		}
+		trampoline = (unsigned char *) _jit_memory_alloc_trampoline(context);
+	}
 	if(!trampoline)
 	{
 		_jit_memory_free_function(context, func);
@@ -91,22 +109,26 @@ jit_function_create(jit_context_t context, jit_type_t signature)
 	func->context = context;
 	func->signature = jit_type_copy(signature);
 	func->optimization_level = JIT_OPTLEVEL_NORMAL;
+	jit_mutex_create(&func->builder_lock);
 
 #if !defined(JIT_BACKEND_INTERP) && defined(jit_redirector_size)
 	/* If we aren't using interpretation, then point the function's
 	   initial entry point at the redirector, which in turn will
 	   invoke the on-demand compiler */
-	func->entry_point = _jit_create_redirector
-		(func->redirector, (void *) context->on_demand_driver,
-		 func, jit_type_get_abi(signature));
+	func->entry_point = _jit_memory_executable(context, _jit_create_redirector
+		(_jit_memory_writable(context, func->redirector),
+		 (void *) context->on_demand_driver,
+		 func, jit_type_get_abi(signature), -(context->write_offset)));
 	_jit_flush_exec(func->redirector, jit_redirector_size);
 #endif
 #if !defined(JIT_BACKEND_INTERP) && defined(jit_indirector_size)
-	_jit_create_indirector(func->indirector, (void**) &(func->entry_point));
+	_jit_create_indirector(_jit_memory_writable(context, func->indirector),
+			       (void**) &(func->entry_point), -(context->write_offset));
 	_jit_flush_exec(func->indirector, jit_indirector_size);
 #endif
 
 	/* Add the function to the context list */
+	_jit_memory_lock(context);
 	func->next = 0;
 	func->prev = context->last_function;
 	if(context->last_function)
@@ -118,6 +140,7 @@ jit_function_create(jit_context_t context, jit_type_t signature)
 		context->functions = func;
 	}
 	context->last_function = func;
+	_jit_memory_unlock(context);
 
 	/* Return the function to the caller */
 	return func;
@@ -216,6 +239,7 @@ void _jit_function_free_builder(jit_function_t func)
 		jit_memory_pool_free(&(func->builder->meta_pool), _jit_meta_free_one);
 		jit_free(func->builder->param_values);
 		jit_free(func->builder->label_info);
+		jit_free(func->builder->live_ranges);
 		jit_free(func->builder);
 		func->builder = 0;
 		func->is_optimized = 0;
@@ -233,6 +257,17 @@ _jit_function_destroy(jit_function_t func)
 	}
 
 	context = func->context;
+
+	_jit_function_free_builder(func);
+	_jit_function_free_inline_body(func);
+	_jit_varint_free_data(func->bytecode_offset);
+	_jit_image_free(func->image);
+	jit_meta_destroy(&func->meta);
+	jit_type_free(func->signature);
+	jit_mutex_destroy(&func->builder_lock);
+
+	_jit_memory_lock(context);
+
 	if(func->next)
 	{
 		func->next->prev = func->prev;
@@ -250,13 +285,6 @@ _jit_function_destroy(jit_function_t func)
 		context->functions = func->next;
 	}
 
-	_jit_function_free_builder(func);
-	_jit_varint_free_data(func->bytecode_offset);
-	jit_meta_destroy(&func->meta);
-	jit_type_free(func->signature);
-
-	_jit_memory_lock(context);
-
 #if !defined(JIT_BACKEND_INTERP) && (defined(jit_redirector_size) || defined(jit_indirector_size))
 # if defined(jit_redirector_size)
 	_jit_memory_free_trampoline(context, func->redirector);
@@ -297,6 +325,32 @@ void jit_function_abandon(jit_function_t func)
 	}
 }
 
+/*@
+ * @deftypefun void jit_function_build_start (jit_function_t @var{func})
+ * Acquire the build lock of @var{func}.  Unlike
+ * @code{jit_context_build_start}, this only excludes other threads
+ * that build or compile the same function, so that several functions
+ * of a context can be built at the same time.  The on-demand compiler
+ * also acquires this lock.
+ * @end deftypefun
+@*/
+void
+jit_function_build_start(jit_function_t func)
+{
+	jit_mutex_lock(&func->builder_lock);
+}
+
+/*@
+ * @deftypefun void jit_function_build_end (jit_function_t @var{func})
+ * Release the build lock of @var{func}.
+ * @end deftypefun
+@*/
+void
+jit_function_build_end(jit_function_t func)
+{
+	jit_mutex_unlock(&func->builder_lock);
+}
+
 /*@
  * @deftypefun jit_context_t jit_function_get_context (jit_function_t @var{func})
  * Get the context associated with a function.
@@ -539,6 +593,27 @@ int jit_function_is_compiled(jit_function_t func)
 	}
 }
 
+/*@
+ * @deftypefun jit_nint jit_function_get_leaf_stack_size (jit_function_t @var{func})
+ * Get the maximum stack space, including the return address, that the
+ * compiled code of @var{func} uses.  Returns zero if the function is not
+ * compiled, or if it is not a leaf function with a fixed frame size.
+ * A leaf function makes no calls and cannot throw exceptions, so it can
+ * be entered directly on any stack with that much space available.
+ * @end deftypefun
+@*/
+jit_nint jit_function_get_leaf_stack_size(jit_function_t func)
+{
+	if(func && func->is_compiled && func->is_leaf)
+	{
+		return func->leaf_stack_size;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
 /*@
  * @deftypefun int jit_function_set_recompilable (jit_function_t @var{func})
  * Mark this function as a candidate for recompilation.  That is,
@@ -599,6 +674,49 @@ int jit_function_is_recompilable(jit_function_t func)
 	}
 }
 
+/*@
+ * @deftypefun void jit_function_set_evictable (jit_function_t @var{func})
+ * Mark this function as one whose compiled code may be freed when the
+ * cache limit of its context is hit, if the @code{JIT_OPTION_CACHE_EVICT}
+ * option is set.  An evicted function is compiled again by its on-demand
+ * compiler when it is called next, so the on-demand compiler must be
+ * able to build it again.
+ *
+ * Like @code{jit_function_set_recompilable}, this must be called before
+ * the function is compiled the first time, so that calls from other
+ * functions and closures go through its indirector.  The code of an
+ * evictable function may be evicted whenever another function of the
+ * context is compiled, but its memory is only reused once no call made
+ * through @code{jit_function_apply} that was running then is still
+ * running.  The function must not be called through its closure from
+ * outside of JIT code, as such calls are not tracked.
+ * @end deftypefun
+@*/
+void jit_function_set_evictable(jit_function_t func)
+{
+	if(func)
+	{
+		func->is_evictable = 1;
+	}
+}
+
+/*@
+ * @deftypefun int jit_function_is_evictable (jit_function_t @var{func})
+ * Determine if this function is evictable.
+ * @end deftypefun
+@*/
+int jit_function_is_evictable(jit_function_t func)
+{
+	if(func)
+	{
+		return func->is_evictable;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
 #ifdef JIT_BACKEND_INTERP
 
 /*
@@ -642,7 +760,8 @@ void *jit_function_to_closure(jit_function_t func)
 							  function_closure, (void *)func);
 #else
 	/* On native platforms, use the closure entry point */
-	if(func->indirector && (!func->is_compiled || func->is_recompilable))
+	if(func->indirector
+	   && (!func->is_compiled || func->is_recompilable || func->is_evictable))
 	{
 		return func->indirector;
 	}
@@ -659,20 +778,11 @@ void *jit_function_to_closure(jit_function_t func)
 jit_function_t
 jit_function_from_closure(jit_context_t context, void *closure)
 {
-	void *func_info;
-
 	if(!context)
 	{
 		return 0;
 	}
-
-	func_info = _jit_memory_find_function_info(context, closure);
-	if(!func_info)
-	{
-		return 0;
-	}
-
-	return _jit_memory_get_function(context, func_info);
+	return _jit_memory_find_function(context, closure);
 }
 
 /*@
@@ -686,7 +796,6 @@ jit_function_from_closure(jit_context_t context, void *closure)
 jit_function_t
 jit_function_from_pc(jit_context_t context, void *pc, void **handler)
 {
-	void *func_info;
 	jit_function_t func;
 
 	if(!context)
@@ -695,12 +804,7 @@ jit_function_from_pc(jit_context_t context, void *pc, void **handler)
 	}
 
 	/* Get the function and the exception handler cookie */
-	func_info = _jit_memory_find_function_info(context, pc);
-	if(!func_info)
-	{
-		return 0;
-	}
-	func = _jit_memory_get_function(context, func_info);
+	func = _jit_memory_find_function(context, pc);
 	if(!func)
 	{
 		return 0;
@@ -750,7 +854,8 @@ jit_function_to_vtable_pointer(jit_function_t func)
 	{
 		return 0;
 	}
-	if(func->indirector && (!func->is_compiled || func->is_recompilable))
+	if(func->indirector
+	   && (!func->is_compiled || func->is_recompilable || func->is_evictable))
 	{
 		return func->indirector;
 	}
@@ -777,20 +882,11 @@ jit_function_from_vtable_pointer(jit_context_t context, void *vtable_pointer)
 	}
 	return 0;
 #else
-	void *func_info;
-
 	if(!context)
 	{
 		return 0;
 	}
-
-	func_info = _jit_memory_find_function_info(context, vtable_pointer);
-	if(!func_info)
-	{
-		return 0;
-	}
-
-	return _jit_memory_get_function(context, func_info);
+	return _jit_memory_find_function(context, vtable_pointer);
 #endif
 }
 
@@ -809,11 +905,11 @@ jit_function_from_vtable_pointer(jit_context_t context, void *vtable_pointer)
  *
  * @enumerate
  * @item
- * The context is locked by calling @code{jit_context_build_start}.
+ * The function is locked by calling @code{jit_function_build_start}.
  *
  * @item
  * If the function has already been compiled, @code{libjit} unlocks
- * the context and returns immediately.  This can happen because of race
+ * the function and returns immediately.  This can happen because of race
  * conditions between threads: some other thread may have beaten us
  * to the on-demand compiler.
  *
@@ -828,7 +924,7 @@ jit_function_from_vtable_pointer(jit_context_t context, void *vtable_pointer)
  * will call @code{jit_function_compile} to compile the function.
  *
  * @item
- * The context is unlocked by calling @code{jit_context_build_end} and
+ * The function is unlocked by calling @code{jit_function_build_end} and
  * @code{libjit} jumps to the newly-compiled entry point.  If an error
  * occurs, a built-in exception of type @code{JIT_RESULT_COMPILE_ERROR}
  * or @code{JIT_RESULT_OUT_OF_MEMORY} will be thrown.
@@ -939,14 +1035,16 @@ int jit_function_apply_vararg
 		jit_exception_builtin(JIT_RESULT_CALLED_NESTED);
 		return 0;
 	}
-	if(func->is_compiled)
+	if(!func->is_compiled)
 	{
-		entry = func->entry_point;
-	}
-	else
-	{
-		entry = (*func->context->on_demand_driver)(func);
+		(*func->context->on_demand_driver)(func);
 	}
+	_jit_function_touch(func);
+
+	/* Keep code that is freed from here on until the call returns.  An
+	   exception leaves the section when it unwinds to this point */
+	_jit_epoch_enter();
+	entry = func->entry_point;
 
 	/* Get the default signature if necessary */
 	if(!signature)
@@ -961,6 +1059,7 @@ int jit_function_apply_vararg
 	jit_apply(signature, entry, args, jit_type_num_params(func->signature), return_area);
 
 	/* Restore the backtrace and "setjmp" contexts and exit */
+	_jit_epoch_leave();
 	_jit_unwind_pop_setjmp();
 	return 1;
 }
@@ -974,6 +1073,23 @@ int jit_function_apply_vararg
  * generate better code for this function.  Usually you would increase
  * this value just before forcing @var{func} to recompile.
  *
+ * At @code{JIT_OPTLEVEL_NORMAL}, the default, the compiler cleans up the
+ * control flow graph, moves computations that give the same result
+ * on every iteration of a loop out of it, and removes null and bounds
+ * checks whose outcome is already known.  It replaces relative loads
+ * from locations whose value is known with that value, also from one
+ * iteration of a simple loop to the next, and removes relative stores
+ * that are overwritten before they can be read.  It also moves the
+ * blocks that are not expected to run, such as the ones that throw, out
+ * of the hot path and aligns loop headers.  At @code{JIT_OPTLEVEL_NONE}
+ * none of this is done.
+ *
+ * At @code{JIT_OPTLEVEL_SSA} the compiler also puts the function into SSA
+ * form to propagate constants through conditional branches, to remove
+ * computations that repeat an earlier one in a dominating block, and to
+ * propagate copies across blocks.  Functions with exception handlers
+ * are not put into SSA form.
+ *
  * When the optimization level reaches the value returned by
  * @code{jit_function_get_max_optimization_level()}, there is usually
  * little point in continuing to recompile the function because
@@ -1025,7 +1141,7 @@ jit_function_get_optimization_level(jit_function_t func)
 unsigned int
 jit_function_get_max_optimization_level(void)
 {
-	return JIT_OPTLEVEL_NORMAL;
+	return JIT_OPTLEVEL_SSA;
 }
 
 /*@
@@ -120,6 +120,62 @@ typedef enum
 	XMM_XORP		= 0x57
 } X86_64_XMM_PLOP;
 
+/*
+ * Arithmetic opcodes used with packed single and double precision values.
+ */
+typedef enum
+{
+	XMM_PSQRT		= 0x51,
+	XMM_PADD		= 0x58,
+	XMM_PMUL		= 0x59,
+	XMM_PSUB		= 0x5C,
+	XMM_PMIN		= 0x5D,
+	XMM_PDIV		= 0x5E,
+	XMM_PMAX		= 0x5F
+} X86_64_XMM_PAOP;
+
+/*
+ * Predicates for the packed single and double precision compares.
+ */
+typedef enum
+{
+	XMM_CMP_EQ		= 0x00,
+	XMM_CMP_LT		= 0x01,
+	XMM_CMP_LE		= 0x02,
+	XMM_CMP_NE		= 0x04
+} X86_64_XMM_CMP;
+
+/*
+ * Opcodes used with packed integer values.
+ * Opcode1: 0x66 (prefix), Opcode2: 0x0F
+ */
+typedef enum
+{
+	XMM_PUNPCKLDQ	= 0x62,
+	XMM_PCMPGTD		= 0x66,
+	XMM_PCMPEQD		= 0x76,
+	XMM_PADDQ		= 0xD4,
+	XMM_PAND		= 0xDB,
+	XMM_PANDN		= 0xDF,
+	XMM_POR			= 0xEB,
+	XMM_PXOR		= 0xEF,
+	XMM_PMULUDQ		= 0xF4,
+	XMM_PSUBD		= 0xFA,
+	XMM_PSUBQ		= 0xFB,
+	XMM_PADDD		= 0xFE
+} X86_64_XMM_PIOP;
+
+/*
+ * Opcodes used with packed integer values that need SSE4.1 or SSE4.2.
+ * Opcode1: 0x66 (prefix), Opcode2: 0x0F, Opcode3: 0x38
+ */
+typedef enum
+{
+	XMM_PCMPEQQ		= 0x29,		/* SSE4.1 */
+	XMM_PCMPGTQ		= 0x37,		/* SSE4.2 */
+	XMM_PMULLD		= 0x40		/* SSE4.1 */
+} X86_64_XMM_PIOP38;
+
 /*
  * Rounding modes for xmm rounding instructions, the mxcsr register and
  * the fpu control word.
@@ -2257,6 +2313,50 @@ typedef union
 		x86_64_shift_memindex_size((inst), 7, (basereg), (disp), (indexreg), (shift), (size)); \
 	} while(0)
 
+/*
+ * Emit the three byte VEX prefix of an instruction without a vector
+ * length.  pp selects the implied 0x66 (1), 0xf3 (2) or 0xf2 (3) prefix
+ * and map the 0x0f (1), 0x0f 0x38 (2) or 0x0f 0x3a (3) opcode map.
+ * vvvv is the additional source register.
+ */
+#define x86_64_vex3_emit(inst, pp, map, width, modrm_reg, vvvv, rm_base_reg) \
+	do { \
+		*(inst)++ = (unsigned char)0xc4; \
+		*(inst)++ = (unsigned char)((((modrm_reg) & 8) ? 0 : 0x80) | \
+									0x40 | \
+									(((rm_base_reg) & 8) ? 0 : 0x20) | \
+									((map) & 0x1f)); \
+		*(inst)++ = (unsigned char)((((width) & 8) ? 0x80 : 0) | \
+									((~(vvvv) & 0x0f) << 3) | \
+									((pp) & 0x03)); \
+	} while(0)
+
+/*
+ * shlx, shrx, sarx: shift sreg by the count in creg into dreg (BMI2).
+ * The count is masked like the one in cl and the flags are unchanged.
+ */
+#define x86_64_bmi2_shift_reg_reg_reg_size(inst, pp, dreg, sreg, creg, size) \
+	do { \
+		x86_64_vex3_emit((inst), (pp), 2, (size), (dreg), (creg), (sreg)); \
+		*(inst)++ = (unsigned char)0xf7; \
+		x86_64_reg_emit((inst), (dreg), (sreg)); \
+	} while(0)
+
+#define x86_64_shlx_reg_reg_reg_size(inst, dreg, sreg, creg, size) \
+	do { \
+		x86_64_bmi2_shift_reg_reg_reg_size((inst), 1, (dreg), (sreg), (creg), (size)); \
+	} while(0)
+
+#define x86_64_shrx_reg_reg_reg_size(inst, dreg, sreg, creg, size) \
+	do { \
+		x86_64_bmi2_shift_reg_reg_reg_size((inst), 3, (dreg), (sreg), (creg), (size)); \
+	} while(0)
+
+#define x86_64_sarx_reg_reg_reg_size(inst, dreg, sreg, creg, size) \
+	do { \
+		x86_64_bmi2_shift_reg_reg_reg_size((inst), 2, (dreg), (sreg), (creg), (size)); \
+	} while(0)
+
 /*
  * test: and tha values and set sf, zf and pf according to the result
  */
@@ -4721,6 +4821,77 @@ typedef union
 		x86_64_xmm2_reg_memindex_size((inst), 0x66, 0x0f, (op), (dreg), (basereg), (disp), (indexreg), (shift), 0); \
 	} while(0)
 
+/*
+ * Macros for the arithmetic operations with packed single and double
+ * precision values.
+ */
+#define x86_64_paops_reg_reg(inst, op, dreg, sreg) \
+	do { \
+		x86_64_xmm2_reg_reg((inst), 0x0f, (op), (dreg), (sreg)); \
+	} while(0)
+
+#define x86_64_paopd_reg_reg(inst, op, dreg, sreg) \
+	do { \
+		x86_64_p1_xmm2_reg_reg_size((inst), 0x66, 0x0f, (op), (dreg), (sreg), 0); \
+	} while(0)
+
+/*
+ * cmpps/cmppd: Compare packed values, setting all bits of each element
+ * for which the predicate holds
+ */
+#define x86_64_cmpps_reg_reg(inst, dreg, sreg, pred) \
+	do { \
+		x86_64_xmm2_reg_reg((inst), 0x0f, 0xc2, (dreg), (sreg)); \
+		x86_imm_emit8((inst), (pred)); \
+	} while(0)
+
+#define x86_64_cmppd_reg_reg(inst, dreg, sreg, pred) \
+	do { \
+		x86_64_p1_xmm2_reg_reg_size((inst), 0x66, 0x0f, 0xc2, (dreg), (sreg), 0); \
+		x86_imm_emit8((inst), (pred)); \
+	} while(0)
+
+/*
+ * Macros for the operations with packed integer values.
+ */
+#define x86_64_piop_reg_reg(inst, op, dreg, sreg) \
+	do { \
+		x86_64_p1_xmm2_reg_reg_size((inst), 0x66, 0x0f, (op), (dreg), (sreg), 0); \
+	} while(0)
+
+#define x86_64_piop38_reg_reg(inst, op, dreg, sreg) \
+	do { \
+		x86_64_p1_xmm3_reg_reg_size((inst), 0x66, 0x0f, 0x38, (op), (dreg), (sreg), 0); \
+	} while(0)
+
+/*
+ * pshufd: Shuffle the doublewords of sreg into dreg as selected by the
+ * two bit fields of order
+ */
+#define x86_64_pshufd_reg_reg(inst, dreg, sreg, order) \
+	do { \
+		x86_64_p1_xmm2_reg_reg_size((inst), 0x66, 0x0f, 0x70, (dreg), (sreg), 0); \
+		x86_imm_emit8((inst), (order)); \
+	} while(0)
+
+/*
+ * psrad: Shift packed doublewords right, filling with the sign bit
+ */
+#define x86_64_psrad_reg_imm(inst, reg, imm) \
+	do { \
+		x86_64_p1_xmm2_reg_reg_size((inst), 0x66, 0x0f, 0x72, 4, (reg), 0); \
+		x86_imm_emit8((inst), (imm)); \
+	} while(0)
+
+/*
+ * psrlq: Shift packed quadwords right, filling with zeros
+ */
+#define x86_64_psrlq_reg_imm(inst, reg, imm) \
+	do { \
+		x86_64_p1_xmm2_reg_reg_size((inst), 0x66, 0x0f, 0x73, 2, (reg), 0); \
+		x86_imm_emit8((inst), (imm)); \
+	} while(0)
+
 /*
  * addsd: Add scalar double precision float values
  */
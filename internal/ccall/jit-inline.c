@@ -0,0 +1,571 @@
+/*
+ * jit-inline.c - Inlining of small functions into their callers.
+ *
+ * This file is part of the libjit library.
+ *
+ * The libjit library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * The libjit library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the libjit library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "jit-internal.h"
+
+/*
+ * The builder of a function is freed once it is compiled, so a function
+ * that is small enough to be inlined keeps a copy of its instructions.
+ * The copy is taken after the function is optimized, and refers to
+ * values by their number and to blocks by their labels.  A call to the
+ * function from another function that is built later replays the copy
+ * into the caller with fresh values and labels, so the optimizer of the
+ * caller sees through the former call boundary.
+ *
+ * Only instructions that need nothing from the frame or the calling
+ * convention of the function are copied: arithmetic, conversions,
+ * branches, copies, and loads and stores through pointers.  A function
+ * that calls out, has exception handlers, takes addresses or moves
+ * structures is never inlined.  As a function without calls cannot
+ * call itself, inlining never recurses.  Neither is a function that may
+ * be recompiled or evicted, because the callers that inlined it would
+ * keep running its old instructions.
+ */
+
+/* Pseudo opcodes that record the structure of the blocks */
+#define INLINE_BLOCK		-1	/* start a block with label "dest" */
+#define INLINE_LABEL		-2	/* give label "dest" to the same block */
+#define INLINE_DEAD		-3	/* the block does not fall through */
+
+typedef struct
+{
+	jit_type_t		type;
+	int			param;
+	int			is_constant;
+	jit_constant_t		constant;
+
+} _jit_inline_value_t;
+
+typedef struct
+{
+	int			opcode;
+	int			flags;
+	jit_nint		dest;
+	jit_nint		value1;
+	jit_nint		value2;
+
+} _jit_inline_insn_t;
+
+struct _jit_inline_body
+{
+	_jit_inline_value_t	*values;
+	int			num_values;
+	_jit_inline_insn_t	*insns;
+	int			num_insns;
+	int			size;
+	jit_label_t		num_labels;
+	int			may_throw;
+};
+
+/*
+ * Determine if an instruction may be copied into another function.
+ */
+static int
+is_inline_opcode(int opcode)
+{
+	if(opcode > JIT_OP_NOP && opcode <= JIT_OP_CHECK_NULL)
+	{
+		return 1;
+	}
+	if(opcode >= JIT_OP_RETURN && opcode <= JIT_OP_RETURN_NFLOAT)
+	{
+		return 1;
+	}
+	if(opcode >= JIT_OP_COPY_LOAD_SBYTE && opcode <= JIT_OP_COPY_STORE_SHORT)
+	{
+		return opcode != JIT_OP_COPY_STRUCT;
+	}
+	if(opcode >= JIT_OP_LOAD_RELATIVE_SBYTE && opcode <= JIT_OP_STORE_ELEMENT_NFLOAT)
+	{
+		return opcode != JIT_OP_LOAD_RELATIVE_STRUCT
+			&& opcode != JIT_OP_STORE_RELATIVE_STRUCT;
+	}
+	return 0;
+}
+
+/*
+ * Determine if values of a type may be copied into another function.
+ */
+static int
+is_inline_type(jit_type_t type)
+{
+	type = jit_type_normalize(type);
+	return type && type->kind != JIT_TYPE_STRUCT && type->kind != JIT_TYPE_UNION;
+}
+
+/*
+ * Get the maximum number of instructions of an inlined function.
+ */
+static int
+get_inline_limit(jit_context_t context)
+{
+	return (int) jit_context_get_meta_numeric(context, JIT_OPTION_INLINE_LIMIT);
+}
+
+/*
+ * Check that a function may be inlined and count its instructions.
+ * Returns -1 if it may not be.
+ */
+static int
+count_inline_insns(jit_function_t func)
+{
+	jit_block_t block;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+	unsigned int param;
+	int size;
+
+	if(func->nested_parent || func->has_try
+	   || func->is_recompilable || func->is_evictable)
+	{
+		return -1;
+	}
+	if(!is_inline_type(jit_type_get_return(func->signature)))
+	{
+		return -1;
+	}
+	for(param = 0; param < jit_type_num_params(func->signature); param++)
+	{
+		if(!is_inline_type(jit_type_get_param(func->signature, param)))
+		{
+			return -1;
+		}
+	}
+
+	size = 0;
+	for(block = func->builder->entry_block; block; block = block->next)
+	{
+		if(block->address_of)
+		{
+			return -1;
+		}
+		jit_insn_iter_init(&iter, block);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			switch(insn->opcode)
+			{
+			case JIT_OP_NOP:
+			case JIT_OP_MARK_OFFSET:
+			case JIT_OP_INCOMING_REG:
+			case JIT_OP_INCOMING_FRAME_POSN:
+				break;
+
+			default:
+				if(!is_inline_opcode(insn->opcode))
+				{
+					return -1;
+				}
+				++size;
+				break;
+			}
+		}
+	}
+	return size;
+}
+
+/*
+ * Give a number to a value of the function being saved.  Returns -1
+ * if the value may not be copied.
+ */
+static jit_nint
+save_inline_value(jit_function_t func, struct _jit_inline_body *body,
+		  jit_value_t *values, jit_value_t value)
+{
+	_jit_inline_value_t *saved;
+	unsigned int param;
+
+	if(!value)
+	{
+		return 0;
+	}
+	if(value->index >= 0)
+	{
+		return value->index + 1;
+	}
+	if(value->is_addressable || value->is_volatile || !is_inline_type(value->type)
+	   || (!value->is_constant && (!value->block || value->block->func != func)))
+	{
+		return -1;
+	}
+
+	value->index = body->num_values;
+	values[body->num_values] = value;
+	saved = &body->values[body->num_values++];
+	saved->type = jit_type_copy(value->type);
+	saved->param = -1;
+	if(value->is_constant)
+	{
+		saved->is_constant = 1;
+		saved->constant = jit_value_get_constant(value);
+	}
+	else if(value->is_parameter && func->builder->param_values)
+	{
+		for(param = 0; param < jit_type_num_params(func->signature); param++)
+		{
+			if(func->builder->param_values[param] == value)
+			{
+				saved->param = (int) param;
+			}
+		}
+	}
+	return value->index + 1;
+}
+
+/*
+ * Free a saved function body.
+ */
+static void
+free_inline_body(struct _jit_inline_body *body)
+{
+	int index;
+
+	if(body)
+	{
+		for(index = 0; index < body->num_values; index++)
+		{
+			jit_type_free(body->values[index].type);
+		}
+		jit_free(body->values);
+		jit_free(body->insns);
+		jit_free(body);
+	}
+}
+
+/*
+ * Copy the instructions of a function into a new saved body.
+ */
+static struct _jit_inline_body *
+save_inline_body(jit_function_t func, int size)
+{
+	struct _jit_inline_body *body;
+	jit_value_t *values;
+	jit_block_t block;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+	_jit_inline_insn_t *saved;
+	jit_label_t label;
+	int max_insns, index, ok;
+
+	/* Each instruction has up to three values, and each block up to
+	   two entries, plus one for each extra label */
+	max_insns = size + func->builder->next_label;
+	for(block = func->builder->entry_block; block; block = block->next)
+	{
+		max_insns += 2;
+	}
+
+	body = jit_cnew(struct _jit_inline_body);
+	values = (jit_value_t *) jit_calloc(3 * size + 1, sizeof(jit_value_t));
+	if(!body || !values)
+	{
+		jit_free(body);
+		jit_free(values);
+		return 0;
+	}
+	body->values = (_jit_inline_value_t *) jit_calloc(3 * size + 1, sizeof(_jit_inline_value_t));
+	body->insns = (_jit_inline_insn_t *) jit_calloc(max_insns, sizeof(_jit_inline_insn_t));
+	body->size = size;
+	body->num_labels = func->builder->next_label;
+	body->may_throw = func->builder->may_throw;
+	ok = (body->values && body->insns);
+
+	for(block = func->builder->entry_block; ok && block; block = block->next)
+	{
+		/* Record the labels of the block */
+		saved = &body->insns[body->num_insns++];
+		saved->opcode = INLINE_BLOCK;
+		saved->dest = (jit_nint) block->label;
+		if(block->label != jit_label_undefined)
+		{
+			label = func->builder->label_info[block->label].alias;
+			while(label != jit_label_undefined)
+			{
+				saved = &body->insns[body->num_insns++];
+				saved->opcode = INLINE_LABEL;
+				saved->dest = (jit_nint) label;
+				label = func->builder->label_info[label].alias;
+			}
+		}
+
+		jit_insn_iter_init(&iter, block);
+		while(ok && (insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			if(insn->opcode == JIT_OP_NOP || insn->opcode == JIT_OP_MARK_OFFSET
+			   || insn->opcode == JIT_OP_INCOMING_REG
+			   || insn->opcode == JIT_OP_INCOMING_FRAME_POSN)
+			{
+				continue;
+			}
+			saved = &body->insns[body->num_insns++];
+			saved->opcode = insn->opcode;
+			saved->flags = insn->flags & (JIT_INSN_DEST_IS_LABEL | JIT_INSN_DEST_IS_VALUE);
+			if((insn->flags & JIT_INSN_DEST_IS_LABEL) != 0)
+			{
+				saved->dest = (jit_nint) (jit_label_t) insn->dest;
+			}
+			else
+			{
+				saved->dest = save_inline_value(func, body, values, insn->dest);
+			}
+			saved->value1 = save_inline_value(func, body, values, insn->value1);
+			saved->value2 = save_inline_value(func, body, values, insn->value2);
+			ok = (saved->dest >= 0 && saved->value1 >= 0 && saved->value2 >= 0);
+		}
+
+		if(block->ends_in_dead)
+		{
+			saved = &body->insns[body->num_insns++];
+			saved->opcode = INLINE_DEAD;
+		}
+	}
+
+	for(index = 0; index < body->num_values; index++)
+	{
+		values[index]->index = -1;
+	}
+	jit_free(values);
+	if(!ok)
+	{
+		free_inline_body(body);
+		return 0;
+	}
+	return body;
+}
+
+void
+_jit_function_save_inline_body(jit_function_t func)
+{
+	int limit, size;
+
+	limit = get_inline_limit(func->context);
+	if(limit <= 0 || func->inline_body)
+	{
+		return;
+	}
+	size = count_inline_insns(func);
+	if(size < 0 || size > limit)
+	{
+		return;
+	}
+	func->inline_body = save_inline_body(func, size);
+}
+
+void
+_jit_function_free_inline_body(jit_function_t func)
+{
+	free_inline_body(func->inline_body);
+	func->inline_body = 0;
+}
+
+int
+_jit_function_can_inline(jit_function_t func, jit_function_t callee)
+{
+	return func != callee
+		&& func->optimization_level != JIT_OPTLEVEL_NONE
+		&& !func->nested_parent
+		&& callee->is_compiled
+		&& !callee->is_recompilable
+		&& !callee->is_evictable
+		&& callee->inline_body
+		&& callee->inline_body->size <= get_inline_limit(func->context);
+}
+
+/*
+ * Get the value of the caller that stands for a value of the callee,
+ * creating it the first time.
+ */
+static jit_value_t
+get_inline_value(jit_function_t func, struct _jit_inline_body *body,
+		 jit_value_t *values, jit_nint index)
+{
+	_jit_inline_value_t *saved;
+
+	if(index <= 0)
+	{
+		return 0;
+	}
+	if(!values[index - 1])
+	{
+		saved = &body->values[index - 1];
+		if(saved->is_constant)
+		{
+			saved->constant.type = saved->type;
+			values[index - 1] = jit_value_create_constant(func, &saved->constant);
+		}
+		else
+		{
+			values[index - 1] = jit_value_create(func, saved->type);
+		}
+	}
+	return values[index - 1];
+}
+
+/*
+ * Get the value of the caller that stands for an operand of the callee
+ * and record its use.  Clears "ok" when out of memory.
+ */
+static jit_value_t
+ref_inline_value(jit_function_t func, struct _jit_inline_body *body,
+		 jit_value_t *values, jit_nint index, int *ok)
+{
+	jit_value_t value;
+
+	if(index <= 0)
+	{
+		return 0;
+	}
+	value = get_inline_value(func, body, values, index);
+	if(!value)
+	{
+		*ok = 0;
+		return 0;
+	}
+	jit_value_ref(func, value);
+	return value;
+}
+
+/*
+ * Get the label of the caller that stands for a label of the callee.
+ */
+static jit_label_t
+get_inline_label(jit_function_t func, jit_label_t *labels, jit_nint label)
+{
+	if(labels[label] == jit_label_undefined)
+	{
+		labels[label] = func->builder->next_label++;
+	}
+	return labels[label];
+}
+
+jit_value_t
+_jit_insn_inline_call(jit_function_t func, jit_function_t callee,
+		      jit_value_t *args, unsigned int num_args)
+{
+	struct _jit_inline_body *body = callee->inline_body;
+	_jit_inline_insn_t *saved;
+	jit_value_t *values;
+	jit_label_t *labels;
+	jit_label_t label_end;
+	jit_value_t return_value, value;
+	jit_insn_t insn;
+	int index, ok;
+
+	values = (jit_value_t *) jit_calloc(body->num_values + 1, sizeof(jit_value_t));
+	labels = (jit_label_t *) jit_malloc((body->num_labels + 1) * sizeof(jit_label_t));
+	return_value = jit_value_create(func, jit_type_get_return(callee->signature));
+	if(!values || !labels || !return_value)
+	{
+		jit_free(values);
+		jit_free(labels);
+		return 0;
+	}
+	for(index = 0; index <= (int) body->num_labels; index++)
+	{
+		labels[index] = jit_label_undefined;
+	}
+
+	/* Copy the arguments, as the callee may assign to its parameters */
+	ok = 1;
+	for(index = 0; ok && index < body->num_values; index++)
+	{
+		if(body->values[index].param >= 0
+		   && (unsigned int) body->values[index].param < num_args)
+		{
+			value = get_inline_value(func, body, values, index + 1);
+			ok = value && jit_insn_store(func, value, args[body->values[index].param]);
+		}
+	}
+
+	/* Replay the instructions.  Returns store the value and branch
+	   to the end */
+	label_end = jit_label_undefined;
+	for(index = 0; ok && index < body->num_insns; index++)
+	{
+		saved = &body->insns[index];
+		switch(saved->opcode)
+		{
+		case INLINE_BLOCK:
+			if(saved->dest != (jit_nint) jit_label_undefined)
+			{
+				ok = jit_insn_label(func, &labels[saved->dest]);
+			}
+			else if(index > 0)
+			{
+				ok = jit_insn_new_block(func);
+			}
+			break;
+
+		case INLINE_LABEL:
+			ok = jit_insn_label_tight(func, &labels[saved->dest]);
+			break;
+
+		case INLINE_DEAD:
+			func->builder->current_block->ends_in_dead = 1;
+			break;
+
+		case JIT_OP_RETURN:
+			ok = jit_insn_branch(func, &label_end);
+			break;
+
+		case JIT_OP_RETURN_INT:
+		case JIT_OP_RETURN_LONG:
+		case JIT_OP_RETURN_FLOAT32:
+		case JIT_OP_RETURN_FLOAT64:
+		case JIT_OP_RETURN_NFLOAT:
+			value = get_inline_value(func, body, values, saved->value1);
+			ok = value && jit_insn_store(func, return_value, value)
+				&& jit_insn_branch(func, &label_end);
+			break;
+
+		default:
+			insn = _jit_block_add_insn(func->builder->current_block);
+			if(!insn)
+			{
+				ok = 0;
+				break;
+			}
+			insn->opcode = (short) saved->opcode;
+			insn->flags = (short) saved->flags;
+			if((saved->flags & JIT_INSN_DEST_IS_LABEL) != 0)
+			{
+				insn->dest = (jit_value_t) get_inline_label(func, labels, saved->dest);
+			}
+			else
+			{
+				insn->dest = ref_inline_value(func, body, values, saved->dest, &ok);
+			}
+			insn->value1 = ref_inline_value(func, body, values, saved->value1, &ok);
+			insn->value2 = ref_inline_value(func, body, values, saved->value2, &ok);
+			break;
+		}
+	}
+	if(ok)
+	{
+		ok = jit_insn_label(func, &label_end);
+	}
+	if(ok && body->may_throw)
+	{
+		func->builder->may_throw = 1;
+	}
+
+	jit_free(values);
+	jit_free(labels);
+	return ok ? return_value : 0;
+}
@@ -1207,6 +1207,18 @@ _jit_load_opcode(int base_opcode, jit_type_t type)
 	case JIT_TYPE_STRUCT:
 	case JIT_TYPE_UNION:
 		return base_opcode + 9;
+
+	case JIT_TYPE_VECTOR:
+		/* Vectors are only copied and loaded through pointers */
+		if(base_opcode == JIT_OP_COPY_LOAD_SBYTE)
+		{
+			return JIT_OP_COPY_VECTOR;
+		}
+		if(base_opcode == JIT_OP_LOAD_RELATIVE_SBYTE)
+		{
+			return JIT_OP_LOAD_RELATIVE_VECTOR;
+		}
+		return 0;
 	}
 
 	return 0;
@@ -1258,12 +1270,100 @@ _jit_store_opcode(int base_opcode, int small_base, jit_type_t type)
 	case JIT_TYPE_UNION:
 		return base_opcode + 7;
 
+	case JIT_TYPE_VECTOR:
+		if(small_base == JIT_OP_COPY_STORE_BYTE)
+		{
+			return JIT_OP_COPY_VECTOR;
+		}
+		if(small_base == JIT_OP_STORE_RELATIVE_BYTE)
+		{
+			return JIT_OP_STORE_RELATIVE_VECTOR;
+		}
+		return 0;
+
 	default:
 		/* Shouldn't happen, but do something sane anyway */
 		return base_opcode + 2;
 	}
 }
 
+jit_value_t
+_jit_insn_get_def(jit_insn_t insn)
+{
+	switch(insn->opcode)
+	{
+	case JIT_OP_NOP:
+		return 0;
+
+	case JIT_OP_INCOMING_REG:
+	case JIT_OP_INCOMING_FRAME_POSN:
+	case JIT_OP_RETURN_REG:
+	case JIT_OP_FLUSH_SMALL_STRUCT:
+		return insn->value1;
+	}
+
+	if((insn->flags & (JIT_INSN_DEST_OTHER_FLAGS | JIT_INSN_DEST_IS_VALUE)) == 0)
+	{
+		return insn->dest;
+	}
+	return 0;
+}
+
+int
+_jit_opcode_is_pure(int opcode)
+{
+	switch(opcode)
+	{
+	case JIT_OP_CHECK_SBYTE:
+	case JIT_OP_CHECK_UBYTE:
+	case JIT_OP_CHECK_SHORT:
+	case JIT_OP_CHECK_USHORT:
+	case JIT_OP_CHECK_INT:
+	case JIT_OP_CHECK_UINT:
+	case JIT_OP_CHECK_LOW_WORD:
+	case JIT_OP_CHECK_SIGNED_LOW_WORD:
+	case JIT_OP_CHECK_LONG:
+	case JIT_OP_CHECK_ULONG:
+	case JIT_OP_CHECK_FLOAT32_TO_INT:
+	case JIT_OP_CHECK_FLOAT32_TO_UINT:
+	case JIT_OP_CHECK_FLOAT32_TO_LONG:
+	case JIT_OP_CHECK_FLOAT32_TO_ULONG:
+	case JIT_OP_CHECK_FLOAT64_TO_INT:
+	case JIT_OP_CHECK_FLOAT64_TO_UINT:
+	case JIT_OP_CHECK_FLOAT64_TO_LONG:
+	case JIT_OP_CHECK_FLOAT64_TO_ULONG:
+	case JIT_OP_CHECK_NFLOAT_TO_INT:
+	case JIT_OP_CHECK_NFLOAT_TO_UINT:
+	case JIT_OP_CHECK_NFLOAT_TO_LONG:
+	case JIT_OP_CHECK_NFLOAT_TO_ULONG:
+	case JIT_OP_IADD_OVF:
+	case JIT_OP_IADD_OVF_UN:
+	case JIT_OP_ISUB_OVF:
+	case JIT_OP_ISUB_OVF_UN:
+	case JIT_OP_IMUL_OVF:
+	case JIT_OP_IMUL_OVF_UN:
+	case JIT_OP_IDIV:
+	case JIT_OP_IDIV_UN:
+	case JIT_OP_IREM:
+	case JIT_OP_IREM_UN:
+	case JIT_OP_LADD_OVF:
+	case JIT_OP_LADD_OVF_UN:
+	case JIT_OP_LSUB_OVF:
+	case JIT_OP_LSUB_OVF_UN:
+	case JIT_OP_LMUL_OVF:
+	case JIT_OP_LMUL_OVF_UN:
+	case JIT_OP_LDIV:
+	case JIT_OP_LDIV_UN:
+	case JIT_OP_LREM:
+	case JIT_OP_LREM_UN:
+		return 0;
+	}
+	return (opcode >= JIT_OP_TRUNC_SBYTE && opcode <= JIT_OP_LSHR_UN)
+		|| (opcode >= JIT_OP_ICMP && opcode <= JIT_OP_NFSIGN)
+		|| (opcode >= JIT_OP_VIADD && opcode <= JIT_OP_VDREDUCE_MAX)
+		|| opcode == JIT_OP_ADD_RELATIVE;
+}
+
 /*@
  * @deftypefun int jit_insn_nop (jit_function_t @var{func})
  * Emits "no operation" instruction. You may want to do that if you need
@@ -3485,6 +3585,660 @@ jit_insn_sign(jit_function_t func, jit_value_t value)
 	return apply_unary(func, oper, value, jit_type_int);
 }
 
+/*
+ * Get the lane of a vector type as an index into the vector opcode
+ * tables: int, long, float32 and float64.  Returns -1 if the type is
+ * not a vector type.
+ */
+static int
+vector_lane(jit_type_t type)
+{
+	type = jit_type_normalize(type);
+	if(!type || type->kind != JIT_TYPE_VECTOR)
+	{
+		return -1;
+	}
+	switch(type->sub_type->kind)
+	{
+	case JIT_TYPE_INT:
+		return 0;
+	case JIT_TYPE_LONG:
+		return 1;
+	case JIT_TYPE_FLOAT32:
+		return 2;
+	case JIT_TYPE_FLOAT64:
+		return 3;
+	}
+	return -1;
+}
+
+/*
+ * Get the lane kind of a value, or -1 if it is not a vector or if the
+ * instruction that should have produced it failed.
+ */
+static int
+value_lane(jit_value_t value)
+{
+	return value ? vector_lane(value->type) : -1;
+}
+
+/*
+ * Get the type of the lane masks that the compares of a vector type
+ * produce.
+ */
+static jit_type_t
+vector_mask_type(int lane)
+{
+	return (lane & 1) ? jit_type_v2i64 : jit_type_v4i32;
+}
+
+/*
+ * Apply a binary vector operator to two values of the same vector type.
+ */
+static jit_value_t
+apply_vector_binary(jit_function_t func, const short *opers, jit_value_t value1,
+		    jit_value_t value2, jit_type_t type)
+{
+	int lane = value_lane(value1);
+	if(lane < 0 || value_lane(value2) < 0
+	   || jit_type_normalize(value2->type) != jit_type_normalize(value1->type))
+	{
+		return 0;
+	}
+	if(!opers[lane] || !_jit_opcode_is_supported(opers[lane]))
+	{
+		return 0;
+	}
+	return apply_binary(func, opers[lane], value1, value2, type ? type : value1->type);
+}
+
+/*
+ * Apply a unary vector operator.
+ */
+static jit_value_t
+apply_vector_unary(jit_function_t func, const short *opers, jit_value_t value,
+		   jit_type_t type)
+{
+	int lane = value_lane(value);
+	if(lane < 0 || !opers[lane] || !_jit_opcode_is_supported(opers[lane]))
+	{
+		return 0;
+	}
+	return apply_unary(func, opers[lane], value, type ? type : value->type);
+}
+
+/*
+ * Invert a lane mask.
+ */
+static jit_value_t
+vector_not(jit_function_t func, jit_value_t mask)
+{
+	/* Any integer lane compares equal to itself */
+	jit_value_t ones = apply_binary(func, JIT_OP_VIEQ, mask, mask, mask->type);
+	if(!ones)
+	{
+		return 0;
+	}
+	return apply_binary(func, JIT_OP_VXOR, mask, ones, mask->type);
+}
+
+/*@
+ * @deftypefun jit_value_t jit_insn_vload (jit_function_t @var{func}, jit_value_t @var{base_addr}, jit_value_t @var{index}, jit_type_t @var{type})
+ * Load a vector of the specified @var{type} from the array of its lane
+ * type that starts at @var{base_addr}, beginning with the element at
+ * position @var{index}.  The address does not need to be aligned.
+ * @end deftypefun
+@*/
+jit_value_t
+jit_insn_vload(jit_function_t func, jit_value_t base_addr, jit_value_t index,
+	       jit_type_t type)
+{
+	if(vector_lane(type) < 0 || !_jit_opcode_is_supported(JIT_OP_LOAD_RELATIVE_VECTOR))
+	{
+		return 0;
+	}
+	jit_nint size = (jit_nint) jit_type_get_size(jit_type_get_lane_type(jit_type_normalize(type)));
+
+	/* Convert the index into a native integer */
+	index = jit_insn_convert(func, index, jit_type_nint, 0);
+	if(!index)
+	{
+		return 0;
+	}
+	if(jit_value_is_constant(index))
+	{
+		size *= jit_value_get_nint_constant(index);
+		return jit_insn_load_relative(func, base_addr, size, type);
+	}
+
+	jit_value_t addr = element_address(func, base_addr, index, size);
+	if(!addr)
+	{
+		return 0;
+	}
+	return jit_insn_load_relative(func, addr, 0, type);
+}
+
+/*@
+ * @deftypefun int jit_insn_vstore (jit_function_t @var{func}, jit_value_t @var{base_addr}, jit_value_t @var{index}, jit_value_t @var{value})
+ * Store the vector @var{value} into the array of its lane type that
+ * starts at @var{base_addr}, beginning with the element at position
+ * @var{index}.  The address does not need to be aligned.
+ * @end deftypefun
+@*/
+int
+jit_insn_vstore(jit_function_t func, jit_value_t base_addr, jit_value_t index,
+		jit_value_t value)
+{
+	if(value_lane(value) < 0
+	   || !_jit_opcode_is_supported(JIT_OP_STORE_RELATIVE_VECTOR))
+	{
+		return 0;
+	}
+	jit_nint size = (jit_nint) jit_type_get_size(
+		jit_type_get_lane_type(jit_type_normalize(value->type)));
+
+	/* Convert the index into a native integer */
+	index = jit_insn_convert(func, index, jit_type_nint, 0);
+	if(!index)
+	{
+		return 0;
+	}
+	if(jit_value_is_constant(index))
+	{
+		size *= jit_value_get_nint_constant(index);
+		return jit_insn_store_relative(func, base_addr, size, value);
+	}
+
+	jit_value_t addr = element_address(func, base_addr, index, size);
+	if(!addr)
+	{
+		return 0;
+	}
+	return jit_insn_store_relative(func, addr, 0, value);
+}
+
+/*@
+ * @deftypefun jit_value_t jit_insn_vadd (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vsub (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vmul (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vdiv (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vmin (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vmax (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vsqrt (jit_function_t @var{func}, jit_value_t @var{value1})
+ * Apply an arithmetic operator to each lane of vectors of the same type.
+ * Integer lanes wrap around on overflow.  There is no multiplication of
+ * 64-bit integer lanes, and division and square root are only available
+ * for floating point lanes; the functions return NULL if the operation
+ * is not available for the lane type.
+ * @end deftypefun
+@*/
+jit_value_t
+jit_insn_vadd(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VIADD, JIT_OP_VLADD, JIT_OP_VFADD, JIT_OP_VDADD
+	};
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+jit_value_t
+jit_insn_vsub(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VISUB, JIT_OP_VLSUB, JIT_OP_VFSUB, JIT_OP_VDSUB
+	};
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+jit_value_t
+jit_insn_vmul(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VIMUL, 0, JIT_OP_VFMUL, JIT_OP_VDMUL
+	};
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+jit_value_t
+jit_insn_vdiv(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		0, 0, JIT_OP_VFDIV, JIT_OP_VDDIV
+	};
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+jit_value_t
+jit_insn_vmin(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		0, 0, JIT_OP_VFMIN, JIT_OP_VDMIN
+	};
+	if(value_lane(value1) < 2)
+	{
+		/* SSE2 has no integer minimum, so select by a compare */
+		return jit_insn_vselect(func, jit_insn_vgt(func, value1, value2), value2, value1);
+	}
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+jit_value_t
+jit_insn_vmax(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		0, 0, JIT_OP_VFMAX, JIT_OP_VDMAX
+	};
+	if(value_lane(value1) < 2)
+	{
+		return jit_insn_vselect(func, jit_insn_vgt(func, value1, value2), value1, value2);
+	}
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+jit_value_t
+jit_insn_vsqrt(jit_function_t func, jit_value_t value1)
+{
+	static short const opers[4] = {
+		0, 0, JIT_OP_VFSQRT, JIT_OP_VDSQRT
+	};
+	return apply_vector_unary(func, opers, value1, 0);
+}
+
+/*@
+ * @deftypefun jit_value_t jit_insn_vand (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vor (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vxor (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vandnot (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * Apply a bitwise operator to vectors of the same type.
+ * @code{jit_insn_vandnot} computes @code{~@var{value1} & @var{value2}}.
+ * @end deftypefun
+@*/
+jit_value_t
+jit_insn_vand(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VAND, JIT_OP_VAND, JIT_OP_VAND, JIT_OP_VAND
+	};
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+jit_value_t
+jit_insn_vor(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VOR, JIT_OP_VOR, JIT_OP_VOR, JIT_OP_VOR
+	};
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+jit_value_t
+jit_insn_vxor(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VXOR, JIT_OP_VXOR, JIT_OP_VXOR, JIT_OP_VXOR
+	};
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+jit_value_t
+jit_insn_vandnot(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VANDNOT, JIT_OP_VANDNOT, JIT_OP_VANDNOT, JIT_OP_VANDNOT
+	};
+	return apply_vector_binary(func, opers, value1, value2, 0);
+}
+
+/*@
+ * @deftypefun jit_value_t jit_insn_veq (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vne (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vlt (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vle (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vgt (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * @deftypefunx jit_value_t jit_insn_vge (jit_function_t @var{func}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * Compare each lane of vectors of the same type.  The result is a lane
+ * mask of type @code{jit_type_v4i32} for 32-bit lanes or
+ * @code{jit_type_v2i64} for 64-bit lanes, with all bits of a lane set
+ * if the comparison holds and clear otherwise.  Integer lanes compare
+ * as signed values.
+ * @end deftypefun
+@*/
+jit_value_t
+jit_insn_veq(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VIEQ, JIT_OP_VLEQ, JIT_OP_VFEQ, JIT_OP_VDEQ
+	};
+	int lane = value_lane(value1);
+	if(lane < 0)
+	{
+		return 0;
+	}
+	return apply_vector_binary(func, opers, value1, value2, vector_mask_type(lane));
+}
+
+jit_value_t
+jit_insn_vne(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		0, 0, JIT_OP_VFNE, JIT_OP_VDNE
+	};
+	int lane = value_lane(value1);
+	if(lane < 0)
+	{
+		return 0;
+	}
+	if(lane < 2)
+	{
+		jit_value_t mask = jit_insn_veq(func, value1, value2);
+		if(!mask)
+		{
+			return 0;
+		}
+		return vector_not(func, mask);
+	}
+	return apply_vector_binary(func, opers, value1, value2, vector_mask_type(lane));
+}
+
+jit_value_t
+jit_insn_vlt(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VIGT, JIT_OP_VLGT, JIT_OP_VFLT, JIT_OP_VDLT
+	};
+	int lane = value_lane(value1);
+	if(lane < 0)
+	{
+		return 0;
+	}
+	if(lane < 2)
+	{
+		/* Integer lanes only have a "greater than" compare */
+		return apply_vector_binary(func, opers, value2, value1, vector_mask_type(lane));
+	}
+	return apply_vector_binary(func, opers, value1, value2, vector_mask_type(lane));
+}
+
+jit_value_t
+jit_insn_vle(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		0, 0, JIT_OP_VFLE, JIT_OP_VDLE
+	};
+	int lane = value_lane(value1);
+	if(lane < 0)
+	{
+		return 0;
+	}
+	if(lane < 2)
+	{
+		jit_value_t mask = jit_insn_vgt(func, value1, value2);
+		if(!mask)
+		{
+			return 0;
+		}
+		return vector_not(func, mask);
+	}
+	return apply_vector_binary(func, opers, value1, value2, vector_mask_type(lane));
+}
+
+jit_value_t
+jit_insn_vgt(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		JIT_OP_VIGT, JIT_OP_VLGT, JIT_OP_VFLT, JIT_OP_VDLT
+	};
+	int lane = value_lane(value1);
+	if(lane < 0)
+	{
+		return 0;
+	}
+	if(lane < 2)
+	{
+		return apply_vector_binary(func, opers, value1, value2, vector_mask_type(lane));
+	}
+
+	/* The packed float compares only test "less than" */
+	return apply_vector_binary(func, opers, value2, value1, vector_mask_type(lane));
+}
+
+jit_value_t
+jit_insn_vge(jit_function_t func, jit_value_t value1, jit_value_t value2)
+{
+	static short const opers[4] = {
+		0, 0, JIT_OP_VFLE, JIT_OP_VDLE
+	};
+	int lane = value_lane(value1);
+	if(lane < 0)
+	{
+		return 0;
+	}
+	if(lane < 2)
+	{
+		jit_value_t mask = jit_insn_vlt(func, value1, value2);
+		if(!mask)
+		{
+			return 0;
+		}
+		return vector_not(func, mask);
+	}
+	return apply_vector_binary(func, opers, value2, value1, vector_mask_type(lane));
+}
+
+/*@
+ * @deftypefun jit_value_t jit_insn_vselect (jit_function_t @var{func}, jit_value_t @var{mask}, jit_value_t @var{value1}, jit_value_t @var{value2})
+ * Blend two vectors of the same type: each lane of the result comes
+ * from @var{value1} where the lane of @var{mask} is set, and from
+ * @var{value2} where it is clear.  The @var{mask} is usually the result
+ * of one of the vector compares.
+ * @end deftypefun
+@*/
+jit_value_t
+jit_insn_vselect(jit_function_t func, jit_value_t mask, jit_value_t value1,
+		 jit_value_t value2)
+{
+	if(value_lane(mask) < 0 || value_lane(value1) < 0 || value_lane(value2) < 0
+	   || jit_type_normalize(value1->type) != jit_type_normalize(value2->type)
+	   || !_jit_opcode_is_supported(JIT_OP_VANDNOT))
+	{
+		return 0;
+	}
+
+	/* (mask & value1) | (~mask & value2) */
+	jit_value_t taken = apply_binary(func, JIT_OP_VAND, mask, value1, value1->type);
+	if(!taken)
+	{
+		return 0;
+	}
+	jit_value_t other = apply_binary(func, JIT_OP_VANDNOT, mask, value2, value1->type);
+	if(!other)
+	{
+		return 0;
+	}
+	return apply_binary(func, JIT_OP_VOR, taken, other, value1->type);
+}
+
+/*@
+ * @deftypefun jit_value_t jit_insn_vshuffle (jit_function_t @var{func}, jit_value_t @var{value}, jit_nint @var{order})
+ * Rearrange the lanes of a vector.  Lane @var{i} of the result is the
+ * lane of @var{value} selected by bits @code{2 * @var{i}} and
+ * @code{2 * @var{i} + 1} of @var{order}, as with the @code{pshufd}
+ * instruction.  Vectors of two lanes only use the lower of the two bits.
+ * @end deftypefun
+@*/
+jit_value_t
+jit_insn_vshuffle(jit_function_t func, jit_value_t value, jit_nint order)
+{
+	int lane = value_lane(value);
+	if(lane < 0 || !_jit_opcode_is_supported(JIT_OP_VSHUFFLE))
+	{
+		return 0;
+	}
+	order &= 0xFF;
+	if(lane & 1)
+	{
+		/* Each 64-bit lane moves as a pair of 32-bit lanes */
+		int low = (int) (order & 1);
+		int high = (int) ((order >> 2) & 1);
+		order = (low * 2) | ((low * 2 + 1) << 2) | ((high * 2) << 4) | ((high * 2 + 1) << 6);
+	}
+	jit_value_t order_value = jit_value_create_nint_constant(func, jit_type_int, order);
+	if(!order_value)
+	{
+		return 0;
+	}
+	return apply_binary(func, JIT_OP_VSHUFFLE, value, order_value, value->type);
+}
+
+/*@
+ * @deftypefun jit_value_t jit_insn_vbroadcast (jit_function_t @var{func}, jit_value_t @var{value}, jit_type_t @var{type})
+ * Create a vector of the specified @var{type} with @var{value} in every
+ * lane.  The @var{value} is first converted to the lane type.
+ * @end deftypefun
+@*/
+jit_value_t
+jit_insn_vbroadcast(jit_function_t func, jit_value_t value, jit_type_t type)
+{
+	static short const opers[4] = {
+		JIT_OP_VIBROADCAST, JIT_OP_VLBROADCAST, JIT_OP_VFBROADCAST, JIT_OP_VDBROADCAST
+	};
+	int lane = vector_lane(type);
+	if(!value || lane < 0 || !_jit_opcode_is_supported(opers[lane]))
+	{
+		return 0;
+	}
+	value = jit_insn_convert(func, value, jit_type_get_lane_type(jit_type_normalize(type)), 0);
+	if(!value)
+	{
+		return 0;
+	}
+	return apply_unary(func, opers[lane], value, type);
+}
+
+/*@
+ * @deftypefun jit_value_t jit_insn_vextract (jit_function_t @var{func}, jit_value_t @var{value}, unsigned int @var{lane})
+ * Get the value of a single lane of a vector.  Returns NULL if @var{lane}
+ * is out of range.
+ * @end deftypefun
+@*/
+jit_value_t
+jit_insn_vextract(jit_function_t func, jit_value_t value, unsigned int lane)
+{
+	static short const opers[4] = {
+		JIT_OP_VIEXTRACT, JIT_OP_VLEXTRACT, JIT_OP_VFEXTRACT, JIT_OP_VDEXTRACT
+	};
+	int kind = value_lane(value);
+	if(kind < 0 || lane >= ((kind & 1) ? 2 : 4) || !_jit_opcode_is_supported(opers[kind]))
+	{
+		return 0;
+	}
+	jit_value_t lane_value = jit_value_create_nint_constant(func, jit_type_int, lane);
+	if(!lane_value)
+	{
+		return 0;
+	}
+	return apply_binary(func, opers[kind], value, lane_value,
+			    jit_type_get_lane_type(jit_type_normalize(value->type)));
+}
+
+/*
+ * Reduce the lanes of an integer vector by folding it in half with a
+ * shuffle until one lane is left.
+ */
+static jit_value_t
+vector_fold(jit_function_t func, jit_value_t value,
+	    jit_value_t (*fold)(jit_function_t, jit_value_t, jit_value_t))
+{
+	/* Swap the halves: lanes 2, 3, 0, 1 or 1, 0 */
+	jit_value_t half = jit_insn_vshuffle(func, value, value_lane(value) == 0 ? 0x4E : 0x01);
+	if(!half)
+	{
+		return 0;
+	}
+	value = (*fold)(func, value, half);
+	if(!value)
+	{
+		return 0;
+	}
+	if(value_lane(value) == 0)
+	{
+		half = jit_insn_vshuffle(func, value, 0xB1);
+		if(!half)
+		{
+			return 0;
+		}
+		value = (*fold)(func, value, half);
+		if(!value)
+		{
+			return 0;
+		}
+	}
+	return jit_insn_vextract(func, value, 0);
+}
+
+/*@
+ * @deftypefun jit_value_t jit_insn_vreduce_add (jit_function_t @var{func}, jit_value_t @var{value})
+ * @deftypefunx jit_value_t jit_insn_vreduce_min (jit_function_t @var{func}, jit_value_t @var{value})
+ * @deftypefunx jit_value_t jit_insn_vreduce_max (jit_function_t @var{func}, jit_value_t @var{value})
+ * Combine the lanes of a vector into a single value of the lane type.
+ * The lanes are combined pairwise, so the sum of four floating point
+ * lanes is computed as @code{(a0 + a2) + (a1 + a3)}.
+ * @end deftypefun
+@*/
+jit_value_t
+jit_insn_vreduce_add(jit_function_t func, jit_value_t value)
+{
+	static short const opers[4] = {
+		JIT_OP_VIREDUCE_ADD, JIT_OP_VLREDUCE_ADD, JIT_OP_VFREDUCE_ADD, JIT_OP_VDREDUCE_ADD
+	};
+	int lane = value_lane(value);
+	if(lane < 0)
+	{
+		return 0;
+	}
+	return apply_vector_unary(func, opers, value,
+				  jit_type_get_lane_type(jit_type_normalize(value->type)));
+}
+
+jit_value_t
+jit_insn_vreduce_min(jit_function_t func, jit_value_t value)
+{
+	static short const opers[4] = {
+		0, 0, JIT_OP_VFREDUCE_MIN, JIT_OP_VDREDUCE_MIN
+	};
+	int lane = value_lane(value);
+	if(lane < 0)
+	{
+		return 0;
+	}
+	if(lane < 2)
+	{
+		return vector_fold(func, value, jit_insn_vmin);
+	}
+	return apply_vector_unary(func, opers, value,
+				  jit_type_get_lane_type(jit_type_normalize(value->type)));
+}
+
+jit_value_t
+jit_insn_vreduce_max(jit_function_t func, jit_value_t value)
+{
+	static short const opers[4] = {
+		0, 0, JIT_OP_VFREDUCE_MAX, JIT_OP_VDREDUCE_MAX
+	};
+	int lane = value_lane(value);
+	if(lane < 0)
+	{
+		return 0;
+	}
+	if(lane < 2)
+	{
+		return vector_fold(func, value, jit_insn_vmax);
+	}
+	return apply_vector_unary(func, opers, value,
+				  jit_type_get_lane_type(jit_type_normalize(value->type)));
+}
+
 /*@
  * @deftypefun int jit_insn_branch (jit_function_t @var{func}, jit_label_t *@var{label})
  * Terminate the current block by branching unconditionally
@@ -5466,6 +6220,12 @@ handle_return(jit_function_t func,
  * Tail calls are only appropriate when the signature of the called
  * function matches the callee, and none of the parameters point
  * to local variables.
+ *
+ * @vindex JIT_CALL_PURE
+ * @item JIT_CALL_PURE
+ * The function neither reads nor writes memory that the caller can
+ * access, so values loaded from memory before the call may be used
+ * after it.
  * @end table
  *
  * If @var{jit_func} has already been compiled, then @code{jit_insn_call}
@@ -5543,6 +6303,14 @@ jit_insn_call(jit_function_t func, const char *name, jit_function_t jit_func,
 		new_args = args;
 	}
 
+	/* Copy the instructions of small functions in place of the call */
+	if((flags & JIT_CALL_TAIL) == 0 && !is_nested
+	   && signature_identical(signature, jit_func->signature)
+	   && _jit_function_can_inline(func, jit_func))
+	{
+		return _jit_insn_inline_call(func, jit_func, new_args, num_args);
+	}
+
 	/* Intuit additional flags from "jit_func" if it was already compiled */
 	if(jit_func->no_throw)
 	{
@@ -5611,6 +6379,10 @@ jit_insn_call(jit_function_t func, const char *name, jit_function_t jit_func,
 			insn->opcode = JIT_OP_CALL;
 		}
 		insn->flags = JIT_INSN_DEST_IS_FUNCTION | JIT_INSN_VALUE1_IS_NAME;
+		if((flags & JIT_CALL_PURE) != 0)
+		{
+			insn->flags |= JIT_INSN_CALL_IS_PURE;
+		}
 		insn->dest = (jit_value_t) jit_func;
 		insn->value1 = (jit_value_t) name;
 	}
@@ -5711,6 +6483,10 @@ jit_insn_call_nested_indirect(jit_function_t func, jit_value_t value,
 		insn->opcode = JIT_OP_CALL_INDIRECT;
 	}
 	insn->flags = JIT_INSN_VALUE2_IS_SIGNATURE;
+	if((flags & JIT_CALL_PURE) != 0)
+	{
+		insn->flags |= JIT_INSN_CALL_IS_PURE;
+	}
 	insn->value1 = value;
 	jit_value_ref(func, value);
 	insn->value2 = (jit_value_t) jit_type_copy(signature);
@@ -5911,6 +6687,10 @@ jit_insn_call_native(jit_function_t func, const char *name, void *native_func,
 		insn->opcode = JIT_OP_CALL_EXTERNAL;
 	}
 	insn->flags = JIT_INSN_DEST_IS_NATIVE | JIT_INSN_VALUE1_IS_NAME;
+	if((flags & JIT_CALL_PURE) != 0)
+	{
+		insn->flags |= JIT_INSN_CALL_IS_PURE;
+	}
 	insn->dest = (jit_value_t) native_func;
 	insn->value1 = (jit_value_t) name;
 #ifdef JIT_BACKEND_INTERP
@@ -6474,6 +7254,10 @@ jit_insn_import(jit_function_t func, jit_value_t value)
 		return 0;
 	}
 
+	/* The nested function reads the value from the frame of its
+	   ancestor, so the ancestor must keep the value there */
+	jit_value_set_addressable(value);
+
 	result = apply_binary(func, JIT_OP_IMPORT, value_frame, value, result_type);
 	jit_type_free(result_type);
 
@@ -202,6 +202,15 @@ struct _jit_meta
 	jit_function_t		pool_owner;
 };
 
+/*
+ * Function metadata types used by the Go bindings.  They are negative so
+ * that they cannot collide with the types that user code may pass to
+ * Function.Meta and Function.FreeMeta, which only accept 0 to 9999.
+ */
+#define	JIT_META_BATCH_DRIVER		(-1)
+#define	JIT_META_BUILD_SCRATCH		(-2)
+#define	JIT_META_TIER_COUNTER		(-3)
+
 /*
  * Control flow graph edge.
  */
@@ -253,6 +262,16 @@ struct _jit_block
 	unsigned		ends_in_dead : 1;
 	unsigned		address_of : 1;
 
+	/* Position in the block order while the SSA optimizer or the
+	   liveness analysis runs */
+	int			index;
+
+	/* Number of loops that contain the block, found by the optimizer */
+	int			loop_depth;
+
+	/* Set if the optimizer found the block to be the header of a loop */
+	unsigned		loop_header : 1;
+
 	/* Metadata */
 	jit_meta_t		meta;
 
@@ -340,6 +359,7 @@ struct _jit_insn
 #define	JIT_INSN_VALUE2_IS_SIGNATURE	0x0800
 #define	JIT_INSN_VALUE2_OTHER_FLAGS	0x0800
 #define	JIT_INSN_DEST_IS_VALUE		0x1000
+#define	JIT_INSN_CALL_IS_PURE		0x2000
 
 /*
  * Information about each label associated with a function.
@@ -362,6 +382,19 @@ struct _jit_label_info
 
 #define JIT_LABEL_ADDRESS_OF		0x0001
 
+/*
+ * The range of instructions over which a local variable is live,
+ * numbered in block order, and the cost of not keeping it in a
+ * register, which grows with the loop depth of its uses.
+ */
+typedef struct _jit_live_range _jit_live_range_t;
+struct _jit_live_range
+{
+	jit_value_t		value;
+	int			start;
+	int			end;
+	jit_ulong		weight;
+};
 
 /*
  * Information that is associated with a function for building
@@ -390,6 +423,10 @@ struct _jit_builder
 	jit_block_t		*block_order;
 	int			num_block_order;
 
+	/* Live ranges of the local variables for global register allocation */
+	_jit_live_range_t	*live_ranges;
+	int			num_live_ranges;
+
 	/* The next block label to be allocated */
 	jit_label_t		next_label;
 
@@ -451,6 +488,67 @@ struct _jit_builder
 #endif
 };
 
+/*
+ * Kinds of relocation that the back end records in a code image.
+ */
+#define JIT_RELOC_ABSOLUTE	1	/* Pointer-sized absolute address */
+#define JIT_RELOC_RELATIVE32	2	/* 32-bit offset from the end of the field */
+
+/*
+ * A block of constant data that belongs to a code image.
+ */
+typedef struct
+{
+	unsigned char		*address;
+	unsigned long		size;
+
+} _jit_image_block_t;
+
+/*
+ * A location in a code image that holds the address of "target".
+ * The name is set if the target is a native function or symbol.
+ */
+typedef struct
+{
+	unsigned char		*address;
+	int			type;
+	char			*name;
+
+} _jit_image_reloc_t;
+
+/*
+ * The instructions of a small function that are kept after its builder
+ * is freed, to inline it into its callers.  Defined in jit-inline.c.
+ */
+typedef struct _jit_inline_body *_jit_inline_body_t;
+
+/*
+ * The code of a function along with the constant data and relocations
+ * that are needed to move it to another address.  It is only kept for
+ * functions that are compiled in a context with JIT_OPTION_PRE_COMPILE,
+ * for the ELF writer.
+ */
+typedef struct _jit_image *_jit_image_t;
+struct _jit_image
+{
+	unsigned char		*code_start;
+	unsigned char		*code_end;
+	jit_nint		exec_offset;
+	_jit_image_block_t	*blocks;
+	int			num_blocks;
+	int			max_blocks;
+	_jit_image_reloc_t	*relocs;
+	int			num_relocs;
+	int			max_relocs;
+};
+
+/*
+ * Create, clear and free code images.
+ */
+_jit_image_t _jit_image_create(void);
+void _jit_image_reset(_jit_image_t image);
+void _jit_image_free(_jit_image_t image);
+
 /*
  * Internal structure of a function.
  */
@@ -480,6 +578,9 @@ struct _jit_function
 	/* The builder information for this function */
 	jit_builder_t		builder;
 
+	/* Lock that controls access to the building process of this function */
+	jit_mutex_t		builder_lock;
+
 	/* Debug information for this function */
 	jit_varint_data_t	bytecode_offset;
 
@@ -492,17 +593,34 @@ struct _jit_function
 	unsigned		no_throw : 1;
 	unsigned		no_return : 1;
 	unsigned		has_try : 1;
+	unsigned		is_leaf : 1;
+	unsigned		is_evictable : 1;
+	unsigned		shares_code : 1;
 	unsigned		optimization_level : 8;
 
+	/* Upper bound of the stack space used by the compiled code of a
+	   leaf function, including the return address.  Zero if unknown */
+	jit_nint		leaf_stack_size;
+
 	/* Flag set once the function is compiled */
 	int volatile		is_compiled;
 
+	/* Use clock of the context when the function was last compiled or
+	   called from outside of JIT code, see JIT_OPTION_CACHE_EVICT */
+	jit_nuint volatile	last_use;
+
 	/* The entry point for the function's compiled code */
 	void * volatile		entry_point;
 
 	/* The function to call to perform on-demand compilation */
 	jit_on_demand_func	on_demand;
 
+	/* Relocatable image of the compiled code, if pre-compiling */
+	_jit_image_t		image;
+
+	/* Copy of the instructions for inlining, see JIT_OPTION_INLINE_LIMIT */
+	_jit_inline_body_t	inline_body;
+
 #ifndef JIT_BACKEND_INTERP
 # ifdef jit_redirector_size
 	/* Buffer that contains the redirector for this function.
@@ -533,16 +651,123 @@ void _jit_function_free_builder(jit_function_t func);
  */
 void _jit_function_destroy(jit_function_t func);
 
+/*
+ * Keep a copy of the instructions of a function that is about to be
+ * compiled if it is small enough to be inlined into its callers.
+ */
+void _jit_function_save_inline_body(jit_function_t func);
+
+/*
+ * Free the copy of the instructions of a function.
+ */
+void _jit_function_free_inline_body(jit_function_t func);
+
+/*
+ * Determine if a call from "func" to "callee" may be inlined.
+ */
+int _jit_function_can_inline(jit_function_t func, jit_function_t callee);
+
+/*
+ * Copy the instructions of "callee" into "func" in place of a call with
+ * converted arguments.  Returns the value that holds the result, or
+ * null if out of memory.
+ */
+jit_value_t _jit_insn_inline_call(jit_function_t func, jit_function_t callee,
+				  jit_value_t *args, unsigned int num_args);
+
 /*
  * Compute value liveness and "next use" information for a function.
  */
 void _jit_function_compute_liveness(jit_function_t func);
 
+/*
+ * Propagate constants, eliminate redundant computations and resolve
+ * constant branches in a function with a clean control flow graph.
+ * Returns non-zero if the function changed and its control flow graph
+ * needs cleaning again.
+ */
+int _jit_function_optimize_ssa(jit_function_t func);
+
+/*
+ * Replace loads from memory locations whose value is known with copies,
+ * and delete stores that are overwritten before anything may read them.
+ */
+void _jit_function_optimize_accesses(jit_function_t func);
+
+/*
+ * Carry the value that a memory location holds at the end of an
+ * iteration of a loop into the next one in a variable, so that a load
+ * at the start of the loop does not read back what the iteration before
+ * stored.  The loop must have a preheader, and its blocks must follow
+ * the header in a line.
+ */
+void _jit_function_forward_loop_accesses(jit_function_t func, jit_block_t preheader,
+					 jit_block_t header);
+
+/*
+ * Remove the null checks and fold the integer branches of a function with
+ * a clean control flow graph that earlier checks make redundant.  Then
+ * find its loops, record the loop depth of its blocks, and move the
+ * instructions that compute the same value on every iteration of a loop
+ * out of it.  Returns non-zero if blocks were added.
+ */
+int _jit_function_optimize_loops(jit_function_t func);
+
 /*
  * Compile a function on-demand.  Returns the entry point.
  */
 void *_jit_function_compile_on_demand(jit_function_t func);
 
+/*
+ * Record a use of "func" for the least recently used eviction.  The
+ * function is only written to when the clock has moved on, so that
+ * threads calling the same function do not contend for its cache line.
+ */
+#define _jit_function_touch(func)					\
+	do {								\
+		jit_nuint _clock = (func)->context->use_clock;		\
+		if((func)->last_use != _clock)				\
+		{							\
+			(func)->last_use = _clock;			\
+		}							\
+	} while (0)
+
+/*
+ * Free the compiled code of "func" and point its entry at the redirector.
+ * The code, and the data that lookups by address may read, are retired
+ * and only freed once no thread may still run or read them.  The build
+ * lock of "func" and the memory lock of its context must be held.
+ * Returns zero if the memory manager cannot free code.
+ */
+int _jit_function_free_code(jit_function_t func);
+
+/*
+ * Bytecode offsets and image of a function whose code was freed, kept
+ * until the epoch that they were retired at is safe.
+ */
+typedef struct _jit_retired_code *_jit_retired_code_t;
+struct _jit_retired_code
+{
+	_jit_retired_code_t	next;
+	unsigned long		epoch;
+	jit_varint_data_t	bytecode_offset;
+	_jit_image_t		image;
+};
+
+/*
+ * Free the retired data of "context" that is safe to free, or all of it
+ * if "all" is non-zero because the context is destroyed.  The memory lock
+ * must be held unless the context is destroyed.
+ */
+void _jit_context_reclaim_code(jit_context_t context, int all);
+
+/*
+ * Free the code of the least recently used evictable functions of
+ * "context", except "func".  Returns non-zero if any code was freed.
+ * The memory lock of the context must not be held.
+ */
+int _jit_context_evict_code(jit_context_t context, jit_function_t func);
+
 /*
  * Get the bytecode offset that is associated with a native
  * offset within a method.  Returns JIT_CACHE_NO_OFFSET
@@ -561,6 +786,49 @@ struct jit_regsym
 	char	name[1];
 };
 
+/*
+ * Cache of compiled code by the hash of the IR, see JIT_OPTION_COMPILE_CACHE.
+ */
+typedef struct _jit_compile_cache *_jit_compile_cache_t;
+
+/*
+ * Key of a function in the compile cache.  The hash is zero if the
+ * function cannot share its code.  "ir" is the serialization of the IR
+ * that the hash was computed from, which a hit must match exactly.
+ */
+typedef struct
+{
+	jit_ulong		hash;
+	unsigned int		num_insns;
+	unsigned char		*ir;
+	unsigned int		ir_len;
+
+} _jit_compile_key_t;
+
+/*
+ * Look up the code of a function with the same IR as "func" and compute
+ * the key of "func".  Returns non-zero and sets "entry_point" on a hit.
+ */
+int _jit_compile_cache_lookup(jit_function_t func, _jit_compile_key_t *key,
+			      void **entry_point);
+
+/*
+ * Make the code that was compiled for "func" available to other
+ * functions with the same key.
+ */
+void _jit_compile_cache_insert(jit_function_t func, _jit_compile_key_t *key,
+			       void *entry_point);
+
+/*
+ * Free the serialization of a key that was not inserted into the cache.
+ */
+void _jit_compile_key_free(_jit_compile_key_t *key);
+
+/*
+ * Free the compile cache of a context.
+ */
+void _jit_compile_cache_destroy(jit_context_t context);
+
 /*
  * Internal structure of a context.
  */
@@ -571,6 +839,10 @@ struct _jit_context
 	jit_memory_context_t	memory_context;
 	jit_mutex_t		memory_lock;
 
+	/* Offset from the address that code runs at to the address that
+	   it is written to, if the memory manager maps code twice */
+	jit_nint		write_offset;
+
 	/* Lock that controls access to the building process */
 	jit_mutex_t		builder_lock;
 
@@ -594,6 +866,26 @@ struct _jit_context
 
 	/* On-demand compilation driver */
 	jit_on_demand_driver_func	on_demand_driver;
+
+	/* Compiled code that is shared by functions with the same IR */
+	_jit_compile_cache_t	compile_cache;
+	jit_mutex_t		compile_cache_lock;
+
+	/* Clock for the least recently used eviction, advanced whenever
+	   a function is compiled.  Updated without atomics, as the order
+	   of uses only needs to be approximate */
+	jit_nuint volatile	use_clock;
+
+	/* Number of functions whose code was evicted */
+	jit_nuint		num_evictions;
+
+	/* Data of functions whose code was freed, newest first, that may
+	   still be read by lookups on other threads */
+	_jit_retired_code_t	retired_code;
+
+	/* Instruction set extensions that the code generator may use,
+	   see jit_context_set_cpu_features */
+	jit_uint		cpu_features;
 };
 
 void *_jit_malloc_exec(unsigned int size);
@@ -604,9 +896,16 @@ void _jit_memory_lock(jit_context_t context);
 void _jit_memory_unlock(jit_context_t context);
 
 int _jit_memory_ensure(jit_context_t context);
+int _jit_memory_is_concurrent(jit_context_t context);
 void _jit_memory_destroy(jit_context_t context);
 
+/*
+ * The info found for "pc" stays valid while the thread is between
+ * _jit_epoch_enter and _jit_epoch_leave, even if another thread frees
+ * the code.  _jit_memory_find_function looks up the function in one go.
+ */
 jit_function_info_t _jit_memory_find_function_info(jit_context_t context, void *pc);
+jit_function_t _jit_memory_find_function(jit_context_t context, void *pc);
 jit_function_t _jit_memory_get_function(jit_context_t context, jit_function_info_t info);
 void *_jit_memory_get_function_start(jit_context_t context, jit_function_info_t info);
 void *_jit_memory_get_function_end(jit_context_t context, jit_function_info_t info);
@@ -624,6 +923,19 @@ void _jit_memory_free_trampoline(jit_context_t context, void *ptr);
 void *_jit_memory_alloc_closure(jit_context_t context);
 void _jit_memory_free_closure(jit_context_t context, void *ptr);
 void *_jit_memory_alloc_data(jit_context_t context, jit_size_t size, jit_size_t align);
+int _jit_memory_free_code(jit_context_t context, jit_function_info_t info);
+jit_nuint _jit_memory_get_num_huge_pages(jit_context_t context);
+
+/*
+ * Convert between the address that code runs at and the address that it
+ * is written to.  The memory functions that the code generator uses
+ * (break, limit and data) deal in addresses to write to, the others in
+ * addresses to run.
+ */
+#define _jit_memory_writable(context, ptr) \
+	((void *) (((unsigned char *) (ptr)) + (context)->write_offset))
+#define _jit_memory_executable(context, ptr) \
+	((void *) (((unsigned char *) (ptr)) - (context)->write_offset))
 
 /*
  * Backtrace control structure, for managing stack traces.
@@ -663,6 +975,9 @@ struct jit_thread_control
 	jit_exception_func	exception_handler;
 	jit_backtrace_t		backtrace_head;
 	struct jit_jmp_buf	*setjmp_head;
+	unsigned int		index;
+	unsigned int		epoch_depth;
+	int			*epoch_count;
 };
 
 /*
@@ -731,6 +1046,12 @@ int _jit_block_record_label_flags(jit_function_t func, jit_label_t label, int fl
  */
 jit_insn_t _jit_block_add_insn(jit_block_t block);
 
+/*
+ * Add an instruction to the end of a block, before the branch that ends
+ * it if there is one.
+ */
+jit_insn_t _jit_block_add_insn_before_branch(jit_block_t block);
+
 /*
  * Get the last instruction in a block.  NULL if the block is empty.
  */
@@ -742,6 +1063,28 @@ jit_insn_t _jit_block_get_last(jit_block_t block);
  */
 int _jit_block_is_final(jit_block_t block);
 
+/*
+ * Replace the conditional branch that ends a block with an unconditional
+ * branch if it is always taken, or with nothing if it is never taken,
+ * and delete the control flow edge that can no longer be followed.
+ */
+void _jit_block_fold_branch(jit_block_t block, int taken);
+
+/*
+ * Insert an empty block just before a block and make the given edges,
+ * which all end at the block, end at the new block instead.  The new
+ * block falls through to the block.
+ */
+jit_block_t _jit_block_split_edges(jit_function_t func, jit_block_t block,
+				   _jit_edge_t *edges, int num_edges);
+
+/*
+ * Order the blocks of a function so that the blocks that only lead to
+ * an exception come last and that each block falls through to the hot
+ * one of its successors.
+ */
+void _jit_block_layout(jit_function_t func);
+
 /*
  * Free one element in a metadata list.
  */
@@ -771,6 +1114,18 @@ int _jit_load_opcode(int base_opcode, jit_type_t type);
  */
 int _jit_store_opcode(int base_opcode, int small_base, jit_type_t type);
 
+/*
+ * Get the value that an instruction defines, or NULL if it defines none.
+ * A few notes define their first value rather than the destination.
+ */
+jit_value_t _jit_insn_get_def(jit_insn_t insn);
+
+/*
+ * Determine if an opcode computes its result from its operands alone
+ * and cannot throw.
+ */
+int _jit_opcode_is_pure(int opcode);
+
 /*
  * Function that is called upon each breakpoint location.
  */
@@ -824,6 +1179,10 @@ extern struct _jit_type const _jit_type_float32_def;
 extern struct _jit_type const _jit_type_float64_def;
 extern struct _jit_type const _jit_type_nfloat_def;
 extern struct _jit_type const _jit_type_void_ptr_def;
+extern struct _jit_type const _jit_type_v4i32_def;
+extern struct _jit_type const _jit_type_v2i64_def;
+extern struct _jit_type const _jit_type_v4f32_def;
+extern struct _jit_type const _jit_type_v2f64_def;
 
 /*
  * Intrinsic signatures.
@@ -0,0 +1,841 @@
+/*
+ * jit-ir-cache.c - Share compiled code between functions with the same IR.
+ *
+ * This file is part of the libjit library.
+ *
+ * The libjit library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * The libjit library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the libjit library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "jit-internal.h"
+
+/*
+ * Parameters of the 64-bit hash.  Words are mixed in with a multiply
+ * and a shift, and bytes with FNV-1a.
+ */
+#define	IR_HASH_BASIS		((jit_ulong)0xcbf29ce484222325ULL)
+#define	IR_HASH_PRIME		((jit_ulong)0x00000100000001b3ULL)
+#define	IR_HASH_MULTIPLIER	((jit_ulong)0x9e3779b97f4a7c15ULL)
+
+/*
+ * Number of values that the hasher can number before it has to
+ * allocate a table.  Must be a power of two.
+ */
+#define	IR_HASH_LOCAL_VALUES	128
+
+/*
+ * Limit on the nesting of types that are hashed structurally.
+ */
+#define	IR_HASH_MAX_TYPE_DEPTH	16
+
+/*
+ * Initial size of the serialization of the IR.
+ */
+#define	IR_KEY_MIN_SIZE		256
+
+/*
+ * State of the hash computation.  Values are numbered in the order in
+ * which they are first seen, so that the hash does not depend on where
+ * the builder allocated them.
+ *
+ * If "record" is set, everything that is hashed is also appended to
+ * "ir".  The cache compares this serialization in full when the hashes
+ * match, so that a collision never runs the code of another function.
+ */
+typedef struct
+{
+	jit_function_t		func;
+	jit_ulong		hash;
+	unsigned char		*ir;
+	unsigned int		ir_len;
+	unsigned int		ir_max;
+	int			record;
+	int			out_of_memory;
+	jit_value_t		*values;
+	unsigned int		*numbers;
+	unsigned int		num_values;
+	unsigned int		max_values;
+	unsigned int		num_insns;
+	jit_value_t		local_values[IR_HASH_LOCAL_VALUES];
+	unsigned int		local_numbers[IR_HASH_LOCAL_VALUES];
+
+} ir_hasher_t;
+
+/*
+ * Entry in the compile cache.  The code belongs to "func", which was
+ * the first function that was compiled with this IR.
+ */
+typedef struct _jit_compile_cache_entry *_jit_compile_cache_entry_t;
+struct _jit_compile_cache_entry
+{
+	_jit_compile_cache_entry_t	next;
+	jit_ulong			hash;
+	unsigned int			num_insns;
+	unsigned char			*ir;
+	unsigned int			ir_len;
+	jit_function_t			func;
+	void				*entry_point;
+	jit_nint			leaf_stack_size;
+	unsigned			is_leaf : 1;
+	unsigned			no_throw : 1;
+	unsigned			no_return : 1;
+};
+
+#define	COMPILE_CACHE_MIN_BUCKETS	64
+
+struct _jit_compile_cache
+{
+	_jit_compile_cache_entry_t	*buckets;
+	unsigned int			num_buckets;
+	unsigned int			num_entries;
+	jit_nuint			hits;
+	jit_nuint			misses;
+};
+
+static void
+record_bytes(ir_hasher_t *hasher, const void *buf, unsigned int len)
+{
+	unsigned char *ir;
+	unsigned int max;
+
+	if(!hasher->record || hasher->out_of_memory)
+	{
+		return;
+	}
+	if(hasher->ir_len + len > hasher->ir_max)
+	{
+		max = hasher->ir_max ? hasher->ir_max : IR_KEY_MIN_SIZE;
+		while(max < hasher->ir_len + len)
+		{
+			max *= 2;
+		}
+		ir = (unsigned char *)jit_realloc(hasher->ir, max);
+		if(!ir)
+		{
+			hasher->out_of_memory = 1;
+			return;
+		}
+		hasher->ir = ir;
+		hasher->ir_max = max;
+	}
+	jit_memcpy(hasher->ir + hasher->ir_len, buf, len);
+	hasher->ir_len += len;
+}
+
+static void
+hash_word(ir_hasher_t *hasher, jit_ulong word)
+{
+	hasher->hash = (hasher->hash ^ word) * IR_HASH_MULTIPLIER;
+	hasher->hash ^= hasher->hash >> 32;
+	record_bytes(hasher, &word, sizeof(word));
+}
+
+static void
+hash_bytes(ir_hasher_t *hasher, const void *buf, unsigned int len)
+{
+	const unsigned char *bytes = (const unsigned char *)buf;
+	jit_ulong prefix = len;
+
+	/* The length keeps the serialization unambiguous */
+	record_bytes(hasher, &prefix, sizeof(prefix));
+	record_bytes(hasher, buf, len);
+	while(len > 0)
+	{
+		hasher->hash ^= *bytes++;
+		hasher->hash *= IR_HASH_PRIME;
+		--len;
+	}
+}
+
+static void
+hash_string(ir_hasher_t *hasher, const char *str)
+{
+	if(str)
+	{
+		hash_bytes(hasher, str, jit_strlen(str) + 1);
+	}
+	else
+	{
+		hash_word(hasher, 0);
+	}
+}
+
+/*
+ * Hash a type by its structure rather than by its address, because
+ * frontends usually create a new signature for every function.
+ */
+static void
+hash_type(ir_hasher_t *hasher, jit_type_t type, int depth)
+{
+	unsigned int index;
+	unsigned int num;
+	int kind;
+
+	if(!type || depth > IR_HASH_MAX_TYPE_DEPTH)
+	{
+		hash_word(hasher, (jit_ulong)(jit_nuint)type);
+		return;
+	}
+	kind = jit_type_get_kind(type);
+	hash_word(hasher, (jit_ulong)kind);
+	if(kind >= JIT_TYPE_FIRST_TAGGED)
+	{
+		hash_word(hasher, (jit_ulong)(jit_nuint)jit_type_get_tagged_data(type));
+		hash_type(hasher, jit_type_get_tagged_type(type), depth + 1);
+		return;
+	}
+	switch(kind)
+	{
+	case JIT_TYPE_STRUCT:
+	case JIT_TYPE_UNION:
+		num = jit_type_num_fields(type);
+		hash_word(hasher, jit_type_get_size(type));
+		hash_word(hasher, jit_type_get_alignment(type));
+		hash_word(hasher, num);
+		for(index = 0; index < num; ++index)
+		{
+			hash_word(hasher, jit_type_get_offset(type, index));
+			hash_type(hasher, jit_type_get_field(type, index), depth + 1);
+		}
+		break;
+
+	case JIT_TYPE_SIGNATURE:
+		num = jit_type_num_params(type);
+		hash_word(hasher, (jit_ulong)jit_type_get_abi(type));
+		hash_word(hasher, num);
+		hash_type(hasher, jit_type_get_return(type), depth + 1);
+		for(index = 0; index < num; ++index)
+		{
+			hash_type(hasher, jit_type_get_param(type, index), depth + 1);
+		}
+		break;
+
+	case JIT_TYPE_PTR:
+		hash_type(hasher, jit_type_get_ref(type), depth + 1);
+		break;
+
+	case JIT_TYPE_VECTOR:
+		hash_type(hasher, jit_type_get_lane_type(type), depth + 1);
+		break;
+	}
+}
+
+/*
+ * Get the first slot of a value in the table.  Values are allocated
+ * at a fixed stride, so the address is mixed before it is masked.
+ */
+static unsigned int
+value_slot(jit_value_t value, unsigned int mask)
+{
+	return (unsigned int)((((jit_ulong)(jit_nuint)value) * IR_HASH_MULTIPLIER) >> 40)
+		& mask;
+}
+
+static void
+free_values(ir_hasher_t *hasher)
+{
+	if(hasher->values != hasher->local_values)
+	{
+		jit_free(hasher->values);
+		jit_free(hasher->numbers);
+	}
+}
+
+/*
+ * Get the number of a value, giving it the next number if it is new.
+ * Returns -1 if out of memory.
+ */
+static int
+number_value(ir_hasher_t *hasher, jit_value_t value, int *is_new)
+{
+	jit_value_t *values;
+	unsigned int *numbers;
+	unsigned int max_values;
+	unsigned int index;
+	unsigned int mask;
+
+	/* Grow the table once it is half full */
+	if(2 * (hasher->num_values + 1) > hasher->max_values)
+	{
+		max_values = 2 * hasher->max_values;
+		values = (jit_value_t *)jit_calloc(max_values, sizeof(jit_value_t));
+		numbers = (unsigned int *)jit_malloc(max_values * sizeof(unsigned int));
+		if(!values || !numbers)
+		{
+			jit_free(values);
+			jit_free(numbers);
+			return -1;
+		}
+		mask = max_values - 1;
+		for(index = 0; index < hasher->max_values; ++index)
+		{
+			jit_value_t old = hasher->values[index];
+			unsigned int posn;
+			if(!old)
+			{
+				continue;
+			}
+			posn = value_slot(old, mask);
+			while(values[posn])
+			{
+				posn = (posn + 1) & mask;
+			}
+			values[posn] = old;
+			numbers[posn] = hasher->numbers[index];
+		}
+		free_values(hasher);
+		hasher->values = values;
+		hasher->numbers = numbers;
+		hasher->max_values = max_values;
+	}
+
+	/* Look for the value, or insert it */
+	mask = hasher->max_values - 1;
+	index = value_slot(value, mask);
+	while(hasher->values[index])
+	{
+		if(hasher->values[index] == value)
+		{
+			*is_new = 0;
+			return (int)(hasher->numbers[index]);
+		}
+		index = (index + 1) & mask;
+	}
+	hasher->values[index] = value;
+	hasher->numbers[index] = hasher->num_values;
+	*is_new = 1;
+	return (int)(hasher->num_values++);
+}
+
+static int
+hash_value(ir_hasher_t *hasher, jit_value_t value)
+{
+	jit_ulong bits;
+	int number;
+	int is_new;
+
+	if(!value)
+	{
+		hash_word(hasher, 0);
+		return 1;
+	}
+	number = number_value(hasher, value, &is_new);
+	if(number < 0)
+	{
+		return 0;
+	}
+	if(!is_new)
+	{
+		hash_word(hasher, (jit_ulong)number + 1);
+		return 1;
+	}
+
+	/* Describe the value the first time that it is seen */
+	bits = (value->is_temporary << 0) | (value->is_local << 1)
+		| (value->is_volatile << 2) | (value->is_addressable << 3)
+		| (value->is_constant << 4) | (value->is_nint_constant << 5)
+		| (value->is_parameter << 6);
+	hash_word(hasher, ((jit_ulong)number + 1) | (bits << 32));
+	hash_type(hasher, value->type, 0);
+	if(!value->is_constant)
+	{
+		return 1;
+	}
+	if(value->is_nint_constant)
+	{
+		hash_word(hasher, (jit_ulong)value->address);
+		return 1;
+	}
+	switch(jit_type_get_kind(jit_type_normalize(value->type)))
+	{
+	case JIT_TYPE_LONG:
+	case JIT_TYPE_ULONG:
+		hash_word(hasher, (jit_ulong)(*((jit_long *)(value->address))));
+		break;
+
+	case JIT_TYPE_FLOAT32:
+		hash_bytes(hasher, (void *)(value->address), sizeof(jit_float32));
+		break;
+
+	case JIT_TYPE_FLOAT64:
+		hash_bytes(hasher, (void *)(value->address), sizeof(jit_float64));
+		break;
+
+	case JIT_TYPE_NFLOAT:
+	{
+		/* The padding of "long double" is not initialized, so hash
+		   the value as the sum of two doubles, which is exact */
+		jit_nfloat nfloat = *((jit_nfloat *)(value->address));
+		jit_float64 high = (jit_float64)nfloat;
+		jit_float64 low = (jit_float64)(nfloat - (jit_nfloat)high);
+		hash_bytes(hasher, &high, sizeof(high));
+		hash_bytes(hasher, &low, sizeof(low));
+		break;
+	}
+
+	default:
+		hash_word(hasher, (jit_ulong)value->address);
+		break;
+	}
+	return 1;
+}
+
+static int
+hash_insn(ir_hasher_t *hasher, jit_insn_t insn)
+{
+	jit_label_t *labels;
+	jit_nint num_labels;
+	jit_nint index;
+	int flags = insn->flags;
+
+	hash_word(hasher, (jit_ulong)(jit_ushort)insn->opcode
+		  | ((jit_ulong)(flags & ~JIT_INSN_LIVENESS_FLAGS) << 16));
+
+	/* The destination may be a label or a called function */
+	if((flags & JIT_INSN_DEST_IS_FUNCTION) != 0
+	   && (jit_function_t)(insn->dest) == hasher->func)
+	{
+		/* A recursive call refers to whichever function has the code */
+		hash_word(hasher, 1);
+	}
+	else if((flags & JIT_INSN_DEST_OTHER_FLAGS) != 0)
+	{
+		hash_word(hasher, (jit_ulong)(jit_nuint)(insn->dest));
+	}
+	else if(!hash_value(hasher, insn->dest))
+	{
+		return 0;
+	}
+
+	/* The jump table keeps the address of its labels in a constant */
+	if(insn->opcode == JIT_OP_JUMP_TABLE)
+	{
+		labels = (jit_label_t *)(insn->value1->address);
+		num_labels = insn->value2->address;
+		hash_word(hasher, (jit_ulong)num_labels);
+		for(index = 0; index < num_labels; ++index)
+		{
+			hash_word(hasher, (jit_ulong)labels[index]);
+		}
+		return 1;
+	}
+
+	if((flags & JIT_INSN_VALUE1_IS_NAME) != 0)
+	{
+		hash_string(hasher, (const char *)(insn->value1));
+	}
+	else if((flags & JIT_INSN_VALUE1_IS_LABEL) != 0)
+	{
+		hash_word(hasher, (jit_ulong)(jit_nuint)(insn->value1));
+	}
+	else if(!hash_value(hasher, insn->value1))
+	{
+		return 0;
+	}
+
+	if((flags & JIT_INSN_VALUE2_IS_SIGNATURE) != 0)
+	{
+		hash_type(hasher, (jit_type_t)(insn->value2), 0);
+	}
+	else if(!hash_value(hasher, insn->value2))
+	{
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * Hash the IR of "func", and serialize it as well if "record" is set.
+ * Returns zero if out of memory.
+ */
+static int
+hash_function(ir_hasher_t *hasher, jit_function_t func, int record)
+{
+	jit_builder_t builder = func->builder;
+	jit_block_t block;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+	jit_label_t label;
+	unsigned int num_params;
+	unsigned int param;
+	int is_new;
+	int ok = 1;
+
+	hasher->func = func;
+	hasher->hash = IR_HASH_BASIS;
+	hasher->ir = 0;
+	hasher->ir_len = 0;
+	hasher->ir_max = 0;
+	hasher->record = record;
+	hasher->out_of_memory = 0;
+	hasher->values = hasher->local_values;
+	hasher->numbers = hasher->local_numbers;
+	hasher->num_values = 0;
+	hasher->max_values = IR_HASH_LOCAL_VALUES;
+	hasher->num_insns = 0;
+	jit_memzero(hasher->local_values, sizeof(hasher->local_values));
+
+	/* Hash the signature and the properties of the function */
+	hash_type(hasher, func->signature, 0);
+	hash_word(hasher, (jit_ulong)((builder->non_leaf << 0)
+				      | (builder->may_throw << 1)
+				      | (builder->ordinary_return << 2)
+				      | (builder->has_tail_call << 3)
+				      | (builder->position_independent << 4)
+				      | (func->no_throw << 5)
+				      | (func->no_return << 6)));
+	hash_word(hasher, (jit_ulong)func->optimization_level);
+	hash_word(hasher, (jit_ulong)func->context->cpu_features);
+
+	/* Number the parameters first, so that their order is fixed */
+	if(builder->param_values)
+	{
+		num_params = jit_type_num_params(func->signature);
+		for(param = 0; ok && param < num_params; ++param)
+		{
+			ok = number_value(hasher, builder->param_values[param],
+					  &is_new) >= 0;
+		}
+	}
+	if(ok && builder->struct_return)
+	{
+		ok = number_value(hasher, builder->struct_return, &is_new) >= 0;
+	}
+
+	/* Hash the blocks with their labels and instructions */
+	block = 0;
+	while(ok && (block = jit_block_next(func, block)) != 0)
+	{
+		hash_word(hasher, (jit_ulong)(jit_nuint)block->label);
+		label = block->label;
+		while(label != jit_label_undefined && label < builder->max_label_info)
+		{
+			label = builder->label_info[label].alias;
+			hash_word(hasher, (jit_ulong)(jit_nuint)label);
+		}
+		hash_word(hasher, (jit_ulong)(jit_nuint)jit_label_undefined);
+		hash_word(hasher, (jit_ulong)block->num_insns);
+		jit_insn_iter_init(&iter, block);
+		while(ok && (insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			ok = hash_insn(hasher, insn);
+			++(hasher->num_insns);
+		}
+	}
+
+	free_values(hasher);
+	if(!ok || hasher->out_of_memory)
+	{
+		jit_free(hasher->ir);
+		hasher->ir = 0;
+		return 0;
+	}
+	return 1;
+}
+
+/*@
+ * @deftypefun jit_ulong jit_function_get_ir_hash (jit_function_t @var{func})
+ * Get a hash of the instructions of @var{func} that have been built so
+ * far.  Functions that were built with the same sequence of instructions,
+ * types and constants have the same hash, even if they are in different
+ * contexts.  Returns zero if the function has no instructions or if
+ * out of memory.
+ * @end deftypefun
+@*/
+jit_ulong
+jit_function_get_ir_hash(jit_function_t func)
+{
+	ir_hasher_t hasher;
+
+	if(!func || !func->builder)
+	{
+		return 0;
+	}
+	if(!hash_function(&hasher, func, 0) || !hasher.hash)
+	{
+		return 0;
+	}
+	return hasher.hash;
+}
+
+/*
+ * Determine if the code of "func" may be shared with another function.
+ * Code that is recompiled, evicted, nested, pre-compiled or that has
+ * exception handlers is tied to its function.
+ */
+static int
+is_cacheable(jit_function_t func)
+{
+	jit_context_t context = func->context;
+
+	if(!jit_context_get_meta_numeric(context, JIT_OPTION_COMPILE_CACHE)
+	   || jit_context_get_meta_numeric(context, JIT_OPTION_PRE_COMPILE))
+	{
+		return 0;
+	}
+	return !func->is_recompilable && !func->is_evictable
+		&& !func->nested_parent && !func->has_try;
+}
+
+/*
+ * Find the entry with the same IR as "key".  The hash only selects the
+ * candidates; the serializations must be equal.
+ */
+static _jit_compile_cache_entry_t
+find_entry(_jit_compile_cache_t cache, _jit_compile_key_t *key)
+{
+	_jit_compile_cache_entry_t entry;
+
+	entry = cache->buckets[(unsigned int)(key->hash) & (cache->num_buckets - 1)];
+	while(entry && (entry->hash != key->hash || entry->num_insns != key->num_insns
+			|| entry->ir_len != key->ir_len
+			|| jit_memcmp(entry->ir, key->ir, key->ir_len) != 0))
+	{
+		entry = entry->next;
+	}
+	return entry;
+}
+
+/*
+ * Get the cache of "context", creating it if necessary.  The cache
+ * lock must be held.
+ */
+static _jit_compile_cache_t
+get_cache(jit_context_t context)
+{
+	_jit_compile_cache_t cache = context->compile_cache;
+
+	if(!cache)
+	{
+		cache = jit_cnew(struct _jit_compile_cache);
+		if(!cache)
+		{
+			return 0;
+		}
+		cache->buckets = (_jit_compile_cache_entry_t *)
+			jit_calloc(COMPILE_CACHE_MIN_BUCKETS,
+				   sizeof(_jit_compile_cache_entry_t));
+		if(!(cache->buckets))
+		{
+			jit_free(cache);
+			return 0;
+		}
+		cache->num_buckets = COMPILE_CACHE_MIN_BUCKETS;
+		context->compile_cache = cache;
+	}
+	return cache;
+}
+
+int
+_jit_compile_cache_lookup(jit_function_t func, _jit_compile_key_t *key,
+			  void **entry_point)
+{
+	jit_context_t context = func->context;
+	_jit_compile_cache_t cache;
+	_jit_compile_cache_entry_t entry = 0;
+	ir_hasher_t hasher;
+
+	key->hash = 0;
+	key->num_insns = 0;
+	key->ir = 0;
+	key->ir_len = 0;
+	if(!func->builder || !is_cacheable(func) || !hash_function(&hasher, func, 1))
+	{
+		return 0;
+	}
+
+	jit_mutex_lock(&context->compile_cache_lock);
+	cache = get_cache(context);
+	if(cache)
+	{
+		key->hash = hasher.hash;
+		key->num_insns = hasher.num_insns;
+		key->ir = hasher.ir;
+		key->ir_len = hasher.ir_len;
+		entry = find_entry(cache, key);
+		if(entry)
+		{
+			*entry_point = entry->entry_point;
+			func->is_leaf = entry->is_leaf;
+			func->leaf_stack_size = entry->leaf_stack_size;
+			func->no_throw = entry->no_throw;
+			func->no_return = entry->no_return;
+			func->shares_code = 1;
+			++(cache->hits);
+		}
+		else
+		{
+			++(cache->misses);
+		}
+	}
+	jit_mutex_unlock(&context->compile_cache_lock);
+	if(!cache)
+	{
+		jit_free(hasher.ir);
+	}
+	else if(entry)
+	{
+		_jit_compile_key_free(key);
+	}
+	return entry != 0;
+}
+
+/*
+ * Double the number of buckets of the cache.
+ */
+static void
+grow_cache(_jit_compile_cache_t cache)
+{
+	_jit_compile_cache_entry_t *buckets;
+	_jit_compile_cache_entry_t entry;
+	_jit_compile_cache_entry_t next;
+	unsigned int num_buckets = cache->num_buckets * 2;
+	unsigned int index;
+
+	buckets = (_jit_compile_cache_entry_t *)
+		jit_calloc(num_buckets, sizeof(_jit_compile_cache_entry_t));
+	if(!buckets)
+	{
+		/* Keep the longer chains */
+		return;
+	}
+	for(index = 0; index < cache->num_buckets; ++index)
+	{
+		for(entry = cache->buckets[index]; entry; entry = next)
+		{
+			next = entry->next;
+			entry->next = buckets[(unsigned int)(entry->hash) & (num_buckets - 1)];
+			buckets[(unsigned int)(entry->hash) & (num_buckets - 1)] = entry;
+		}
+	}
+	jit_free(cache->buckets);
+	cache->buckets = buckets;
+	cache->num_buckets = num_buckets;
+}
+
+void
+_jit_compile_cache_insert(jit_function_t func, _jit_compile_key_t *key,
+			  void *entry_point)
+{
+	jit_context_t context = func->context;
+	_jit_compile_cache_t cache;
+	_jit_compile_cache_entry_t entry;
+	unsigned int bucket;
+
+	if(!key->hash || !entry_point)
+	{
+		return;
+	}
+
+	jit_mutex_lock(&context->compile_cache_lock);
+	cache = context->compile_cache;
+
+	/* Another thread may have compiled the same IR in the meantime */
+	if(!find_entry(cache, key))
+	{
+		entry = jit_cnew(struct _jit_compile_cache_entry);
+		if(entry)
+		{
+			entry->hash = key->hash;
+			entry->num_insns = key->num_insns;
+			entry->ir = key->ir;
+			entry->ir_len = key->ir_len;
+			key->ir = 0;
+			entry->func = func;
+			entry->entry_point = entry_point;
+			entry->leaf_stack_size = func->leaf_stack_size;
+			entry->is_leaf = func->is_leaf;
+			entry->no_throw = func->no_throw;
+			entry->no_return = func->no_return;
+			func->shares_code = 1;
+			bucket = (unsigned int)(key->hash) & (cache->num_buckets - 1);
+			entry->next = cache->buckets[bucket];
+			cache->buckets[bucket] = entry;
+			if(++(cache->num_entries) > 2 * cache->num_buckets)
+			{
+				grow_cache(cache);
+			}
+		}
+	}
+	jit_mutex_unlock(&context->compile_cache_lock);
+}
+
+void
+_jit_compile_key_free(_jit_compile_key_t *key)
+{
+	jit_free(key->ir);
+	key->ir = 0;
+	key->ir_len = 0;
+}
+
+void
+_jit_compile_cache_destroy(jit_context_t context)
+{
+	_jit_compile_cache_t cache = context->compile_cache;
+	_jit_compile_cache_entry_t entry;
+	_jit_compile_cache_entry_t next;
+	unsigned int index;
+
+	if(!cache)
+	{
+		return;
+	}
+	for(index = 0; index < cache->num_buckets; ++index)
+	{
+		for(entry = cache->buckets[index]; entry; entry = next)
+		{
+			next = entry->next;
+			jit_free(entry->ir);
+			jit_free(entry);
+		}
+	}
+	jit_free(cache->buckets);
+	jit_free(cache);
+	context->compile_cache = 0;
+}
+
+/*@
+ * @deftypefun void jit_context_get_compile_cache_stats (jit_context_t @var{context}, jit_nuint *@var{hits}, jit_nuint *@var{misses})
+ * Get the number of compilations that reused the code of an earlier
+ * function with the same IR, and the number that had to generate new code,
+ * since the @code{JIT_OPTION_COMPILE_CACHE} option was set on
+ * @var{context}.
+ * @end deftypefun
+@*/
+void
+jit_context_get_compile_cache_stats(jit_context_t context, jit_nuint *hits,
+				    jit_nuint *misses)
+{
+	jit_nuint num_hits = 0;
+	jit_nuint num_misses = 0;
+
+	if(context)
+	{
+		jit_mutex_lock(&context->compile_cache_lock);
+		if(context->compile_cache)
+		{
+			num_hits = context->compile_cache->hits;
+			num_misses = context->compile_cache->misses;
+		}
+		jit_mutex_unlock(&context->compile_cache_lock);
+	}
+	if(hits)
+	{
+		*hits = num_hits;
+	}
+	if(misses)
+	{
+		*misses = num_misses;
+	}
+}
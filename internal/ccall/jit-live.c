@@ -21,11 +21,23 @@
  */
 
 #include "jit-internal.h"
+#include "jit-bitset.h"
 #include <jit/jit-dump.h>
 
 #define USE_FORWARD_PROPAGATION 1
 #define USE_BACKWARD_PROPAGATION 1
 
+/* Each loop multiplies the cost of a use by this many bits, and loops
+   that are nested deeper than the maximum cost as much as the maximum */
+#define LOOP_WEIGHT_SHIFT	3
+#define MAX_LOOP_DEPTH		8
+
+/* A definition in a loop costs this many times as much as a use.  A
+   variable in the frame that a loop changes costs a store and then a
+   load that waits for it on the next iteration, while a variable that
+   a loop only reads costs a load that waits for nothing */
+#define LOOP_DEF_WEIGHT		4
+
 /*
  * Compute liveness information for a basic block.
  */
@@ -307,7 +319,7 @@ forward_propagation(jit_block_t block)
 			/* Skip NOP instructions, which may have arguments left
 			   over from when the instruction was replaced, but which
 			   are not relevant to our analysis */
-			if(insn->opcode == JIT_OP_NOP)
+			if(insn2->opcode == JIT_OP_NOP)
 			{
 				continue;
 			}
@@ -453,7 +465,7 @@ backward_propagation(jit_block_t block)
 			/* Skip NOP instructions, which may have arguments left
 			   over from when the instruction was replaced, but which
 			   are not relevant to our analysis */
-			if(insn->opcode == JIT_OP_NOP)
+			if(insn2->opcode == JIT_OP_NOP)
 			{
 				continue;
 			}
@@ -496,7 +508,7 @@ backward_propagation(jit_block_t block)
 			}
 			if((flags2 & JIT_INSN_VALUE2_OTHER_FLAGS) == 0)
 			{
-				if(insn2->value2 == dest || insn2->value1 == value)
+				if(insn2->value2 == dest || insn2->value2 == value)
 				{
 					break;
 				}
@@ -508,15 +520,432 @@ backward_propagation(jit_block_t block)
 }
 #endif
 
+/*
+ * Liveness of the local variables across the blocks of a function.
+ */
+typedef struct
+{
+	/* Local variables that are tracked, indexed by "value->index" */
+	jit_value_t		*values;
+	int			num_values;
+	int			max_values;
+
+	/* Blocks of the function, indexed by "block->index" */
+	jit_block_t		*blocks;
+	int			num_blocks;
+
+	/* Variables that each block reads before writing them, that it
+	   writes, and that are live on entry to and exit from it */
+	_jit_bitset_t		*uses;
+	_jit_bitset_t		*defs;
+	_jit_bitset_t		*live_in;
+	_jit_bitset_t		*live_out;
+
+} _jit_live_t;
+
+/*
+ * Determine if the liveness of a value is tracked across blocks.
+ * Values that may be reached other than through the instructions
+ * of the function are always live.
+ */
+static int
+is_tracked_value(jit_function_t func, jit_value_t value)
+{
+	return value && !value->is_constant && !value->is_temporary
+		&& !value->is_addressable && !value->is_volatile
+		&& value->block && value->block->func == func;
+}
+
+/*
+ * Assign an index to a local variable the first time it is seen.
+ */
+static int
+add_value(_jit_live_t *live, jit_value_t value)
+{
+	jit_value_t *values;
+	int max_values;
+
+	if(value->index >= 0)
+	{
+		return 1;
+	}
+	if(live->num_values >= live->max_values)
+	{
+		max_values = live->max_values ? live->max_values * 2 : 64;
+		values = (jit_value_t *) jit_realloc(live->values,
+						     max_values * sizeof(jit_value_t));
+		if(!values)
+		{
+			return 0;
+		}
+		live->values = values;
+		live->max_values = max_values;
+	}
+	value->index = live->num_values;
+	live->values[live->num_values++] = value;
+	return 1;
+}
+
+/*
+ * Record that a block reads a value.
+ */
+static void
+add_use(_jit_live_t *live, jit_block_t block, jit_value_t value)
+{
+	if(value && value->index >= 0
+	   && !_jit_bitset_test_bit(&live->defs[block->index], value->index))
+	{
+		_jit_bitset_set_bit(&live->uses[block->index], value->index);
+	}
+}
+
+/*
+ * Record that a block writes a value.
+ */
+static void
+add_def(_jit_live_t *live, jit_block_t block, jit_value_t value)
+{
+	if(value && value->index >= 0)
+	{
+		_jit_bitset_set_bit(&live->defs[block->index], value->index);
+	}
+}
+
+/*
+ * Free an array of per-block sets.
+ */
+static void
+free_sets(_jit_bitset_t *sets, int num_blocks)
+{
+	int index;
+
+	if(sets)
+	{
+		for(index = 0; index < num_blocks; index++)
+		{
+			_jit_bitset_free(&sets[index]);
+		}
+		jit_free(sets);
+	}
+}
+
+/*
+ * Release the memory used by the liveness analysis.
+ */
+static void
+free_global_liveness(_jit_live_t *live)
+{
+	int index;
+
+	for(index = 0; index < live->num_values; index++)
+	{
+		live->values[index]->index = -1;
+	}
+	jit_free(live->values);
+	jit_free(live->blocks);
+	free_sets(live->uses, live->num_blocks);
+	free_sets(live->defs, live->num_blocks);
+	free_sets(live->live_in, live->num_blocks);
+	free_sets(live->live_out, live->num_blocks);
+}
+
+/*
+ * Compute which local variables are live on exit from each block by
+ * iterating over the control flow graph until nothing changes.  Returns
+ * zero if the analysis is not possible, in which case every local
+ * variable is considered live at the end of every block.
+ */
+static int
+compute_global_liveness(jit_function_t func, _jit_live_t *live)
+{
+	jit_block_t block;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+	_jit_bitset_t temp;
+	int index, edge, changed;
+
+	jit_memzero(live, sizeof(_jit_live_t));
+
+	/* The control flow graph is built only by the optimizer, and it
+	   does not show where exceptions and computed jumps go */
+	if(func->optimization_level == JIT_OPTLEVEL_NONE || func->has_try)
+	{
+		return 0;
+	}
+	for(block = func->builder->entry_block; block; block = block->next)
+	{
+		if(block->address_of)
+		{
+			return 0;
+		}
+		block->index = live->num_blocks++;
+	}
+
+	/* Number the local variables */
+	for(block = func->builder->entry_block; block; block = block->next)
+	{
+		jit_insn_iter_init(&iter, block);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			if(insn->opcode == JIT_OP_NOP)
+			{
+				continue;
+			}
+			if((insn->flags & JIT_INSN_DEST_OTHER_FLAGS) == 0
+			   && is_tracked_value(func, insn->dest)
+			   && !add_value(live, insn->dest))
+			{
+				return 0;
+			}
+			if((insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0
+			   && is_tracked_value(func, insn->value1)
+			   && !add_value(live, insn->value1))
+			{
+				return 0;
+			}
+			if((insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0
+			   && is_tracked_value(func, insn->value2)
+			   && !add_value(live, insn->value2))
+			{
+				return 0;
+			}
+		}
+	}
+	if(live->num_values == 0)
+	{
+		return 0;
+	}
+
+	/* Allocate the sets */
+	live->blocks = (jit_block_t *) jit_calloc(live->num_blocks, sizeof(jit_block_t));
+	live->uses = (_jit_bitset_t *) jit_calloc(live->num_blocks, sizeof(_jit_bitset_t));
+	live->defs = (_jit_bitset_t *) jit_calloc(live->num_blocks, sizeof(_jit_bitset_t));
+	live->live_in = (_jit_bitset_t *) jit_calloc(live->num_blocks, sizeof(_jit_bitset_t));
+	live->live_out = (_jit_bitset_t *) jit_calloc(live->num_blocks, sizeof(_jit_bitset_t));
+	if(!live->blocks || !live->uses || !live->defs || !live->live_in || !live->live_out)
+	{
+		return 0;
+	}
+	for(index = 0; index < live->num_blocks; index++)
+	{
+		if(!_jit_bitset_allocate(&live->uses[index], live->num_values)
+		   || !_jit_bitset_allocate(&live->defs[index], live->num_values)
+		   || !_jit_bitset_allocate(&live->live_in[index], live->num_values)
+		   || !_jit_bitset_allocate(&live->live_out[index], live->num_values))
+		{
+			return 0;
+		}
+	}
+
+	/* Collect the variables that each block reads before writing them
+	   and the variables that it writes */
+	for(block = func->builder->entry_block; block; block = block->next)
+	{
+		live->blocks[block->index] = block;
+		jit_insn_iter_init(&iter, block);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			if(insn->opcode == JIT_OP_NOP)
+			{
+				continue;
+			}
+			if((insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0)
+			{
+				add_use(live, block, insn->value1);
+			}
+			if((insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0)
+			{
+				add_use(live, block, insn->value2);
+			}
+			if((insn->flags & JIT_INSN_DEST_OTHER_FLAGS) == 0)
+			{
+				if((insn->flags & JIT_INSN_DEST_IS_VALUE) != 0)
+				{
+					add_use(live, block, insn->dest);
+				}
+				else
+				{
+					add_def(live, block, insn->dest);
+				}
+			}
+		}
+		_jit_bitset_copy(&live->live_in[block->index], &live->uses[block->index]);
+	}
+
+	/* Propagate liveness backwards until it settles.  Visiting the
+	   blocks in reverse order takes few passes for most functions */
+	if(!_jit_bitset_allocate(&temp, live->num_values))
+	{
+		return 0;
+	}
+	do
+	{
+		changed = 0;
+		for(index = live->num_blocks - 1; index >= 0; index--)
+		{
+			block = live->blocks[index];
+			for(edge = 0; edge < block->num_succs; edge++)
+			{
+				_jit_bitset_add(&live->live_out[index],
+						&live->live_in[block->succs[edge]->dst->index]);
+			}
+			_jit_bitset_copy(&temp, &live->live_out[index]);
+			_jit_bitset_sub(&temp, &live->defs[index]);
+			_jit_bitset_add(&temp, &live->uses[index]);
+			changed |= _jit_bitset_copy(&live->live_in[index], &temp);
+		}
+	}
+	while(changed);
+	_jit_bitset_free(&temp);
+
+	return 1;
+}
+
+/*
+ * Extend the live range of a value to cover an instruction position,
+ * and add the cost of a use or definition there.
+ */
+static void
+extend_live_range(_jit_live_t *live, _jit_live_range_t *ranges,
+		  jit_value_t value, int posn, jit_ulong cost)
+{
+	_jit_live_range_t *range;
+
+	if(!value || value->index < 0 || value->index >= live->num_values
+	   || live->values[value->index] != value)
+	{
+		return;
+	}
+	range = &ranges[value->index];
+	if(range->start < 0)
+	{
+		range->start = posn;
+	}
+	range->end = posn;
+	range->weight += cost;
+}
+
+/*
+ * Extend the live ranges of all values in a set to cover a position.
+ */
+static void
+extend_live_ranges(_jit_live_t *live, _jit_live_range_t *ranges,
+		   _jit_bitset_t *set, int posn)
+{
+	int index;
+
+	for(index = 0; index < live->num_values; index++)
+	{
+		if(_jit_bitset_test_bit(set, index))
+		{
+			extend_live_range(live, ranges, live->values[index], posn, 0);
+		}
+	}
+}
+
+/*
+ * Compute the live range of each local variable from the liveness
+ * across blocks, for the global register allocator.  A variable is
+ * live from the first to the last instruction that mentions it or
+ * where it is live on entry to or exit from a block.  There are no
+ * holes in a range, so the allocator may only give the same register
+ * to variables whose ranges do not overlap at all.  A use weighs more
+ * the deeper the loop depth of its block, which the optimizer records,
+ * and a definition in a loop weighs more than a use.
+ */
+static void
+compute_live_ranges(jit_function_t func, _jit_live_t *live)
+{
+	_jit_live_range_t *ranges;
+	jit_block_t block;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+	jit_ulong cost;
+	int index, num, posn;
+
+	jit_free(func->builder->live_ranges);
+	func->builder->live_ranges = 0;
+	func->builder->num_live_ranges = 0;
+
+	ranges = (_jit_live_range_t *) jit_calloc(live->num_values, sizeof(_jit_live_range_t));
+	if(!ranges)
+	{
+		return;
+	}
+	for(index = 0; index < live->num_values; index++)
+	{
+		ranges[index].start = -1;
+		ranges[index].end = -1;
+	}
+
+	posn = 0;
+	for(index = 0; index < live->num_blocks; index++)
+	{
+		block = live->blocks[index];
+		num = block->loop_depth < MAX_LOOP_DEPTH ? block->loop_depth : MAX_LOOP_DEPTH;
+		cost = ((jit_ulong) 1) << (LOOP_WEIGHT_SHIFT * num);
+
+		extend_live_ranges(live, ranges, &live->live_in[index], posn);
+		jit_insn_iter_init(&iter, block);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			++posn;
+			if(insn->opcode == JIT_OP_NOP)
+			{
+				continue;
+			}
+			if((insn->flags & JIT_INSN_DEST_OTHER_FLAGS) == 0)
+			{
+				if((insn->flags & JIT_INSN_DEST_IS_VALUE) == 0 && num > 0)
+				{
+					extend_live_range(live, ranges, insn->dest, posn,
+							  cost * LOOP_DEF_WEIGHT);
+				}
+				else
+				{
+					extend_live_range(live, ranges, insn->dest, posn, cost);
+				}
+			}
+			if((insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0)
+			{
+				extend_live_range(live, ranges, insn->value1, posn, cost);
+			}
+			if((insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0)
+			{
+				extend_live_range(live, ranges, insn->value2, posn, cost);
+			}
+		}
+		++posn;
+		extend_live_ranges(live, ranges, &live->live_out[index], posn);
+		++posn;
+	}
+
+	/* Keep only the values that are live somewhere */
+	num = 0;
+	for(index = 0; index < live->num_values; index++)
+	{
+		if(ranges[index].start >= 0)
+		{
+			ranges[index].value = live->values[index];
+			ranges[num++] = ranges[index];
+		}
+	}
+	func->builder->live_ranges = ranges;
+	func->builder->num_live_ranges = num;
+}
+
 /* Reset value liveness flags. */
 static void
-reset_value_liveness(jit_value_t value)
+reset_value_liveness(jit_value_t value, _jit_bitset_t *live_out)
 {
 	if(value)
 	{
 		if (!value->is_constant && !value->is_temporary)
 		{
-			value->live = 1;
+			/* Local variables are live at the end of the block
+			   unless the liveness analysis proved otherwise */
+			value->live = !live_out || value->index < 0
+				|| _jit_bitset_test_bit(live_out, value->index);
 		}
 		else
 		{
@@ -531,7 +960,7 @@ reset_value_liveness(jit_value_t value)
  * because we need them in the original state for the next block.
  */
 static void
-reset_liveness_flags(jit_block_t block, int reset_all)
+reset_liveness_flags(jit_block_t block, _jit_bitset_t *live_out, int reset_all)
 {
 	jit_insn_iter_t iter;
 	jit_insn_t insn;
@@ -543,15 +972,15 @@ reset_liveness_flags(jit_block_t block, int reset_all)
 		flags = insn->flags;
 		if((flags & JIT_INSN_DEST_OTHER_FLAGS) == 0)
 		{
-			reset_value_liveness(insn->dest);
+			reset_value_liveness(insn->dest, live_out);
 		}
 		if((flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0)
 		{
-			reset_value_liveness(insn->value1);
+			reset_value_liveness(insn->value1, live_out);
 		}
 		if((flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0)
 		{
-			reset_value_liveness(insn->value2);
+			reset_value_liveness(insn->value2, live_out);
 		}
 		if(reset_all)
 		{
@@ -564,16 +993,25 @@ reset_liveness_flags(jit_block_t block, int reset_all)
 
 void _jit_function_compute_liveness(jit_function_t func)
 {
+	_jit_live_t live;
+	_jit_bitset_t *live_out;
+	int global;
+
+	/* Find the local variables that are live across blocks */
+	global = compute_global_liveness(func, &live);
+
 	jit_block_t block = func->builder->entry_block;
 	while(block != 0)
 	{
+		live_out = global ? &live.live_out[block->index] : 0;
+
 #ifdef USE_FORWARD_PROPAGATION
 		/* Perform forward copy propagation for the block */
 		forward_propagation(block);
 #endif
 
 		/* Reset the liveness flags for the next block */
-		reset_liveness_flags(block, 0);
+		reset_liveness_flags(block, live_out, 0);
 
 		/* Compute the liveness flags for the block */
 		compute_liveness_for_block(block);
@@ -583,7 +1021,7 @@ void _jit_function_compute_liveness(jit_function_t func)
 		if(backward_propagation(block))
 		{
 			/* Reset the liveness flags and compute them again */
-			reset_liveness_flags(block, 1);
+			reset_liveness_flags(block, live_out, 1);
 			compute_liveness_for_block(block);
 		}
 #endif
@@ -591,4 +1029,12 @@ void _jit_function_compute_liveness(jit_function_t func)
 		/* Move on to the next block in the function */
 		block = block->next;
 	}
+
+	/* Record where the local variables are live for the global
+	   register allocator */
+	if(global)
+	{
+		compute_live_ranges(func, &live);
+	}
+	free_global_liveness(&live);
 }
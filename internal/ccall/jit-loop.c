@@ -0,0 +1,1750 @@
+/*
+ * jit-loop.c - Loop discovery and loop-invariant code motion.
+ *
+ * This file is part of the libjit library.
+ *
+ * The libjit library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * The libjit library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the libjit library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "jit-internal.h"
+#include "jit-rules.h"
+#include "jit-bitset.h"
+
+#include <stdlib.h>
+
+/*
+ * A natural loop is found for every edge that goes back to a block that
+ * dominates its source.  Loops that share a header are merged.  Every
+ * block gets the number of loops that contain it as its loop depth, for
+ * register allocation and code layout.
+ *
+ * Each loop then gets a preheader: a block outside of the loop that is
+ * the only way into its header.  Instructions whose operands do not
+ * change in the loop are moved into the preheader, innermost loops
+ * first, so that an instruction may move out of several loops.  Pure
+ * instructions that cannot throw move from anywhere in the loop.  Loads
+ * move only out of loops that neither write memory nor throw, and only
+ * from blocks that run whenever the loop is left, so that a load never
+ * runs where it would not have run before.  Null checks of invariant
+ * pointers move out the same way from loops that do nothing else that
+ * may throw, ahead of the loads that they guard.  Then the loads at the
+ * top of a loop may get the value that the previous iteration left in
+ * memory from a variable instead (see jit-access.c).
+ *
+ * Last, a variable that a loop uses and that is also used outside of it
+ * gets a new variable for the loop, copied from it in the preheader and,
+ * if the loop changes it, copied back where the loop is left.  The two
+ * then get a global register each or stay in the frame each, so that a
+ * variable that is busy elsewhere may still get a register in the loop.
+ *
+ * Before that, checks that earlier checks make redundant are removed.
+ * A null check is redundant if a check of the same pointer dominates it
+ * and the pointer is defined once, before that check.  A conditional
+ * branch that compares two integers is decided if the edges that lead
+ * to it, from branches on the same two values that neither changes on
+ * the way, already tell how they compare.  A counter that starts at a
+ * non-negative constant and only goes up by one while it is below some
+ * bound is known to be non-negative, so that both halves of a bounds
+ * check inside a counted loop go away.
+ */
+
+/*
+ * How two integers compare, as a set of these bits.
+ */
+#define	REL_LT			1
+#define	REL_EQ			2
+#define	REL_GT			4
+#define	REL_ANY			7
+
+/*
+ * Number of dominators to search for branches that decide another one.
+ */
+#define	MAX_FACT_DEPTH		32
+
+/*
+ * Loop with its header, preheader and the blocks of its body.
+ */
+typedef struct
+{
+	int			header;
+	int			preheader;
+	int			size;
+	_jit_bitset_t		body;
+
+} _jit_loop_t;
+
+/*
+ * State of the loop optimizer for one function.
+ */
+typedef struct
+{
+	jit_function_t		func;
+
+	/* Blocks in reverse postorder followed by the new preheaders */
+	jit_block_t		*blocks;
+	int			num_blocks;
+	int			num_old_blocks;
+	int			max_blocks;
+
+	/* Dominator tree numbered in preorder.  A new preheader dominates
+	   the same old blocks as the header of its loop */
+	int			*idom;
+	int			*dom_pre;
+	int			*dom_last;
+	int			*dom_block;
+
+	/* Loops, innermost first once sorted */
+	_jit_loop_t		*loops;
+	int			num_loops;
+	int			*header_loop;
+
+	/* Values and their definitions and uses in the function and in a
+	   loop, and the variables that stand for them in a loop */
+	jit_value_t		*values;
+	int			num_values;
+	int			max_values;
+	int			*num_defs;
+	int			*loop_defs;
+	int			*num_uses;
+	int			*loop_uses;
+	jit_value_t		*splits;
+
+	/* Place of the last definition of each value, and whether a value
+	   is known never to be negative: zero if not known yet, 1 if it is
+	   and 2 if it is not */
+	int			*def_block;
+	int			*def_posn;
+	char			*nonneg;
+
+	/* Stamps of the blocks visited by a backward walk */
+	int			*marks;
+	int			stamp;
+
+	/* Scratch arrays */
+	int			*stack;
+	_jit_edge_t		*edges;
+
+} _jit_loop_state_t;
+
+/*
+ * Determine if an opcode loads a value from memory.
+ */
+static int
+is_load(int opcode)
+{
+	return (opcode >= JIT_OP_LOAD_RELATIVE_SBYTE && opcode <= JIT_OP_LOAD_RELATIVE_NFLOAT)
+		|| (opcode >= JIT_OP_LOAD_ELEMENT_SBYTE && opcode <= JIT_OP_LOAD_ELEMENT_NFLOAT)
+		|| opcode == JIT_OP_LOAD_RELATIVE_VECTOR;
+}
+
+/*
+ * Determine if an opcode neither writes memory nor throws.  Anything
+ * that is not known to be harmless is assumed to do both.
+ */
+static int
+is_harmless(int opcode)
+{
+	return opcode == JIT_OP_NOP
+		|| _jit_opcode_is_pure(opcode)
+		|| is_load(opcode)
+		|| (opcode >= JIT_OP_BR && opcode <= JIT_OP_BR_NFGE_INV)
+		|| (opcode >= JIT_OP_COPY_LOAD_SBYTE && opcode <= JIT_OP_COPY_NFLOAT)
+		|| opcode == JIT_OP_MARK_OFFSET;
+}
+
+/*
+ * Determine if the loop optimizer may move the definition of a value.
+ */
+static int
+is_candidate(jit_function_t func, jit_value_t value)
+{
+	jit_type_t type;
+
+	if(!value || value->is_constant || value->is_addressable || value->is_volatile)
+	{
+		return 0;
+	}
+	if(!value->is_temporary && !value->is_local)
+	{
+		return 0;
+	}
+	if(!value->block || value->block->func != func)
+	{
+		return 0;
+	}
+	type = jit_type_normalize(value->type);
+	return type && type->kind != JIT_TYPE_STRUCT && type->kind != JIT_TYPE_UNION;
+}
+
+/*
+ * Assign an index to a value the first time it is seen.
+ */
+static int
+add_value(_jit_loop_state_t *state, jit_value_t value)
+{
+	jit_value_t *values;
+	int max_values;
+
+	if(!value || value->is_constant || value->index >= 0)
+	{
+		return 1;
+	}
+	if(state->num_values >= state->max_values)
+	{
+		max_values = state->max_values ? state->max_values * 2 : 64;
+		values = (jit_value_t *) jit_realloc(state->values,
+						     max_values * sizeof(jit_value_t));
+		if(!values)
+		{
+			return 0;
+		}
+		state->values = values;
+		state->max_values = max_values;
+	}
+	value->index = state->num_values;
+	state->values[state->num_values++] = value;
+	return 1;
+}
+
+/*
+ * Count the uses of the values that an instruction reads.
+ */
+static void
+count_uses(jit_insn_t insn, int *uses)
+{
+	if(insn->opcode == JIT_OP_NOP)
+	{
+		return;
+	}
+	if((insn->flags & (JIT_INSN_DEST_OTHER_FLAGS | JIT_INSN_DEST_IS_VALUE))
+	   == JIT_INSN_DEST_IS_VALUE && insn->dest && insn->dest->index >= 0)
+	{
+		++(uses[insn->dest->index]);
+	}
+	if((insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0 && insn->value1
+	   && insn->value1->index >= 0 && _jit_insn_get_def(insn) != insn->value1)
+	{
+		++(uses[insn->value1->index]);
+	}
+	if((insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0 && insn->value2
+	   && insn->value2->index >= 0)
+	{
+		++(uses[insn->value2->index]);
+	}
+}
+
+static void
+free_state(_jit_loop_state_t *state)
+{
+	int index;
+
+	for(index = 0; index < state->num_values; index++)
+	{
+		state->values[index]->index = -1;
+	}
+	for(index = 0; index < state->num_loops; index++)
+	{
+		_jit_bitset_free(&state->loops[index].body);
+	}
+	jit_free(state->blocks);
+	jit_free(state->idom);
+	jit_free(state->dom_pre);
+	jit_free(state->dom_last);
+	jit_free(state->dom_block);
+	jit_free(state->loops);
+	jit_free(state->header_loop);
+	jit_free(state->values);
+	jit_free(state->num_defs);
+	jit_free(state->loop_defs);
+	jit_free(state->num_uses);
+	jit_free(state->loop_uses);
+	jit_free(state->splits);
+	jit_free(state->def_block);
+	jit_free(state->def_posn);
+	jit_free(state->nonneg);
+	jit_free(state->marks);
+	jit_free(state->stack);
+	jit_free(state->edges);
+}
+
+/*
+ * Number the blocks in reverse postorder and the values that the
+ * instructions mention, and count the definitions of each value.
+ * Returns zero if the function has a shape that is not handled.
+ */
+static int
+number_blocks_and_values(_jit_loop_state_t *state)
+{
+	jit_function_t func = state->func;
+	jit_block_t block;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+	jit_value_t value;
+	int index, posn, max_edges;
+
+	/* Blocks that are taken address of may be entered from anywhere,
+	   and exceptions go where the control flow graph does not show */
+	if(func->has_try)
+	{
+		return 0;
+	}
+	max_edges = 0;
+	for(block = func->builder->entry_block; block; block = block->next)
+	{
+		if(block->address_of)
+		{
+			return 0;
+		}
+		block->index = -1;
+		block->loop_depth = 0;
+		block->loop_header = 0;
+		max_edges += block->num_preds;
+	}
+
+	state->num_blocks = func->builder->num_block_order;
+	state->num_old_blocks = state->num_blocks;
+	state->max_blocks = 2 * state->num_blocks;
+	state->blocks = (jit_block_t *) jit_calloc(state->max_blocks, sizeof(jit_block_t));
+	state->idom = (int *) jit_calloc(state->max_blocks, sizeof(int));
+	state->dom_pre = (int *) jit_calloc(state->max_blocks, sizeof(int));
+	state->dom_last = (int *) jit_calloc(state->max_blocks, sizeof(int));
+	state->dom_block = (int *) jit_calloc(state->max_blocks, sizeof(int));
+	state->loops = (_jit_loop_t *) jit_calloc(state->max_blocks, sizeof(_jit_loop_t));
+	state->header_loop = (int *) jit_calloc(state->max_blocks, sizeof(int));
+	state->stack = (int *) jit_calloc(state->max_blocks, sizeof(int));
+	state->marks = (int *) jit_calloc(state->max_blocks, sizeof(int));
+	state->edges = (_jit_edge_t *) jit_calloc(max_edges + 1, sizeof(_jit_edge_t));
+	if(!state->blocks || !state->idom || !state->dom_pre || !state->dom_last
+	   || !state->dom_block || !state->loops || !state->header_loop
+	   || !state->stack || !state->marks || !state->edges)
+	{
+		return 0;
+	}
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		block = func->builder->block_order[state->num_blocks - 1 - index];
+		block->index = index;
+		state->blocks[index] = block;
+		state->dom_block[index] = index;
+		state->header_loop[index] = -1;
+	}
+	if(state->num_blocks == 0 || state->blocks[0] != func->builder->entry_block
+	   || state->blocks[0]->num_preds != 0)
+	{
+		return 0;
+	}
+
+	/* Reset the value indexes before numbering the values */
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		jit_insn_iter_init(&iter, state->blocks[index]);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			if((insn->flags & JIT_INSN_DEST_OTHER_FLAGS) == 0 && insn->dest)
+			{
+				insn->dest->index = -1;
+			}
+			if((insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0 && insn->value1)
+			{
+				insn->value1->index = -1;
+			}
+			if((insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0 && insn->value2)
+			{
+				insn->value2->index = -1;
+			}
+		}
+	}
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		jit_insn_iter_init(&iter, state->blocks[index]);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			if(insn->opcode == JIT_OP_NOP)
+			{
+				continue;
+			}
+			if(((insn->flags & JIT_INSN_DEST_OTHER_FLAGS) == 0
+			    && !add_value(state, insn->dest))
+			   || ((insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0
+			       && !add_value(state, insn->value1))
+			   || ((insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0
+			       && !add_value(state, insn->value2)))
+			{
+				return 0;
+			}
+		}
+	}
+
+	state->num_defs = (int *) jit_calloc(state->num_values + 1, sizeof(int));
+	state->loop_defs = (int *) jit_calloc(state->num_values + 1, sizeof(int));
+	state->num_uses = (int *) jit_calloc(state->num_values + 1, sizeof(int));
+	state->loop_uses = (int *) jit_calloc(state->num_values + 1, sizeof(int));
+	state->splits = (jit_value_t *) jit_calloc(state->num_values + 1, sizeof(jit_value_t));
+	state->def_block = (int *) jit_calloc(state->num_values + 1, sizeof(int));
+	state->def_posn = (int *) jit_calloc(state->num_values + 1, sizeof(int));
+	state->nonneg = (char *) jit_calloc(state->num_values + 1, sizeof(char));
+	if(!state->num_defs || !state->loop_defs || !state->num_uses
+	   || !state->loop_uses || !state->splits || !state->def_block
+	   || !state->def_posn || !state->nonneg)
+	{
+		return 0;
+	}
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		block = state->blocks[index];
+		for(posn = 0; posn < block->num_insns; posn++)
+		{
+			insn = &block->insns[posn];
+			value = _jit_insn_get_def(insn);
+			if(value && value->index >= 0)
+			{
+				++(state->num_defs[value->index]);
+				state->def_block[value->index] = index;
+				state->def_posn[value->index] = posn;
+			}
+			count_uses(insn, state->num_uses);
+		}
+	}
+	return 1;
+}
+
+/*
+ * Compute the dominator tree with the algorithm of Cooper, Harvey and
+ * Kennedy, and number it in preorder.
+ */
+static void
+compute_dominators(_jit_loop_state_t *state)
+{
+	jit_block_t block;
+	int *idom, *child, *sibling;
+	int index, pred, dom, other, changed, top, num;
+
+	idom = state->idom;
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		idom[index] = -1;
+	}
+	idom[0] = 0;
+	do
+	{
+		changed = 0;
+		for(index = 1; index < state->num_blocks; index++)
+		{
+			block = state->blocks[index];
+			dom = -1;
+			for(pred = 0; pred < block->num_preds; pred++)
+			{
+				other = block->preds[pred]->src->index;
+				if(other < 0 || idom[other] < 0)
+				{
+					continue;
+				}
+				if(dom < 0)
+				{
+					dom = other;
+					continue;
+				}
+				while(dom != other)
+				{
+					while(dom > other)
+					{
+						dom = idom[dom];
+					}
+					while(other > dom)
+					{
+						other = idom[other];
+					}
+				}
+			}
+			if(idom[index] != dom)
+			{
+				idom[index] = dom;
+				changed = 1;
+			}
+		}
+	}
+	while(changed);
+
+	/* Number the tree in preorder.  The children of a block are kept in
+	   the loop state arrays that are not in use yet */
+	child = state->header_loop;
+	sibling = state->dom_block;
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		child[index] = -1;
+		sibling[index] = -1;
+	}
+	for(index = state->num_blocks - 1; index > 0; index--)
+	{
+		sibling[index] = child[idom[index]];
+		child[idom[index]] = index;
+	}
+	num = 0;
+	top = 0;
+	state->stack[top++] = 0;
+	while(top > 0)
+	{
+		index = state->stack[--top];
+		state->dom_pre[index] = num++;
+		for(other = child[index]; other >= 0; other = sibling[other])
+		{
+			state->stack[top++] = other;
+		}
+	}
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		state->dom_last[index] = state->dom_pre[index];
+		state->dom_block[index] = index;
+		state->header_loop[index] = -1;
+	}
+	for(index = state->num_blocks - 1; index > 0; index--)
+	{
+		/* Children follow their parents in reverse postorder */
+		if(state->dom_last[idom[index]] < state->dom_last[index])
+		{
+			state->dom_last[idom[index]] = state->dom_last[index];
+		}
+	}
+}
+
+/*
+ * Determine if block "dom" dominates the old block "block".
+ */
+static int
+dominates(_jit_loop_state_t *state, int dom, int block)
+{
+	dom = state->dom_block[dom];
+	return state->dom_pre[dom] <= state->dom_pre[block]
+		&& state->dom_pre[block] <= state->dom_last[dom];
+}
+
+/*
+ * Get the relation that an integer branch tests as a set of REL_* bits,
+ * or zero if the instruction is not such a branch.
+ */
+static int
+branch_relation(jit_insn_t insn, int *is_long, int *is_unsigned)
+{
+	static const int relations[] = {
+		REL_EQ,			REL_LT | REL_GT,
+		REL_LT,			REL_LT,
+		REL_LT | REL_EQ,	REL_LT | REL_EQ,
+		REL_GT,			REL_GT,
+		REL_GT | REL_EQ,	REL_GT | REL_EQ
+	};
+	int index;
+
+	if(!insn)
+	{
+		return 0;
+	}
+	if(insn->opcode >= JIT_OP_BR_IEQ && insn->opcode <= JIT_OP_BR_IGE_UN)
+	{
+		*is_long = 0;
+		index = insn->opcode - JIT_OP_BR_IEQ;
+	}
+	else if(insn->opcode >= JIT_OP_BR_LEQ && insn->opcode <= JIT_OP_BR_LGE_UN)
+	{
+		*is_long = 1;
+		index = insn->opcode - JIT_OP_BR_LEQ;
+	}
+	else
+	{
+		return 0;
+	}
+
+	/* The unsigned variants follow the signed ones */
+	*is_unsigned = (index >= 2 && (index & 1) != 0);
+	return relations[index];
+}
+
+/*
+ * Swap the operands of a relation.
+ */
+static int
+mirror_relation(int rel)
+{
+	return (rel & REL_EQ) | ((rel & REL_LT) ? REL_GT : 0) | ((rel & REL_GT) ? REL_LT : 0);
+}
+
+/*
+ * Get the value of an integer constant as a branch on values of the
+ * given size sees it.  Returns zero if the value is not such a constant.
+ */
+static int
+get_int_constant(jit_value_t value, int is_long, jit_long *result)
+{
+	jit_constant_t constant;
+
+	if(!value || !value->is_constant)
+	{
+		return 0;
+	}
+	constant = jit_value_get_constant(value);
+	switch(jit_type_normalize(constant.type)->kind)
+	{
+	case JIT_TYPE_SBYTE:
+	case JIT_TYPE_UBYTE:
+	case JIT_TYPE_SHORT:
+	case JIT_TYPE_USHORT:
+	case JIT_TYPE_INT:
+	case JIT_TYPE_UINT:
+		if(is_long)
+		{
+			return 0;
+		}
+		*result = constant.un.int_value;
+		return 1;
+
+	case JIT_TYPE_LONG:
+	case JIT_TYPE_ULONG:
+		if(!is_long)
+		{
+			return 0;
+		}
+		*result = constant.un.long_value;
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Determine if two branch operands are the same value.
+ */
+static int
+same_operand(jit_value_t value1, jit_value_t value2, int is_long)
+{
+	jit_long const1, const2;
+
+	if(value1 == value2)
+	{
+		return 1;
+	}
+	return get_int_constant(value1, is_long, &const1)
+		&& get_int_constant(value2, is_long, &const2)
+		&& const1 == const2;
+}
+
+/*
+ * Determine if one of two values may be changed by the instructions of
+ * a block from position "start" up to position "end".
+ */
+static int
+is_changed_in(jit_block_t block, int start, int end, jit_value_t value1, jit_value_t value2)
+{
+	jit_value_t value;
+	int index;
+
+	for(index = start; index < end; index++)
+	{
+		value = _jit_insn_get_def(&block->insns[index]);
+		if(value && (value == value1 || value == value2))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Determine if two values keep what they held on entry to block "dom"
+ * up to the given position in block "block", which "dom" dominates.
+ * Every block on a path from "dom" to "block" that does not go through
+ * "dom" again is searched for definitions of the values.
+ */
+static int
+is_unchanged(_jit_loop_state_t *state, int dom, int block, int posn,
+	     jit_value_t value1, jit_value_t value2)
+{
+	jit_block_t current, pred;
+	int index, top;
+
+	if(value1 && (value1->is_constant || state->num_defs[value1->index] == 0))
+	{
+		value1 = 0;
+	}
+	if(value2 && (value2->is_constant || state->num_defs[value2->index] == 0))
+	{
+		value2 = 0;
+	}
+	if(!value1 && !value2)
+	{
+		return 1;
+	}
+	current = state->blocks[block];
+	if(dom == block)
+	{
+		return !is_changed_in(current, 0, posn, value1, value2);
+	}
+	if(is_changed_in(state->blocks[dom], 0, state->blocks[dom]->num_insns, value1, value2)
+	   || is_changed_in(current, 0, posn, value1, value2))
+	{
+		return 0;
+	}
+
+	++(state->stamp);
+	state->marks[dom] = state->stamp;
+	top = 0;
+	state->stack[top++] = block;
+	while(top > 0)
+	{
+		current = state->blocks[state->stack[--top]];
+		for(index = 0; index < current->num_preds; index++)
+		{
+			pred = current->preds[index]->src;
+			if(pred->index < 0)
+			{
+				return 0;
+			}
+			if(state->marks[pred->index] == state->stamp)
+			{
+				continue;
+			}
+			state->marks[pred->index] = state->stamp;
+			if(is_changed_in(pred, 0, pred->num_insns, value1, value2))
+			{
+				return 0;
+			}
+			state->stack[top++] = pred->index;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Get the relation between two values that the edge into a block tells,
+ * if the block has a single predecessor that ends with an integer branch
+ * on them.  Returns REL_ANY if nothing is known.
+ */
+static int
+edge_relation(jit_block_t block, jit_value_t value1, jit_value_t value2,
+	      int is_long, int *is_unsigned)
+{
+	_jit_edge_t edge;
+	jit_insn_t insn;
+	int rel, branch_long;
+
+	if(block->num_preds != 1)
+	{
+		return REL_ANY;
+	}
+	edge = block->preds[0];
+	if(edge->src->num_succs != 2
+	   || (edge->flags != _JIT_EDGE_BRANCH && edge->flags != _JIT_EDGE_FALLTHRU))
+	{
+		return REL_ANY;
+	}
+	insn = _jit_block_get_last(edge->src);
+	rel = branch_relation(insn, &branch_long, is_unsigned);
+	if(!rel || branch_long != is_long)
+	{
+		return REL_ANY;
+	}
+	if(edge->flags == _JIT_EDGE_FALLTHRU)
+	{
+		rel = REL_ANY & ~rel;
+	}
+	if(same_operand(insn->value1, value1, is_long)
+	   && (!value2 || same_operand(insn->value2, value2, is_long)))
+	{
+		return rel;
+	}
+	if(same_operand(insn->value2, value1, is_long)
+	   && (!value2 || same_operand(insn->value1, value2, is_long)))
+	{
+		return mirror_relation(rel);
+	}
+	return REL_ANY;
+}
+
+/*
+ * Determine if a value is known to be below some other value, compared
+ * as signed integers, at the given position.
+ */
+static int
+is_bounded(_jit_loop_state_t *state, jit_value_t value, int is_long, int block, int posn)
+{
+	int dom, depth, rel, is_unsigned;
+
+	dom = block;
+	for(depth = 0; depth < MAX_FACT_DEPTH; depth++)
+	{
+		rel = edge_relation(state->blocks[dom], value, 0, is_long, &is_unsigned);
+		if(rel != REL_ANY && !is_unsigned && (rel & ~REL_LT) == 0
+		   && is_unchanged(state, dom, block, posn, value, 0))
+		{
+			return 1;
+		}
+		if(dom == 0)
+		{
+			break;
+		}
+		dom = state->idom[dom];
+	}
+	return 0;
+}
+
+/*
+ * Determine if the definition of a value at the given place comes
+ * before the given position in a block.
+ */
+static int
+def_dominates(_jit_loop_state_t *state, int def_block, int def_posn, int block, int posn)
+{
+	if(def_block == block)
+	{
+		return def_posn < posn;
+	}
+	return dominates(state, def_block, block);
+}
+
+/*
+ * Determine if a value is a counter: it is set to a non-negative
+ * constant in one place that comes before every other definition, and
+ * otherwise only ever goes up by one while it is below some other
+ * value, so that it cannot overflow.  The place of the constant
+ * definition is kept as the place of the last definition of the value.
+ */
+static int
+is_counter(_jit_loop_state_t *state, jit_value_t value, int is_long)
+{
+	jit_block_t block;
+	jit_insn_t insn, add;
+	jit_value_t def;
+	jit_long constant;
+	int index, posn, other, init_block, init_posn, num_inits;
+
+	/* Find the only constant definition */
+	num_inits = 0;
+	init_block = 0;
+	init_posn = 0;
+	for(index = 0; index < state->num_old_blocks; index++)
+	{
+		block = state->blocks[index];
+		for(posn = 0; posn < block->num_insns; posn++)
+		{
+			insn = &block->insns[posn];
+			if(_jit_insn_get_def(insn) != value)
+			{
+				continue;
+			}
+			if(insn->opcode == (is_long ? JIT_OP_COPY_LONG : JIT_OP_COPY_INT)
+			   && get_int_constant(insn->value1, is_long, &constant))
+			{
+				if(constant < 0)
+				{
+					return 0;
+				}
+				++num_inits;
+				init_block = index;
+				init_posn = posn;
+			}
+		}
+	}
+	if(num_inits != 1)
+	{
+		return 0;
+	}
+
+	/* Every other definition adds zero or one to the value, directly or
+	   through a temporary that is copied back in the same block */
+	for(index = 0; index < state->num_old_blocks; index++)
+	{
+		block = state->blocks[index];
+		for(posn = 0; posn < block->num_insns; posn++)
+		{
+			insn = &block->insns[posn];
+			if(_jit_insn_get_def(insn) != value || (index == init_block && posn == init_posn))
+			{
+				continue;
+			}
+			add = insn;
+			other = posn;
+			if(insn->opcode == (is_long ? JIT_OP_COPY_LONG : JIT_OP_COPY_INT))
+			{
+				def = insn->value1;
+				if(!def || def->is_constant || def->index < 0
+				   || state->num_defs[def->index] != 1
+				   || state->def_block[def->index] != index
+				   || state->def_posn[def->index] >= posn)
+				{
+					return 0;
+				}
+				other = state->def_posn[def->index];
+				add = &block->insns[other];
+				if(is_changed_in(block, other + 1, posn, value, 0))
+				{
+					return 0;
+				}
+			}
+			if(add->opcode != (is_long ? JIT_OP_LADD : JIT_OP_IADD))
+			{
+				return 0;
+			}
+			if(add->value1 == value)
+			{
+				def = add->value2;
+			}
+			else if(add->value2 == value)
+			{
+				def = add->value1;
+			}
+			else
+			{
+				return 0;
+			}
+			if(!get_int_constant(def, is_long, &constant) || constant < 0 || constant > 1)
+			{
+				return 0;
+			}
+			if(!def_dominates(state, init_block, init_posn, index, other)
+			   || (constant != 0 && !is_bounded(state, value, is_long, index, other)))
+			{
+				return 0;
+			}
+		}
+	}
+	state->def_block[value->index] = init_block;
+	state->def_posn[value->index] = init_posn;
+	return 1;
+}
+
+/*
+ * Determine if a value is not negative as a signed integer at the given
+ * position, because it is a non-negative constant or a counter that was
+ * set before that position.
+ */
+static int
+is_nonnegative(_jit_loop_state_t *state, jit_value_t value, int is_long, int where, int where_posn)
+{
+	jit_long constant;
+
+	if(get_int_constant(value, is_long, &constant))
+	{
+		return constant >= 0;
+	}
+	if(!value || value->index < 0 || value->is_addressable || value->is_volatile
+	   || value->is_parameter || state->num_defs[value->index] == 0)
+	{
+		return 0;
+	}
+	if(state->nonneg[value->index] == 0)
+	{
+		state->nonneg[value->index] = 2;
+		if(is_counter(state, value, is_long))
+		{
+			state->nonneg[value->index] = 1;
+		}
+	}
+	return state->nonneg[value->index] == 1
+		&& def_dominates(state, state->def_block[value->index],
+				 state->def_posn[value->index], where, where_posn);
+}
+
+/*
+ * Determine if the conditional branch at the end of a block is decided
+ * by the branches that lead to it.  Returns 1 if it is always taken, 0
+ * if it is never taken and -1 if it is not known.
+ */
+static int
+decide_branch(_jit_loop_state_t *state, int block)
+{
+	jit_block_t current;
+	jit_insn_t insn;
+	jit_value_t value1, value2, value;
+	jit_long constant;
+	int rel, known, fact, dom, depth, posn, is_long, is_unsigned, fact_unsigned;
+
+	current = state->blocks[block];
+	if(current->num_succs != 2 || current->succs[0]->flags != _JIT_EDGE_BRANCH)
+	{
+		return -1;
+	}
+	insn = _jit_block_get_last(current);
+	rel = branch_relation(insn, &is_long, &is_unsigned);
+	if(!rel)
+	{
+		return -1;
+	}
+	value1 = insn->value1;
+	value2 = insn->value2;
+	if(value1->is_constant && value2->is_constant)
+	{
+		return -1;
+	}
+	posn = current->num_insns - 1;
+	known = REL_ANY;
+
+	/* A counter is never below zero */
+	if(!is_unsigned)
+	{
+		if(get_int_constant(value2, is_long, &constant) && constant <= 0
+		   && is_nonnegative(state, value1, is_long, block, posn))
+		{
+			known &= constant < 0 ? REL_GT : (REL_GT | REL_EQ);
+		}
+		else if(get_int_constant(value1, is_long, &constant) && constant <= 0
+			&& is_nonnegative(state, value2, is_long, block, posn))
+		{
+			known &= constant < 0 ? REL_LT : (REL_LT | REL_EQ);
+		}
+	}
+
+	/* Collect what the edges into the dominators tell */
+	dom = block;
+	for(depth = 0; depth < MAX_FACT_DEPTH; depth++)
+	{
+		fact = edge_relation(state->blocks[dom], value1, value2, is_long, &fact_unsigned);
+		if(fact != REL_ANY && fact != REL_EQ && fact != (REL_LT | REL_GT)
+		   && fact_unsigned != is_unsigned)
+		{
+			/* Signed and unsigned order agree on values that are
+			   not negative.  A signed fact that puts such a value
+			   below another tells that the other one is not
+			   negative either, and so does an unsigned fact that
+			   puts a value below such a value */
+			if((fact & ~(REL_LT | REL_EQ)) == 0)
+			{
+				value = fact_unsigned ? value2 : value1;
+			}
+			else
+			{
+				value = fact_unsigned ? value1 : value2;
+			}
+			if(!is_nonnegative(state, value, is_long, block, posn))
+			{
+				fact = REL_ANY;
+			}
+		}
+		if(fact != REL_ANY && is_unchanged(state, dom, block, posn, value1, value2))
+		{
+			known &= fact;
+		}
+		if(dom == 0)
+		{
+			break;
+		}
+		dom = state->idom[dom];
+	}
+
+	if(known == 0)
+	{
+		/* The block cannot be reached */
+		return -1;
+	}
+	if((known & ~rel) == 0)
+	{
+		return 1;
+	}
+	if((known & rel) == 0)
+	{
+		return 0;
+	}
+	return -1;
+}
+
+/*
+ * Remove the null checks that earlier checks make redundant and fold the
+ * integer branches that earlier branches decide.  Returns the number of
+ * branches folded.
+ */
+static int
+eliminate_checks(_jit_loop_state_t *state)
+{
+	jit_block_t block;
+	jit_insn_t insn;
+	jit_value_t value;
+	int *check_block, *check_posn;
+	int index, posn, num, num_folded;
+
+	check_block = (int *) jit_malloc((state->num_values + 1) * sizeof(int));
+	check_posn = (int *) jit_malloc((state->num_values + 1) * sizeof(int));
+	if(!check_block || !check_posn)
+	{
+		jit_free(check_block);
+		jit_free(check_posn);
+		return 0;
+	}
+	for(index = 0; index < state->num_values; index++)
+	{
+		check_block[index] = -1;
+	}
+
+	num_folded = 0;
+	for(index = 0; index < state->num_old_blocks; index++)
+	{
+		/* A check is redundant if the pointer was checked before and
+		   has not changed since, because its only definition comes
+		   before that check */
+		block = state->blocks[index];
+		for(posn = 0; posn < block->num_insns; posn++)
+		{
+			insn = &block->insns[posn];
+			value = insn->value1;
+			if(insn->opcode != JIT_OP_CHECK_NULL || !value || value->index < 0
+			   || value->is_constant || value->is_addressable || value->is_volatile)
+			{
+				continue;
+			}
+			num = value->index;
+			if(check_block[num] >= 0
+			   && def_dominates(state, check_block[num], check_posn[num], index, posn)
+			   && (state->num_defs[num] == 0
+			       || (state->num_defs[num] == 1
+				   && def_dominates(state, state->def_block[num], state->def_posn[num],
+						    check_block[num], check_posn[num]))))
+			{
+				insn->opcode = JIT_OP_NOP;
+				continue;
+			}
+			check_block[num] = index;
+			check_posn[num] = posn;
+		}
+
+		switch(decide_branch(state, index))
+		{
+		case 0:
+			_jit_block_fold_branch(block, 0);
+			++num_folded;
+			break;
+
+		case 1:
+			_jit_block_fold_branch(block, 1);
+			++num_folded;
+			break;
+		}
+	}
+
+	jit_free(check_block);
+	jit_free(check_posn);
+	return num_folded;
+}
+
+/*
+ * Add the blocks that reach a back edge without going through its
+ * header to the loop of the header.
+ */
+static int
+add_loop(_jit_loop_state_t *state, _jit_edge_t edge)
+{
+	_jit_loop_t *loop;
+	jit_block_t block, pred;
+	int header, index, top;
+
+	header = edge->dst->index;
+	if(state->header_loop[header] < 0)
+	{
+		loop = &state->loops[state->num_loops];
+		if(!_jit_bitset_allocate(&loop->body, state->max_blocks))
+		{
+			return 0;
+		}
+		loop->header = header;
+		loop->preheader = -1;
+		loop->size = 1;
+		_jit_bitset_set_bit(&loop->body, header);
+		state->header_loop[header] = state->num_loops++;
+	}
+	loop = &state->loops[state->header_loop[header]];
+
+	top = 0;
+	index = edge->src->index;
+	if(!_jit_bitset_test_bit(&loop->body, index))
+	{
+		_jit_bitset_set_bit(&loop->body, index);
+		++(loop->size);
+		state->stack[top++] = index;
+	}
+	while(top > 0)
+	{
+		block = state->blocks[state->stack[--top]];
+		for(index = 0; index < block->num_preds; index++)
+		{
+			pred = block->preds[index]->src;
+			if(pred->index >= 0 && !_jit_bitset_test_bit(&loop->body, pred->index))
+			{
+				_jit_bitset_set_bit(&loop->body, pred->index);
+				++(loop->size);
+				state->stack[top++] = pred->index;
+			}
+		}
+	}
+	return 1;
+}
+
+static int
+compare_loops(const void *loop1, const void *loop2)
+{
+	return ((const _jit_loop_t *) loop1)->size - ((const _jit_loop_t *) loop2)->size;
+}
+
+/*
+ * Find the natural loops and the loop depth of every block.  Returns
+ * zero if out of memory.
+ */
+static int
+find_loops(_jit_loop_state_t *state)
+{
+	jit_block_t block;
+	_jit_edge_t edge;
+	int index, succ, loop;
+
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		block = state->blocks[index];
+		for(succ = 0; succ < block->num_succs; succ++)
+		{
+			edge = block->succs[succ];
+			if(edge->dst->index >= 0 && dominates(state, edge->dst->index, index)
+			   && !add_loop(state, edge))
+			{
+				return 0;
+			}
+		}
+	}
+
+	/* An inner loop has fewer blocks than the loops that contain it */
+	qsort(state->loops, state->num_loops, sizeof(_jit_loop_t), compare_loops);
+	for(loop = 0; loop < state->num_loops; loop++)
+	{
+		state->header_loop[state->loops[loop].header] = loop;
+		state->blocks[state->loops[loop].header]->loop_header = 1;
+		for(index = 0; index < state->num_blocks; index++)
+		{
+			if(_jit_bitset_test_bit(&state->loops[loop].body, index))
+			{
+				++(state->blocks[index]->loop_depth);
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+ * Find or make the preheader of a loop.  An outside block that is the
+ * only way into the header and goes nowhere else already is one.
+ * Otherwise a new block is inserted just before the header, unless a
+ * block of the loop falls through to the header or a jump table leads
+ * to it.
+ */
+static void
+make_preheader(_jit_loop_state_t *state, int loop_num)
+{
+	_jit_loop_t *loop = &state->loops[loop_num];
+	jit_block_t header, block;
+	jit_insn_t insn;
+	_jit_edge_t edge;
+	int index, num_edges, other;
+
+	header = state->blocks[loop->header];
+	num_edges = 0;
+	for(index = 0; index < header->num_preds; index++)
+	{
+		edge = header->preds[index];
+		if(edge->src->index < 0)
+		{
+			return;
+		}
+		if(!_jit_bitset_test_bit(&loop->body, edge->src->index))
+		{
+			state->edges[num_edges++] = edge;
+		}
+	}
+	if(num_edges == 0)
+	{
+		return;
+	}
+	if(num_edges == 1 && state->edges[0]->src->num_succs == 1)
+	{
+		loop->preheader = state->edges[0]->src->index;
+		return;
+	}
+
+	if(!header->prev->ends_in_dead
+	   && (header->prev->index < 0
+	       || _jit_bitset_test_bit(&loop->body, header->prev->index)))
+	{
+		return;
+	}
+	for(index = 0; index < num_edges; index++)
+	{
+		edge = state->edges[index];
+		if(edge->flags == _JIT_EDGE_FALLTHRU)
+		{
+			continue;
+		}
+		insn = _jit_block_get_last(edge->src);
+		if(edge->flags != _JIT_EDGE_BRANCH
+		   || !insn || insn->opcode < JIT_OP_BR || insn->opcode > JIT_OP_BR_NFGE_INV)
+		{
+			return;
+		}
+	}
+
+	block = _jit_block_split_edges(state->func, header, state->edges, num_edges);
+	block->index = state->num_blocks++;
+	block->loop_depth = header->loop_depth - 1;
+	state->blocks[block->index] = block;
+	state->dom_block[block->index] = loop->header;
+	loop->preheader = block->index;
+
+	/* The preheader is in every loop that contains this one */
+	for(other = loop_num + 1; other < state->num_loops; other++)
+	{
+		if(_jit_bitset_test_bit(&state->loops[other].body, loop->header))
+		{
+			_jit_bitset_set_bit(&state->loops[other].body, block->index);
+			++(state->loops[other].size);
+		}
+	}
+}
+
+/*
+ * Determine if a value keeps its value throughout a loop.
+ */
+static int
+is_invariant(_jit_loop_state_t *state, jit_value_t value)
+{
+	if(!value || value->is_constant)
+	{
+		return 1;
+	}
+	if(value->is_addressable || value->is_volatile || value->index < 0)
+	{
+		return 0;
+	}
+	if(!value->block || value->block->func != state->func)
+	{
+		return 0;
+	}
+	return state->loop_defs[value->index] == 0;
+}
+
+/*
+ * Move an instruction to the end of a preheader, before the branch that
+ * ends it if there is one.
+ */
+static int
+move_insn(jit_block_t preheader, jit_insn_t insn)
+{
+	struct _jit_insn copy;
+	jit_insn_t slot;
+
+	copy = *insn;
+	slot = _jit_block_add_insn_before_branch(preheader);
+	if(!slot)
+	{
+		return 0;
+	}
+	*slot = copy;
+	insn->opcode = JIT_OP_NOP;
+	return 1;
+}
+
+/*
+ * Move the instructions of a loop that compute the same value on every
+ * iteration into its preheader.
+ */
+static void
+hoist_invariants(_jit_loop_state_t *state, _jit_loop_t *loop)
+{
+	jit_function_t func = state->func;
+	jit_block_t block, preheader;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+	jit_value_t value;
+	int index, succ, num_exits, num_checks, clobbers, changed;
+
+	/* Count the definitions and null checks in the loop, and find out
+	   whether it writes memory or may throw otherwise and which blocks
+	   leave it */
+	for(index = 0; index < state->num_values; index++)
+	{
+		state->loop_defs[index] = 0;
+	}
+	num_checks = 0;
+	clobbers = 0;
+	num_exits = 0;
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		if(!_jit_bitset_test_bit(&loop->body, index))
+		{
+			continue;
+		}
+		block = state->blocks[index];
+		jit_insn_iter_init(&iter, block);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			value = _jit_insn_get_def(insn);
+			if(value && value->index >= 0)
+			{
+				++(state->loop_defs[value->index]);
+			}
+			if(insn->opcode == JIT_OP_CHECK_NULL)
+			{
+				++num_checks;
+			}
+			else if(!is_harmless(insn->opcode) || (value && value->is_addressable))
+			{
+				clobbers = 1;
+			}
+		}
+		for(succ = 0; succ < block->num_succs; succ++)
+		{
+			if(block->succs[succ]->dst->index < 0
+			   || !_jit_bitset_test_bit(&loop->body, block->succs[succ]->dst->index))
+			{
+				state->stack[num_exits++] = index;
+				break;
+			}
+		}
+	}
+
+	preheader = state->blocks[loop->preheader];
+	do
+	{
+		changed = 0;
+		for(index = 0; index < state->num_blocks; index++)
+		{
+			if(!_jit_bitset_test_bit(&loop->body, index))
+			{
+				continue;
+			}
+			block = state->blocks[index];
+			jit_insn_iter_init(&iter, block);
+			while((insn = jit_insn_iter_next(&iter)) != 0)
+			{
+				if(insn->opcode == JIT_OP_CHECK_NULL || is_load(insn->opcode))
+				{
+					/* Loads move once every null check has */
+					if(clobbers
+					   || (num_checks > 0 && insn->opcode != JIT_OP_CHECK_NULL))
+					{
+						continue;
+					}
+					for(succ = 0; succ < num_exits; succ++)
+					{
+						if(!dominates(state, index, state->stack[succ]))
+						{
+							break;
+						}
+					}
+					if(succ < num_exits)
+					{
+						continue;
+					}
+					if(insn->opcode == JIT_OP_CHECK_NULL)
+					{
+						if(!is_invariant(state, insn->value1))
+						{
+							continue;
+						}
+						if(!move_insn(preheader, insn))
+						{
+							return;
+						}
+						--num_checks;
+						changed = 1;
+						continue;
+					}
+				}
+				else if(!_jit_opcode_is_pure(insn->opcode))
+				{
+					continue;
+				}
+				if((insn->flags & (JIT_INSN_DEST_OTHER_FLAGS | JIT_INSN_DEST_IS_VALUE
+						   | JIT_INSN_VALUE1_OTHER_FLAGS
+						   | JIT_INSN_VALUE2_OTHER_FLAGS)) != 0)
+				{
+					continue;
+				}
+
+				/* The value must be defined only here, from values
+				   that the loop does not change */
+				value = insn->dest;
+				if(!is_candidate(func, value) || value->index < 0
+				   || state->num_defs[value->index] != 1
+				   || !is_invariant(state, insn->value1)
+				   || !is_invariant(state, insn->value2))
+				{
+					continue;
+				}
+				if(!move_insn(preheader, insn))
+				{
+					return;
+				}
+				--(state->loop_defs[value->index]);
+				changed = 1;
+
+				/* The value is now used in other blocks than the
+				   one that defines it */
+				if(value->is_temporary)
+				{
+					value->is_temporary = 0;
+					value->is_local = 1;
+					if(_jit_gen_is_global_candidate(value->type))
+					{
+						value->global_candidate = 1;
+					}
+				}
+			}
+		}
+	}
+	while(changed);
+}
+
+/*
+ * Replace an operand with the variable that stands for it in a loop.
+ */
+static jit_value_t
+split_operand(_jit_loop_state_t *state, jit_value_t value)
+{
+	if(value && value->index >= 0 && state->splits[value->index])
+	{
+		return state->splits[value->index];
+	}
+	return value;
+}
+
+/*
+ * Add a copy of a value to the start of a block.
+ */
+static int
+add_copy_at_start(jit_block_t block, int opcode, jit_value_t dest, jit_value_t value)
+{
+	jit_insn_t insn;
+
+	insn = _jit_block_add_insn(block);
+	if(!insn)
+	{
+		return 0;
+	}
+	jit_memmove(block->insns + 1, block->insns,
+		    (block->num_insns - 1) * sizeof(struct _jit_insn));
+	insn = &block->insns[0];
+	jit_memzero(insn, sizeof(struct _jit_insn));
+	insn->opcode = (short) opcode;
+	insn->dest = dest;
+	insn->value1 = value;
+	return 1;
+}
+
+/*
+ * Split the live ranges of the variables that a loop uses and that are
+ * also read outside of it.  The loop uses a new variable instead, which
+ * gets the value of the old one in the preheader and, if the loop
+ * changes it, gives it back at the start of every block that the loop
+ * exits to.  The global register allocator may then give a register to
+ * the new variable for the loop alone and leave the old one in the frame
+ * elsewhere, or the other way around.  Variables that the loop changes
+ * are split only if each exit leads to a block that is entered from
+ * nowhere else.
+ */
+static void
+split_live_ranges(_jit_loop_state_t *state, _jit_loop_t *loop)
+{
+	jit_block_t block, preheader;
+	jit_insn_iter_t iter;
+	jit_insn_t insn;
+	jit_value_t value, copy;
+	int index, succ, num_exits, num_splits, opcode;
+
+	/* Count the uses in the loop and find the blocks that it exits to */
+	for(index = 0; index < state->num_values; index++)
+	{
+		state->loop_uses[index] = 0;
+	}
+	num_exits = 0;
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		if(!_jit_bitset_test_bit(&loop->body, index))
+		{
+			continue;
+		}
+		block = state->blocks[index];
+		jit_insn_iter_init(&iter, block);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			count_uses(insn, state->loop_uses);
+		}
+		for(succ = 0; succ < block->num_succs && num_exits >= 0; succ++)
+		{
+			if(block->succs[succ]->dst->index >= 0
+			   && _jit_bitset_test_bit(&loop->body, block->succs[succ]->dst->index))
+			{
+				continue;
+			}
+			if(block->succs[succ]->dst->index < 0
+			   || block->succs[succ]->dst->num_preds != 1)
+			{
+				num_exits = -1;
+				break;
+			}
+			state->stack[num_exits++] = block->succs[succ]->dst->index;
+		}
+	}
+
+	preheader = state->blocks[loop->preheader];
+	num_splits = 0;
+	for(index = 0; index < state->num_values; index++)
+	{
+		state->splits[index] = 0;
+		value = state->values[index];
+		if((state->loop_uses[index] == 0 && state->loop_defs[index] == 0)
+		   || (state->loop_defs[index] != 0 && num_exits < 0)
+		   || state->num_uses[index] <= state->loop_uses[index]
+		   || !is_candidate(state->func, value)
+		   || !value->is_local || !value->global_candidate)
+		{
+			continue;
+		}
+		opcode = _jit_store_opcode(JIT_OP_COPY_INT, JIT_OP_COPY_STORE_BYTE, value->type);
+		copy = jit_value_create(state->func, value->type);
+		if(!opcode || !copy)
+		{
+			continue;
+		}
+		insn = _jit_block_add_insn_before_branch(preheader);
+		if(!insn)
+		{
+			return;
+		}
+		insn->opcode = (short) opcode;
+		insn->dest = copy;
+		insn->value1 = value;
+		if(state->loop_defs[index] != 0)
+		{
+			for(succ = 0; succ < num_exits; succ++)
+			{
+				if(!add_copy_at_start(state->blocks[state->stack[succ]],
+						      opcode, value, copy))
+				{
+					return;
+				}
+			}
+			state->num_defs[index] += num_exits - state->loop_defs[index];
+		}
+
+		/* Count the uses like the builder does, so that both variables
+		   may get a global register */
+		copy->is_temporary = 0;
+		copy->is_local = 1;
+		copy->global_candidate = 1;
+		copy->usage_count = state->loop_uses[index] + state->loop_defs[index] + 1;
+		value->usage_count += 1 - state->loop_uses[index] - state->loop_defs[index];
+		state->num_uses[index] += 1 - state->loop_uses[index];
+		if(state->loop_defs[index] != 0)
+		{
+			copy->usage_count += num_exits;
+			value->usage_count += num_exits;
+		}
+		state->splits[index] = copy;
+		++num_splits;
+	}
+	if(num_splits == 0)
+	{
+		return;
+	}
+
+	/* Make the loop use the new variables */
+	for(index = 0; index < state->num_blocks; index++)
+	{
+		if(!_jit_bitset_test_bit(&loop->body, index))
+		{
+			continue;
+		}
+		block = state->blocks[index];
+		jit_insn_iter_init(&iter, block);
+		while((insn = jit_insn_iter_next(&iter)) != 0)
+		{
+			if(insn->opcode == JIT_OP_NOP)
+			{
+				continue;
+			}
+			if((insn->flags & JIT_INSN_DEST_OTHER_FLAGS) == 0)
+			{
+				insn->dest = split_operand(state, insn->dest);
+			}
+			if((insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) == 0)
+			{
+				insn->value1 = split_operand(state, insn->value1);
+			}
+			if((insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) == 0)
+			{
+				insn->value2 = split_operand(state, insn->value2);
+			}
+		}
+	}
+}
+
+int
+_jit_function_optimize_loops(jit_function_t func)
+{
+	_jit_loop_state_t state;
+	int pass, loop, result;
+
+	for(pass = 0; ; pass++)
+	{
+		jit_memzero(&state, sizeof(state));
+		state.func = func;
+		if(!number_blocks_and_values(&state))
+		{
+			free_state(&state);
+			return 0;
+		}
+		compute_dominators(&state);
+
+		/* Folded branches leave blocks behind that cannot be reached,
+		   so the control flow graph is cleaned and analyzed again */
+		if(pass > 0 || !eliminate_checks(&state))
+		{
+			break;
+		}
+		free_state(&state);
+		_jit_block_clean_cfg(func);
+	}
+	result = 0;
+	if(!find_loops(&state))
+	{
+		free_state(&state);
+		return 0;
+	}
+
+	for(loop = 0; loop < state.num_loops; loop++)
+	{
+		make_preheader(&state, loop);
+		if(state.loops[loop].preheader >= 0)
+		{
+			hoist_invariants(&state, &state.loops[loop]);
+			_jit_function_forward_loop_accesses(
+				func, state.blocks[state.loops[loop].preheader],
+				state.blocks[state.loops[loop].header]);
+			split_live_ranges(&state, &state.loops[loop]);
+		}
+	}
+
+	/* Keep the block order up to date with the new preheaders */
+	if(state.num_blocks > state.num_old_blocks)
+	{
+		if(!_jit_block_compute_postorder(func))
+		{
+			free_state(&state);
+			jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+		}
+		result = 1;
+	}
+	free_state(&state);
+	return result;
+}
@@ -52,18 +52,93 @@ extern	"C" {
 #endif
 
 /*
- * Method information block, organised as a red-black tree node.
- * There may be more than one such block associated with a method
- * if the method contains exception regions.
+ * Tune the size of the address space that is reserved for the cache up
+ * front, and how far it may be from the code of the library.  Calls
+ * between functions in the reserved space, and from them to the
+ * runtime helpers, can then use 32-bit relative call instructions.
+ */
+#ifndef JIT_CACHE_RESERVE_SIZE
+#define JIT_CACHE_RESERVE_SIZE		(128 * 1024 * 1024)
+#endif
+#ifndef JIT_CACHE_MAX_RESERVE_SIZE
+#define JIT_CACHE_MAX_RESERVE_SIZE	(1024 * 1024 * 1024)
+#endif
+#ifndef JIT_CACHE_RESERVE_RANGE
+#define JIT_CACHE_RESERVE_RANGE		((jit_nuint) 1024 * 1024 * 1024)
+#endif
+
+#ifndef JIT_CACHE_NUM_REGIONS
+#define JIT_CACHE_NUM_REGIONS		8
+#endif
+
+/*
+ * Tune the lookup tables of functions that were not added at the end
+ * of the address range.  The smallest one holds up to this many entries
+ * and is copied for each function that is added to it.  Each of the
+ * others holds up to twice as many as the one before it.
+ */
+#ifndef JIT_CACHE_RECENT_RANGES
+#define JIT_CACHE_RECENT_RANGES		64
+#endif
+#ifndef JIT_CACHE_NUM_RUNS
+#define JIT_CACHE_NUM_RUNS		16
+#endif
+
+/*
+ * Method information block.  There may be more than one such block
+ * associated with a method if the method contains exception regions.
  */
 typedef struct jit_cache_node *jit_cache_node_t;
 struct jit_cache_node
 {
-	jit_cache_node_t	left;		/* Left sub-tree and red/black bit */
-	jit_cache_node_t	right;		/* Right sub-tree */
 	unsigned char		*start;		/* Start of the cache region */
 	unsigned char		*end;		/* End of the cache region */
+	unsigned char		*data_start;	/* Start of the auxiliary data */
+	unsigned char		*data_end;	/* End of the auxiliary data */
 	jit_function_t		func;		/* Function info block slot */
+	jit_cache_node_t	next;		/* Next node waiting to be freed */
+	unsigned long		epoch;		/* Epoch that the code was freed at */
+};
+
+/*
+ * Entry of the lookup table.  The bounds are copied out of the node,
+ * so that searching does not touch the nodes.  "node" is cleared when
+ * the code of the function is freed.
+ */
+struct jit_cache_range
+{
+	unsigned char		*start;		/* Start of the code */
+	unsigned char		*end;		/* End of the code */
+	jit_cache_node_t	node;		/* Node of the function, or null */
+};
+
+/*
+ * Lookup table sorted by start address.  Published tables are only
+ * changed by clearing "node" in their entries, and by adding entries
+ * past "num" before "num" is raised.  They are freed when no lookup may
+ * still be reading them.
+ */
+typedef struct jit_cache_table *jit_cache_table_t;
+struct jit_cache_table
+{
+	unsigned long		num;		/* Number of entries */
+	unsigned long		max;		/* Number of entries there is room for */
+	unsigned long		cleared;	/* Number of entries with no node */
+	jit_cache_table_t	next;		/* Next table waiting to be freed */
+	unsigned long		epoch;		/* Epoch that the table was replaced at */
+	struct jit_cache_range	ranges[1];	/* Entries, by start address */
+};
+
+/*
+ * Free block within a cache page.  Free blocks are kept out of line,
+ * so that freeing code does not touch the pages.
+ */
+typedef struct jit_cache_block *jit_cache_block_t;
+struct jit_cache_block
+{
+	unsigned char		*start;		/* Start of the free block */
+	unsigned char		*end;		/* End of the free block */
+	jit_cache_block_t	next;		/* Next free block by address */
 };
 
 /*
@@ -73,64 +148,624 @@ struct jit_cache_page
 {
 	void			*page;		/* Page memory */
 	long			factor;		/* Page size factor */
+	unsigned long		free_size;	/* Number of bytes in free blocks */
+	unsigned long		largest;	/* Size of the largest free block */
+	jit_cache_block_t	free;		/* Free blocks sorted by address */
+	unsigned long		hugetlb;	/* Number of explicit huge pages */
+};
+
+/*
+ * Stack of freed blocks of one fixed size, such as trampolines.
+ */
+struct jit_cache_slots
+{
+	void			**items;	/* Freed blocks */
+	unsigned long		num;		/* Number of freed blocks */
+	unsigned long		max;		/* Size of the stack */
 };
 
 /*
  * Structure of the method cache.
  */
+typedef struct jit_cache_region *jit_cache_region_t;
+struct jit_cache_region
+{
+	jit_mutex_t		lock;		/* Held while a function is being written */
+	unsigned char		*page;		/* Page that holds the free region */
+	long			factor;		/* Page size factor of that page */
+	unsigned char		*free_start;	/* Current start of the free region */
+	unsigned char		*free_end;	/* Current end of the free region */
+	unsigned char		*prev_start;	/* Previous start of the free region */
+	unsigned char		*prev_end;	/* Previous end of the free region */
+	jit_cache_node_t	node;		/* Information for the current function */
+	unsigned long		need;		/* Smallest free block worth moving to */
+};
+
 typedef struct jit_cache *jit_cache_t;
 struct jit_cache
 {
-	struct jit_cache_page	*pages;		/* List of pages currently in the cache */
+	jit_mutex_t		lock;		/* Protects the pages, free blocks and lookup table */
+	struct jit_cache_page	*pages;		/* Pages currently in the cache, by address */
 	unsigned long		numPages;	/* Number of pages currently in the cache */
 	unsigned long		maxNumPages;	/* Maximum number of pages that could be in the list */
 	unsigned long		pageSize;	/* Default size of a page for allocation */
 	unsigned int		maxPageFactor;	/* Maximum page size factor */
-	long			pagesLeft;	/* Number of pages left to allocate */
-	unsigned char		*free_start;	/* Current start of the free region */
-	unsigned char		*free_end;	/* Current end of the free region */
-	unsigned char		*prev_start;	/* Previous start of the free region */
-	unsigned char		*prev_end;	/* Previous end of the free region */
-	jit_cache_node_t	node;		/* Information for the current function */
-	struct jit_cache_node	head;		/* Head of the lookup tree */
-	struct jit_cache_node	nil;		/* Nil pointer for the lookup tree */
+	unsigned long		usedPages;	/* Number of default size pages allocated */
+	jit_context_t		context;	/* Context that holds the cache limit */
+	unsigned long		freeSize;	/* Number of bytes in the free blocks of all pages */
+	struct jit_cache_slots	trampolines;	/* Freed trampolines */
+	struct jit_cache_slots	closures;	/* Freed closures */
+	struct jit_cache_region	regions[JIT_CACHE_NUM_REGIONS]; /* Per-thread free regions */
+	struct jit_cache_region	stubs;		/* Free region for trampolines and closures */
+	jit_cache_table_t	table;		/* Lookup table that functions are appended to */
+	jit_cache_table_t	runs[JIT_CACHE_NUM_RUNS]; /* Lookup tables of the others, by size */
+	jit_cache_table_t	retired;	/* Tables replaced but maybe in use */
+	jit_cache_node_t	retiredNodes;	/* Freed code that may still be in use */
+	unsigned long		retiredEpoch;	/* Epoch of the last retired table or node */
+	int			numRetired;	/* Number of retired tables and nodes */
+	unsigned long		retiredSize;	/* Number of bytes held by retired nodes */
+	unsigned char		*reserve;	/* Address space reserved for the pages */
+	unsigned long		reserveSize;	/* Size of the reserved address space */
+	unsigned long		reserveTop;	/* Offset of the reserve not used so far */
+	jit_cache_block_t	reserveFree;	/* Released parts of the reserve, by address */
+	unsigned long		hugePageSize;	/* Size of a huge page, or zero */
+	unsigned long		hugetlbPages;	/* Number of explicit huge pages */
+	int			sharedFd;	/* Memory object behind both views, or -1 */
+	unsigned char		*writeReserve;	/* Writable view of the reserve */
 };
 
+void _jit_cache_destroy(jit_cache_t cache);
+void * _jit_cache_alloc_data(jit_cache_t cache, unsigned long size, unsigned long align);
+static void ReclaimRetired(jit_cache_t cache);
+
 /*
- * Get or set the sub-trees of a node.
+ * Get the free region that the current thread writes code to.
  */
-#define	GetLeft(node)	\
-	((jit_cache_node_t)(((jit_nuint)(node)->left) & ~((jit_nuint)1)))
-#define	GetRight(node)	\
-	((node)->right)
-#define	SetLeft(node,value)	\
-	((node)->left = (jit_cache_node_t)(((jit_nuint)value) | \
-						(((jit_nuint)(node)->left) & ((jit_nuint)1))))
-#define	SetRight(node,value)	\
-	((node)->right = (value))
+static jit_cache_region_t
+GetRegion(jit_cache_t cache)
+{
+	return &cache->regions[_jit_thread_get_index() % JIT_CACHE_NUM_REGIONS];
+}
 
 /*
- * Get or set the red/black state of a node.
+ * Get the index of the first page that starts after "ptr".
  */
-#define	GetRed(node)	\
-	((((jit_nuint)((node)->left)) & ((jit_nuint)1)) != 0)
-#define	SetRed(node)	\
-	((node)->left = (jit_cache_node_t)(((jit_nuint)(node)->left) | ((jit_nuint)1)))
-#define	SetBlack(node)	\
-	((node)->left = (jit_cache_node_t)(((jit_nuint)(node)->left) & ~((jit_nuint)1)))
+static unsigned long
+FindPageAfter(jit_cache_t cache, unsigned char *ptr)
+{
+	unsigned long low = 0;
+	unsigned long high = cache->numPages;
+	unsigned long middle;
 
-void _jit_cache_destroy(jit_cache_t cache);
-void * _jit_cache_alloc_data(jit_cache_t cache, unsigned long size, unsigned long align);
+	while(low < high)
+	{
+		middle = low + (high - low) / 2;
+		if(((unsigned char *) cache->pages[middle].page) <= ptr)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low;
+}
+
+/*
+ * Find the page that contains "ptr".  The cache lock must be held.
+ */
+static struct jit_cache_page *
+FindPage(jit_cache_t cache, unsigned char *ptr)
+{
+	unsigned long index = FindPageAfter(cache, ptr);
+	struct jit_cache_page *page;
+
+	if(index == 0)
+	{
+		return 0;
+	}
+	page = &(cache->pages[index - 1]);
+	if(ptr >= ((unsigned char *) page->page) + cache->pageSize * page->factor)
+	{
+		return 0;
+	}
+	return page;
+}
+
+/*
+ * Give the range between "ptr" and "ptr + size" back to the reserved
+ * address space, merging it with the released parts next to it.  The
+ * cache lock must be held.
+ */
+static void
+ReturnReserve(jit_cache_t cache, unsigned char *ptr, unsigned long size)
+{
+	jit_cache_block_t block;
+	jit_cache_block_t *prev;
+	jit_cache_block_t next;
+
+	/* Find the released parts before and after the range */
+	for(prev = &cache->reserveFree; (block = *prev) != 0; prev = &block->next)
+	{
+		if(block->end >= ptr)
+		{
+			break;
+		}
+	}
+	if(block && block->end == ptr)
+	{
+		block->end += size;
+		next = block->next;
+		if(next && next->start == block->end)
+		{
+			block->end = next->end;
+			block->next = next->next;
+			jit_free(next);
+		}
+	}
+	else if(block && block->start == ptr + size)
+	{
+		block->start = ptr;
+	}
+	else
+	{
+		next = jit_cnew(struct jit_cache_block);
+		if(!next)
+		{
+			/* The range is lost until the cache is destroyed */
+			return;
+		}
+		next->start = ptr;
+		next->end = ptr + size;
+		next->next = block;
+		*prev = next;
+		block = next;
+	}
+
+	/* The last released part goes back to the unused top */
+	if(!block->next && block->end == cache->reserve + cache->reserveTop)
+	{
+		cache->reserveTop = block->start - cache->reserve;
+		*prev = 0;
+		jit_free(block);
+	}
+}
+
+/*
+ * Take "size" bytes aligned to "align" from the reserved address space,
+ * reusing the parts that were released first.  The cache lock must be
+ * held.
+ */
+static unsigned char *
+TakeReserve(jit_cache_t cache, unsigned long size, unsigned long align)
+{
+	jit_cache_block_t block;
+	jit_cache_block_t *prev;
+	jit_cache_block_t tail;
+	unsigned char *ptr;
+	unsigned char *top;
+
+	for(prev = &cache->reserveFree; (block = *prev) != 0; prev = &block->next)
+	{
+		ptr = (unsigned char *)
+			((((jit_nuint) block->start) + align - 1) & ~((jit_nuint) align - 1));
+		if(ptr + size > block->end)
+		{
+			continue;
+		}
+		if(ptr == block->start && ptr + size == block->end)
+		{
+			*prev = block->next;
+			jit_free(block);
+		}
+		else if(ptr == block->start)
+		{
+			block->start += size;
+		}
+		else if(ptr + size == block->end)
+		{
+			block->end = ptr;
+		}
+		else
+		{
+			tail = jit_cnew(struct jit_cache_block);
+			if(!tail)
+			{
+				continue;
+			}
+			tail->start = ptr + size;
+			tail->end = block->end;
+			tail->next = block->next;
+			block->end = ptr;
+			block->next = tail;
+		}
+		return ptr;
+	}
+
+	top = cache->reserve + cache->reserveTop;
+	ptr = (unsigned char *)
+		((((jit_nuint) top) + align - 1) & ~((jit_nuint) align - 1));
+	if(ptr + size > cache->reserve + cache->reserveSize)
+	{
+		return 0;
+	}
+	cache->reserveTop = (ptr + size) - cache->reserve;
+	if(ptr > top)
+	{
+		ReturnReserve(cache, top, ptr - top);
+	}
+	return ptr;
+}
+
+/*
+ * Get the offset from the address that code runs at to the address that
+ * it is written to, which is zero unless the cache is mapped twice.
+ */
+static jit_nint
+WriteOffset(jit_cache_t cache)
+{
+	if(cache->sharedFd < 0)
+	{
+		return 0;
+	}
+	return cache->writeReserve - cache->reserve;
+}
+
+/*
+ * Get "size" bytes of executable memory for "page".  Pages are committed
+ * from the reserved address space while it lasts.  Huge pages are taken
+ * from the system pool if it has any, and asked for as transparent huge
+ * pages if not.  The cache lock must be held.
+ */
+static unsigned char *
+AllocPageMemory(jit_cache_t cache, struct jit_cache_page *page,
+		unsigned long size, int huge)
+{
+	unsigned char *ptr;
+
+	page->hugetlb = 0;
+	if(cache->sharedFd >= 0)
+	{
+		/* The pages are never writable and executable at the same
+		   address, so there is no fallback to _jit_malloc_exec */
+		ptr = TakeReserve(cache, size, cache->pageSize);
+		if(!ptr)
+		{
+			return 0;
+		}
+		if(jit_vmem_commit_shared(ptr, size, JIT_PROT_EXEC_READ,
+					  cache->sharedFd, ptr - cache->reserve) &&
+		   jit_vmem_commit_shared(ptr + WriteOffset(cache),
+					  size, JIT_PROT_READ_WRITE,
+					  cache->sharedFd, ptr - cache->reserve))
+		{
+			return ptr;
+		}
+		jit_vmem_decommit(ptr, (jit_uint) size);
+		jit_vmem_decommit(ptr + WriteOffset(cache), (jit_uint) size);
+		ReturnReserve(cache, ptr, size);
+		return 0;
+	}
+	if(cache->reserve)
+	{
+		ptr = TakeReserve(cache, size, huge ? cache->hugePageSize : cache->pageSize);
+		if(ptr && huge && jit_vmem_commit_huge(ptr, size, JIT_PROT_EXEC_READ_WRITE))
+		{
+			page->hugetlb = size / cache->hugePageSize;
+			cache->hugetlbPages += page->hugetlb;
+			return ptr;
+		}
+		if(ptr && jit_vmem_commit(ptr, size, JIT_PROT_EXEC_READ_WRITE))
+		{
+			if(huge)
+			{
+				jit_vmem_advise_huge(ptr, size);
+			}
+			return ptr;
+		}
+		if(ptr)
+		{
+			ReturnReserve(cache, ptr, size);
+		}
+	}
+	return (unsigned char *) _jit_malloc_exec((unsigned int) size);
+}
 
 /*
- * Allocate a cache page and add it to the cache.
+ * Give the memory of "page" back to the system.  Parts of the reserved
+ * address space are decommitted and kept for later pages.  The cache
+ * lock must be held.
  */
 static void
-AllocCachePage(jit_cache_t cache, int factor)
+FreePageMemory(jit_cache_t cache, struct jit_cache_page *page)
+{
+	unsigned char *ptr = (unsigned char *) page->page;
+	unsigned long size = cache->pageSize * page->factor;
+
+	if(ptr < cache->reserve || ptr >= cache->reserve + cache->reserveSize)
+	{
+		_jit_free_exec(ptr, (unsigned int) size);
+		return;
+	}
+	if(cache->sharedFd >= 0)
+	{
+		jit_vmem_discard_shared(ptr + WriteOffset(cache),
+					(jit_uint) size);
+		jit_vmem_decommit(ptr + WriteOffset(cache),
+				  (jit_uint) size);
+	}
+	jit_vmem_decommit(ptr, (jit_uint) size);
+	cache->hugetlbPages -= page->hugetlb;
+	ReturnReserve(cache, ptr, size);
+}
+
+/*
+ * Determine if new pages should be huge pages.  The option is read every
+ * time, so that it can be set after the cache was created.
+ */
+static int
+UseHugePages(jit_cache_t cache)
+{
+	return cache->hugePageSize && cache->reserve && cache->sharedFd < 0 &&
+		jit_context_get_meta_numeric(cache->context, JIT_OPTION_CACHE_HUGE_PAGES);
+}
+
+/*
+ * Remove an empty page from the cache and give it back to the system.
+ * The cache lock must be held.
+ */
+static void
+ReleasePage(jit_cache_t cache, struct jit_cache_page *page)
+{
+	jit_cache_block_t block;
+	jit_cache_block_t next;
+	unsigned long index = page - cache->pages;
+
+	for(block = page->free; block; block = next)
+	{
+		next = block->next;
+		jit_free(block);
+	}
+	cache->freeSize -= page->free_size;
+	cache->usedPages -= page->factor;
+	FreePageMemory(cache, page);
+
+	--(cache->numPages);
+	jit_memmove(page, page + 1,
+		    (cache->numPages - index) * sizeof(struct jit_cache_page));
+}
+
+/*
+ * Give the memory between "start" and "end" back to its page, merging
+ * it with the free blocks next to it.  The page is released once all
+ * of it is free.  The cache lock must be held.
+ */
+static void
+FreeBlock(jit_cache_t cache, unsigned char *start, unsigned char *end)
+{
+	struct jit_cache_page *page;
+	jit_cache_block_t block;
+	jit_cache_block_t prev;
+	jit_cache_block_t next;
+
+	if(start >= end || (page = FindPage(cache, start)) == 0)
+	{
+		return;
+	}
+
+	/* Find the free blocks around the block */
+	prev = 0;
+	next = page->free;
+	while(next && next->start < start)
+	{
+		prev = next;
+		next = next->next;
+	}
+
+	if(prev && prev->end == start)
+	{
+		/* Extend the previous block */
+		block = prev;
+		block->end = end;
+	}
+	else
+	{
+		/* If there is no memory to record the block, then it is
+		   only lost until the context is destroyed */
+		block = jit_new(struct jit_cache_block);
+		if(!block)
+		{
+			return;
+		}
+		block->start = start;
+		block->end = end;
+		block->next = next;
+		if(prev)
+		{
+			prev->next = block;
+		}
+		else
+		{
+			page->free = block;
+		}
+	}
+	if(next && next->start == block->end)
+	{
+		/* Merge with the next block */
+		block->end = next->end;
+		block->next = next->next;
+		jit_free(next);
+	}
+
+	page->free_size += end - start;
+	cache->freeSize += end - start;
+	if((unsigned long) (block->end - block->start) > page->largest)
+	{
+		page->largest = block->end - block->start;
+	}
+	if(page->free_size == cache->pageSize * page->factor)
+	{
+		ReleasePage(cache, page);
+	}
+}
+
+/*
+ * Give the rest of the free region of "region" back to its page.
+ * The cache lock must be held.
+ */
+static void
+RetireRegion(jit_cache_t cache, jit_cache_region_t region)
+{
+	if(region->free_start < region->free_end)
+	{
+		FreeBlock(cache, region->free_start, region->free_end);
+	}
+	region->page = 0;
+	region->factor = 0;
+	region->free_start = 0;
+	region->free_end = 0;
+}
+
+/*
+ * Find the page with the largest free block, if that block has at
+ * least "size" bytes.  The cache lock must be held.
+ */
+static struct jit_cache_page *
+FindLargestBlock(jit_cache_t cache, unsigned long size)
+{
+	struct jit_cache_page *best = 0;
+	unsigned long index;
+
+	if(cache->freeSize < size)
+	{
+		return 0;
+	}
+	for(index = 0; index < cache->numPages; ++index)
+	{
+		if(cache->pages[index].largest >= size
+		   && (!best || cache->pages[index].largest > best->largest))
+		{
+			best = &(cache->pages[index]);
+		}
+	}
+	return best;
+}
+
+/*
+ * Make the largest free block the free region of "region", if it has
+ * at least "size" bytes.  The previous free region is given back.
+ * The cache lock must be held.
+ */
+static int
+TakeFreeBlock(jit_cache_t cache, jit_cache_region_t region, unsigned long size)
+{
+	struct jit_cache_page *page;
+	jit_cache_block_t block;
+	jit_cache_block_t prev;
+
+	if(!FindLargestBlock(cache, size))
+	{
+		return 0;
+	}
+
+	/* Giving the free region back may merge or release blocks,
+	   so look for the largest block again afterwards */
+	RetireRegion(cache, region);
+	page = FindLargestBlock(cache, size);
+	if(!page)
+	{
+		return 0;
+	}
+
+	/* Unlink the block */
+	prev = 0;
+	block = page->free;
+	while((unsigned long) (block->end - block->start) != page->largest)
+	{
+		prev = block;
+		block = block->next;
+	}
+	if(prev)
+	{
+		prev->next = block->next;
+	}
+	else
+	{
+		page->free = block->next;
+	}
+	page->free_size -= page->largest;
+	cache->freeSize -= page->largest;
+
+	/* Set up the working region within the block */
+	region->page = page->page;
+	region->factor = page->factor;
+	region->free_start = block->start;
+	region->free_end = block->end;
+	jit_free(block);
+
+	/* Find the next largest block of the page */
+	page->largest = 0;
+	for(block = page->free; block; block = block->next)
+	{
+		if((unsigned long) (block->end - block->start) > page->largest)
+		{
+			page->largest = block->end - block->start;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Get the number of pages left before the cache limit is hit, or -1
+ * if there is no limit.  The limit is read every time, so that it can
+ * be changed after the cache was created.  Freed code that is waiting
+ * for the calls that may run it to return is not counted.  A thread
+ * that is in compiled code itself may be what it waits for, so then
+ * there is no limit at all until that code was reused.
+ */
+static long
+GetPagesLeft(jit_cache_t cache)
+{
+	unsigned long used;
+	long limit;
+
+	limit = (long)
+		jit_context_get_meta_numeric(cache->context, JIT_OPTION_CACHE_LIMIT);
+	if(limit <= 0 || (cache->retiredSize != 0 && _jit_epoch_is_inside()))
+	{
+		return -1;
+	}
+	limit /= (long) cache->pageSize;
+	if(limit < 1)
+	{
+		limit = 1;
+	}
+	used = (cache->retiredSize + cache->pageSize - 1) / cache->pageSize;
+	used = (used < cache->usedPages) ? cache->usedPages - used : 0;
+	if((unsigned long) limit <= used)
+	{
+		return 0;
+	}
+	return limit - (long) used;
+}
+
+/*
+ * Give "region" a new free region of at least "factor" pages: the
+ * largest free block if it is big enough, or else a newly allocated
+ * cache page.  The rest of the previous free region is given back.
+ */
+static void
+AllocCachePage(jit_cache_t cache, jit_cache_region_t region, int factor)
 {
 	long num;
+	long pagesLeft;
+	long huge_factor;
+	int huge;
+	unsigned long index;
 	unsigned char *ptr;
 	struct jit_cache_page *list;
+	struct jit_cache_page page;
 
 	/* The minimum page factor is 1 */
 	if(factor <= 0)
@@ -138,23 +773,50 @@ AllocCachePage(jit_cache_t cache, int factor)
 		factor = 1;
 	}
 
+	jit_mutex_lock(&cache->lock);
+
+	/* Reuse freed memory if possible, including code that was freed
+	   while it could still be running */
+	ReclaimRetired(cache);
+	if(TakeFreeBlock(cache, region, cache->pageSize * factor))
+	{
+		jit_mutex_unlock(&cache->lock);
+		return;
+	}
+	RetireRegion(cache, region);
+
 	/* If too big a page is requested, then bail out */
 	if(((unsigned int) factor) > cache->maxPageFactor)
 	{
 		goto failAlloc;
 	}
 
-	/* If the page limit is hit, then bail out */
-	if(cache->pagesLeft >= 0 && cache->pagesLeft < factor)
+	/* If the page limit is hit, then make do with a smaller free
+	   block, as long as it is bigger than the one that was too small */
+	pagesLeft = GetPagesLeft(cache);
+	if(pagesLeft >= 0 && pagesLeft < factor)
 	{
-		goto failAlloc;
+		TakeFreeBlock(cache, region, region->need ? region->need : 1);
+		jit_mutex_unlock(&cache->lock);
+		return;
 	}
 
-	/* Try to allocate a physical page */
-	ptr = (unsigned char *) _jit_malloc_exec((unsigned int) cache->pageSize * factor);
-	if(!ptr)
+	/* Huge pages are allocated whole, as long as the limit allows */
+	huge = UseHugePages(cache);
+	if(huge)
 	{
-		goto failAlloc;
+		huge_factor = (long) ((cache->pageSize * factor + cache->hugePageSize - 1)
+				      / cache->hugePageSize * cache->hugePageSize
+				      / cache->pageSize);
+		if((pagesLeft >= 0 && pagesLeft < huge_factor) ||
+		   huge_factor > (long) cache->maxPageFactor)
+		{
+			huge = 0;
+		}
+		else
+		{
+			factor = (int) huge_factor;
+		}
 	}
 
 	/* Add the page to the page list.  We keep this in an array
@@ -172,217 +834,518 @@ AllocCachePage(jit_cache_t cache, int factor)
 		{
 			num = cache->numPages * 2;
 		}
-		if(cache->pagesLeft > 0 && num > (cache->numPages + cache->pagesLeft - factor + 1))
-		{
-			num = cache->numPages + cache->pagesLeft - factor + 1;
-		}
 
 		list = (struct jit_cache_page *) jit_realloc(cache->pages,
 							     sizeof(struct jit_cache_page) * num);
 		if(!list)
 		{
-			_jit_free_exec(ptr, cache->pageSize * factor);
-		failAlloc:
-			cache->free_start = 0;
-			cache->free_end = 0;
-			return;
+			goto failAlloc;
 		}
 
 		cache->maxNumPages = num;
 		cache->pages = list;
 	}
-	cache->pages[cache->numPages].page = ptr;
-	cache->pages[cache->numPages].factor = factor;
+
+	/* Try to allocate a physical page */
+	ptr = AllocPageMemory(cache, &page, cache->pageSize * factor, huge);
+	if(!ptr)
+	{
+	failAlloc:
+		jit_mutex_unlock(&cache->lock);
+		return;
+	}
+
+	/* The list is sorted by address, so that pages can be found
+	   by binary search when memory is freed */
+	index = FindPageAfter(cache, ptr);
+	jit_memmove(&(cache->pages[index + 1]), &(cache->pages[index]),
+		    (cache->numPages - index) * sizeof(struct jit_cache_page));
+	cache->pages[index].page = ptr;
+	cache->pages[index].factor = factor;
+	cache->pages[index].free_size = 0;
+	cache->pages[index].largest = 0;
+	cache->pages[index].free = 0;
+	cache->pages[index].hugetlb = page.hugetlb;
 	++(cache->numPages);
 
-	/* Adjust te number of pages left before we hit the limit */
-	if(cache->pagesLeft > 0)
+	/* Adjust te number of pages used towards the limit */
+	cache->usedPages += factor;
+
+	jit_mutex_unlock(&cache->lock);
+
+	/* Set up the working region within the new page */
+	region->page = ptr;
+	region->factor = factor;
+	region->free_start = ptr;
+	region->free_end = ptr + (int) cache->pageSize * factor;
+}
+
+/*
+ * Get the index of the first entry of "table" that starts after "pc".
+ * The search halves the range without branching on the comparison,
+ * which cannot be predicted for lookups from all over the code.
+ */
+static unsigned long
+FindRangeAfter(jit_cache_table_t table, unsigned char *pc)
+{
+	unsigned long num = table ? jit_atomic_load(&table->num) : 0;
+	const struct jit_cache_range *base;
+	unsigned long half;
+
+	if(num == 0)
+	{
+		return 0;
+	}
+	base = table->ranges;
+	while(num > 1)
 	{
-		cache->pagesLeft -= factor;
+		half = num / 2;
+		base = (base[half].start <= pc) ? base + half : base;
+		num -= half;
 	}
+	return (base - table->ranges) + (base->start <= pc);
+}
+
+/*
+ * Allocate a lookup table with room for "max" entries.
+ */
+static jit_cache_table_t
+AllocTable(unsigned long max)
+{
+	jit_cache_table_t table;
+
+	table = (jit_cache_table_t) jit_malloc(
+		offsetof(struct jit_cache_table, ranges) +
+		sizeof(struct jit_cache_range) * (max ? max : 1));
+	if(table)
+	{
+		table->num = 0;
+		table->max = max;
+		table->cleared = 0;
+		table->next = 0;
+	}
+	return table;
+}
+
+/*
+ * Get the number of entries of "table" that still have a node.
+ */
+static unsigned long
+LiveRanges(jit_cache_table_t table)
+{
+	return table ? table->num - table->cleared : 0;
+}
+
+/*
+ * Get the room to leave in the main lookup table for "num" entries.  It
+ * is doubled whenever the table fills, so that appending to it costs
+ * amortized constant time.
+ */
+static unsigned long
+MainTableSize(unsigned long num)
+{
+	unsigned long max = JIT_CACHE_RECENT_RANGES;
+
+	while(max < num)
+	{
+		max *= 2;
+	}
+	return max;
+}
+
+/*
+ * Free the replaced lookup tables, and the code and auxiliary data of
+ * freed functions, that no lookup or call may still be reading.  The
+ * lists are ordered from the newest entry to the oldest, so everything
+ * after the first entry that is safe to free is safe as well.  The
+ * cache lock must be held.
+ */
+static void
+ReclaimRetired(jit_cache_t cache)
+{
+	jit_cache_table_t *table_link = &cache->retired;
+	jit_cache_node_t *node_link = &cache->retiredNodes;
+	jit_cache_table_t table;
+	jit_cache_node_t node;
+	unsigned char *data_start;
+	unsigned char *data_end;
+	int num = cache->numRetired;
+
+	while(*table_link && !_jit_epoch_is_safe((*table_link)->epoch))
+	{
+		table_link = &((*table_link)->next);
+	}
+	while((table = *table_link) != 0)
+	{
+		*table_link = table->next;
+		--num;
+		jit_free(table);
+	}
+
+	while(*node_link && !_jit_epoch_is_safe((*node_link)->epoch))
+	{
+		node_link = &((*node_link)->next);
+	}
+	while((node = *node_link) != 0)
+	{
+		/* The node itself is part of the auxiliary data */
+		*node_link = node->next;
+		--num;
+		data_start = node->data_start;
+		data_end = node->data_end;
+		cache->retiredSize -= (node->end - node->start) + (data_end - data_start);
+		FreeBlock(cache, node->start, node->end);
+		FreeBlock(cache, data_start, data_end);
+	}
+	jit_atomic_store(&cache->numRetired, num);
+}
+
+/*
+ * Note that a table or node was retired at "epoch".  The cache lock must
+ * be held.
+ */
+static void
+NoteRetired(jit_cache_t cache, unsigned long epoch)
+{
+	jit_atomic_store(&cache->retiredEpoch, epoch);
+	jit_atomic_store(&cache->numRetired, cache->numRetired + 1);
+}
+
+/*
+ * Put a lookup table that was replaced on the list of tables to free.
+ * The cache lock must be held.
+ */
+static void
+RetireTable(jit_cache_t cache, jit_cache_table_t table)
+{
+	if(table)
+	{
+		table->epoch = _jit_epoch_get();
+		table->next = cache->retired;
+		cache->retired = table;
+		NoteRetired(cache, table->epoch);
+	}
+}
+
+/*
+ * Merge the entries of "first" and "second" that still have a node into
+ * a new table with room for "max" entries.  Either table may be null.
+ */
+static jit_cache_table_t
+MergeTables(jit_cache_table_t first, jit_cache_table_t second,
+	    unsigned long max)
+{
+	jit_cache_table_t merged;
+	unsigned long num_first = first ? first->num : 0;
+	unsigned long num_second = second ? second->num : 0;
+	unsigned long i = 0;
+	unsigned long j = 0;
+	struct jit_cache_range *range;
+
+	merged = AllocTable(max);
+	if(!merged)
+	{
+		return 0;
+	}
+	while(i < num_first || j < num_second)
+	{
+		if(j >= num_second ||
+		   (i < num_first && first->ranges[i].start < second->ranges[j].start))
+		{
+			range = &(first->ranges[i++]);
+		}
+		else
+		{
+			range = &(second->ranges[j++]);
+		}
+		if(range->node)
+		{
+			merged->ranges[merged->num++] = *range;
+		}
+	}
+	return merged;
+}
+
+/*
+ * Replace the table in "slot" with "table", and retire the old one.
+ * The cache lock must be held.
+ */
+static void
+ReplaceTable(jit_cache_t cache, jit_cache_table_t *slot,
+	     jit_cache_table_t table)
+{
+	jit_cache_table_t old = *slot;
 
-	/* Set up the working region within the new page */
-	cache->free_start = ptr;
-	cache->free_end = ptr + (int) cache->pageSize * factor;
+	jit_atomic_store(slot, table);
+	RetireTable(cache, old);
 }
 
 /*
- * Compare a key against a node, being careful of sentinel nodes.
+ * Merge the full runs at the bottom of the lookup tables into the first
+ * free run, like carrying in a binary counter.  Once they hold as many
+ * entries as half the main table, they are merged into the main table
+ * instead, so that every entry is copied O(log n) times in all.
+ *
+ * The merged table is published before the runs that went into it are
+ * emptied, and lookups read the runs from the bottom up, so that none
+ * misses a function.  A lookup that reads the main table first checks
+ * afterwards that it was not replaced.  The cache lock must be held.
  */
 static int
-CacheCompare(jit_cache_t cache, unsigned char *key, jit_cache_node_t node)
+PushRuns(jit_cache_t cache)
 {
-	if(node == &cache->nil || node == &cache->head)
+	jit_cache_table_t merged = 0;
+	jit_cache_table_t next;
+	unsigned long live = 0;
+	int to_main;
+	int top;
+	int index;
+
+	/* Find the first free run */
+	top = 1;
+	while(top < JIT_CACHE_NUM_RUNS && cache->runs[top])
 	{
-		/* Every key is greater than the sentinel nodes */
-		return 1;
+		++top;
 	}
-	else
+	for(index = 0; index < top; ++index)
 	{
-		/* Compare a regular node */
-		if(key < node->start)
-		{
-			return -1;
-		}
-		else if(key > node->start)
+		live += LiveRanges(cache->runs[index]);
+	}
+	to_main = (top >= JIT_CACHE_NUM_RUNS
+		   || live * 2 >= LiveRanges(cache->table));
+
+	/* Merge from the smallest run up, so that the copies that are
+	   thrown away are small ones */
+	for(index = 0; index < top; ++index)
+	{
+		next = MergeTables(merged, cache->runs[index],
+				   LiveRanges(merged) + LiveRanges(cache->runs[index]));
+		jit_free(merged);
+		merged = next;
+		if(!merged)
 		{
-			return 1;
+			return 0;
 		}
-		else
+	}
+	if(to_main)
+	{
+		live = LiveRanges(merged) + LiveRanges(cache->table);
+		next = MergeTables(cache->table, merged, MainTableSize(live));
+		jit_free(merged);
+		if(!next)
 		{
 			return 0;
 		}
+		ReplaceTable(cache, &cache->table, next);
+	}
+	else
+	{
+		ReplaceTable(cache, &cache->runs[top], merged);
+	}
+	for(index = 0; index < top; ++index)
+	{
+		ReplaceTable(cache, &cache->runs[index], 0);
 	}
+	ReclaimRetired(cache);
+	return 1;
 }
 
 /*
- * Rotate a sub-tree around a specific node.
+ * Add a method region block to the lookup table of the cache.  Code is
+ * mostly written at increasing addresses, so the block is appended in
+ * place to the main table when it starts after every function in it.
+ * Other blocks go to the smallest run, which is copied.  The cache lock
+ * must be held.
  */
-static jit_cache_node_t
-CacheRotate(jit_cache_t cache, unsigned char *key, jit_cache_node_t around)
+static int
+AddNode(jit_cache_t cache, jit_cache_node_t node)
 {
-	jit_cache_node_t child, grandChild;
-	int setOnLeft;
-	if(CacheCompare(cache, key, around) < 0)
-	{
-		child = GetLeft(around);
-		setOnLeft = 1;
-	}
-	else
+	jit_cache_table_t table = cache->table;
+	jit_cache_table_t recent;
+	jit_cache_table_t copy;
+	unsigned long num = table ? table->num : 0;
+	unsigned long index;
+
+	if(num == 0 || table->ranges[num - 1].start < node->start)
 	{
-		child = GetRight(around);
-		setOnLeft = 0;
+		if(!table || num >= table->max)
+		{
+			copy = MergeTables(table, 0,
+					   MainTableSize(LiveRanges(table) + 1));
+			if(!copy)
+			{
+				return 0;
+			}
+			ReplaceTable(cache, &cache->table, copy);
+			table = copy;
+		}
+
+		/* The entry is written before lookups may see it */
+		table->ranges[table->num].start = node->start;
+		table->ranges[table->num].end = node->end;
+		table->ranges[table->num].node = node;
+		jit_atomic_store(&table->num, table->num + 1);
+		ReclaimRetired(cache);
+		return 1;
 	}
-	if(CacheCompare(cache, key, child) < 0)
+
+	if(cache->runs[0] && cache->runs[0]->num >= JIT_CACHE_RECENT_RANGES)
 	{
-		grandChild = GetLeft(child);
-		SetLeft(child, GetRight(grandChild));
-		SetRight(grandChild, child);
+		if(!PushRuns(cache))
+		{
+			return 0;
+		}
 	}
-	else
+	recent = cache->runs[0];
+	num = recent ? recent->num : 0;
+
+	copy = AllocTable(num + 1);
+	if(!copy)
 	{
-		grandChild = GetRight(child);
-		SetRight(child, GetLeft(grandChild));
-		SetLeft(grandChild, child);
+		return 0;
 	}
-	if(setOnLeft)
+	index = FindRangeAfter(recent, node->start);
+	if(index > 0)
 	{
-		SetLeft(around, grandChild);
+		jit_memcpy(copy->ranges, recent->ranges,
+			   index * sizeof(struct jit_cache_range));
 	}
-	else
+	copy->ranges[index].start = node->start;
+	copy->ranges[index].end = node->end;
+	copy->ranges[index].node = node;
+	if(index < num)
 	{
-		SetRight(around, grandChild);
+		jit_memcpy(&(copy->ranges[index + 1]), &(recent->ranges[index]),
+			   (num - index) * sizeof(struct jit_cache_range));
 	}
-	return grandChild;
+	copy->num = num + 1;
+
+	ReplaceTable(cache, &cache->runs[0], copy);
+	ReclaimRetired(cache);
+	return 1;
 }
 
 /*
- * Split a red-black tree at the current position.
+ * Clear the entry of "node" in the table in "slot", if it is there.
+ * The table is rebuilt once half of its entries are cleared.  The cache
+ * lock must be held.
  */
-#define	Split()								\
-	do {								\
-		SetRed(temp);						\
-		SetBlack(GetLeft(temp));				\
-		SetBlack(GetRight(temp));				\
-		if(GetRed(parent))					\
-		{							\
-			SetRed(grandParent);				\
-			if((CacheCompare(cache, key, grandParent) < 0) != \
-			   (CacheCompare(cache, key, parent) < 0))	\
-			{						\
-				parent = CacheRotate(cache, key, grandParent); \
-			}						\
-			temp = CacheRotate(cache, key, greatGrandParent); \
-			SetBlack(temp);					\
-		}							\
-	} while (0)
+static int
+ClearNode(jit_cache_t cache, jit_cache_table_t *slot, jit_cache_node_t node)
+{
+	jit_cache_table_t table = *slot;
+	jit_cache_table_t copy;
+	unsigned long index;
 
-/*
- * Add a method region block to the red-black lookup tree
- * that is associated with a method cache.
- */
-static void
-AddToLookupTree(jit_cache_t cache, jit_cache_node_t method)
-{
-	unsigned char *key = method->start;
-	jit_cache_node_t temp;
-	jit_cache_node_t greatGrandParent;
-	jit_cache_node_t grandParent;
-	jit_cache_node_t parent;
-	jit_cache_node_t nil = &(cache->nil);
-	int cmp;
-
-	/* Search for the insert position */
-	temp = &(cache->head);
-	greatGrandParent = temp;
-	grandParent = temp;
-	parent = temp;
-	while(temp != nil)
-	{
-		/* Adjust our ancestor pointers */
-		greatGrandParent = grandParent;
-		grandParent = parent;
-		parent = temp;
-
-		/* Compare the key against the current node */
-		cmp = CacheCompare(cache, key, temp);
-		if(cmp == 0)
-		{
-			/* This is a duplicate, which normally shouldn't happen.
-			   If it does happen, then ignore the node and bail out */
-			return;
-		}
-		else if(cmp < 0)
-		{
-			temp = GetLeft(temp);
-		}
-		else
+	index = FindRangeAfter(table, node->start);
+	if(index == 0 || table->ranges[index - 1].node != node)
+	{
+		return 0;
+	}
+	jit_atomic_store(&(table->ranges[index - 1].node), (jit_cache_node_t) 0);
+	++(table->cleared);
+	if(table->cleared * 2 > table->num)
+	{
+		/* Failing to rebuild only leaves the cleared entries in place */
+		copy = MergeTables(table, 0, slot == &cache->table
+				   ? MainTableSize(LiveRanges(table))
+				   : LiveRanges(table));
+		if(copy)
 		{
-			temp = GetRight(temp);
+			ReplaceTable(cache, slot, copy);
+			ReclaimRetired(cache);
 		}
+	}
+	return 1;
+}
+
+/*
+ * Remove a method region block from the lookup table of the cache.  A
+ * function in the smallest run is removed by copying that run.
+ * Otherwise its entry is cleared in place.  The cache lock must be held.
+ */
+static int
+RemoveNode(jit_cache_t cache, jit_cache_node_t node)
+{
+	jit_cache_table_t recent = cache->runs[0];
+	jit_cache_table_t copy;
+	unsigned long index;
+	int run;
 
-		/* Do we need to split this node? */
-		if(GetRed(GetLeft(temp)) && GetRed(GetRight(temp)))
+	index = FindRangeAfter(recent, node->start);
+	if(index > 0 && recent->ranges[index - 1].node == node)
+	{
+		copy = AllocTable(recent->num - 1);
+		if(!copy)
 		{
-			Split();
+			return 0;
 		}
+		jit_memcpy(copy->ranges, recent->ranges,
+			   (index - 1) * sizeof(struct jit_cache_range));
+		jit_memcpy(&(copy->ranges[index - 1]), &(recent->ranges[index]),
+			   (recent->num - index) * sizeof(struct jit_cache_range));
+		copy->num = recent->num - 1;
+		ReplaceTable(cache, &cache->runs[0], copy);
+		ReclaimRetired(cache);
+		return 1;
 	}
 
-	/* Insert the new node into the current position */
-	method->left = (jit_cache_node_t)(((jit_nuint)nil) | ((jit_nuint)1));
-	method->right = nil;
-	if(CacheCompare(cache, key, parent) < 0)
+	for(run = 1; run < JIT_CACHE_NUM_RUNS; ++run)
 	{
-		SetLeft(parent, method);
+		if(ClearNode(cache, &cache->runs[run], node))
+		{
+			return 1;
+		}
 	}
-	else
+	return ClearNode(cache, &cache->table, node);
+}
+
+/*
+ * Find the entry of "table" that contains "pc".
+ */
+static jit_cache_node_t
+FindNode(jit_cache_table_t table, unsigned char *pc)
+{
+	unsigned long index = FindRangeAfter(table, pc);
+
+	if(index > 0 && pc < table->ranges[index - 1].end)
 	{
-		SetRight(parent, method);
+		return jit_atomic_load(&(table->ranges[index - 1].node));
 	}
-	Split();
-	SetBlack(cache->head.right);
+	return 0;
 }
 
 jit_cache_t
 _jit_cache_create(jit_context_t context)
 {
 	jit_cache_t cache;
-	long limit, cache_page_size;
+	long cache_page_size;
 	int max_page_factor;
 	unsigned long exec_page_size;
+	jit_nuint reserve_size;
+	int dual_map;
+	int index;
 
-	limit = (long)
-		jit_context_get_meta_numeric(context, JIT_OPTION_CACHE_LIMIT);
 	cache_page_size = (long)
 		jit_context_get_meta_numeric(context, JIT_OPTION_CACHE_PAGE_SIZE);
 	max_page_factor = (int)
 		jit_context_get_meta_numeric(context, JIT_OPTION_CACHE_MAX_PAGE_FACTOR);
+	reserve_size =
+		jit_context_get_meta_numeric(context, JIT_OPTION_CACHE_RESERVE);
+	dual_map = (int)
+		jit_context_get_meta_numeric(context, JIT_OPTION_CACHE_DUAL_MAP);
 
 	/* Allocate space for the cache control structure */
-	if((cache = (jit_cache_t) jit_malloc(sizeof(struct jit_cache))) == 0)
+	if((cache = (jit_cache_t) jit_cnew(struct jit_cache)) == 0)
 	{
 		return 0;
 	}
+	jit_mutex_create(&cache->lock);
+	for(index = 0; index < JIT_CACHE_NUM_REGIONS; ++index)
+	{
+		jit_mutex_create(&cache->regions[index].lock);
+	}
+	jit_mutex_create(&cache->stubs.lock);
 
 	/* determine the default cache page size */
 	exec_page_size = jit_vmem_page_size();
@@ -411,31 +1374,71 @@ _jit_cache_create(jit_context_t context)
 	cache->maxNumPages = 0;
 	cache->pageSize = cache_page_size;
 	cache->maxPageFactor = max_page_factor;
-	cache->free_start = 0;
-	cache->free_end = 0;
-	if(limit > 0)
+	cache->usedPages = 0;
+	cache->context = context;
+	cache->sharedFd = -1;
+
+	/* Reserve address space for the pages next to the code of the
+	   library if possible, or anywhere else if not, so that calls
+	   between the pages can still be relative */
+	if(reserve_size == 0)
+	{
+		reserve_size = JIT_CACHE_RESERVE_SIZE;
+	}
+	if(reserve_size > JIT_CACHE_MAX_RESERVE_SIZE)
 	{
-		cache->pagesLeft = limit / cache_page_size;
-		if(cache->pagesLeft < 1)
+		reserve_size = JIT_CACHE_MAX_RESERVE_SIZE;
+	}
+	reserve_size = (reserve_size / cache_page_size) * cache_page_size;
+	if(reserve_size > 0)
+	{
+		cache->reserve = (unsigned char *) jit_vmem_reserve_near
+			((void *) jit_exception_builtin, (jit_uint) reserve_size,
+			 JIT_CACHE_RESERVE_RANGE);
+		if(!cache->reserve)
+		{
+			cache->reserve = (unsigned char *)
+				jit_vmem_reserve((jit_uint) reserve_size);
+		}
+		if(cache->reserve)
 		{
-			cache->pagesLeft = 1;
+			cache->reserveSize = reserve_size;
 		}
 	}
-	else
+
+	/* Map the reserve a second time for writing, if asked to, with both
+	   views backed by one shared memory object.  Only the x86-64 back
+	   end knows how to write code that runs at a different address */
+#if defined(JIT_BACKEND_X86_64)
+	if(dual_map && cache->reserve)
+	{
+		cache->writeReserve = (unsigned char *)
+			jit_vmem_reserve((jit_uint) cache->reserveSize);
+		if(cache->writeReserve)
+		{
+			cache->sharedFd = jit_vmem_shared_create(cache->reserveSize);
+		}
+	}
+#endif
+	if(dual_map && cache->sharedFd < 0)
 	{
-		cache->pagesLeft = -1;
+		/* Fail rather than fall back to pages that are writable and
+		   executable at the same time */
+		_jit_cache_destroy(cache);
+		return 0;
 	}
-	cache->node = 0;
-	cache->nil.left = &(cache->nil);
-	cache->nil.right = &(cache->nil);
-	cache->nil.func = 0;
-	cache->head.left = 0;
-	cache->head.right = &(cache->nil);
-	cache->head.func = 0;
 
-	/* Allocate the initial cache page */
-	AllocCachePage(cache, 0);
-	if(!cache->free_start)
+	/* Huge pages must be made of whole cache pages */
+	cache->hugePageSize = jit_vmem_huge_page_size();
+	if(cache->hugePageSize % cache_page_size != 0)
+	{
+		cache->hugePageSize = 0;
+	}
+
+	/* Allocate the initial cache page.  The regions of other threads
+	   get their first page when they start writing a function */
+	AllocCachePage(cache, GetRegion(cache), 0);
+	if(!GetRegion(cache)->free_start)
 	{
 		_jit_cache_destroy(cache);
 		return 0;
@@ -449,17 +1452,71 @@ void
 _jit_cache_destroy(jit_cache_t cache)
 {
 	unsigned long page;
+	jit_cache_block_t block;
+	jit_cache_block_t next;
+	jit_cache_table_t table;
+	int index;
 
 	/* Free all of the cache pages */
 	for(page = 0; page < cache->numPages; ++page)
 	{
-		_jit_free_exec(cache->pages[page].page,
-			       cache->pageSize * cache->pages[page].factor);
+		for(block = cache->pages[page].free; block; block = next)
+		{
+			next = block->next;
+			jit_free(block);
+		}
+		if(((unsigned char *) cache->pages[page].page) < cache->reserve ||
+		   ((unsigned char *) cache->pages[page].page) >=
+		   cache->reserve + cache->reserveSize)
+		{
+			_jit_free_exec(cache->pages[page].page,
+				       cache->pageSize * cache->pages[page].factor);
+		}
+	}
+	for(block = cache->reserveFree; block; block = next)
+	{
+		next = block->next;
+		jit_free(block);
+	}
+	if(cache->reserve)
+	{
+		jit_vmem_release(cache->reserve, (jit_uint) cache->reserveSize);
+	}
+	if(cache->writeReserve)
+	{
+		jit_vmem_release(cache->writeReserve, (jit_uint) cache->reserveSize);
 	}
+	jit_vmem_shared_destroy(cache->sharedFd);
 	if(cache->pages)
 	{
 		jit_free(cache->pages);
 	}
+	/* The retired nodes were in the pages, which are gone already */
+	RetireTable(cache, cache->table);
+	for(index = 0; index < JIT_CACHE_NUM_RUNS; ++index)
+	{
+		RetireTable(cache, cache->runs[index]);
+	}
+	while((table = cache->retired) != 0)
+	{
+		cache->retired = table->next;
+		jit_free(table);
+	}
+	if(cache->trampolines.items)
+	{
+		jit_free(cache->trampolines.items);
+	}
+	if(cache->closures.items)
+	{
+		jit_free(cache->closures.items);
+	}
+
+	for(index = 0; index < JIT_CACHE_NUM_REGIONS; ++index)
+	{
+		jit_mutex_destroy(&cache->regions[index].lock);
+	}
+	jit_mutex_destroy(&cache->stubs.lock);
+	jit_mutex_destroy(&cache->lock);
 
 	/* Free the cache object itself */
 	jit_free(cache);
@@ -468,44 +1525,39 @@ _jit_cache_destroy(jit_cache_t cache)
 int
 _jit_cache_extend(jit_cache_t cache, int count)
 {
+	jit_cache_region_t region = GetRegion(cache);
+	int result;
+
 	/* Compute the page size factor */
 	int factor = 1 << count;
 
+	jit_mutex_lock(&region->lock);
+
 	/* Bail out if there is a started function */
-	if(cache->node)
+	if(region->node)
 	{
+		jit_mutex_unlock(&region->lock);
 		return JIT_MEMORY_ERROR;
 	}
 
-	/* If we had a newly allocated page then it has to be freed
-	   to let allocate another new page of appropriate size. */
-	struct jit_cache_page *p = &cache->pages[cache->numPages - 1];
-	if((cache->free_start == ((unsigned char *)p->page))
-	   && (cache->free_end == (cache->free_start + cache->pageSize * p->factor)))
+	/* If we had a newly allocated page then it is given back when
+	   the new one is allocated, and the new one has to be bigger */
+	if(region->page
+	   && (region->free_start == region->page)
+	   && (region->free_end == (region->page + cache->pageSize * region->factor)))
 	{
-		_jit_free_exec(p->page, cache->pageSize * p->factor);
-
-		--(cache->numPages);
-		if(cache->pagesLeft >= 0)
-		{
-			cache->pagesLeft += p->factor;
-		}
-		cache->free_start = 0;
-		cache->free_end = 0;
-
-		if(factor <= p->factor)
+		if(factor <= region->factor)
 		{
-			factor = p->factor << 1;
+			factor = region->factor << 1;
 		}
 	}
 
 	/* Allocate a new page now */
-	AllocCachePage(cache, factor);
-	if(!cache->free_start)
-	{
-		return JIT_MEMORY_TOO_BIG;
-	}
-	return JIT_MEMORY_OK;
+	AllocCachePage(cache, region, factor);
+	result = region->free_start ? JIT_MEMORY_OK : JIT_MEMORY_TOO_BIG;
+
+	jit_mutex_unlock(&region->lock);
+	return result;
 }
 
 jit_function_t
@@ -520,38 +1572,92 @@ _jit_cache_free_function(jit_cache_t cache, jit_function_t func)
 	jit_free(func);
 }
 
+/*
+ * Allocate data from the top of the free region of "region".
+ */
+static void *
+AllocData(jit_cache_region_t region, unsigned long size, unsigned long align)
+{
+	unsigned char *ptr;
+
+	/* Get memory from the top of the free region, so that it does not
+	   overlap with the function code possibly being written at the bottom
+	   of the free region */
+	ptr = region->free_end - size;
+	ptr = (unsigned char *) (((jit_nuint) ptr) & ~(align - 1));
+	if(ptr < region->free_start)
+	{
+		/* When we aligned the block, it caused an overflow */
+		return 0;
+	}
+
+	/* Allocate the block and return it */
+	region->free_end = ptr;
+	return ptr;
+}
+
+/*
+ * The region of the current thread stays locked from a successful
+ * _jit_cache_start_function until the matching _jit_cache_end_function,
+ * so functions are written into different regions concurrently.
+ */
 int
 _jit_cache_start_function(jit_cache_t cache, jit_function_t func)
 {
+	jit_cache_region_t region = GetRegion(cache);
+
+	jit_mutex_lock(&region->lock);
+
 	/* Bail out if there is a started function already */
-	if(cache->node)
+	if(region->node)
 	{
+		jit_mutex_unlock(&region->lock);
 		return JIT_MEMORY_ERROR;
 	}
+	/* Move to a bigger free block, if little space is left */
+	if(region->page
+	   && (unsigned long) (region->free_end - region->free_start) < cache->pageSize / 4
+	   && cache->freeSize > (unsigned long) (region->free_end - region->free_start))
+	{
+		jit_mutex_lock(&cache->lock);
+		TakeFreeBlock(cache, region, region->free_end - region->free_start + 1);
+		jit_mutex_unlock(&cache->lock);
+	}
+	/* The region gets its first page on first use */
+	if(!region->page)
+	{
+		AllocCachePage(cache, region, 0);
+	}
 	/* Bail out if the cache is already full */
-	if(!cache->free_start)
+	if(!region->free_start)
 	{
+		jit_mutex_unlock(&region->lock);
 		return JIT_MEMORY_TOO_BIG;
 	}
 
 	/* Save the cache position */
-	cache->prev_start = cache->free_start;
-	cache->prev_end = cache->free_end;
-
-	/* Allocate a new cache node */
-	cache->node = _jit_cache_alloc_data(
-		cache, sizeof(struct jit_cache_node), sizeof(void *));
-	if(!cache->node)
+	region->prev_start = region->free_start;
+	region->prev_end = region->free_end;
+
+	/* Allocate a new cache node.  It is kept at its writable address
+	   when the cache is mapped twice */
+	region->node = AllocData(
+		region, sizeof(struct jit_cache_node), sizeof(void *));
+	if(!region->node)
 	{
+		region->need = region->prev_end - region->prev_start + 1;
+		jit_mutex_unlock(&region->lock);
 		return JIT_MEMORY_RESTART;
 	}
-	cache->node->func = func;
+	region->node = (jit_cache_node_t)
+		((unsigned char *) region->node + WriteOffset(cache));
+	region->node->func = func;
 
 	/* Initialize the function information */
-	cache->node->start = cache->free_start;
-	cache->node->end = 0;
-	cache->node->left = 0;
-	cache->node->right = 0;
+	region->node->start = region->free_start;
+	region->node->end = 0;
+	region->node->data_start = 0;
+	region->node->data_end = region->prev_end;
 
 	return JIT_MEMORY_OK;
 }
@@ -559,8 +1665,10 @@ _jit_cache_start_function(jit_cache_t cache, jit_function_t func)
 int
 _jit_cache_end_function(jit_cache_t cache, int result)
 {
+	jit_cache_region_t region = GetRegion(cache);
+
 	/* Bail out if there is no started function */
-	if(!cache->node)
+	if(!region->node)
 	{
 		return JIT_MEMORY_ERROR;
 	}
@@ -568,18 +1676,36 @@ _jit_cache_end_function(jit_cache_t cache, int result)
 	/* Determine if we ran out of space while writing the function */
 	if(result != JIT_MEMORY_OK)
 	{
-		/* Restore the saved cache position */
-		cache->free_start = cache->prev_start;
-		cache->free_end = cache->prev_end;
-		cache->node = 0;
-
+		/* Restore the saved cache position, and remember that the
+		   function needs more space than this */
+		region->free_start = region->prev_start;
+		region->free_end = region->prev_end;
+		region->node = 0;
+		region->need = region->prev_end - region->prev_start + 1;
+
+		jit_mutex_unlock(&region->lock);
 		return JIT_MEMORY_RESTART;
 	}
 
-	/* Update the method region block and then add it to the lookup tree */
-	cache->node->end = cache->free_start;
-	AddToLookupTree(cache, cache->node);
-	cache->node = 0;
+	/* Update the method region block and then add it to the lookup table */
+	region->node->end = region->free_start;
+	region->node->data_start = region->free_end;
+	jit_mutex_lock(&cache->lock);
+	if(!AddNode(cache, region->node))
+	{
+		jit_mutex_unlock(&cache->lock);
+		region->free_start = region->prev_start;
+		region->free_end = region->prev_end;
+		region->node = 0;
+
+		jit_mutex_unlock(&region->lock);
+		return JIT_MEMORY_ERROR;
+	}
+	jit_mutex_unlock(&cache->lock);
+	region->node = 0;
+	region->need = 0;
+
+	jit_mutex_unlock(&region->lock);
 
 	/* The method is ready to go */
 	return JIT_MEMORY_OK;
@@ -588,90 +1714,106 @@ _jit_cache_end_function(jit_cache_t cache, int result)
 void *
 _jit_cache_get_code_break(jit_cache_t cache)
 {
+	jit_cache_region_t region = GetRegion(cache);
+
 	/* Bail out if there is no started function */
-	if(!cache->node)
+	if(!region->node)
 	{
 		return 0;
 	}
 
 	/* Return the address of the available code area */
-	return cache->free_start;
+	return region->free_start;
 }
 
 void
 _jit_cache_set_code_break(jit_cache_t cache, void *ptr)
 {
+	jit_cache_region_t region = GetRegion(cache);
+
 	/* Bail out if there is no started function */
-	if(!cache->node)
+	if(!region->node)
 	{
 		return;
 	}
 	/* Sanity checks */
-	if((unsigned char *) ptr < cache->free_start)
+	if((unsigned char *) ptr < region->free_start)
 	{
 		return;
 	}
-	if((unsigned char *) ptr > cache->free_end)
+	if((unsigned char *) ptr > region->free_end)
 	{
 		return;
 	}
 
 	/* Update the address of the available code area */
-	cache->free_start = ptr;
+	region->free_start = ptr;
 }
 
 void *
 _jit_cache_get_code_limit(jit_cache_t cache)
 {
+	jit_cache_region_t region = GetRegion(cache);
+
 	/* Bail out if there is no started function */
-	if(!cache->node)
+	if(!region->node)
 	{
 		return 0;
 	}
 
 	/* Return the end address of the available code area */
-	return cache->free_end;
+	return region->free_end;
 }
 
+/*
+ * Data is only allocated while a function is being written, so the
+ * region of the current thread is already locked.
+ */
 void *
 _jit_cache_alloc_data(jit_cache_t cache, unsigned long size, unsigned long align)
 {
+	return AllocData(GetRegion(cache), size, align);
+}
+
+/*
+ * Allocate a trampoline or closure, reusing a freed one from "slots"
+ * if there is any.
+ */
+static void *
+alloc_code(jit_cache_t cache, struct jit_cache_slots *slots,
+	   unsigned int size, unsigned int align)
+{
+	jit_cache_region_t region = &(cache->stubs);
 	unsigned char *ptr;
 
-	/* Get memory from the top of the free region, so that it does not
-	   overlap with the function code possibly being written at the bottom
-	   of the free region */
-	ptr = cache->free_end - size;
-	ptr = (unsigned char *) (((jit_nuint) ptr) & ~(align - 1));
-	if(ptr < cache->free_start)
+	jit_mutex_lock(&cache->lock);
+	if(slots->num > 0)
 	{
-		/* When we aligned the block, it caused an overflow */
-		return 0;
+		ptr = (unsigned char *) slots->items[--(slots->num)];
+		jit_mutex_unlock(&cache->lock);
+		return (void *) ptr;
 	}
+	jit_mutex_unlock(&cache->lock);
 
-	/* Allocate the block and return it */
-	cache->free_end = ptr;
-	return ptr;
-}
+	jit_mutex_lock(&region->lock);
 
-static void *
-alloc_code(jit_cache_t cache, unsigned int size, unsigned int align)
-{
-	unsigned char *ptr;
+	/* A smaller free block is no use */
+	region->need = size + align;
 
-	/* Bail out if there is a started function */
-	if(cache->node)
+	/* The region gets its first page on first use */
+	if(!region->page)
 	{
-		return 0;
+		AllocCachePage(cache, region, 0);
 	}
 	/* Bail out if there is no cache available */
-	if(!cache->free_start)
+	if(!region->free_start)
 	{
+		jit_mutex_unlock(&region->lock);
 		return 0;
 	}
 
 	/* Allocate aligned memory */
-	ptr = cache->free_start;
+	ptr = region->free_start;
 	if(align > 1)
 	{
 		jit_nuint p = ((jit_nuint) ptr + align - 1) & ~(align - 1);
@@ -679,19 +1821,20 @@ alloc_code(jit_cache_t cache, unsigned int size, unsigned int align)
 	}
 
 	/* Do we need to allocate a new cache page? */
-	if((ptr + size) > cache->free_end)
+	if((ptr + size) > region->free_end)
 	{
 		/* Allocate a new page */
-		AllocCachePage(cache, 0);
+		AllocCachePage(cache, region, 0);
 
 		/* Bail out if the cache is full */
-		if(!cache->free_start)
+		if(!region->free_start)
 		{
+			jit_mutex_unlock(&region->lock);
 			return 0;
 		}
 
 		/* Allocate memory from the new page */
-		ptr = cache->free_start;
+		ptr = region->free_start;
 		if(align > 1)
 		{
 			jit_nuint p = ((jit_nuint) ptr + align - 1) & ~(align - 1);
@@ -700,14 +1843,47 @@ alloc_code(jit_cache_t cache, unsigned int size, unsigned int align)
 	}
 
 	/* Allocate the block and return it */
-	cache->free_start = ptr + size;
+	region->free_start = ptr + size;
+	jit_mutex_unlock(&region->lock);
 	return (void *) ptr;
 }
 
+/*
+ * Keep a freed trampoline or closure in "slots" for reuse.  All of them
+ * have the same size, so they are not merged with other free blocks.
+ */
+static void
+free_code(jit_cache_t cache, struct jit_cache_slots *slots, void *ptr)
+{
+	void **items;
+	unsigned long num;
+
+	if(!ptr)
+	{
+		return;
+	}
+	jit_mutex_lock(&cache->lock);
+	if(slots->num == slots->max)
+	{
+		num = slots->max ? slots->max * 2 : 16;
+		items = (void **) jit_realloc(slots->items, sizeof(void *) * num);
+		if(!items)
+		{
+			/* The block is lost until the context is destroyed */
+			jit_mutex_unlock(&cache->lock);
+			return;
+		}
+		slots->items = items;
+		slots->max = num;
+	}
+	slots->items[(slots->num)++] = ptr;
+	jit_mutex_unlock(&cache->lock);
+}
+
 void *
 _jit_cache_alloc_trampoline(jit_cache_t cache)
 {
-	return alloc_code(cache,
+	return alloc_code(cache, &(cache->trampolines),
 			  jit_get_trampoline_size(),
 			  jit_get_trampoline_alignment());
 }
@@ -715,13 +1891,13 @@ _jit_cache_alloc_trampoline(jit_cache_t cache)
 void
 _jit_cache_free_trampoline(jit_cache_t cache, void *trampoline)
 {
-	/* not supported yet */
+	free_code(cache, &(cache->trampolines), trampoline);
 }
 
 void *
 _jit_cache_alloc_closure(jit_cache_t cache)
 {
-	return alloc_code(cache,
+	return alloc_code(cache, &(cache->closures),
 			  jit_get_closure_size(),
 			  jit_get_closure_alignment());
 }
@@ -729,7 +1905,7 @@ _jit_cache_alloc_closure(jit_cache_t cache)
 void
 _jit_cache_free_closure(jit_cache_t cache, void *closure)
 {
-	/* not supported yet */
+	free_code(cache, &(cache->closures), closure);
 }
 
 #if 0
@@ -789,26 +1965,77 @@ _jit_cache_alloc_no_method(jit_cache_t cache, unsigned long size, unsigned long
 }
 #endif
 
+/*
+ * Find the node of the function that contains "pc".  No lock is taken,
+ * and the tables that are read are kept from being freed by the epoch.
+ * The node is freed in the same way, so it stays valid for as long as
+ * the caller is in an epoch section of its own.
+ */
 void *
 _jit_cache_find_function_info(jit_cache_t cache, void *pc)
 {
-	jit_cache_node_t node = cache->head.right;
-	while(node != &(cache->nil))
+	jit_cache_table_t table;
+	jit_cache_node_t node;
+	int run;
+
+	/* Most functions are in the main table, so it is searched first.  The
+	   runs are published to it before they are emptied, so if a function
+	   is missing from the runs as well, it may have been moved to a main
+	   table that replaced the one that was searched */
+	_jit_epoch_enter();
+	do
 	{
-		if(((unsigned char *)pc) < node->start)
-		{
-			node = GetLeft(node);
-		}
-		else if(((unsigned char *)pc) >= node->end)
-		{
-			node = GetRight(node);
-		}
-		else
+		table = jit_atomic_load(&cache->table);
+		node = FindNode(table, (unsigned char *) pc);
+		for(run = 0; run < JIT_CACHE_NUM_RUNS && !node; ++run)
 		{
-			return node;
+			node = FindNode(jit_atomic_load(&cache->runs[run]),
+					(unsigned char *) pc);
 		}
 	}
-	return 0;
+	while(!node && jit_atomic_load(&cache->table) != table);
+	_jit_epoch_leave();
+
+	/* Free what was retired while lookups were in progress, unless a
+	   writer is busy and will do it anyway */
+	if(jit_atomic_load(&cache->numRetired)
+	   && _jit_epoch_is_safe(jit_atomic_load(&cache->retiredEpoch))
+	   && jit_mutex_trylock(&cache->lock))
+	{
+		ReclaimRetired(cache);
+		jit_mutex_unlock(&cache->lock);
+	}
+	return node;
+}
+
+/*
+ * Free the code and auxiliary data of a function.  The node is removed
+ * from the lookup table at once, but the memory is only reused for
+ * other functions, and pages that become empty are only given back to
+ * the system, once no lookup or call may still be reading it.
+ */
+void
+_jit_cache_free_code(jit_cache_t cache, void *func_info)
+{
+	jit_cache_node_t node = (jit_cache_node_t) func_info;
+
+	if(!node)
+	{
+		return;
+	}
+
+	jit_mutex_lock(&cache->lock);
+	if(RemoveNode(cache, node))
+	{
+		node->epoch = _jit_epoch_get();
+		node->next = cache->retiredNodes;
+		cache->retiredNodes = node;
+		cache->retiredSize += (node->end - node->start)
+			+ (node->data_end - node->data_start);
+		NoteRetired(cache, node->epoch);
+		ReclaimRetired(cache);
+	}
+	jit_mutex_unlock(&cache->lock);
 }
 
 jit_function_t
@@ -844,6 +2071,39 @@ _jit_cache_get_function_end(jit_memory_context_t memctx, void *func_info)
 	return 0;
 }
 
+/*
+ * Get the offset from the address that code runs at to the address that
+ * it is written to.
+ */
+static jit_nint
+_jit_cache_get_write_offset(jit_cache_t cache)
+{
+	return WriteOffset(cache);
+}
+
+/*
+ * Get the number of huge pages that back the cache, both the explicit
+ * ones and the transparent ones that the system reports.
+ */
+static jit_nuint
+_jit_cache_get_num_huge_pages(jit_cache_t cache)
+{
+	jit_nuint num;
+
+	if(!cache->hugePageSize)
+	{
+		return 0;
+	}
+	jit_mutex_lock(&cache->lock);
+	num = cache->hugetlbPages;
+	if(cache->reserve)
+	{
+		num += jit_vmem_count_huge(cache->reserve, cache->reserveSize);
+	}
+	jit_mutex_unlock(&cache->lock);
+	return num;
+}
+
 jit_memory_manager_t
 jit_default_memory_manager(void)
 {
@@ -904,7 +2164,16 @@ jit_default_memory_manager(void)
 		&_jit_cache_free_closure,
 
 		(void * (*)(jit_memory_context_t, jit_size_t, jit_size_t))
-		&_jit_cache_alloc_data
+		&_jit_cache_alloc_data,
+
+		(void (*)(jit_memory_context_t, jit_function_info_t))
+		&_jit_cache_free_code,
+
+		(jit_nuint (*)(jit_memory_context_t))
+		&_jit_cache_get_num_huge_pages,
+
+		(jit_nint (*)(jit_memory_context_t))
+		&_jit_cache_get_write_offset
 	};
 	return &mm;
 }
@@ -989,15 +2258,85 @@ allocate a block of consecutive pages as a single unit. The method
 code and auxiliary data is written to such a multiple-page block in
 the same manner as into an ordinary page.
 
+The pages are committed from a block of address space that is reserved
+when the cache is created (JIT_OPTION_CACHE_RESERVE, 128M by default).
+The block is placed within 1G of the code of the library if possible,
+so that the x86-64 back end can call runtime helpers and other compiled
+functions with 32-bit relative calls instead of loading the target into
+a register first.  Released pages are decommitted, and their address
+space is reused for the next pages.  Once the reserved block is full,
+further pages are allocated anywhere.
+
 Each method has one or more jit_cache_method auxiliary data blocks associated
 with it.  These blocks indicate the start and end of regions within the
 method.  Normally these regions correspond to exception "try" blocks, or
 regular code between "try" blocks.
 
-The jit_cache_method blocks are organised into a red-black tree, which
-is used to perform fast lookups by address (_jit_cache_get_method).  These
-lookups are used when walking the stack during exceptions or security
-processing.
+The jit_cache_method blocks are kept in a table sorted by start address,
+which is used to perform fast lookups by address (_jit_cache_get_method).
+These lookups are used when walking the stack during exceptions or security
+processing.  Blocks are removed from the table when their code is freed.
+
+Lookups take no lock.  Each entry holds the bounds of the code next to
+the block, so a binary search does not chase pointers.  Writers hold the
+cache lock.  Code is mostly written at increasing addresses, so most
+functions start after every function in the main table, and are
+appended to it in place: the entry is written first, and the number of
+entries is raised with a release store.  When the main table is full, a
+copy with twice the room is published in its place.
+
+The other functions go to a set of smaller tables, or runs, that are
+merged like the digits of a binary counter.  The smallest run holds up
+to JIT_CACHE_RECENT_RANGES entries and is copied for every function
+added to it.  When it is full, it and the full runs above it are merged
+into the first free run, which holds up to twice as many entries as the
+one below it.  Once the runs hold as many entries as half the main
+table, they are merged into the main table instead.  So every entry is
+copied O(log n) times.  A lookup searches the main table first, and
+only searches the runs, which are at most JIT_CACHE_NUM_RUNS small
+tables, for the functions that are not in it.  Removing a function clears its entry in
+place, except in the smallest run, and a table is rebuilt once half of
+its entries are cleared.
+
+Replaced tables are freed by epoch (see _jit_epoch_enter in jit-thread.c),
+so a lookup never reads freed memory.  A lookup counts itself in a slot
+chosen by thread index, and the tables are freed once every lookup that
+may have seen them has left.  Writers free what they can whenever they
+replace a table, and a lookup that finds retired tables or nodes that
+are safe to free on its way out does the same if the cache lock is free,
+so that the list cannot grow without bound when nothing is written.
+
+Code is not written to a single free region, but to one of
+JIT_CACHE_NUM_REGIONS regions, chosen by the index of the current thread.
+Each region has its own current page and lock, which is held while a
+function is being written, so that threads which compile at the same
+time do not wait for each other.  The page list and the lookup table are
+shared by all regions, and changes to them are made under the cache lock.
+
+Freeing code
+------------
+
+The code and auxiliary data of a function can be freed with
+_jit_cache_free_code.  The function is removed from the lookup table at
+once, but its node is retired like a replaced table, because lookups
+that found it earlier may still read it.  Once that is safe, the code
+and the auxiliary data are given back to the page they were written
+to as free blocks, which are kept out of line in address order and merged
+with their neighbours.  The rest of the free region of a region is given
+back in the same way when the region moves on to other memory.  Once all
+of a page is free, the page is returned to the system, and it no longer
+counts against the cache limit.
+
+A region reuses the largest free block instead of allocating a new page
+when it needs more space, and moves to it early when less than a quarter
+of a page is left in its own free region.  Once the cache limit is hit,
+it makes do with a block smaller than a page, as long as the block is
+bigger than the free region that the last function did not fit in.
+
+Trampolines and closures are written to a free region of their own, so
+that they do not split the code of neighbouring functions.  They all
+have the same size, so freed ones are kept on separate stacks and handed
+out again as they are.
 
 Each method can also have offset information associated with it, to map
 between native code addresses and offsets within the original bytecode.
@@ -1041,9 +2380,10 @@ to a starting address for execution:
 Why aren't methods flushed when the cache fills up?
 ---------------------------------------------------
 
-In this cache implementation, methods are never "flushed" when the
-cache becomes full.  Instead, all translation stops.  This is not a bug.
-It is a feature.
+In this cache implementation, methods are not "flushed" behind the
+back of the program when the cache becomes full.  Instead, all translation
+stops, unless the program has said which functions may be flushed.  This
+is not a bug.  It is a feature.
 
 In a multi-threaded environment, it is impossible to know if some
 other thread is executing the code of a method that may be a candidate
@@ -1063,7 +2403,23 @@ a solution to this problem, it seems.  Suggestions are welcome.
 
 To prevent the cache from chewing up all of system memory, it is possible
 to set a limit on how far it will grow.  Once the limit is reached, out
-of memory will be reported and there is no way to recover.
+of memory will be reported.
+
+The program can free code with jit_function_free_code.  It can also mark
+functions as evictable with jit_function_set_evictable.  With the
+JIT_OPTION_CACHE_EVICT option, hitting the limit then frees the least
+recently used evictable functions, and they are compiled again on demand
+when they are called next.  Freed code may still be running on another
+thread, or even on the thread that frees it, if an evictable function
+calls a function that is compiled on demand.  So calls into compiled code
+through jit_function_apply and the Go call helpers hold an epoch section
+like lookups do, and freed code is retired with its node, to be reused
+once every thread that was in compiled code has returned from it.
+Retired code does not count towards the limit, so the cache may grow
+past the limit by as much code as is waiting to be reused, rounded up to
+whole pages.  A function that is compiled on demand from compiled code
+may wait for itself, so the limit is not applied to it at all while
+there is retired code.
 
 */
 
@@ -38,10 +38,26 @@ _jit_memory_ensure(jit_context_t context)
 	if(!context->memory_context)
 	{
  		context->memory_context = context->memory_manager->create(context);
+		if(context->memory_context && context->memory_manager->get_write_offset)
+		{
+			context->write_offset = context->memory_manager->get_write_offset
+				(context->memory_context);
+		}
 	}
 	return (context->memory_context != 0);
 }
 
+/*
+ * The default memory manager synchronizes itself and writes the code of
+ * each thread into a separate region, so compilation does not have to
+ * hold the memory lock of the context while generating code.
+ */
+int
+_jit_memory_is_concurrent(jit_context_t context)
+{
+	return context->memory_manager == jit_default_memory_manager();
+}
+
 void
 _jit_memory_destroy(jit_context_t context)
 {
@@ -50,6 +66,7 @@ _jit_memory_destroy(jit_context_t context)
 		return;
 	}
 	context->memory_manager->destroy(context->memory_context);
+	context->write_offset = 0;
 }
 
 jit_function_info_t
@@ -59,10 +76,26 @@ _jit_memory_find_function_info(jit_context_t context, void *pc)
 	{
 		return 0;
 	}
-	/* TODO: read lock? */
+	/* The default memory manager does not need a lock to look up */
 	return context->memory_manager->find_function_info(context->memory_context, pc);
 }
 
+jit_function_t
+_jit_memory_find_function(jit_context_t context, void *pc)
+{
+	jit_function_info_t info;
+	jit_function_t func = 0;
+
+	_jit_epoch_enter();
+	info = _jit_memory_find_function_info(context, pc);
+	if(info)
+	{
+		func = _jit_memory_get_function(context, info);
+	}
+	_jit_epoch_leave();
+	return func;
+}
+
 jit_function_t
 _jit_memory_get_function(jit_context_t context, jit_function_info_t info)
 {
@@ -117,19 +150,22 @@ _jit_memory_extend_limit(jit_context_t context, int count)
 void *
 _jit_memory_get_limit(jit_context_t context)
 {
-	return context->memory_manager->get_limit(context->memory_context);
+	return _jit_memory_writable
+		(context, context->memory_manager->get_limit(context->memory_context));
 }
 
 void *
 _jit_memory_get_break(jit_context_t context)
 {
-	return context->memory_manager->get_break(context->memory_context);
+	return _jit_memory_writable
+		(context, context->memory_manager->get_break(context->memory_context));
 }
 
 void
 _jit_memory_set_break(jit_context_t context, void *brk)
 {
-	context->memory_manager->set_break(context->memory_context, brk);
+	context->memory_manager->set_break
+		(context->memory_context, _jit_memory_executable(context, brk));
 }
 
 void *
@@ -159,5 +195,33 @@ _jit_memory_free_closure(jit_context_t context, void *ptr)
 void *
 _jit_memory_alloc_data(jit_context_t context, jit_size_t size, jit_size_t align)
 {
-	return context->memory_manager->alloc_data(context->memory_context, size, align);
+	void *ptr;
+
+	ptr = context->memory_manager->alloc_data(context->memory_context, size, align);
+	if(!ptr)
+	{
+		return 0;
+	}
+	return _jit_memory_writable(context, ptr);
+}
+
+int
+_jit_memory_free_code(jit_context_t context, jit_function_info_t info)
+{
+	if(!context->memory_manager->free_code)
+	{
+		return 0;
+	}
+	context->memory_manager->free_code(context->memory_context, info);
+	return 1;
+}
+
+jit_nuint
+_jit_memory_get_num_huge_pages(jit_context_t context)
+{
+	if(!context->memory_manager->get_num_huge_pages)
+	{
+		return 0;
+	}
+	return context->memory_manager->get_num_huge_pages(context->memory_context);
 }
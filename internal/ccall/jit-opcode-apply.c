@@ -139,7 +139,7 @@ apply_i_piii(jit_constant_t *result,
 	     jit_cf_i_piii_func intrinsic)
 {
 	return intrinsic(&result->un.int_value,
-			 value1->address, value2->address);
+			 value1->address, value2->address) == JIT_RESULT_OK;
 }
 
 static int
@@ -183,7 +183,7 @@ apply_i_pIII(jit_constant_t *result,
 	     jit_cf_i_pIII_func intrinsic)
 {
 	return intrinsic(&result->un.uint_value,
-			 value1->address, value2->address);
+			 value1->address, value2->address) == JIT_RESULT_OK;
 }
 
 static int
@@ -219,11 +219,11 @@ apply_i_plll(jit_constant_t *result,
 {
 #ifdef JIT_NATIVE_INT64
 	return intrinsic(&result->un.long_value,
-			 value1->address, value2->address);
+			 value1->address, value2->address) == JIT_RESULT_OK;
 #else
 	return intrinsic(&result->un.long_value,
 			 *((jit_long *) value1->address),
-			 *((jit_long *) value2->address));
+			 *((jit_long *) value2->address)) == JIT_RESULT_OK;
 #endif
 }
 
@@ -300,11 +300,11 @@ apply_i_pLLL(jit_constant_t *result,
 {
 #ifdef JIT_NATIVE_INT64
 	return intrinsic(&result->un.ulong_value,
-			 value1->address, value2->address);
+			 value1->address, value2->address) == JIT_RESULT_OK;
 #else
 	return intrinsic(&result->un.ulong_value,
 			 *((jit_ulong *) value1->address),
-			 *((jit_ulong *) value2->address));
+			 *((jit_ulong *) value2->address)) == JIT_RESULT_OK;
 #endif
 }
 
@@ -653,9 +653,11 @@ _jit_opcode_apply_helper(jit_function_t func, jit_uint opcode, jit_type_t type,
 		{
 			/*
 			 * We have to apply a logical not to the constant
-			 * jit_int result value.
+			 * jit_int result value.  Make a new constant because
+			 * the function shares a single zero constant.
 			 */
-			value->address = !value->address;
+			value = jit_value_create_nint_constant(func, value->type,
+							       !value->address);
 		}
 		return value;
 	}
@@ -472,7 +472,62 @@ jit_opcode_info_t const jit_opcodes[JIT_OP_NUM_OPCODES] = {
 	{"alloca", JIT_OPCODE_DEST_PTR | JIT_OPCODE_SRC1_PTR},
 	{"mark_offset", JIT_OPCODE_SRC1_INT},
 	{"mark_breakpoint", JIT_OPCODE_SRC1_PTR | JIT_OPCODE_SRC2_PTR},
-	{"jump_table", JIT_OPCODE_IS_JUMP_TABLE | JIT_OPCODE_SRC1_PTR | JIT_OPCODE_SRC2_INT}
+	{"jump_table", JIT_OPCODE_IS_JUMP_TABLE | JIT_OPCODE_SRC1_PTR | JIT_OPCODE_SRC2_INT},
+	{"copy_vector", JIT_OPCODE_OPER_COPY | JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY},
+	{"load_relative_vector", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_PTR | JIT_OPCODE_SRC2_INT | NINT_ARG},
+	{"store_relative_vector", JIT_OPCODE_DEST_PTR | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_INT | NINT_ARG},
+	{"viadd", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"visub", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vimul", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vladd", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vlsub", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfadd", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfsub", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfmul", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfdiv", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfmin", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfmax", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfsqrt", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY},
+	{"vdadd", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vdsub", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vdmul", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vddiv", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vdmin", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vdmax", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vdsqrt", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY},
+	{"vand", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vor", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vxor", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vandnot", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vieq", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vigt", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vleq", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vlgt", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfeq", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfne", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vflt", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vfle", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vdeq", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vdne", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vdlt", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vdle", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_ANY},
+	{"vshuffle", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_INT},
+	{"vibroadcast", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_INT},
+	{"vlbroadcast", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_LONG},
+	{"vfbroadcast", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_FLOAT32},
+	{"vdbroadcast", JIT_OPCODE_DEST_ANY | JIT_OPCODE_SRC1_FLOAT64},
+	{"viextract", JIT_OPCODE_DEST_INT | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_INT},
+	{"vlextract", JIT_OPCODE_DEST_LONG | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_INT},
+	{"vfextract", JIT_OPCODE_DEST_FLOAT32 | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_INT},
+	{"vdextract", JIT_OPCODE_DEST_FLOAT64 | JIT_OPCODE_SRC1_ANY | JIT_OPCODE_SRC2_INT},
+	{"vireduce_add", JIT_OPCODE_DEST_INT | JIT_OPCODE_SRC1_ANY},
+	{"vlreduce_add", JIT_OPCODE_DEST_LONG | JIT_OPCODE_SRC1_ANY},
+	{"vfreduce_add", JIT_OPCODE_DEST_FLOAT32 | JIT_OPCODE_SRC1_ANY},
+	{"vdreduce_add", JIT_OPCODE_DEST_FLOAT64 | JIT_OPCODE_SRC1_ANY},
+	{"vfreduce_min", JIT_OPCODE_DEST_FLOAT32 | JIT_OPCODE_SRC1_ANY},
+	{"vfreduce_max", JIT_OPCODE_DEST_FLOAT32 | JIT_OPCODE_SRC1_ANY},
+	{"vdreduce_min", JIT_OPCODE_DEST_FLOAT64 | JIT_OPCODE_SRC1_ANY},
+	{"vdreduce_max", JIT_OPCODE_DEST_FLOAT64 | JIT_OPCODE_SRC1_ANY}
 };
 
 _jit_intrinsic_info_t const _jit_intrinsics[JIT_OP_NUM_OPCODES] = {
@@ -912,5 +967,60 @@ _jit_intrinsic_info_t const _jit_intrinsics[JIT_OP_NUM_OPCODES] = {
 	{0, JIT_SIG_NONE, 0},
 	{0, JIT_SIG_NONE, 0},
 	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
+	{0, JIT_SIG_NONE, 0},
 	{0, JIT_SIG_NONE, 0}
 };
@@ -24,6 +24,7 @@
 #include "jit-reg-alloc.h"
 #include <jit/jit-dump.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /*@
@@ -90,7 +91,6 @@ mostly don't have to worry about it:
 #define CLOBBER_OTHER_REG	4
 
 #ifdef JIT_REG_DEBUG
-#include <stdlib.h>
 
 static void dump_regs(jit_gencode_t gen, const char *name)
 {
@@ -1523,12 +1523,15 @@ choose_input_register(jit_gencode_t gen, _jit_regs_t *regs, int index)
  * Assign diplicate input value to the same register if possible.
  * The first value has to be already assigned. The second value
  * is assigned to the same register if it is equal to the first
- * and neither of them is clobbered.
+ * and neither of them is clobbered.  Two different values that
+ * share a register after a copy are not duplicates, because only
+ * the first one would be freed if the output clobbers the register
+ * and the second one would stay bound to it.
  */
 static void
 check_duplicate_value(_jit_regs_t *regs, _jit_regdesc_t *desc1, _jit_regdesc_t *desc2)
 {
-	if(desc2->reg < 0 && desc1->reg >= 0 && are_values_equal(desc1, desc2)
+	if(desc2->reg < 0 && desc1->reg >= 0 && desc1->value == desc2->value
 #ifdef JIT_REG_STACK
 	   && (!IS_STACK_REG(desc1->reg) || regs->x87_arith)
 #endif
@@ -2012,6 +2015,13 @@ free_value(jit_gencode_t gen, jit_value_t value, int reg, int other_reg, int tem
 		return;
 	}
 
+	/* A dead value need not be copied to its global register, but the
+	   blocks that follow expect to find the value there */
+	if(value->has_global_register)
+	{
+		value->in_global_register = 1;
+	}
+
 	if(gen->contents[reg].num_values == 1)
 	{
 		if(temp)
@@ -2679,60 +2689,67 @@ _jit_regs_lookup(char *name)
 	return -1;
 }
 
-/*@
- * @deftypefun void _jit_regs_alloc_global (jit_gencode_t gen, jit_function_t func)
- * Perform global register allocation on the values in @code{func}.
- * This is called during function compilation just after variable
- * liveness has been computed.
- * @end deftypefun
-@*/
-void _jit_regs_alloc_global(jit_gencode_t gen, jit_function_t func)
+/*
+ * Free the live ranges of a function once the global registers
+ * are allocated.
+ */
+static void
+free_live_ranges(jit_function_t func)
 {
+	jit_free(func->builder->live_ranges);
+	func->builder->live_ranges = 0;
+	func->builder->num_live_ranges = 0;
+}
+
 #if JIT_NUM_GLOBAL_REGS != 0
+
+/*
+ * Determine if a value may be kept in a global register.
+ */
+static int
+is_global_candidate(jit_value_t value)
+{
+	return value->global_candidate && value->usage_count >= JIT_MIN_USED
+		&& !(value->is_addressable) && !(value->is_volatile);
+}
+
+/*
+ * Give a global register to a value for the whole function.
+ */
+static void
+set_global_register(jit_gencode_t gen, jit_value_t value, int reg)
+{
+	value->has_global_register = 1;
+	value->in_global_register = 1;
+	value->global_reg = (short)reg;
+	jit_reg_set_used(gen->touched, reg);
+	jit_reg_set_used(gen->permanent, reg);
+}
+
+/*
+ * Give the global registers to the most used values.  This is used
+ * when the liveness of the values across blocks is not known.
+ */
+static void
+alloc_global_by_usage(jit_gencode_t gen, jit_function_t func)
+{
 	jit_value_t candidates[JIT_NUM_GLOBAL_REGS];
 	int num_candidates = 0;
 	int index, reg, posn, num;
 	jit_pool_block_t block;
 	jit_value_t value, temp;
 
-	/* If the function has a "try" block, then don't do global allocation
-	   as the "longjmp" for exception throws will wipe out global registers */
-	if(func->has_try)
-	{
-		return;
-	}
-
-	/* If the current function involves a tail call, then we don't do
-	   global register allocation and we also prevent the code generator
-	   from using any of the callee-saved registers.  This simplifies
-	   tail calls, which don't have to worry about restoring such registers */
-	if(func->builder->has_tail_call)
-	{
-		for(reg = 0; reg < JIT_NUM_REGS; ++reg)
-		{
-			if((jit_reg_flags(reg) & (JIT_REG_FIXED|JIT_REG_CALL_USED)) == 0)
-			{
-				jit_reg_set_used(gen->permanent, reg);
-			}
-		}
-		return;
-	}
-
 	/* Scan all values within the function, looking for the most used.
-	   We will replace this with a better allocation strategy later */
+	   The pool adds new blocks at the head, so only the first block
+	   is partially filled */
 	block = func->builder->value_pool.blocks;
-	num = (int)(func->builder->value_pool.elems_per_block);
+	num = (int)(func->builder->value_pool.elems_in_last);
 	while(block != 0)
 	{
-		if(!(block->next))
-		{
-			num = (int)(func->builder->value_pool.elems_in_last);
-		}
 		for(posn = 0; posn < num; ++posn)
 		{
 			value = (jit_value_t)(block->data + posn * sizeof(struct _jit_value));
-			if(value->global_candidate && value->usage_count >= JIT_MIN_USED &&
-			   !(value->is_addressable) && !(value->is_volatile))
+			if(is_global_candidate(value))
 			{
 				/* Insert this candidate into the list, ordered on count */
 				index = 0;
@@ -2755,6 +2772,7 @@ void _jit_regs_alloc_global(jit_gencode_t gen, jit_function_t func)
 			}
 		}
 		block = block->next;
+		num = (int)(func->builder->value_pool.elems_per_block);
 	}
 
 	/* Allocate registers to the candidates.  We allocate from the top-most
@@ -2767,15 +2785,176 @@ void _jit_regs_alloc_global(jit_gencode_t gen, jit_function_t func)
 		{
 			--reg;
 		}
-		candidates[index]->has_global_register = 1;
-		candidates[index]->in_global_register = 1;
-		candidates[index]->global_reg = (short)reg;
-		jit_reg_set_used(gen->touched, reg);
-		jit_reg_set_used(gen->permanent, reg);
+		set_global_register(gen, candidates[index], reg);
 		--reg;
 	}
+}
+
+/*
+ * Compare two live ranges by their start, for "qsort".
+ */
+static int
+compare_live_ranges(const void *e1, const void *e2)
+{
+	const _jit_live_range_t *r1 = (const _jit_live_range_t *)e1;
+	const _jit_live_range_t *r2 = (const _jit_live_range_t *)e2;
+	if(r1->start < r2->start)
+	{
+		return -1;
+	}
+	else if(r1->start > r2->start)
+	{
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Give the global registers to values by a linear scan over their
+ * live ranges.  Values whose ranges do not overlap share a register.
+ * When all registers are taken, the value that is cheapest to keep in
+ * the frame, weighted by the loop depth of its uses, loses its register.
+ * A value keeps its register over its whole range, because the code
+ * generator cannot move a value between the frame and a global register
+ * in the middle of the function.
+ */
+static void
+alloc_global_linear_scan(jit_gencode_t gen, jit_function_t func)
+{
+	_jit_live_range_t *ranges = func->builder->live_ranges;
+	_jit_live_range_t *active[JIT_NUM_GLOBAL_REGS];
+	int free_regs[JIT_NUM_GLOBAL_REGS];
+	int num_active, num_free, index, posn, lowest, reg;
+	jit_value_t value;
+
+	/* Hand out the registers from the top-most one in the allocation
+	   order, like the allocation by usage does.  Free registers are
+	   taken from the end of the list */
+	num_free = 0;
+	for(reg = JIT_NUM_REGS - 1; reg >= 0 && num_free < JIT_NUM_GLOBAL_REGS; --reg)
+	{
+		if((jit_reg_flags(reg) & JIT_REG_GLOBAL) != 0)
+		{
+			++num_free;
+		}
+	}
+	posn = num_free;
+	for(reg = JIT_NUM_REGS - 1; reg >= 0 && posn > 0; --reg)
+	{
+		if((jit_reg_flags(reg) & JIT_REG_GLOBAL) != 0)
+		{
+			free_regs[--posn] = reg;
+		}
+	}
+
+	qsort(ranges, func->builder->num_live_ranges,
+	      sizeof(_jit_live_range_t), compare_live_ranges);
+
+	num_active = 0;
+	for(index = 0; index < func->builder->num_live_ranges; ++index)
+	{
+		value = ranges[index].value;
+		if(!is_global_candidate(value))
+		{
+			continue;
+		}
+
+		/* Release the registers of the ranges that end before this one */
+		posn = 0;
+		while(posn < num_active)
+		{
+			if(active[posn]->end < ranges[index].start)
+			{
+				free_regs[num_free++] = active[posn]->value->global_reg;
+				active[posn] = active[--num_active];
+			}
+			else
+			{
+				++posn;
+			}
+		}
+
+		if(num_free > 0)
+		{
+			reg = free_regs[--num_free];
+		}
+		else
+		{
+			/* Take the register of the cheapest active value,
+			   if that is cheaper than this one */
+			lowest = 0;
+			for(posn = 1; posn < num_active; ++posn)
+			{
+				if(active[posn]->weight < active[lowest]->weight)
+				{
+					lowest = posn;
+				}
+			}
+			if(active[lowest]->weight >= ranges[index].weight)
+			{
+				continue;
+			}
+			reg = active[lowest]->value->global_reg;
+			active[lowest]->value->has_global_register = 0;
+			active[lowest]->value->in_global_register = 0;
+			active[lowest] = active[--num_active];
+		}
+		set_global_register(gen, value, reg);
+		active[num_active++] = &ranges[index];
+	}
+}
+
+#endif
+
+/*@
+ * @deftypefun void _jit_regs_alloc_global (jit_gencode_t gen, jit_function_t func)
+ * Perform global register allocation on the values in @code{func}.
+ * This is called during function compilation just after variable
+ * liveness has been computed.  Values get a register over their live
+ * ranges when those are known, and the most used values get one over
+ * the whole function otherwise.
+ * @end deftypefun
+@*/
+void _jit_regs_alloc_global(jit_gencode_t gen, jit_function_t func)
+{
+#if JIT_NUM_GLOBAL_REGS != 0
+	int reg;
+
+	/* If the function has a "try" block, then don't do global allocation
+	   as the "longjmp" for exception throws will wipe out global registers */
+	if(func->has_try)
+	{
+		free_live_ranges(func);
+		return;
+	}
+
+	/* If the current function involves a tail call, then we don't do
+	   global register allocation and we also prevent the code generator
+	   from using any of the callee-saved registers.  This simplifies
+	   tail calls, which don't have to worry about restoring such registers */
+	if(func->builder->has_tail_call)
+	{
+		for(reg = 0; reg < JIT_NUM_REGS; ++reg)
+		{
+			if((jit_reg_flags(reg) & (JIT_REG_FIXED|JIT_REG_CALL_USED)) == 0)
+			{
+				jit_reg_set_used(gen->permanent, reg);
+			}
+		}
+		free_live_ranges(func);
+		return;
+	}
 
+	if(func->builder->live_ranges)
+	{
+		alloc_global_linear_scan(gen, func);
+	}
+	else
+	{
+		alloc_global_by_usage(gen, func);
+	}
 #endif
+	free_live_ranges(func);
 }
 
 /*@
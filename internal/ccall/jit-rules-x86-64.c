@@ -104,15 +104,12 @@
 #define HAVE_RED_ZONE 1
 
 /*
- * Some declarations that should be replaced by querying the cpuinfo
- * if generating code for the current cpu.
+ * Determine if the code generator may use an instruction set extension.
+ * The extensions are detected when the context is created and may be
+ * limited with jit_context_set_cpu_features.
  */
-/*
-#define HAVE_X86_SSE_4_1 0
-#define HAVE_X86_SSE_4 0
-#define HAVE_X86_SSE_3 0
-#define HAVE_X86_FISTTP 0
-*/
+#define HAVE_X86_FEATURE(gen, feature) \
+	(((gen)->context->cpu_features & (feature)) != 0)
 
 #define	TODO() \
 do { \
@@ -311,6 +308,7 @@ _jit_xmm1_reg_imm_size_float32(jit_gencode_t gen, unsigned char **inst_ptr,
 		/* We can use RIP relative addressing here */
 		x86_64_xmm1_reg_membase(inst, opc, reg,
 									 X86_64_RIP, offset, 0);
+		_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 	}
 	else if(((jit_nint)ptr >= jit_min_int) &&
 			((jit_nint)ptr <= jit_max_int))
@@ -354,6 +352,7 @@ _jit_xmm1_reg_imm_size_float64(jit_gencode_t gen, unsigned char **inst_ptr,
 		/* We can use RIP relative addressing here */
 		x86_64_xmm1_reg_membase(inst, opc, reg,
 									 X86_64_RIP, offset, 1);
+		_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 	}
 	else if(((jit_nint)ptr >= jit_min_int) &&
 			((jit_nint)ptr <= jit_max_int))
@@ -396,6 +395,7 @@ _jit_plops_reg_imm(jit_gencode_t gen, unsigned char **inst_ptr,
 	{
 		/* We can use RIP relative addressing here */
 		x86_64_plops_reg_membase(inst, opc, reg, X86_64_RIP, offset);
+		_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 		*inst_ptr = inst;
 		return 1;
 	}
@@ -438,6 +438,7 @@ _jit_plopd_reg_imm(jit_gencode_t gen, unsigned char **inst_ptr,
 	{
 		/* We can use RIP relative addressing here */
 		x86_64_plopd_reg_membase(inst, opc, reg, X86_64_RIP, offset);
+		_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 		*inst_ptr = inst;
 		return 1;
 	}
@@ -550,13 +551,15 @@ _x86_64_restore_mxcsr(unsigned char *inst, int sp_offset)
  * We have to use the fpu where see4.1 is not supported.
  */
 static unsigned char *
-x86_64_rounds_reg_reg(unsigned char *inst, int dreg, int sreg,
-					  int scratch_reg, X86_64_ROUNDMODE mode)
+x86_64_rounds_reg_reg(jit_gencode_t gen, unsigned char *inst, int dreg,
+					  int sreg, int scratch_reg, X86_64_ROUNDMODE mode)
 {
+	if(HAVE_X86_FEATURE(gen, JIT_CPU_SSE4_1))
+	{
+		x86_64_roundss_reg_reg(inst, dreg, sreg, mode);
+		return inst;
+	}
 #ifdef HAVE_RED_ZONE
-#ifdef HAVE_X86_SSE_4_1
-	x86_64_roundss_reg_reg(inst, dreg, sreg, mode);
-#else
 	/* Copy the xmm register to the stack */
 	x86_64_movss_membase_reg(inst, X86_64_RSP, -16, sreg);
 	/* Set the fpu round mode */
@@ -570,10 +573,6 @@ x86_64_rounds_reg_reg(unsigned char *inst, int dreg, int sreg,
 	/* and move st(0) to the destination register */
 	x86_64_fstp_membase_size(inst, X86_64_RSP, -16, 4);
 	x86_64_movss_reg_membase(inst, dreg, X86_64_RSP, -16);
-#endif
-#else
-#ifdef HAVE_X86_SSE_4_1
-	x86_64_roundss_reg_reg(inst, dreg, sreg, mode);
 #else
 	/* allocate space on the stack for two ints and one long value */
 	x86_64_sub_reg_imm_size(inst, X86_64_RSP, 16, 8);
@@ -592,19 +591,20 @@ x86_64_rounds_reg_reg(unsigned char *inst, int dreg, int sreg,
 	x86_64_movss_reg_regp(inst, dreg, X86_64_RSP);
 	/* restore the stack pointer */
 	x86_64_add_reg_imm_size(inst, X86_64_RSP, 16, 8);
-#endif
 #endif
 	return inst;
 }
 
 static unsigned char *
-x86_64_rounds_reg_membase(unsigned char *inst, int dreg, int offset,
-						  int scratch_reg, X86_64_ROUNDMODE mode)
+x86_64_rounds_reg_membase(jit_gencode_t gen, unsigned char *inst, int dreg,
+						  int offset, int scratch_reg, X86_64_ROUNDMODE mode)
 {
+	if(HAVE_X86_FEATURE(gen, JIT_CPU_SSE4_1))
+	{
+		x86_64_roundss_reg_membase(inst, dreg, X86_64_RBP, offset, mode);
+		return inst;
+	}
 #ifdef HAVE_RED_ZONE
-#ifdef HAVE_X86_SSE_4_1
-	x86_64_roundss_reg_membase(inst, dreg, X86_64_RBP, offset, mode);
-#else
 	/* Load the value to the fpu */
 	x86_64_fld_membase_size(inst, X86_64_RBP, offset, 4);
 	/* Set the fpu round mode */
@@ -616,10 +616,6 @@ x86_64_rounds_reg_membase(unsigned char *inst, int dreg, int offset,
 	/* and move st(0) to the destination register */
 	x86_64_fstp_membase_size(inst, X86_64_RSP, -16, 4);
 	x86_64_movss_reg_membase(inst, dreg, X86_64_RSP, -16);
-#endif
-#else
-#ifdef HAVE_X86_SSE_4_1
-	x86_64_roundss_reg_membase(inst, dreg, X86_64_RBP, offset, mode);
 #else
 	/* allocate space on the stack for two ints and one long value */
 	x86_64_sub_reg_imm_size(inst, X86_64_RSP, 16, 8);
@@ -636,7 +632,6 @@ x86_64_rounds_reg_membase(unsigned char *inst, int dreg, int offset,
 	x86_64_movss_reg_regp(inst, dreg, X86_64_RSP);
 	/* restore the stack pointer */
 	x86_64_add_reg_imm_size(inst, X86_64_RSP, 16, 8);
-#endif
 #endif
 	return inst;
 }
@@ -646,13 +641,15 @@ x86_64_rounds_reg_membase(unsigned char *inst, int dreg, int offset,
  * We have to use the fpu where see4.1 is not supported.
  */
 static unsigned char *
-x86_64_roundd_reg_reg(unsigned char *inst, int dreg, int sreg,
-					  int scratch_reg, X86_64_ROUNDMODE mode)
+x86_64_roundd_reg_reg(jit_gencode_t gen, unsigned char *inst, int dreg,
+					  int sreg, int scratch_reg, X86_64_ROUNDMODE mode)
 {
+	if(HAVE_X86_FEATURE(gen, JIT_CPU_SSE4_1))
+	{
+		x86_64_roundsd_reg_reg(inst, dreg, sreg, mode);
+		return inst;
+	}
 #ifdef HAVE_RED_ZONE
-#ifdef HAVE_X86_SSE_4_1
-	x86_64_roundsd_reg_reg(inst, dreg, sreg, mode);
-#else
 	/* Copy the xmm register to the stack */
 	x86_64_movsd_membase_reg(inst, X86_64_RSP, -16, sreg);
 	/* Set the fpu round mode */
@@ -666,10 +663,6 @@ x86_64_roundd_reg_reg(unsigned char *inst, int dreg, int sreg,
 	/* and move st(0) to the destination register */
 	x86_64_fstp_membase_size(inst, X86_64_RSP, -16, 8);
 	x86_64_movsd_reg_membase(inst, dreg, X86_64_RSP, -16);
-#endif
-#else
-#ifdef HAVE_X86_SSE_4_1
-	x86_64_roundsd_reg_reg(inst, dreg, sreg, mode);
 #else
 	/* allocate space on the stack for two ints and one long value */
 	x86_64_sub_reg_imm_size(inst, X86_64_RSP, 16, 8);
@@ -688,19 +681,20 @@ x86_64_roundd_reg_reg(unsigned char *inst, int dreg, int sreg,
 	x86_64_movsd_reg_regp(inst, dreg, X86_64_RSP);
 	/* restore the stack pointer */
 	x86_64_add_reg_imm_size(inst, X86_64_RSP, 16, 8);
-#endif
 #endif
 	return inst;
 }
 
 static unsigned char *
-x86_64_roundd_reg_membase(unsigned char *inst, int dreg, int offset,
-						  int scratch_reg, X86_64_ROUNDMODE mode)
+x86_64_roundd_reg_membase(jit_gencode_t gen, unsigned char *inst, int dreg,
+						  int offset, int scratch_reg, X86_64_ROUNDMODE mode)
 {
+	if(HAVE_X86_FEATURE(gen, JIT_CPU_SSE4_1))
+	{
+		x86_64_roundsd_reg_membase(inst, dreg, X86_64_RBP, offset, mode);
+		return inst;
+	}
 #ifdef HAVE_RED_ZONE
-#ifdef HAVE_X86_SSE_4_1
-	x86_64_roundsd_reg_membase(inst, dreg, X86_64_RBP, offset, mode);
-#else
 	/* Load the value to the fpu */
 	x86_64_fld_membase_size(inst, X86_64_RBP, offset, 8);
 	/* Set the fpu round mode */
@@ -712,10 +706,6 @@ x86_64_roundd_reg_membase(unsigned char *inst, int dreg, int offset,
 	/* and move st(0) to the destination register */
 	x86_64_fstp_membase_size(inst, X86_64_RSP, -16, 8);
 	x86_64_movsd_reg_membase(inst, dreg, X86_64_RSP, -16);
-#endif
-#else
-#ifdef HAVE_X86_SSE_4_1
-	x86_64_roundsd_reg_membase(inst, dreg, X86_64_RBP, offset, mode);
 #else
 	/* allocate space on the stack for two ints and one long value */
 	x86_64_sub_reg_imm_size(inst, X86_64_RSP, 16, 8);
@@ -732,7 +722,6 @@ x86_64_roundd_reg_membase(unsigned char *inst, int dreg, int offset,
 	x86_64_movsd_reg_regp(inst, dreg, X86_64_RSP);
 	/* restore the stack pointer */
 	x86_64_add_reg_imm_size(inst, X86_64_RSP, 16, 8);
-#endif
 #endif
 	return inst;
 }
@@ -771,15 +760,18 @@ x86_64_roundnf(unsigned char *inst, int scratch_reg, X86_64_ROUNDMODE mode)
  * store the value in dreg. St(0) is popped from the fpu stack.
  */
 static unsigned char *
-x86_64_nfloat_to_int(unsigned char *inst, int dreg, int scratch_reg, int size)
+x86_64_nfloat_to_int(jit_gencode_t gen, unsigned char *inst, int dreg,
+					 int scratch_reg, int size)
 {
 #ifdef HAVE_RED_ZONE
-#ifdef HAVE_X86_FISTTP
-	/* convert float to int */
-	x86_64_fisttp_membase_size(inst, X86_64_RSP, -8, 4);
-	/* move result to the destination */
-	x86_64_mov_reg_membase_size(inst, dreg, X86_64_RSP, -8, 4);
-#else
+	if(HAVE_X86_FEATURE(gen, JIT_CPU_SSE3))
+	{
+		/* convert float to int, truncating without a round mode change */
+		x86_64_fisttp_membase_size(inst, X86_64_RSP, -8, size);
+		/* move result to the destination */
+		x86_64_mov_reg_membase_size(inst, dreg, X86_64_RSP, -8, size);
+		return inst;
+	}
 	/* Set the fpu round mode */
 	inst = _x86_64_set_fpu_roundmode(inst, scratch_reg, -8, X86_ROUND_ZERO);
 	/* And round the value in st(0) to integer and store it on the stack */
@@ -788,18 +780,19 @@ x86_64_nfloat_to_int(unsigned char *inst, int dreg, int scratch_reg, int size)
 	inst = _x86_64_restore_fpcw(inst, -8);
 	/* and load the integer to the destination register */
 	x86_64_mov_reg_membase_size(inst, dreg, X86_64_RSP, -16, size);
-#endif
-#else
-#ifdef HAVE_X86_FISTTP
-	/* allocate space on the stack for one long value */
-	x86_64_sub_reg_imm_size(inst, X86_64_RSP, 8, 8);
-	/* convert float to int */
-	x86_64_fisttp_regp_size(inst, X86_64_RSP, 4);
-	/* move result to the destination */
-	x86_64_mov_reg_regp_size(inst, dreg, X86_64_RSP, 4);
-	/* restore the stack pointer */
-	x86_64_add_reg_imm_size(inst, X86_64_RSP, 8, 8);
 #else
+	if(HAVE_X86_FEATURE(gen, JIT_CPU_SSE3))
+	{
+		/* allocate space on the stack for one long value */
+		x86_64_sub_reg_imm_size(inst, X86_64_RSP, 8, 8);
+		/* convert float to int, truncating without a round mode change */
+		x86_64_fisttp_regp_size(inst, X86_64_RSP, size);
+		/* move result to the destination */
+		x86_64_mov_reg_regp_size(inst, dreg, X86_64_RSP, size);
+		/* restore the stack pointer */
+		x86_64_add_reg_imm_size(inst, X86_64_RSP, 8, 8);
+		return inst;
+	}
 	/* allocate space on the stack for 2 ints and one long value */
 	x86_64_sub_reg_imm_size(inst, X86_64_RSP, 16, 8);
 	/* Set the fpu round mode */
@@ -812,22 +805,40 @@ x86_64_nfloat_to_int(unsigned char *inst, int dreg, int scratch_reg, int size)
 	x86_64_mov_reg_regp_size(inst, dreg, X86_64_RSP, size);
 	/* restore the stack pointer */
 	x86_64_add_reg_imm_size(inst, X86_64_RSP, 16, 8);
-#endif
 #endif
 	return inst;
 }
 
 /*
- * Call a function
+ * Load an address into a register with a full 64-bit immediate, and
+ * record it for the ELF writer, which may have to relocate it.
  */
 static unsigned char *
-x86_64_call_code(unsigned char *inst, jit_nint func)
+x86_64_mov_reg_reloc(jit_gencode_t gen, unsigned char *inst, int dreg,
+		     jit_nint value, const char *name)
+{
+	x86_64_rex_emit(inst, 8, 0, 0, dreg);
+	*inst++ = (unsigned char)0xb8 + (dreg & 0x7);
+	x86_64_imm_emit64(inst, value);
+	_jit_gen_reloc(gen, inst - 8, JIT_RELOC_ABSOLUTE, name);
+	return inst;
+}
+
+/*
+ * Call a native function or symbol.  Functions that are compiled for
+ * the ELF writer always call through a register, so that the target
+ * can be relocated.  The offset of an immediate call is taken from the
+ * address that the code runs at, which may differ from "inst".
+ */
+static unsigned char *
+x86_64_call_symbol(jit_gencode_t gen, unsigned char *inst, jit_nint func,
+		   const char *name)
 {
 	jit_nint offset;
 
 	x86_64_mov_reg_imm_size(inst, X86_64_RAX, 8, 4);
-	offset = func - ((jit_nint)inst + 5);
-	if(offset >= jit_min_int && offset <= jit_max_int)
+	offset = func - ((jit_nint)inst + gen->exec_offset + 5);
+	if(!gen->image && offset >= jit_min_int && offset <= jit_max_int)
 	{
 		/* We can use the immediate call */
 		x86_64_call_imm(inst, offset);
@@ -835,22 +846,32 @@ x86_64_call_code(unsigned char *inst, jit_nint func)
 	else
 	{
 		/* We have to do a call via register */
-		x86_64_mov_reg_imm_size(inst, X86_64_SCRATCH, func, 8);
+		inst = x86_64_mov_reg_reloc(gen, inst, X86_64_SCRATCH, func, name);
 		x86_64_call_reg(inst, X86_64_SCRATCH);
 	}
 	return inst;
 }
 
 /*
- * Jump to a function
+ * Call a function
  */
 static unsigned char *
-x86_64_jump_to_code(unsigned char *inst, jit_nint func)
+x86_64_call_code(jit_gencode_t gen, unsigned char *inst, jit_nint func)
+{
+	return x86_64_call_symbol(gen, inst, func, 0);
+}
+
+/*
+ * Jump to a native function or symbol
+ */
+static unsigned char *
+x86_64_jump_to_symbol(jit_gencode_t gen, unsigned char *inst, jit_nint func,
+		      const char *name)
 {
 	jit_nint offset;
 
-	offset = func - ((jit_nint)inst + 5);
-	if(offset >= jit_min_int && offset <= jit_max_int)
+	offset = func - ((jit_nint)inst + gen->exec_offset + 5);
+	if(!gen->image && offset >= jit_min_int && offset <= jit_max_int)
 	{
 		/* We can use the immediate call */
 		x86_64_jmp_imm(inst, offset);
@@ -858,17 +879,26 @@ x86_64_jump_to_code(unsigned char *inst, jit_nint func)
 	else
 	{
 		/* We have to do a call via register */
-		x86_64_mov_reg_imm_size(inst, X86_64_SCRATCH, func, 8);
+		inst = x86_64_mov_reg_reloc(gen, inst, X86_64_SCRATCH, func, name);
 		x86_64_jmp_reg(inst, X86_64_SCRATCH);
 	}
 	return inst;
 }
 
+/*
+ * Jump to a function
+ */
+static unsigned char *
+x86_64_jump_to_code(jit_gencode_t gen, unsigned char *inst, jit_nint func)
+{
+	return x86_64_jump_to_symbol(gen, inst, func, 0);
+}
+
 /*
  * Throw a builtin exception.
  */
 static unsigned char *
-throw_builtin(unsigned char *inst, jit_function_t func, int type)
+throw_builtin(jit_gencode_t gen, unsigned char *inst, jit_function_t func, int type)
 {
 	/* We need to update "catch_pc" if we have a "try" block */
 	if(func->builder->setjmp_value != 0)
@@ -885,7 +915,7 @@ throw_builtin(unsigned char *inst, jit_function_t func, int type)
 	x86_64_mov_reg_imm_size(inst, X86_64_RDI, type, 4);
 
 	/* Call the "jit_exception_builtin" function, which will never return */
-	return x86_64_call_code(inst, (jit_nint)jit_exception_builtin);
+	return x86_64_call_code(gen, inst, (jit_nint)jit_exception_builtin);
 }
 
 /*
@@ -988,6 +1018,13 @@ _spill_reg(unsigned char **inst_ptr, jit_type_t type,
 			}
 			break;
 
+			case JIT_TYPE_VECTOR:
+			{
+				x86_64_movups_membase_reg(inst, X86_64_RBP, offset,
+										  _jit_reg_info[reg].cpu_reg);
+			}
+			break;
+
 			case JIT_TYPE_STRUCT:
 			case JIT_TYPE_UNION:
 			{
@@ -1332,6 +1369,58 @@ jump_to_epilog(jit_gencode_t gen, unsigned char *inst, jit_block_t block)
 	return inst;
 }
 
+/*
+ * Throw a builtin exception if the condition holds for the flags that
+ * the previous instruction set.  Unless the function has a "try" block,
+ * the check branches to code after the epilog that is shared by all
+ * the checks for the same exception, so it falls through when it passes.
+ */
+static unsigned char *
+throw_builtin_if(jit_gencode_t gen, unsigned char *inst, jit_function_t func,
+		 int cond, int is_signed, int type)
+{
+	unsigned char *patch;
+	jit_int fixup;
+	int opcode;
+
+	if(is_signed)
+	{
+		opcode = x86_cc_signed_map[cond];
+	}
+	else
+	{
+		opcode = x86_cc_unsigned_map[cond];
+	}
+
+	/* The exception needs the address that it was thrown at */
+	if(func->builder->setjmp_value != 0
+	   || -type <= 0 || -type >= X86_64_NUM_THROW_FIXUPS)
+	{
+		/* Branch around the throw on the opposite condition */
+		patch = inst;
+		*inst++ = (unsigned char)(opcode ^ 1);
+		*inst++ = 0;
+		inst = throw_builtin(gen, inst, func, type);
+		x86_patch(patch, inst);
+		return inst;
+	}
+
+	/* Output a placeholder and add it to the fixup list */
+	*inst++ = (unsigned char)0x0F;
+	*inst++ = (unsigned char)(opcode + 0x10);
+	if(gen->throw_fixup[-type])
+	{
+		fixup = _JIT_CALC_FIXUP(gen->throw_fixup[-type], inst);
+	}
+	else
+	{
+		fixup = 0;
+	}
+	gen->throw_fixup[-type] = (void *)inst;
+	x86_imm_emit32(inst, fixup);
+	return inst;
+}
+
 /*
  * fixup a register being alloca'd to by accounting for the param area
  */
@@ -1409,10 +1498,12 @@ xmm_cmp_reg_imm(jit_gencode_t gen, unsigned char *inst, int xreg, void *imm,
 		if(is_double)
 		{
 			x86_64_ucomisd_reg_membase(inst, xreg, X86_64_RIP, offset);
+			_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 		}
 		else
 		{
 			x86_64_ucomiss_reg_membase(inst, xreg, X86_64_RIP, offset);
+			_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 		}
 	}
 	else if(((jit_nint)ptr >= jit_min_int) &&
@@ -1816,6 +1907,7 @@ _jit_gen_load_value(jit_gencode_t gen, int reg, int other_reg, jit_value_t value
 						{
 							/* We can use RIP relative addressing here */
 							x86_64_fld_membase_size(inst, X86_64_RIP, offset, 4);
+							_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 						}
 						else if(((jit_nint)ptr >= jit_min_int) &&
 								((jit_nint)ptr <= jit_max_int))
@@ -1885,6 +1977,7 @@ _jit_gen_load_value(jit_gencode_t gen, int reg, int other_reg, jit_value_t value
 						{
 							/* We can use RIP relative addressing here */
 							x86_64_fld_membase_size(inst, X86_64_RIP, offset, 8);
+							_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 						}
 						else if(((jit_nint)ptr >= jit_min_int) &&
 								((jit_nint)ptr <= jit_max_int))
@@ -1931,6 +2024,7 @@ _jit_gen_load_value(jit_gencode_t gen, int reg, int other_reg, jit_value_t value
 					{
 						/* We can use RIP relative addressing here */
 						x86_64_movsd_reg_membase(inst, xmm_reg, X86_64_RIP, offset);
+						_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 					}
 					else if(((jit_nint)ptr >= jit_min_int) &&
 							((jit_nint)ptr <= jit_max_int))
@@ -1968,10 +2062,12 @@ _jit_gen_load_value(jit_gencode_t gen, int reg, int other_reg, jit_value_t value
 							if(sizeof(jit_nfloat) == sizeof(jit_float64))
 							{
 								x86_64_fld_membase_size(inst, X86_64_RIP, offset, 8);
+								_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 							}
 							else
 							{
 								x86_64_fld_membase_size(inst, X86_64_RIP, offset, 10);
+								_jit_gen_reloc(gen, inst - 4, JIT_RELOC_RELATIVE32, 0);
 							}
 						}
 						else if(((jit_nint)ptr >= jit_min_int) &&
@@ -2199,6 +2295,14 @@ _jit_gen_load_value(jit_gencode_t gen, int reg, int other_reg, jit_value_t value
 					fputs("Unsupported struct/union reg - reg move\n", stderr);
 				}
 			}
+			break;
+
+			case JIT_TYPE_VECTOR:
+			{
+				x86_64_movaps_reg_reg(inst, _jit_reg_info[reg].cpu_reg,
+									  _jit_reg_info[src_reg].cpu_reg);
+			}
+			break;
 		}
 	}
 	else
@@ -2375,6 +2479,14 @@ _jit_gen_load_value(jit_gencode_t gen, int reg, int other_reg, jit_value_t value
 					}
 				}
 			}
+			break;
+
+			case JIT_TYPE_VECTOR:
+			{
+				x86_64_movups_reg_membase(inst, _jit_reg_info[reg].cpu_reg,
+										  X86_64_RBP, offset);
+			}
+			break;
 		}
 	}
 
@@ -2475,9 +2587,17 @@ _jit_gen_prolog(jit_gencode_t gen, jit_function_t func, void *buf)
 	if(func->builder->param_area_size > 0x50 && regs_to_save > 0)
 	{
 		x86_64_sub_reg_imm_size(inst, X86_64_RSP, func->builder->param_area_size, 8);
+		frame_size += func->builder->param_area_size;
 	}
 #endif /* JIT_USE_PARAM_AREA */
 
+	/* Record the stack usage of leaf functions: the frame, the saved rbp,
+	   the return address and the red zone used by temporary spills */
+	if(func->is_leaf)
+	{
+		func->leaf_stack_size = frame_size + 16 + 128;
+	}
+
 	/* Copy the prolog into place and return the adjusted entry position */
 	reg = (int)(inst - prolog);
 	jit_memcpy(((unsigned char *)buf) + JIT_PROLOG_SIZE - reg, prolog, reg);
@@ -2488,7 +2608,7 @@ void
 _jit_gen_epilog(jit_gencode_t gen, jit_function_t func)
 {
 	unsigned char *inst;
-	int reg;
+	int reg, type;
 	int current_offset;
 	jit_int *fixup;
 	jit_int *next;
@@ -2597,6 +2717,26 @@ _jit_gen_epilog(jit_gencode_t gen, jit_function_t func)
 	/* and return */
 	x86_64_ret(inst);
 
+	/* Output the code that throws the builtin exceptions of the checks */
+	for(type = 1; type < X86_64_NUM_THROW_FIXUPS; ++type)
+	{
+		fixup = (jit_int *)(gen->throw_fixup[type]);
+		if(!fixup)
+		{
+			continue;
+		}
+		gen->ptr = inst;
+		_jit_gen_check_space(gen, 32);
+		while(fixup != 0)
+		{
+			next = (jit_int *)_JIT_CALC_NEXT_FIXUP(fixup, fixup[0]);
+			fixup[0] = (jit_int)(((jit_nint)inst) - ((jit_nint)fixup) - 4);
+			fixup = next;
+		}
+		gen->throw_fixup[type] = 0;
+		inst = throw_builtin(gen, inst, func, -type);
+	}
+
 	gen->ptr = inst;
 }
 
@@ -2729,7 +2869,7 @@ memory_copy(jit_gencode_t gen, unsigned char *inst,
 	{
 		x86_64_add_reg_imm_size(inst, X86_64_RDI, doffset, 8);
 	}
-	inst = x86_64_call_code(inst, (jit_nint)jit_memcpy);
+	inst = x86_64_call_code(gen, inst, (jit_nint)jit_memcpy);
 	return inst;
 }
 
@@ -2848,12 +2988,12 @@ _jit_gen_start_block(jit_gencode_t gen, jit_block_t block)
 	}
 	block->fixup_list = 0;
 
-	/* Absolute fixups contain complete pointers */
+	/* Absolute fixups contain complete pointers to where the code runs */
 	absolute_fixup = (void**)(block->fixup_absolute_list);
 	while(absolute_fixup != 0)
 	{
 		absolute_next = (void **)(absolute_fixup[0]);
-		absolute_fixup[0] = (void *)((jit_nint)(block->address));
+		absolute_fixup[0] = (void *)((jit_nint)(block->address) + gen->exec_offset);
 		absolute_fixup = absolute_next;
 	}
 	block->fixup_absolute_list = 0;
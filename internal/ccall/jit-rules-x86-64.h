@@ -102,6 +102,13 @@ extern	"C" {
  */
 #define	JIT_FUNCTION_ALIGNMENT		32
 
+/*
+ * Preferred alignment for the headers of loops, and the most padding
+ * that may be output to reach it.
+ */
+#define	JIT_LOOP_ALIGNMENT		16
+#define	JIT_LOOP_MAX_PADDING		10
+
 /*
  * Define this to 1 if the platform allows reads and writes on
  * any byte boundary.  Define to 0 if only properly-aligned
@@ -111,14 +118,19 @@ extern	"C" {
 
 /*
  * Extra state information that is added to the "jit_gencode" structure.
+ * There is a fixup list of the checks that throw each builtin exception,
+ * indexed by the negated JIT_RESULT_ code of the exception.
  */
+#define X86_64_NUM_THROW_FIXUPS		10
 
 #define jit_extra_gen_state	\
-	void *alloca_fixup
+	void *alloca_fixup;	\
+	void *throw_fixup[X86_64_NUM_THROW_FIXUPS]
 
 #define jit_extra_gen_init(gen)	\
 	do {	\
 		(gen)->alloca_fixup = 0;	\
+		jit_memzero((gen)->throw_fixup, sizeof((gen)->throw_fixup));	\
 	} while (0)
 
 #define jit_extra_gen_cleanup(gen)	do { ; } while (0)
@@ -751,6 +751,7 @@ void *
 _jit_gen_alloc(jit_gencode_t gen, unsigned long size)
 {
 	void *ptr;
+	_jit_image_block_t *blocks;
 	_jit_memory_set_break(gen->context, gen->ptr);
 	ptr = _jit_memory_alloc_data(gen->context, size, JIT_BEST_ALIGNMENT);
 	if(!ptr)
@@ -758,9 +759,97 @@ _jit_gen_alloc(jit_gencode_t gen, unsigned long size)
 		jit_exception_builtin(JIT_RESULT_MEMORY_FULL);
 	}
 	gen->mem_limit = _jit_memory_get_limit(gen->context);
+
+	/* The ELF writer copies the data along with the code */
+	if(gen->image)
+	{
+		if(gen->image->num_blocks >= gen->image->max_blocks)
+		{
+			blocks = (_jit_image_block_t *)jit_realloc
+				(gen->image->blocks, sizeof(_jit_image_block_t) *
+				 (gen->image->max_blocks + 8));
+			if(!blocks)
+			{
+				jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+			}
+			gen->image->blocks = blocks;
+			gen->image->max_blocks += 8;
+		}
+		blocks = &(gen->image->blocks[gen->image->num_blocks++]);
+		blocks->address = (unsigned char *)ptr;
+		blocks->size = size;
+	}
 	return ptr;
 }
 
+void
+_jit_gen_reloc(jit_gencode_t gen, void *address, int type, const char *name)
+{
+	_jit_image_reloc_t *relocs;
+	char *name_copy;
+	if(!gen->image)
+	{
+		return;
+	}
+	if(gen->image->num_relocs >= gen->image->max_relocs)
+	{
+		relocs = (_jit_image_reloc_t *)jit_realloc
+			(gen->image->relocs, sizeof(_jit_image_reloc_t) *
+			 (gen->image->max_relocs + 16));
+		if(!relocs)
+		{
+			jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+		}
+		gen->image->relocs = relocs;
+		gen->image->max_relocs += 16;
+	}
+	name_copy = 0;
+	if(name)
+	{
+		name_copy = jit_strdup(name);
+		if(!name_copy)
+		{
+			jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+		}
+	}
+	relocs = &(gen->image->relocs[gen->image->num_relocs++]);
+	relocs->address = (unsigned char *)address;
+	relocs->type = type;
+	relocs->name = name_copy;
+}
+
+_jit_image_t
+_jit_image_create(void)
+{
+	return jit_cnew(struct _jit_image);
+}
+
+void
+_jit_image_reset(_jit_image_t image)
+{
+	int index;
+	for(index = 0; index < image->num_relocs; ++index)
+	{
+		jit_free(image->relocs[index].name);
+	}
+	image->code_start = 0;
+	image->code_end = 0;
+	image->num_blocks = 0;
+	image->num_relocs = 0;
+}
+
+void
+_jit_image_free(_jit_image_t image)
+{
+	if(image)
+	{
+		_jit_image_reset(image);
+		jit_free(image->blocks);
+		jit_free(image->relocs);
+		jit_free(image);
+	}
+}
+
 int _jit_int_lowest_byte(void)
 {
 	union
@@ -164,6 +164,7 @@ struct jit_gencode
 	unsigned char		*mem_limit;	/* Available space limit */
 	unsigned char		*code_start;	/* Real code start */
 	unsigned char		*code_end;	/* Real code end */
+	jit_nint		exec_offset;	/* Offset from "ptr" to where the code runs */
 	jit_regused_t		permanent;	/* Permanently allocated global regs */
 	jit_regused_t		touched;	/* All registers that were touched */
 	jit_regused_t		inhibit;	/* Temporarily inhibited registers */
@@ -178,6 +179,7 @@ struct jit_gencode
 	void			*epilog_fixup;	/* Fixup list for function epilogs */
 	int			stack_changed;	/* Stack top changed since entry */
 	jit_varint_encoder_t	offset_encoder;	/* Bytecode offset encoder */
+	_jit_image_t		image;		/* Image for the ELF writer, or NULL */
 };
 
 /*
@@ -206,6 +208,13 @@ void _jit_gen_check_space(jit_gencode_t gen, int space);
  */
 void *_jit_gen_alloc(jit_gencode_t gen, unsigned long size);
 
+/*
+ * Record that the code or data at "address" refers to another
+ * location, if the function is compiled for the ELF writer.
+ * See JIT_RELOC_ABSOLUTE and JIT_RELOC_RELATIVE32 for the types.
+ */
+void _jit_gen_reloc(jit_gencode_t gen, void *address, int type, const char *name);
+
 void _jit_init_backend(void);
 void _jit_gen_get_elf_info(jit_elf_info_t *info);
 int _jit_create_entry_insns(jit_function_t func);
@@ -25,6 +25,13 @@
 
 #include <setjmp.h>
 
+/*
+ * glibc only provides "sigsetjmp" as a macro that expands to "__sigsetjmp".
+ */
+#if defined(__GLIBC__) && !defined(HAVE___SIGSETJMP)
+# define HAVE___SIGSETJMP 1
+#endif
+
 #ifdef	__cplusplus
 extern	"C" {
 #endif
@@ -38,6 +45,7 @@ typedef struct jit_jmp_buf
 	jit_backtrace_t		trace;
 	void			   *catch_pc;
 	struct jit_jmp_buf *parent;
+	unsigned int		epoch_depth;
 
 } jit_jmp_buf;
 #define	jit_jmp_catch_pc_offset	\
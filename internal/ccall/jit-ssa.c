@@ -0,0 +1,2233 @@
+/*
+ * jit-ssa.c - SSA-based optimizations for function bodies.
+ *
+ * This file is part of the libjit library.
+ *
+ * The libjit library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * The libjit library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the libjit library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "jit-internal.h"
+#include "jit-rules.h"
+
+#include <string.h>
+
+/*
+ * The optimizer builds an SSA view of the function on the side: every
+ * definition of a value gets a number, phi functions are placed on the
+ * dominance frontiers, and every use refers to the definition that
+ * reaches it.  Sparse conditional constant propagation and dominator
+ * based value numbering run on that view, and only their results are
+ * written back into the instructions, so the rest of the compiler never
+ * sees a phi function.
+ *
+ * A value takes part if it is a local or a temporary of the function that
+ * is neither addressable nor volatile and is not a structure.  Each such
+ * value has an implicit definition on function entry.
+ */
+
+/*
+ * Slots of an instruction that may hold a value.
+ */
+#define	SLOT_DEST		0
+#define	SLOT_VALUE1		1
+#define	SLOT_VALUE2		2
+#define	NUM_SLOTS		3
+
+/*
+ * Constant propagation lattice.
+ */
+#define	LATTICE_TOP		0
+#define	LATTICE_CONST		1
+#define	LATTICE_BOTTOM		2
+
+/*
+ * Outcome of a conditional branch.
+ */
+#define	BRANCH_UNKNOWN		-2
+#define	BRANCH_BOTH		-1
+#define	BRANCH_NOT_TAKEN	0
+#define	BRANCH_TAKEN		1
+
+/*
+ * Maximum number of arrays that the optimizer allocates.
+ */
+#define	SSA_MAX_ARRAYS		48
+
+/*
+ * Definition of a value on function entry, by a phi function or by an
+ * instruction.
+ */
+typedef struct
+{
+	int			var;
+	int			block;
+	int			insn;
+	int			phi;
+
+	/* Constant propagation state */
+	int			state;
+	jit_value_t		constant;
+	int			queued;
+
+	/* Value number: the definition itself or an earlier one that
+	   computes the same value and whose value never changes */
+	int			number;
+
+} _jit_ssa_def_t;
+
+/*
+ * Phi function that merges the definitions of a value reaching a block,
+ * with one argument for each predecessor edge.
+ */
+typedef struct
+{
+	int			var;
+	int			block;
+	int			def;
+	int			args;
+	int			next;
+
+} _jit_ssa_phi_t;
+
+/*
+ * Operand of an instruction for value numbering.
+ */
+typedef struct
+{
+	int			def;
+	jit_value_t		constant;
+
+} _jit_ssa_operand_t;
+
+/*
+ * State of the optimizer for one function.
+ */
+typedef struct
+{
+	jit_function_t		func;
+
+	/* Blocks in reverse postorder, and their instructions */
+	jit_block_t		*blocks;
+	int			num_blocks;
+	int			*pred_base;
+	int			num_edges;
+	int			*insn_base;
+	int			*insn_block;
+	int			num_insns;
+
+	/* Values that take part */
+	jit_value_t		*vars;
+	int			num_vars;
+	int			*num_var_defs;
+	int			*var_stamp;
+
+	/* Dominator tree and dominance frontiers */
+	int			*idom;
+	int			*dom_child;
+	int			*dom_sibling;
+	int			*dom_pre;
+	int			*dom_last;
+	int			*df_base;
+	int			*df;
+
+	/* Phi functions */
+	_jit_ssa_phi_t		*phis;
+	int			num_phis;
+	int			max_phis;
+	int			*phi_args;
+	int			num_phi_args;
+	int			max_phi_args;
+	int			*block_phis;
+
+	/* Definitions and uses */
+	_jit_ssa_def_t		*defs;
+	int			num_defs;
+	int			*insn_def;
+	int			*use_def;
+	int			*user_base;
+	int			*users;
+
+	/* Constant propagation */
+	char			*block_exec;
+	char			*edge_exec;
+	int			*flow;
+	int			num_flow;
+	int			*work;
+	int			num_work;
+
+	/* Value numbering */
+	int			*table;
+	int			table_mask;
+
+	/* Scratch arrays */
+	int			*stack;
+	int			*marks;
+	int			*log;
+
+	void			*arrays[SSA_MAX_ARRAYS];
+	int			num_arrays;
+
+} _jit_ssa_t;
+
+/*
+ * Allocate a zeroed array that is released with the optimizer state.
+ */
+static void *
+ssa_alloc(_jit_ssa_t *ssa, int count, int size)
+{
+	void *array;
+
+	if(ssa->num_arrays >= SSA_MAX_ARRAYS)
+	{
+		return 0;
+	}
+	array = jit_calloc(count > 0 ? count : 1, size);
+	if(array)
+	{
+		ssa->arrays[ssa->num_arrays++] = array;
+	}
+	return array;
+}
+
+static void
+ssa_free(_jit_ssa_t *ssa)
+{
+	int index;
+
+	for(index = 0; index < ssa->num_arrays; index++)
+	{
+		jit_free(ssa->arrays[index]);
+	}
+	jit_free(ssa->phis);
+	jit_free(ssa->phi_args);
+}
+
+/*
+ * Get the value in an instruction slot, or NULL if the slot holds
+ * something else.
+ */
+static jit_value_t
+get_slot(jit_insn_t insn, int slot)
+{
+	switch(slot)
+	{
+	case SLOT_DEST:
+		if((insn->flags & JIT_INSN_DEST_OTHER_FLAGS) != 0)
+		{
+			return 0;
+		}
+		return insn->dest;
+
+	case SLOT_VALUE1:
+		if((insn->flags & JIT_INSN_VALUE1_OTHER_FLAGS) != 0)
+		{
+			return 0;
+		}
+		return insn->value1;
+	}
+
+	if((insn->flags & JIT_INSN_VALUE2_OTHER_FLAGS) != 0)
+	{
+		return 0;
+	}
+	return insn->value2;
+}
+
+static void
+set_slot(jit_insn_t insn, int slot, jit_value_t value)
+{
+	switch(slot)
+	{
+	case SLOT_DEST:
+		insn->dest = value;
+		break;
+
+	case SLOT_VALUE1:
+		insn->value1 = value;
+		break;
+
+	default:
+		insn->value2 = value;
+		break;
+	}
+}
+
+/*
+ * Get the slot that an instruction defines, or -1 if it defines nothing.
+ * A few notes define their first value rather than the destination.
+ */
+static int
+get_def_slot(jit_insn_t insn)
+{
+	switch(insn->opcode)
+	{
+	case JIT_OP_NOP:
+		return -1;
+
+	case JIT_OP_INCOMING_REG:
+	case JIT_OP_INCOMING_FRAME_POSN:
+	case JIT_OP_RETURN_REG:
+	case JIT_OP_FLUSH_SMALL_STRUCT:
+		return SLOT_VALUE1;
+	}
+
+	if(insn->dest
+	   && (insn->flags & (JIT_INSN_DEST_OTHER_FLAGS | JIT_INSN_DEST_IS_VALUE)) == 0)
+	{
+		return SLOT_DEST;
+	}
+	return -1;
+}
+
+/*
+ * Determine if an instruction slot holds a value that it uses.
+ */
+static int
+is_use_slot(jit_insn_t insn, int slot)
+{
+	if(insn->opcode == JIT_OP_NOP)
+	{
+		return 0;
+	}
+	if(slot == SLOT_DEST)
+	{
+		return (insn->flags & JIT_INSN_DEST_IS_VALUE) != 0;
+	}
+	return slot != get_def_slot(insn);
+}
+
+/*
+ * Determine if an opcode computes its result from its operands alone.
+ */
+static int
+is_pure(int opcode)
+{
+	return (opcode >= JIT_OP_TRUNC_SBYTE && opcode <= JIT_OP_LSHR_UN)
+		|| (opcode >= JIT_OP_ICMP && opcode <= JIT_OP_NFSIGN);
+}
+
+static int
+is_copy(int opcode)
+{
+	return opcode >= JIT_OP_COPY_INT && opcode <= JIT_OP_COPY_NFLOAT;
+}
+
+static int
+is_cond_branch(int opcode)
+{
+	return opcode > JIT_OP_BR && opcode <= JIT_OP_BR_NFGE_INV;
+}
+
+static int
+is_return(int opcode)
+{
+	return opcode >= JIT_OP_RETURN_INT && opcode <= JIT_OP_RETURN_NFLOAT;
+}
+
+/*
+ * Determine if a pure opcode may throw an exception, so that it must
+ * stay even when its result is not used.
+ */
+static int
+may_throw(int opcode)
+{
+	switch(opcode)
+	{
+	case JIT_OP_CHECK_SBYTE:
+	case JIT_OP_CHECK_UBYTE:
+	case JIT_OP_CHECK_SHORT:
+	case JIT_OP_CHECK_USHORT:
+	case JIT_OP_CHECK_INT:
+	case JIT_OP_CHECK_UINT:
+	case JIT_OP_CHECK_LOW_WORD:
+	case JIT_OP_CHECK_SIGNED_LOW_WORD:
+	case JIT_OP_CHECK_LONG:
+	case JIT_OP_CHECK_ULONG:
+	case JIT_OP_CHECK_FLOAT32_TO_INT:
+	case JIT_OP_CHECK_FLOAT32_TO_UINT:
+	case JIT_OP_CHECK_FLOAT32_TO_LONG:
+	case JIT_OP_CHECK_FLOAT32_TO_ULONG:
+	case JIT_OP_CHECK_FLOAT64_TO_INT:
+	case JIT_OP_CHECK_FLOAT64_TO_UINT:
+	case JIT_OP_CHECK_FLOAT64_TO_LONG:
+	case JIT_OP_CHECK_FLOAT64_TO_ULONG:
+	case JIT_OP_CHECK_NFLOAT_TO_INT:
+	case JIT_OP_CHECK_NFLOAT_TO_UINT:
+	case JIT_OP_CHECK_NFLOAT_TO_LONG:
+	case JIT_OP_CHECK_NFLOAT_TO_ULONG:
+	case JIT_OP_IADD_OVF:
+	case JIT_OP_IADD_OVF_UN:
+	case JIT_OP_ISUB_OVF:
+	case JIT_OP_ISUB_OVF_UN:
+	case JIT_OP_IMUL_OVF:
+	case JIT_OP_IMUL_OVF_UN:
+	case JIT_OP_IDIV:
+	case JIT_OP_IDIV_UN:
+	case JIT_OP_IREM:
+	case JIT_OP_IREM_UN:
+	case JIT_OP_LADD_OVF:
+	case JIT_OP_LADD_OVF_UN:
+	case JIT_OP_LSUB_OVF:
+	case JIT_OP_LSUB_OVF_UN:
+	case JIT_OP_LMUL_OVF:
+	case JIT_OP_LMUL_OVF_UN:
+	case JIT_OP_LDIV:
+	case JIT_OP_LDIV_UN:
+	case JIT_OP_LREM:
+	case JIT_OP_LREM_UN:
+		return 1;
+	}
+	return 0;
+}
+
+static int
+is_commutative(int opcode)
+{
+	switch(jit_opcodes[opcode].flags & JIT_OPCODE_OPER_MASK)
+	{
+	case JIT_OPCODE_OPER_ADD:
+	case JIT_OPCODE_OPER_MUL:
+	case JIT_OPCODE_OPER_AND:
+	case JIT_OPCODE_OPER_OR:
+	case JIT_OPCODE_OPER_XOR:
+	case JIT_OPCODE_OPER_EQ:
+	case JIT_OPCODE_OPER_NE:
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Determine if the optimizer tracks the definitions of a value.
+ */
+static int
+is_candidate(jit_function_t func, jit_value_t value)
+{
+	jit_type_t type;
+
+	if(!value || value->is_constant || value->is_addressable || value->is_volatile)
+	{
+		return 0;
+	}
+	if(!value->is_temporary && !value->is_local)
+	{
+		return 0;
+	}
+	if(!value->block || value->block->func != func)
+	{
+		return 0;
+	}
+	type = jit_type_normalize(value->type);
+	return type && type->kind != JIT_TYPE_STRUCT && type->kind != JIT_TYPE_UNION
+		&& type->kind != JIT_TYPE_VECTOR;
+}
+
+static int
+same_type(jit_value_t value1, jit_value_t value2)
+{
+	return jit_type_normalize(value1->type) == jit_type_normalize(value2->type);
+}
+
+/*
+ * Compare two constants bit for bit.
+ */
+static int
+same_constant(jit_value_t value1, jit_value_t value2)
+{
+	jit_constant_t const1, const2;
+	jit_type_t type;
+
+	if(value1 == value2)
+	{
+		return 1;
+	}
+	type = jit_type_normalize(value1->type);
+	if(type != jit_type_normalize(value2->type))
+	{
+		return 0;
+	}
+	const1 = jit_value_get_constant(value1);
+	const2 = jit_value_get_constant(value2);
+	switch(type->kind)
+	{
+	case JIT_TYPE_INT:
+	case JIT_TYPE_UINT:
+		return const1.un.int_value == const2.un.int_value;
+
+	case JIT_TYPE_LONG:
+	case JIT_TYPE_ULONG:
+		return const1.un.long_value == const2.un.long_value;
+
+	case JIT_TYPE_FLOAT32:
+		return memcmp(&const1.un.float32_value, &const2.un.float32_value,
+			      sizeof(jit_float32)) == 0;
+
+	case JIT_TYPE_FLOAT64:
+		return memcmp(&const1.un.float64_value, &const2.un.float64_value,
+			      sizeof(jit_float64)) == 0;
+
+	case JIT_TYPE_NFLOAT:
+		return memcmp(&const1.un.nfloat_value, &const2.un.nfloat_value,
+			      sizeof(jit_nfloat)) == 0;
+	}
+	return 0;
+}
+
+static unsigned int
+hash_constant(jit_value_t value)
+{
+	jit_constant_t constant;
+	jit_type_t type;
+	jit_ulong bits;
+
+	constant = jit_value_get_constant(value);
+	type = jit_type_normalize(value->type);
+	bits = 0;
+	switch(type->kind)
+	{
+	case JIT_TYPE_INT:
+	case JIT_TYPE_UINT:
+		bits = (jit_uint) constant.un.int_value;
+		break;
+
+	case JIT_TYPE_LONG:
+	case JIT_TYPE_ULONG:
+		bits = (jit_ulong) constant.un.long_value;
+		break;
+
+	case JIT_TYPE_FLOAT32:
+		memcpy(&bits, &constant.un.float32_value, sizeof(jit_float32));
+		break;
+
+	case JIT_TYPE_FLOAT64:
+		memcpy(&bits, &constant.un.float64_value, sizeof(jit_float64));
+		break;
+	}
+	return (unsigned int) (bits ^ (bits >> 32)) * 0x9E3779B1u + type->kind;
+}
+
+/*
+ * Create a constant of the type of a value.
+ */
+static jit_value_t
+constant_for(jit_function_t func, jit_value_t constant, jit_value_t value)
+{
+	jit_constant_t result;
+
+	if(constant->type == value->type)
+	{
+		return constant;
+	}
+	result = jit_value_get_constant(constant);
+	result.type = value->type;
+	return jit_value_create_constant(func, &result);
+}
+
+/*
+ * Record that a value is used in a block.  A temporary that is used
+ * outside of the block that defines it becomes a local, the same way
+ * "jit_value_ref" converts it while the function is built.
+ */
+static void
+ref_value(_jit_ssa_t *ssa, int def, int block)
+{
+	jit_value_t value;
+
+	value = ssa->vars[ssa->defs[def].var];
+	value->usage_count++;
+	if(value->is_temporary && ssa->defs[def].block != block)
+	{
+		value->is_temporary = 0;
+		value->is_local = 1;
+		if(_jit_gen_is_global_candidate(value->type))
+		{
+			value->global_candidate = 1;
+		}
+	}
+}
+
+/*
+ * Determine if block "dom" dominates block "block".
+ */
+static int
+dominates(_jit_ssa_t *ssa, int dom, int block)
+{
+	return ssa->dom_pre[dom] <= ssa->dom_pre[block]
+		&& ssa->dom_pre[block] <= ssa->dom_last[dom];
+}
+
+/*
+ * Determine if a definition keeps its value wherever it dominates, so
+ * that its value may replace the values of other definitions.
+ */
+static int
+is_stable(_jit_ssa_t *ssa, int def)
+{
+	_jit_ssa_def_t *d = &ssa->defs[def];
+
+	if(d->insn >= 0)
+	{
+		return ssa->num_var_defs[d->var] == 1;
+	}
+	if(d->phi >= 0)
+	{
+		return 0;
+	}
+	return ssa->num_var_defs[d->var] == 0;
+}
+
+/*
+ * Get the instruction with the given number.
+ */
+static jit_insn_t
+get_insn(_jit_ssa_t *ssa, int insn)
+{
+	int block = ssa->insn_block[insn];
+	return &ssa->blocks[block]->insns[insn - ssa->insn_base[block]];
+}
+
+/*
+ * Get the position of an edge among the predecessors of its destination.
+ */
+static int
+get_pred_index(_jit_edge_t edge)
+{
+	int index;
+
+	for(index = 0; index < edge->dst->num_preds; index++)
+	{
+		if(edge->dst->preds[index] == edge)
+		{
+			return index;
+		}
+	}
+	return -1;
+}
+
+/*
+ * Number the blocks in reverse postorder and the values that take part.
+ * Returns zero if the function has a shape that the optimizer does not
+ * handle.
+ */
+static int
+number_blocks_and_values(_jit_ssa_t *ssa)
+{
+	jit_function_t func = ssa->func;
+	jit_block_t block;
+	jit_insn_t insn;
+	jit_value_t value;
+	int index, count, slot, max_vars;
+
+	for(block = func->builder->entry_block; block; block = block->next)
+	{
+		/* Blocks that are taken address of may be entered from anywhere */
+		if(block->address_of)
+		{
+			return 0;
+		}
+		block->index = -1;
+	}
+
+	ssa->num_blocks = func->builder->num_block_order;
+	ssa->blocks = ssa_alloc(ssa, ssa->num_blocks, sizeof(jit_block_t));
+	ssa->pred_base = ssa_alloc(ssa, ssa->num_blocks + 1, sizeof(int));
+	ssa->insn_base = ssa_alloc(ssa, ssa->num_blocks + 1, sizeof(int));
+	if(!ssa->blocks || !ssa->pred_base || !ssa->insn_base)
+	{
+		return 0;
+	}
+	for(index = 0; index < ssa->num_blocks; index++)
+	{
+		block = func->builder->block_order[ssa->num_blocks - 1 - index];
+		block->index = index;
+		ssa->blocks[index] = block;
+	}
+	if(ssa->num_blocks == 0 || ssa->blocks[0] != func->builder->entry_block
+	   || ssa->blocks[0]->num_preds != 0)
+	{
+		return 0;
+	}
+
+	/* Number the instructions and predecessor edges */
+	for(index = 0; index < ssa->num_blocks; index++)
+	{
+		ssa->pred_base[index + 1] = ssa->pred_base[index] + ssa->blocks[index]->num_preds;
+		ssa->insn_base[index + 1] = ssa->insn_base[index] + ssa->blocks[index]->num_insns;
+	}
+	ssa->num_edges = ssa->pred_base[ssa->num_blocks];
+	ssa->num_insns = ssa->insn_base[ssa->num_blocks];
+	ssa->insn_block = ssa_alloc(ssa, ssa->num_insns, sizeof(int));
+	max_vars = ssa->num_insns * NUM_SLOTS;
+	ssa->vars = ssa_alloc(ssa, max_vars, sizeof(jit_value_t));
+	if(!ssa->insn_block || !ssa->vars)
+	{
+		return 0;
+	}
+
+	/* Reset the value indexes before numbering the values */
+	for(index = 0; index < ssa->num_blocks; index++)
+	{
+		block = ssa->blocks[index];
+		for(count = 0; count < block->num_insns; count++)
+		{
+			insn = &block->insns[count];
+			ssa->insn_block[ssa->insn_base[index] + count] = index;
+			for(slot = 0; slot < NUM_SLOTS; slot++)
+			{
+				value = get_slot(insn, slot);
+				if(value && insn->opcode != JIT_OP_NOP)
+				{
+					value->index = -1;
+				}
+			}
+		}
+	}
+	for(index = 0; index < ssa->num_insns; index++)
+	{
+		insn = get_insn(ssa, index);
+		if(insn->opcode == JIT_OP_NOP)
+		{
+			continue;
+		}
+		for(slot = 0; slot < NUM_SLOTS; slot++)
+		{
+			value = get_slot(insn, slot);
+			if(value && value->index < 0 && is_candidate(func, value))
+			{
+				value->index = ssa->num_vars;
+				ssa->vars[ssa->num_vars++] = value;
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+ * Compute the dominator tree with the algorithm of Cooper, Harvey and
+ * Kennedy, and the dominance frontiers of the blocks.
+ */
+static int
+compute_dominators(_jit_ssa_t *ssa)
+{
+	jit_block_t block;
+	int *idom, *count;
+	int index, pred, dom, other, runner, changed, top, num;
+
+	ssa->idom = idom = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	ssa->dom_child = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	ssa->dom_sibling = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	ssa->dom_pre = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	ssa->dom_last = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	ssa->df_base = ssa_alloc(ssa, ssa->num_blocks + 1, sizeof(int));
+	ssa->stack = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	ssa->marks = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	if(!idom || !ssa->dom_child || !ssa->dom_sibling || !ssa->dom_pre
+	   || !ssa->dom_last || !ssa->df_base || !ssa->stack || !ssa->marks)
+	{
+		return 0;
+	}
+
+	for(index = 0; index < ssa->num_blocks; index++)
+	{
+		idom[index] = -1;
+	}
+	idom[0] = 0;
+	do
+	{
+		changed = 0;
+		for(index = 1; index < ssa->num_blocks; index++)
+		{
+			block = ssa->blocks[index];
+			dom = -1;
+			for(pred = 0; pred < block->num_preds; pred++)
+			{
+				other = block->preds[pred]->src->index;
+				if(other < 0 || idom[other] < 0)
+				{
+					continue;
+				}
+				if(dom < 0)
+				{
+					dom = other;
+					continue;
+				}
+				while(dom != other)
+				{
+					while(dom > other)
+					{
+						dom = idom[dom];
+					}
+					while(other > dom)
+					{
+						other = idom[other];
+					}
+				}
+			}
+			if(idom[index] != dom)
+			{
+				idom[index] = dom;
+				changed = 1;
+			}
+		}
+	}
+	while(changed);
+
+	/* Build the tree and number it in preorder */
+	for(index = 0; index < ssa->num_blocks; index++)
+	{
+		ssa->dom_child[index] = -1;
+		ssa->dom_sibling[index] = -1;
+	}
+	for(index = ssa->num_blocks - 1; index > 0; index--)
+	{
+		ssa->dom_sibling[index] = ssa->dom_child[idom[index]];
+		ssa->dom_child[idom[index]] = index;
+	}
+	num = 0;
+	top = 0;
+	ssa->stack[top++] = 0;
+	while(top > 0)
+	{
+		index = ssa->stack[--top];
+		ssa->dom_pre[index] = num++;
+		for(other = ssa->dom_child[index]; other >= 0; other = ssa->dom_sibling[other])
+		{
+			ssa->stack[top++] = other;
+		}
+	}
+	for(index = 0; index < ssa->num_blocks; index++)
+	{
+		ssa->dom_last[index] = ssa->dom_pre[index];
+	}
+	for(index = ssa->num_blocks - 1; index > 0; index--)
+	{
+		/* Children follow their parents in reverse postorder */
+		if(ssa->dom_last[idom[index]] < ssa->dom_last[index])
+		{
+			ssa->dom_last[idom[index]] = ssa->dom_last[index];
+		}
+	}
+
+	/* Count and then collect the dominance frontiers */
+	count = ssa->marks;
+	for(index = 0; index < ssa->num_blocks; index++)
+	{
+		count[index] = 0;
+	}
+	for(index = 1; index < ssa->num_blocks; index++)
+	{
+		block = ssa->blocks[index];
+		if(block->num_preds < 2)
+		{
+			continue;
+		}
+		for(pred = 0; pred < block->num_preds; pred++)
+		{
+			for(runner = block->preds[pred]->src->index;
+			    runner >= 0 && runner != idom[index]; runner = idom[runner])
+			{
+				++(count[runner]);
+				if(runner == 0)
+				{
+					break;
+				}
+			}
+		}
+	}
+	for(index = 0; index < ssa->num_blocks; index++)
+	{
+		ssa->df_base[index + 1] = ssa->df_base[index] + count[index];
+		count[index] = ssa->df_base[index];
+	}
+	ssa->df = ssa_alloc(ssa, ssa->df_base[ssa->num_blocks], sizeof(int));
+	if(!ssa->df)
+	{
+		return 0;
+	}
+	for(index = 1; index < ssa->num_blocks; index++)
+	{
+		block = ssa->blocks[index];
+		if(block->num_preds < 2)
+		{
+			continue;
+		}
+		for(pred = 0; pred < block->num_preds; pred++)
+		{
+			for(runner = block->preds[pred]->src->index;
+			    runner >= 0 && runner != idom[index]; runner = idom[runner])
+			{
+				ssa->df[count[runner]++] = index;
+				if(runner == 0)
+				{
+					break;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+ * Add a phi function for a value to a block.
+ */
+static int
+add_phi(_jit_ssa_t *ssa, int var, int block)
+{
+	_jit_ssa_phi_t *phis;
+	int *args, num_args, max;
+
+	if(ssa->num_phis >= ssa->max_phis)
+	{
+		max = ssa->max_phis ? ssa->max_phis * 2 : 64;
+		phis = jit_realloc(ssa->phis, max * sizeof(_jit_ssa_phi_t));
+		if(!phis)
+		{
+			return 0;
+		}
+		ssa->phis = phis;
+		ssa->max_phis = max;
+	}
+	num_args = ssa->blocks[block]->num_preds;
+	if(ssa->num_phi_args + num_args > ssa->max_phi_args)
+	{
+		max = ssa->max_phi_args ? ssa->max_phi_args * 2 : 256;
+		while(max < ssa->num_phi_args + num_args)
+		{
+			max *= 2;
+		}
+		args = jit_realloc(ssa->phi_args, max * sizeof(int));
+		if(!args)
+		{
+			return 0;
+		}
+		ssa->phi_args = args;
+		ssa->max_phi_args = max;
+	}
+
+	phis = &ssa->phis[ssa->num_phis];
+	phis->var = var;
+	phis->block = block;
+	phis->def = -1;
+	phis->args = ssa->num_phi_args;
+	phis->next = ssa->block_phis[block];
+	ssa->block_phis[block] = ssa->num_phis++;
+	ssa->num_phi_args += num_args;
+	return 1;
+}
+
+/*
+ * Place phi functions for the values that are live across blocks on the
+ * iterated dominance frontiers of the blocks that define them.
+ */
+static int
+place_phis(_jit_ssa_t *ssa)
+{
+	jit_insn_t insn;
+	jit_value_t value;
+	int *is_global, *def_base, *def_blocks, *phi_stamp, *work_stamp, *count;
+	int index, block, slot, var, top, frontier, num;
+
+	is_global = ssa_alloc(ssa, ssa->num_vars, sizeof(int));
+	def_base = ssa_alloc(ssa, ssa->num_vars + 1, sizeof(int));
+	ssa->num_var_defs = ssa_alloc(ssa, ssa->num_vars, sizeof(int));
+	ssa->var_stamp = ssa_alloc(ssa, ssa->num_vars, sizeof(int));
+	ssa->block_phis = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	phi_stamp = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	work_stamp = ssa_alloc(ssa, ssa->num_blocks, sizeof(int));
+	if(!is_global || !def_base || !ssa->num_var_defs || !ssa->var_stamp
+	   || !ssa->block_phis || !phi_stamp || !work_stamp)
+	{
+		return 0;
+	}
+
+	/* Find the values that are used in a block before it defines them,
+	   and count the definitions of each value */
+	count = ssa->num_var_defs;
+	for(var = 0; var < ssa->num_vars; var++)
+	{
+		ssa->var_stamp[var] = -1;
+	}
+	for(index = 0; index < ssa->num_insns; index++)
+	{
+		insn = get_insn(ssa, index);
+		block = ssa->insn_block[index];
+		for(slot = 0; slot < NUM_SLOTS; slot++)
+		{
+			value = get_slot(insn, slot);
+			if(value && value->index >= 0 && is_use_slot(insn, slot)
+			   && ssa->var_stamp[value->index] != block)
+			{
+				is_global[value->index] = 1;
+			}
+		}
+		slot = get_def_slot(insn);
+		value = slot >= 0 ? get_slot(insn, slot) : 0;
+		if(value && value->index >= 0)
+		{
+			ssa->var_stamp[value->index] = block;
+			++(count[value->index]);
+		}
+	}
+
+	/* Collect the blocks that define each value */
+	for(var = 0; var < ssa->num_vars; var++)
+	{
+		def_base[var + 1] = def_base[var] + count[var];
+	}
+	def_blocks = ssa_alloc(ssa, def_base[ssa->num_vars], sizeof(int));
+	if(!def_blocks)
+	{
+		return 0;
+	}
+	for(var = 0; var < ssa->num_vars; var++)
+	{
+		ssa->var_stamp[var] = def_base[var];
+	}
+	for(index = 0; index < ssa->num_insns; index++)
+	{
+		insn = get_insn(ssa, index);
+		slot = get_def_slot(insn);
+		value = slot >= 0 ? get_slot(insn, slot) : 0;
+		if(value && value->index >= 0)
+		{
+			def_blocks[ssa->var_stamp[value->index]++] = ssa->insn_block[index];
+		}
+	}
+
+	/* The entry block defines every value, so phi placement only needs
+	   the blocks with explicit definitions */
+	for(index = 0; index < ssa->num_blocks; index++)
+	{
+		ssa->block_phis[index] = -1;
+		phi_stamp[index] = -1;
+		work_stamp[index] = -1;
+	}
+	ssa->log = ssa_alloc(ssa, ssa->num_blocks + def_base[ssa->num_vars], sizeof(int));
+	if(!ssa->log)
+	{
+		return 0;
+	}
+	for(var = 0; var < ssa->num_vars; var++)
+	{
+		if(!is_global[var])
+		{
+			continue;
+		}
+		top = 0;
+		for(num = def_base[var]; num < def_base[var + 1]; num++)
+		{
+			block = def_blocks[num];
+			if(work_stamp[block] != var)
+			{
+				work_stamp[block] = var;
+				ssa->log[top++] = block;
+			}
+		}
+		while(top > 0)
+		{
+			block = ssa->log[--top];
+			for(num = ssa->df_base[block]; num < ssa->df_base[block + 1]; num++)
+			{
+				frontier = ssa->df[num];
+				if(phi_stamp[frontier] == var)
+				{
+					continue;
+				}
+				phi_stamp[frontier] = var;
+				if(!add_phi(ssa, var, frontier))
+				{
+					return 0;
+				}
+				if(work_stamp[frontier] != var)
+				{
+					work_stamp[frontier] = var;
+					ssa->log[top++] = frontier;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+ * Create a definition.
+ */
+static int
+new_def(_jit_ssa_t *ssa, int var, int block, int insn, int phi)
+{
+	_jit_ssa_def_t *def = &ssa->defs[ssa->num_defs];
+
+	def->var = var;
+	def->block = block;
+	def->insn = insn;
+	def->phi = phi;
+	def->state = (insn < 0 && phi < 0) ? LATTICE_BOTTOM : LATTICE_TOP;
+	def->constant = 0;
+	def->queued = 0;
+	def->number = ssa->num_defs;
+	return ssa->num_defs++;
+}
+
+/*
+ * Rename the values into definitions with a walk over the dominator tree,
+ * recording the definition that reaches each use.
+ */
+static int
+rename_values(_jit_ssa_t *ssa)
+{
+	jit_block_t block;
+	jit_insn_t insn;
+	jit_value_t value;
+	_jit_edge_t edge;
+	int *current, *log_var, *log_def;
+	int index, num, slot, top, num_log, succ, pred, phi, def;
+
+	ssa->defs = ssa_alloc(ssa, ssa->num_vars + ssa->num_phis + ssa->num_insns,
+			      sizeof(_jit_ssa_def_t));
+	ssa->insn_def = ssa_alloc(ssa, ssa->num_insns, sizeof(int));
+	ssa->use_def = ssa_alloc(ssa, ssa->num_insns * NUM_SLOTS, sizeof(int));
+	current = ssa_alloc(ssa, ssa->num_vars, sizeof(int));
+	log_var = ssa_alloc(ssa, ssa->num_phis + ssa->num_insns, sizeof(int));
+	log_def = ssa_alloc(ssa, ssa->num_phis + ssa->num_insns, sizeof(int));
+	if(!ssa->defs || !ssa->insn_def || !ssa->use_def || !current
+	   || !log_var || !log_def)
+	{
+		return 0;
+	}
+
+	for(index = 0; index < ssa->num_vars; index++)
+	{
+		current[index] = new_def(ssa, index, 0, -1, -1);
+	}
+	for(index = 0; index < ssa->num_phis; index++)
+	{
+		ssa->phis[index].def = new_def(ssa, ssa->phis[index].var,
+					       ssa->phis[index].block, -1, index);
+	}
+	for(index = 0; index < ssa->num_insns; index++)
+	{
+		ssa->insn_def[index] = -1;
+	}
+	for(index = 0; index < ssa->num_insns * NUM_SLOTS; index++)
+	{
+		ssa->use_def[index] = -1;
+	}
+	for(index = 0; index < ssa->num_phi_args; index++)
+	{
+		ssa->phi_args[index] = -1;
+	}
+
+	/* A block is entered with a negative mark and left with the
+	   position of the definition log when it was entered */
+	num_log = 0;
+	top = 0;
+	ssa->stack[top] = 0;
+	ssa->marks[top++] = -1;
+	while(top > 0)
+	{
+		index = ssa->stack[top - 1];
+		if(ssa->marks[top - 1] >= 0)
+		{
+			while(num_log > ssa->marks[top - 1])
+			{
+				--num_log;
+				current[log_var[num_log]] = log_def[num_log];
+			}
+			--top;
+			continue;
+		}
+		ssa->marks[top - 1] = num_log;
+		block = ssa->blocks[index];
+
+		for(phi = ssa->block_phis[index]; phi >= 0; phi = ssa->phis[phi].next)
+		{
+			log_var[num_log] = ssa->phis[phi].var;
+			log_def[num_log++] = current[ssa->phis[phi].var];
+			current[ssa->phis[phi].var] = ssa->phis[phi].def;
+		}
+
+		for(num = 0; num < block->num_insns; num++)
+		{
+			insn = &block->insns[num];
+			for(slot = 0; slot < NUM_SLOTS; slot++)
+			{
+				value = get_slot(insn, slot);
+				if(value && value->index >= 0 && is_use_slot(insn, slot))
+				{
+					ssa->use_def[(ssa->insn_base[index] + num) * NUM_SLOTS + slot]
+						= current[value->index];
+				}
+			}
+			slot = get_def_slot(insn);
+			value = slot >= 0 ? get_slot(insn, slot) : 0;
+			if(value && value->index >= 0)
+			{
+				def = new_def(ssa, value->index, index,
+					      ssa->insn_base[index] + num, -1);
+				ssa->insn_def[ssa->insn_base[index] + num] = def;
+				log_var[num_log] = value->index;
+				log_def[num_log++] = current[value->index];
+				current[value->index] = def;
+			}
+		}
+
+		for(succ = 0; succ < block->num_succs; succ++)
+		{
+			edge = block->succs[succ];
+			if(edge->dst->index < 0)
+			{
+				continue;
+			}
+			pred = get_pred_index(edge);
+			for(phi = ssa->block_phis[edge->dst->index]; phi >= 0;
+			    phi = ssa->phis[phi].next)
+			{
+				ssa->phi_args[ssa->phis[phi].args + pred]
+					= current[ssa->phis[phi].var];
+			}
+		}
+
+		for(succ = ssa->dom_child[index]; succ >= 0; succ = ssa->dom_sibling[succ])
+		{
+			ssa->stack[top] = succ;
+			ssa->marks[top++] = -1;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Collect the instructions and phi functions that use each definition.
+ * Instructions are recorded by number and phi functions by the bitwise
+ * complement of their number.
+ */
+static int
+collect_users(_jit_ssa_t *ssa)
+{
+	int *count;
+	int index, num, def;
+
+	ssa->user_base = ssa_alloc(ssa, ssa->num_defs + 1, sizeof(int));
+	count = ssa_alloc(ssa, ssa->num_defs, sizeof(int));
+	if(!ssa->user_base || !count)
+	{
+		return 0;
+	}
+	for(index = 0; index < ssa->num_insns * NUM_SLOTS; index++)
+	{
+		if(ssa->use_def[index] >= 0)
+		{
+			++(count[ssa->use_def[index]]);
+		}
+	}
+	for(index = 0; index < ssa->num_phi_args; index++)
+	{
+		if(ssa->phi_args[index] >= 0)
+		{
+			++(count[ssa->phi_args[index]]);
+		}
+	}
+	for(index = 0; index < ssa->num_defs; index++)
+	{
+		ssa->user_base[index + 1] = ssa->user_base[index] + count[index];
+		count[index] = ssa->user_base[index];
+	}
+	ssa->users = ssa_alloc(ssa, ssa->user_base[ssa->num_defs], sizeof(int));
+	if(!ssa->users)
+	{
+		return 0;
+	}
+	for(index = 0; index < ssa->num_insns * NUM_SLOTS; index++)
+	{
+		def = ssa->use_def[index];
+		if(def >= 0)
+		{
+			ssa->users[count[def]++] = index / NUM_SLOTS;
+		}
+	}
+	for(index = 0; index < ssa->num_phis; index++)
+	{
+		for(num = 0; num < ssa->blocks[ssa->phis[index].block]->num_preds; num++)
+		{
+			def = ssa->phi_args[ssa->phis[index].args + num];
+			if(def >= 0)
+			{
+				ssa->users[count[def]++] = ~index;
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+ * Get the lattice state of an instruction operand.
+ */
+static int
+get_operand_state(_jit_ssa_t *ssa, int insn, int slot, jit_value_t *constant)
+{
+	jit_value_t value;
+	int def;
+
+	value = get_slot(get_insn(ssa, insn), slot);
+	if(!value)
+	{
+		*constant = 0;
+		return LATTICE_BOTTOM;
+	}
+	if(value->is_constant)
+	{
+		*constant = value;
+		return LATTICE_CONST;
+	}
+	def = ssa->use_def[insn * NUM_SLOTS + slot];
+	if(def < 0)
+	{
+		*constant = 0;
+		return LATTICE_BOTTOM;
+	}
+	*constant = ssa->defs[def].constant;
+	return ssa->defs[def].state;
+}
+
+/*
+ * Lower the lattice state of a definition and queue its users.
+ */
+static void
+set_state(_jit_ssa_t *ssa, int def, int state, jit_value_t constant)
+{
+	_jit_ssa_def_t *d = &ssa->defs[def];
+
+	if(state == LATTICE_CONST && d->state == LATTICE_CONST
+	   && !same_constant(constant, d->constant))
+	{
+		state = LATTICE_BOTTOM;
+	}
+	if(state <= d->state)
+	{
+		return;
+	}
+	d->state = state;
+	d->constant = (state == LATTICE_CONST) ? constant : 0;
+	if(!d->queued)
+	{
+		d->queued = 1;
+		ssa->work[ssa->num_work++] = def;
+	}
+}
+
+/*
+ * Evaluate a phi function over the executable incoming edges.
+ */
+static void
+visit_phi(_jit_ssa_t *ssa, int phi)
+{
+	_jit_ssa_phi_t *p = &ssa->phis[phi];
+	_jit_ssa_def_t *arg;
+	jit_value_t constant;
+	int index, state;
+
+	state = LATTICE_TOP;
+	constant = 0;
+	for(index = 0; index < ssa->blocks[p->block]->num_preds; index++)
+	{
+		if(!ssa->edge_exec[ssa->pred_base[p->block] + index])
+		{
+			continue;
+		}
+		if(ssa->phi_args[p->args + index] < 0)
+		{
+			state = LATTICE_BOTTOM;
+			break;
+		}
+		arg = &ssa->defs[ssa->phi_args[p->args + index]];
+		if(arg->state == LATTICE_BOTTOM)
+		{
+			state = LATTICE_BOTTOM;
+			break;
+		}
+		if(arg->state == LATTICE_CONST)
+		{
+			if(state == LATTICE_TOP)
+			{
+				state = LATTICE_CONST;
+				constant = arg->constant;
+			}
+			else if(!same_constant(constant, arg->constant))
+			{
+				state = LATTICE_BOTTOM;
+				break;
+			}
+		}
+	}
+	set_state(ssa, p->def, state, constant);
+}
+
+/*
+ * Evaluate an instruction with constant operands.
+ */
+static void
+visit_insn(_jit_ssa_t *ssa, int insn)
+{
+	jit_insn_t ins;
+	jit_value_t value1, value2, result;
+	int def, state1, state2;
+
+	def = ssa->insn_def[insn];
+	if(def < 0)
+	{
+		return;
+	}
+	ins = get_insn(ssa, insn);
+
+	if(is_copy(ins->opcode))
+	{
+		state1 = get_operand_state(ssa, insn, SLOT_VALUE1, &value1);
+		if(state1 == LATTICE_CONST && !same_type(value1, ins->dest))
+		{
+			state1 = LATTICE_BOTTOM;
+		}
+		if(state1 != LATTICE_TOP)
+		{
+			set_state(ssa, def, state1, value1);
+		}
+		return;
+	}
+	if(!is_pure(ins->opcode) || get_def_slot(ins) != SLOT_DEST)
+	{
+		set_state(ssa, def, LATTICE_BOTTOM, 0);
+		return;
+	}
+
+	state1 = get_operand_state(ssa, insn, SLOT_VALUE1, &value1);
+	if((jit_opcodes[ins->opcode].flags & JIT_OPCODE_SRC2_MASK) != 0)
+	{
+		state2 = get_operand_state(ssa, insn, SLOT_VALUE2, &value2);
+	}
+	else
+	{
+		state2 = LATTICE_CONST;
+		value2 = 0;
+	}
+	if(state1 == LATTICE_BOTTOM || state2 == LATTICE_BOTTOM)
+	{
+		set_state(ssa, def, LATTICE_BOTTOM, 0);
+		return;
+	}
+	if(state1 == LATTICE_TOP || state2 == LATTICE_TOP)
+	{
+		return;
+	}
+
+	/* Folding fails for operations that would throw */
+	if(value2)
+	{
+		result = _jit_opcode_apply(ssa->func, ins->opcode, value1, value2,
+					   ins->dest->type);
+	}
+	else
+	{
+		result = _jit_opcode_apply_unary(ssa->func, ins->opcode, value1,
+						 ins->dest->type);
+	}
+	if(result && same_type(result, ins->dest))
+	{
+		set_state(ssa, def, LATTICE_CONST, result);
+	}
+	else
+	{
+		set_state(ssa, def, LATTICE_BOTTOM, 0);
+	}
+}
+
+/*
+ * Determine where the conditional branch that ends a block goes.
+ */
+static int
+get_branch_outcome(_jit_ssa_t *ssa, int block)
+{
+	jit_block_t b = ssa->blocks[block];
+	jit_insn_t insn;
+	jit_value_t value1, value2, result;
+	int insn_num, opcode, state1, state2;
+
+	insn = _jit_block_get_last(b);
+	if(!insn || !is_cond_branch(insn->opcode) || b->num_succs != 2
+	   || b->succs[0]->flags != _JIT_EDGE_BRANCH
+	   || b->succs[1]->flags != _JIT_EDGE_FALLTHRU)
+	{
+		return BRANCH_BOTH;
+	}
+	insn_num = ssa->insn_base[block] + b->num_insns - 1;
+	opcode = insn->opcode;
+
+	state1 = get_operand_state(ssa, insn_num, SLOT_VALUE1, &value1);
+	if(opcode == JIT_OP_BR_IFALSE || opcode == JIT_OP_BR_ITRUE
+	   || opcode == JIT_OP_BR_LFALSE || opcode == JIT_OP_BR_LTRUE)
+	{
+		state2 = LATTICE_CONST;
+		value2 = 0;
+	}
+	else
+	{
+		state2 = get_operand_state(ssa, insn_num, SLOT_VALUE2, &value2);
+	}
+	if(state1 == LATTICE_BOTTOM || state2 == LATTICE_BOTTOM)
+	{
+		return BRANCH_BOTH;
+	}
+	if(state1 == LATTICE_TOP || state2 == LATTICE_TOP)
+	{
+		return BRANCH_UNKNOWN;
+	}
+
+	switch(opcode)
+	{
+	case JIT_OP_BR_IFALSE:
+	case JIT_OP_BR_LFALSE:
+		return !jit_value_is_true(value1);
+
+	case JIT_OP_BR_ITRUE:
+	case JIT_OP_BR_LTRUE:
+		return jit_value_is_true(value1);
+	}
+
+	/* Compare with the instruction that computes the same condition */
+	if(opcode <= JIT_OP_BR_IGE_UN)
+	{
+		opcode += JIT_OP_IEQ - JIT_OP_BR_IEQ;
+	}
+	else
+	{
+		opcode += JIT_OP_LEQ - JIT_OP_BR_LEQ;
+	}
+	result = _jit_opcode_apply(ssa->func, opcode, value1, value2, jit_type_int);
+	if(!result)
+	{
+		return BRANCH_BOTH;
+	}
+	return jit_value_is_true(result);
+}
+
+/*
+ * Mark a control flow edge executable.
+ */
+static void
+mark_edge(_jit_ssa_t *ssa, _jit_edge_t edge)
+{
+	int edge_num;
+
+	if(edge->dst->index < 0)
+	{
+		return;
+	}
+	edge_num = ssa->pred_base[edge->dst->index] + get_pred_index(edge);
+	if(!ssa->edge_exec[edge_num])
+	{
+		ssa->edge_exec[edge_num] = 1;
+		ssa->flow[ssa->num_flow++] = edge_num;
+	}
+}
+
+static void
+visit_branch(_jit_ssa_t *ssa, int block)
+{
+	jit_block_t b = ssa->blocks[block];
+	int index;
+
+	switch(get_branch_outcome(ssa, block))
+	{
+	case BRANCH_UNKNOWN:
+		break;
+
+	case BRANCH_TAKEN:
+		mark_edge(ssa, b->succs[0]);
+		break;
+
+	case BRANCH_NOT_TAKEN:
+		mark_edge(ssa, b->succs[1]);
+		break;
+
+	default:
+		for(index = 0; index < b->num_succs; index++)
+		{
+			mark_edge(ssa, b->succs[index]);
+		}
+		break;
+	}
+}
+
+/*
+ * Find the block that an edge number leads to.
+ */
+static int
+get_edge_block(_jit_ssa_t *ssa, int edge_num)
+{
+	int low, high, middle;
+
+	low = 0;
+	high = ssa->num_blocks - 1;
+	while(low < high)
+	{
+		middle = (low + high + 1) / 2;
+		if(ssa->pred_base[middle] <= edge_num)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+	return low;
+}
+
+/*
+ * Sparse conditional constant propagation of Wegman and Zadeck.
+ */
+static int
+propagate_constants(_jit_ssa_t *ssa)
+{
+	jit_block_t b;
+	int block, index, def, user, phi, last;
+
+	ssa->block_exec = ssa_alloc(ssa, ssa->num_blocks, sizeof(char));
+	ssa->edge_exec = ssa_alloc(ssa, ssa->num_edges, sizeof(char));
+	ssa->flow = ssa_alloc(ssa, ssa->num_edges, sizeof(int));
+	ssa->work = ssa_alloc(ssa, ssa->num_defs, sizeof(int));
+	if(!ssa->block_exec || !ssa->edge_exec || !ssa->flow || !ssa->work)
+	{
+		return 0;
+	}
+
+	block = 0;
+	for(;;)
+	{
+		if(block >= 0)
+		{
+			/* The block has just become executable */
+			ssa->block_exec[block] = 1;
+			for(index = ssa->insn_base[block]; index < ssa->insn_base[block + 1]; index++)
+			{
+				visit_insn(ssa, index);
+			}
+			visit_branch(ssa, block);
+			block = -1;
+		}
+		else if(ssa->num_flow > 0)
+		{
+			index = ssa->flow[--(ssa->num_flow)];
+			block = get_edge_block(ssa, index);
+			for(phi = ssa->block_phis[block]; phi >= 0; phi = ssa->phis[phi].next)
+			{
+				visit_phi(ssa, phi);
+			}
+			if(ssa->block_exec[block])
+			{
+				block = -1;
+			}
+		}
+		else if(ssa->num_work > 0)
+		{
+			def = ssa->work[--(ssa->num_work)];
+			ssa->defs[def].queued = 0;
+			for(index = ssa->user_base[def]; index < ssa->user_base[def + 1]; index++)
+			{
+				user = ssa->users[index];
+				if(user < 0)
+				{
+					if(ssa->block_exec[ssa->phis[~user].block])
+					{
+						visit_phi(ssa, ~user);
+					}
+					continue;
+				}
+				if(!ssa->block_exec[ssa->insn_block[user]])
+				{
+					continue;
+				}
+				visit_insn(ssa, user);
+				b = ssa->blocks[ssa->insn_block[user]];
+				last = ssa->insn_base[ssa->insn_block[user]] + b->num_insns - 1;
+				if(user == last)
+				{
+					visit_branch(ssa, ssa->insn_block[user]);
+				}
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	/* Every executable branch must have been decided one way or the
+	   other, or else the unexplored edges are not known to be dead */
+	for(block = 0; block < ssa->num_blocks; block++)
+	{
+		if(ssa->block_exec[block]
+		   && get_branch_outcome(ssa, block) == BRANCH_UNKNOWN)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Get the operand of an instruction for value numbering.  Returns zero
+ * if the operand may change without a new definition.
+ */
+static int
+get_operand(_jit_ssa_t *ssa, int insn, int slot, _jit_ssa_operand_t *operand)
+{
+	jit_value_t value;
+	int def;
+
+	operand->def = -1;
+	operand->constant = 0;
+	value = get_slot(get_insn(ssa, insn), slot);
+	if(!value)
+	{
+		return 1;
+	}
+	if(value->is_constant)
+	{
+		operand->constant = value;
+		return 1;
+	}
+	def = ssa->use_def[insn * NUM_SLOTS + slot];
+	if(def < 0)
+	{
+		return 0;
+	}
+	if(ssa->defs[def].state == LATTICE_CONST)
+	{
+		operand->constant = ssa->defs[def].constant;
+	}
+	else
+	{
+		operand->def = ssa->defs[def].number;
+	}
+	return 1;
+}
+
+static int
+same_operand(_jit_ssa_operand_t *operand1, _jit_ssa_operand_t *operand2)
+{
+	if(operand1->constant || operand2->constant)
+	{
+		return operand1->constant && operand2->constant
+			&& same_constant(operand1->constant, operand2->constant);
+	}
+	return operand1->def == operand2->def;
+}
+
+static unsigned int
+hash_operand(_jit_ssa_operand_t *operand)
+{
+	if(operand->constant)
+	{
+		return hash_constant(operand->constant);
+	}
+	return (unsigned int) (operand->def + 1) * 0x85EBCA6Bu;
+}
+
+/*
+ * Get the operands of a pure instruction and their hash.  Returns zero
+ * if the instruction cannot be numbered.
+ */
+static int
+get_expression(_jit_ssa_t *ssa, int insn, _jit_ssa_operand_t *operands,
+	       unsigned int *hash)
+{
+	jit_insn_t ins = get_insn(ssa, insn);
+	unsigned int hash1, hash2;
+
+	if(!get_operand(ssa, insn, SLOT_VALUE1, &operands[0])
+	   || !get_operand(ssa, insn, SLOT_VALUE2, &operands[1]))
+	{
+		return 0;
+	}
+	hash1 = hash_operand(&operands[0]);
+	hash2 = hash_operand(&operands[1]);
+	if(is_commutative(ins->opcode))
+	{
+		*hash = hash1 + hash2;
+	}
+	else
+	{
+		*hash = hash1 * 31 + hash2;
+	}
+	*hash = *hash * 31 + (unsigned int) ins->opcode;
+	*hash ^= (unsigned int) (jit_nuint) jit_type_normalize(ins->dest->type) >> 4;
+	return 1;
+}
+
+/*
+ * Determine if two pure instructions compute the same value.
+ */
+static int
+same_expression(_jit_ssa_t *ssa, int insn1, _jit_ssa_operand_t *operands1, int insn2)
+{
+	jit_insn_t ins1 = get_insn(ssa, insn1);
+	jit_insn_t ins2 = get_insn(ssa, insn2);
+	_jit_ssa_operand_t operands2[2];
+	unsigned int hash;
+
+	if(ins1->opcode != ins2->opcode || !same_type(ins1->dest, ins2->dest))
+	{
+		return 0;
+	}
+	if(!get_expression(ssa, insn2, operands2, &hash))
+	{
+		return 0;
+	}
+	if(same_operand(&operands1[0], &operands2[0])
+	   && same_operand(&operands1[1], &operands2[1]))
+	{
+		return 1;
+	}
+	return is_commutative(ins1->opcode)
+		&& same_operand(&operands1[0], &operands2[1])
+		&& same_operand(&operands1[1], &operands2[0]);
+}
+
+/*
+ * Number the value of a phi function.  A phi function whose arguments
+ * all have the same number takes that number if it dominates the phi.
+ */
+static void
+number_phi(_jit_ssa_t *ssa, int phi)
+{
+	_jit_ssa_phi_t *p = &ssa->phis[phi];
+	int index, arg, number;
+
+	number = -1;
+	for(index = 0; index < ssa->blocks[p->block]->num_preds; index++)
+	{
+		if(!ssa->edge_exec[ssa->pred_base[p->block] + index])
+		{
+			continue;
+		}
+		arg = ssa->phi_args[p->args + index];
+		if(arg < 0 || ssa->defs[arg].state == LATTICE_CONST)
+		{
+			return;
+		}
+		arg = ssa->defs[arg].number;
+		if(arg == p->def)
+		{
+			continue;
+		}
+		if(number >= 0 && number != arg)
+		{
+			return;
+		}
+		number = arg;
+	}
+	if(number >= 0 && is_stable(ssa, number)
+	   && ssa->defs[number].block != p->block
+	   && dominates(ssa, ssa->defs[number].block, p->block))
+	{
+		ssa->defs[p->def].number = number;
+	}
+}
+
+/*
+ * Number the value of an instruction, looking up earlier instructions
+ * that compute the same value in the scoped hash table.
+ */
+static void
+number_insn(_jit_ssa_t *ssa, int insn, int *num_log)
+{
+	jit_insn_t ins = get_insn(ssa, insn);
+	_jit_ssa_operand_t operands[2];
+	unsigned int hash, slot;
+	int def, source, leader;
+
+	def = ssa->insn_def[insn];
+	if(def < 0 || ssa->defs[def].state == LATTICE_CONST)
+	{
+		return;
+	}
+
+	if(is_copy(ins->opcode))
+	{
+		source = ssa->use_def[insn * NUM_SLOTS + SLOT_VALUE1];
+		if(source >= 0 && ssa->defs[source].state != LATTICE_CONST
+		   && same_type(ins->dest, ins->value1)
+		   && is_stable(ssa, ssa->defs[source].number))
+		{
+			ssa->defs[def].number = ssa->defs[source].number;
+		}
+		return;
+	}
+	if(!is_pure(ins->opcode) || get_def_slot(ins) != SLOT_DEST)
+	{
+		return;
+	}
+	if(!get_expression(ssa, insn, operands, &hash))
+	{
+		return;
+	}
+
+	for(slot = hash & ssa->table_mask; ssa->table[slot] >= 0;
+	    slot = (slot + 1) & ssa->table_mask)
+	{
+		leader = ssa->table[slot];
+		if(same_expression(ssa, insn, operands, ssa->defs[leader].insn))
+		{
+			ssa->defs[def].number = leader;
+			return;
+		}
+	}
+	if(is_stable(ssa, def))
+	{
+		ssa->table[slot] = def;
+		ssa->log[(*num_log)++] = (int) slot;
+	}
+}
+
+/*
+ * Global value numbering over the dominator tree.  The table only holds
+ * the instructions of the dominating blocks, and the entries of a block
+ * are removed in reverse order when the walk leaves it, which keeps the
+ * open addressing intact.
+ */
+static int
+number_values(_jit_ssa_t *ssa)
+{
+	int size, index, top, num_log, phi;
+
+	for(size = 16; size < ssa->num_insns * 2; size *= 2)
+	{
+		/* Nothing to do here */
+	}
+	ssa->table = ssa_alloc(ssa, size, sizeof(int));
+	ssa->log = ssa_alloc(ssa, ssa->num_insns, sizeof(int));
+	if(!ssa->table || !ssa->log)
+	{
+		return 0;
+	}
+	ssa->table_mask = size - 1;
+	for(index = 0; index < size; index++)
+	{
+		ssa->table[index] = -1;
+	}
+
+	num_log = 0;
+	top = 0;
+	ssa->stack[top] = 0;
+	ssa->marks[top++] = -1;
+	while(top > 0)
+	{
+		index = ssa->stack[top - 1];
+		if(ssa->marks[top - 1] >= 0)
+		{
+			while(num_log > ssa->marks[top - 1])
+			{
+				ssa->table[ssa->log[--num_log]] = -1;
+			}
+			--top;
+			continue;
+		}
+		ssa->marks[top - 1] = num_log;
+		if(!ssa->block_exec[index])
+		{
+			continue;
+		}
+
+		for(phi = ssa->block_phis[index]; phi >= 0; phi = ssa->phis[phi].next)
+		{
+			number_phi(ssa, phi);
+		}
+		for(phi = ssa->insn_base[index]; phi < ssa->insn_base[index + 1]; phi++)
+		{
+			number_insn(ssa, phi, &num_log);
+		}
+		for(phi = ssa->dom_child[index]; phi >= 0; phi = ssa->dom_sibling[phi])
+		{
+			ssa->stack[top] = phi;
+			ssa->marks[top++] = -1;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Turn an instruction into a copy of a value.
+ */
+static void
+make_copy(jit_insn_t insn, jit_value_t value)
+{
+	insn->opcode = (short) _jit_store_opcode(JIT_OP_COPY_INT, JIT_OP_COPY_STORE_BYTE,
+						 insn->dest->type);
+	insn->flags = 0;
+	insn->value1 = value;
+	insn->value2 = 0;
+}
+
+/*
+ * Write the results of the analyses back into the instructions of the
+ * executable blocks.  Returns non-zero if a branch was resolved.
+ */
+static int
+rewrite(_jit_ssa_t *ssa)
+{
+	jit_function_t func = ssa->func;
+	jit_insn_t insn;
+	jit_value_t value, replacement;
+	_jit_ssa_def_t *d;
+	int block, index, slot, def, leader, outcome, folded, constants;
+
+	folded = 0;
+	for(block = 0; block < ssa->num_blocks; block++)
+	{
+		if(!ssa->block_exec[block])
+		{
+			continue;
+		}
+		for(index = ssa->insn_base[block]; index < ssa->insn_base[block + 1]; index++)
+		{
+			insn = get_insn(ssa, index);
+			def = ssa->insn_def[index];
+			if(def >= 0 && (is_pure(insn->opcode) || is_copy(insn->opcode))
+			   && get_def_slot(insn) == SLOT_DEST)
+			{
+				d = &ssa->defs[def];
+				if(d->state == LATTICE_CONST)
+				{
+					/* The instruction computes a constant */
+					replacement = constant_for(func, d->constant, insn->dest);
+					if(replacement && !(is_copy(insn->opcode)
+							    && insn->value1 == replacement))
+					{
+						make_copy(insn, replacement);
+					}
+					continue;
+				}
+				leader = d->number;
+				if(leader != def)
+				{
+					/* An earlier instruction computes the same value */
+					value = ssa->vars[ssa->defs[leader].var];
+					if(value != insn->dest && same_type(value, insn->dest))
+					{
+						if(!is_copy(insn->opcode) || insn->value1 != value)
+						{
+							make_copy(insn, value);
+							ref_value(ssa, leader, block);
+						}
+						continue;
+					}
+				}
+			}
+
+			/* Replace the operands with constants or with the values
+			   of the definitions they are equal to */
+			constants = is_pure(insn->opcode) || is_copy(insn->opcode)
+				|| is_cond_branch(insn->opcode) || is_return(insn->opcode);
+			for(slot = SLOT_VALUE2; slot >= SLOT_DEST; slot--)
+			{
+				value = get_slot(insn, slot);
+				def = ssa->use_def[index * NUM_SLOTS + slot];
+				if(!value || def < 0)
+				{
+					continue;
+				}
+				d = &ssa->defs[def];
+				if(d->state == LATTICE_CONST)
+				{
+					/* Leave a register operand for the instruction
+					   selector if the other operand is a constant */
+					if(!constants || (slot == SLOT_VALUE1 && insn->value2
+							  && insn->value2->is_constant))
+					{
+						continue;
+					}
+					replacement = constant_for(func, d->constant, value);
+					if(replacement)
+					{
+						set_slot(insn, slot, replacement);
+					}
+					continue;
+				}
+				leader = d->number;
+				replacement = ssa->vars[ssa->defs[leader].var];
+				if(leader != def && replacement != value && same_type(replacement, value))
+				{
+					set_slot(insn, slot, replacement);
+					ref_value(ssa, leader, block);
+				}
+			}
+		}
+
+		outcome = get_branch_outcome(ssa, block);
+		if(outcome == BRANCH_TAKEN || outcome == BRANCH_NOT_TAKEN)
+		{
+			_jit_block_fold_branch(ssa->blocks[block], outcome);
+			folded = 1;
+		}
+	}
+	return folded;
+}
+
+/*
+ * Remove the pure instructions whose results are never used.  Returns
+ * non-zero if an instruction was removed.
+ */
+static int
+eliminate_dead_code(_jit_ssa_t *ssa)
+{
+	jit_insn_t insn;
+	jit_value_t value;
+	int *uses, *def_base, *def_insns, *queued, *stack;
+	int index, slot, var, top, num, removed;
+
+	uses = ssa_alloc(ssa, ssa->num_vars, sizeof(int));
+	def_base = ssa_alloc(ssa, ssa->num_vars + 1, sizeof(int));
+	queued = ssa_alloc(ssa, ssa->num_vars, sizeof(int));
+	stack = ssa_alloc(ssa, ssa->num_vars, sizeof(int));
+	if(!uses || !def_base || !queued || !stack)
+	{
+		return 0;
+	}
+
+	/* Count the remaining uses and definitions of each value */
+	for(index = 0; index < ssa->num_insns; index++)
+	{
+		insn = get_insn(ssa, index);
+		for(slot = 0; slot < NUM_SLOTS; slot++)
+		{
+			value = get_slot(insn, slot);
+			if(!value || value->is_constant || value->index < 0
+			   || value->index >= ssa->num_vars || ssa->vars[value->index] != value)
+			{
+				continue;
+			}
+			if(is_use_slot(insn, slot))
+			{
+				++(uses[value->index]);
+			}
+			else if(slot == get_def_slot(insn))
+			{
+				++(def_base[value->index + 1]);
+			}
+		}
+	}
+	for(var = 0; var < ssa->num_vars; var++)
+	{
+		def_base[var + 1] += def_base[var];
+		queued[var] = def_base[var];
+	}
+	def_insns = ssa_alloc(ssa, def_base[ssa->num_vars], sizeof(int));
+	if(!def_insns)
+	{
+		return 0;
+	}
+	for(index = 0; index < ssa->num_insns; index++)
+	{
+		insn = get_insn(ssa, index);
+		slot = get_def_slot(insn);
+		value = slot >= 0 ? get_slot(insn, slot) : 0;
+		if(value && !value->is_constant && value->index >= 0
+		   && value->index < ssa->num_vars && ssa->vars[value->index] == value)
+		{
+			def_insns[queued[value->index]++] = index;
+		}
+	}
+
+	/* Remove definitions of unused values, and then the definitions
+	   that become unused in turn */
+	removed = 0;
+	top = 0;
+	for(var = 0; var < ssa->num_vars; var++)
+	{
+		queued[var] = (uses[var] == 0);
+		if(queued[var])
+		{
+			stack[top++] = var;
+		}
+	}
+	while(top > 0)
+	{
+		var = stack[--top];
+		for(num = def_base[var]; num < def_base[var + 1]; num++)
+		{
+			insn = get_insn(ssa, def_insns[num]);
+			if(insn->opcode == JIT_OP_NOP || get_def_slot(insn) != SLOT_DEST
+			   || !((is_pure(insn->opcode) && !may_throw(insn->opcode))
+				|| (insn->opcode >= JIT_OP_COPY_LOAD_SBYTE
+				    && insn->opcode <= JIT_OP_COPY_STORE_SHORT
+				    && insn->opcode != JIT_OP_COPY_STRUCT)))
+			{
+				continue;
+			}
+			for(slot = SLOT_VALUE1; slot <= SLOT_VALUE2; slot++)
+			{
+				value = get_slot(insn, slot);
+				if(!value || value->is_constant || value->index < 0
+				   || value->index >= ssa->num_vars
+				   || ssa->vars[value->index] != value)
+				{
+					continue;
+				}
+				if(--(uses[value->index]) == 0 && !queued[value->index])
+				{
+					queued[value->index] = 1;
+					stack[top++] = value->index;
+				}
+			}
+			insn->opcode = (short) JIT_OP_NOP;
+			removed = 1;
+		}
+	}
+	return removed;
+}
+
+int
+_jit_function_optimize_ssa(jit_function_t func)
+{
+	_jit_ssa_t ssa;
+	int index, changed;
+
+	/* Exception handlers have control flow that the graph does not show */
+	if(func->has_try || !func->builder)
+	{
+		return 0;
+	}
+
+	jit_memzero(&ssa, sizeof(ssa));
+	ssa.func = func;
+	changed = 0;
+	if(number_blocks_and_values(&ssa)
+	   && compute_dominators(&ssa)
+	   && place_phis(&ssa)
+	   && rename_values(&ssa)
+	   && collect_users(&ssa)
+	   && propagate_constants(&ssa)
+	   && number_values(&ssa))
+	{
+		changed = rewrite(&ssa);
+		changed |= eliminate_dead_code(&ssa);
+	}
+
+	for(index = 0; index < ssa.num_vars; index++)
+	{
+		ssa.vars[index]->index = -1;
+	}
+	ssa_free(&ssa);
+	return changed;
+}
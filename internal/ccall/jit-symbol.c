@@ -221,6 +221,8 @@ jit_internalsym const _jit_internal_symbols[] = {
 	{"jit_long_to_ulong", (void *)jit_long_to_ulong},
 	{"jit_long_to_ulong_ovf", (void *)jit_long_to_ulong_ovf},
 	{"jit_long_xor", (void *)jit_long_xor},
+	{"jit_memcpy", (void *)jit_memcpy},
+	{"jit_memset", (void *)jit_memset},
 	{"jit_nfloat_abs", (void *)jit_nfloat_abs},
 	{"jit_nfloat_acos", (void *)jit_nfloat_acos},
 	{"jit_nfloat_add", (void *)jit_nfloat_add},
@@ -42,7 +42,28 @@
  */
 jit_mutex_t _jit_global_lock;
 
-#if defined(JIT_THREADS_PTHREAD)
+/*
+ * Index of the last thread that asked for its index.
+ */
+static unsigned int last_index = 0;
+
+#if defined(JIT_THREADS_TLS)
+
+/*
+ * The control object lives in the thread itself, so there is nothing
+ * to allocate on first use or to free when the thread exits.
+ */
+__thread struct jit_thread_control _jit_thread_control JIT_TLS_MODEL;
+
+/*
+ * Initialize the pthread support routines.  Only called once.
+ */
+static void init_pthread(void)
+{
+	jit_mutex_create(&_jit_global_lock);
+}
+
+#elif defined(JIT_THREADS_PTHREAD)
 
 /*
  * The thread-specific key to use to fetch the control object.
@@ -119,6 +140,8 @@ void _jit_thread_init(void)
 #endif
 }
 
+#if !defined(JIT_THREADS_TLS)
+
 static void *get_raw_control(void)
 {
 	_jit_thread_init();
@@ -158,6 +181,27 @@ jit_thread_control_t _jit_thread_get_control(void)
 	return control;
 }
 
+#endif /* !JIT_THREADS_TLS */
+
+unsigned int _jit_thread_get_index(void)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+	if(!control)
+	{
+		return 0;
+	}
+
+	/* The index is stored plus one, so that zero means "not assigned" */
+	if(!control->index)
+	{
+		_jit_thread_init();
+		jit_mutex_lock(&_jit_global_lock);
+		control->index = ++last_index;
+		jit_mutex_unlock(&_jit_global_lock);
+	}
+	return control->index - 1;
+}
+
 jit_thread_id_t _jit_thread_current_id(void)
 {
 #if defined(JIT_THREADS_PTHREAD)
@@ -170,6 +214,133 @@ jit_thread_id_t _jit_thread_current_id(void)
 #endif
 }
 
+/*
+ * Threads between "_jit_epoch_enter" and "_jit_epoch_leave" are counted
+ * by the parity of the epoch that they entered at.  The counts are
+ * spread over several slots by thread index, each on its own cache line,
+ * so that threads which enter at the same time do not write to the same
+ * line.  The epoch advances once no thread is counted with the parity
+ * that it is about to take, so a thread that entered at epoch "e" holds
+ * it below "e + 2" until it leaves.
+ */
+#define	JIT_EPOCH_NUM_SLOTS	16
+#define	JIT_EPOCH_LINE_SIZE	64
+
+typedef union
+{
+	int		count[2];
+	char		pad[JIT_EPOCH_LINE_SIZE];
+
+} jit_epoch_slot_t;
+
+typedef union
+{
+	unsigned long	value;
+	char		pad[JIT_EPOCH_LINE_SIZE];
+
+} jit_epoch_value_t;
+
+static jit_epoch_value_t epoch;
+static jit_epoch_slot_t epoch_slots[JIT_EPOCH_NUM_SLOTS];
+
+void _jit_epoch_enter(void)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+	jit_epoch_slot_t *slot;
+	unsigned long current;
+	int *count;
+
+	if(!control || (control->epoch_depth)++ != 0)
+	{
+		return;
+	}
+
+	/* The increment is a full barrier.  If the epoch moved on before it,
+	   then the count may have been missed, so it is taken again */
+	slot = &epoch_slots[_jit_thread_get_index() % JIT_EPOCH_NUM_SLOTS];
+	for(;;)
+	{
+		current = jit_atomic_load(&epoch.value);
+		count = &(slot->count[current & 1]);
+		jit_atomic_inc(count);
+		if(jit_atomic_load(&epoch.value) == current)
+		{
+			break;
+		}
+		jit_atomic_dec(count);
+	}
+	control->epoch_count = count;
+}
+
+void _jit_epoch_leave(void)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+
+	if(!control || control->epoch_depth == 0 || --(control->epoch_depth) != 0)
+	{
+		return;
+	}
+	jit_atomic_dec(control->epoch_count);
+}
+
+void _jit_epoch_restore(unsigned int depth)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+
+	if(!control || control->epoch_depth <= depth)
+	{
+		return;
+	}
+	if(depth == 0)
+	{
+		jit_atomic_dec(control->epoch_count);
+	}
+	control->epoch_depth = depth;
+}
+
+int _jit_epoch_is_inside(void)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+
+	return control && control->epoch_depth != 0;
+}
+
+unsigned long _jit_epoch_get(void)
+{
+	/* Readers that enter after the object was unlinked cannot see it */
+	jit_memory_barrier();
+	return jit_atomic_load(&epoch.value);
+}
+
+int _jit_epoch_is_safe(unsigned long retired)
+{
+	unsigned long current;
+	unsigned int index;
+	int parity;
+
+	for(;;)
+	{
+		current = jit_atomic_load(&epoch.value);
+		if(current - retired >= 2)
+		{
+			return 1;
+		}
+
+		/* Advance the epoch if no thread holds it back.  Another thread
+		   may advance it first, which is just as good */
+		jit_memory_barrier();
+		parity = (int) ((current + 1) & 1);
+		for(index = 0; index < JIT_EPOCH_NUM_SLOTS; ++index)
+		{
+			if(jit_atomic_load(&(epoch_slots[index].count[parity])) != 0)
+			{
+				return 0;
+			}
+		}
+		jit_atomic_cas(&epoch.value, current, current + 1);
+	}
+}
+
 int _jit_monitor_wait(jit_monitor_t *mon, jit_int timeout)
 {
 #if defined(JIT_THREADS_PTHREAD)
@@ -68,9 +68,28 @@ typedef struct jit_thread_control *jit_thread_control_t;
 void _jit_thread_init(void);
 
 /*
- * Get the JIT control object for the current thread.
+ * Get the JIT control object for the current thread.  With "__thread"
+ * support the control object is a thread-local variable, and getting it
+ * is a single TLS access that never fails.  The initial-exec model keeps
+ * the access free of calls to "__tls_get_addr".
  */
+#if defined(JIT_THREADS_TLS)
+#if defined(__ELF__)
+#define	JIT_TLS_MODEL	__attribute__((tls_model("initial-exec")))
+#else
+#define	JIT_TLS_MODEL
+#endif
+extern __thread struct jit_thread_control _jit_thread_control JIT_TLS_MODEL;
+#define	_jit_thread_get_control()	(&_jit_thread_control)
+#else
 jit_thread_control_t _jit_thread_get_control(void);
+#endif
+
+/*
+ * Get a small number that identifies the current thread.  Threads are
+ * numbered in the order they first use the JIT, starting at zero.
+ */
+unsigned int _jit_thread_get_index(void);
 
 /*
  * Get the identifier for the current thread.
@@ -87,6 +106,7 @@ typedef pthread_mutex_t jit_mutex_t;
 #define	jit_mutex_destroy(mutex)	(pthread_mutex_destroy((mutex)))
 #define	jit_mutex_lock(mutex)		(pthread_mutex_lock((mutex)))
 #define	jit_mutex_unlock(mutex)		(pthread_mutex_unlock((mutex)))
+#define	jit_mutex_trylock(mutex)	(pthread_mutex_trylock((mutex)) == 0)
 
 #elif defined(JIT_THREADS_WIN32)
 
@@ -95,6 +115,7 @@ typedef CRITICAL_SECTION jit_mutex_t;
 #define	jit_mutex_destroy(mutex)	(DeleteCriticalSection((mutex)))
 #define	jit_mutex_lock(mutex)		(EnterCriticalSection((mutex)))
 #define	jit_mutex_unlock(mutex)		(LeaveCriticalSection((mutex)))
+#define	jit_mutex_trylock(mutex)	(TryEnterCriticalSection((mutex)) != 0)
 
 #else
 
@@ -103,6 +124,7 @@ typedef int jit_mutex_t;
 #define	jit_mutex_destroy(mutex)	do { ; } while (0)
 #define	jit_mutex_lock(mutex)		do { ; } while (0)
 #define	jit_mutex_unlock(mutex)		do { ; } while (0)
+#define	jit_mutex_trylock(mutex)	(1)
 
 #endif
 
@@ -111,6 +133,61 @@ typedef int jit_mutex_t;
  */
 extern jit_mutex_t _jit_global_lock;
 
+/*
+ * Atomic increment and decrement of reference counts that may be shared
+ * between threads.  Both return the new value.
+ */
+#if JIT_THREADS_SUPPORTED && defined(__GNUC__)
+#define	jit_atomic_inc(ptr)		(__sync_add_and_fetch((ptr), 1))
+#define	jit_atomic_dec(ptr)		(__sync_sub_and_fetch((ptr), 1))
+#else
+#define	jit_atomic_inc(ptr)		(++*(ptr))
+#define	jit_atomic_dec(ptr)		(--*(ptr))
+#endif
+
+/*
+ * Publication of pointers to data that is read without locks.  A load
+ * sees everything that was written before the store of its value.
+ */
+#if JIT_THREADS_SUPPORTED && defined(__GNUC__)
+#define	jit_atomic_load(ptr)		(__atomic_load_n((ptr), __ATOMIC_ACQUIRE))
+#define	jit_atomic_store(ptr, value)	(__atomic_store_n((ptr), (value), __ATOMIC_RELEASE))
+#define	jit_memory_barrier()		(__sync_synchronize())
+#else
+#define	jit_atomic_load(ptr)		(*(ptr))
+#define	jit_atomic_store(ptr, value)	(*(ptr) = (value))
+#define	jit_memory_barrier()		do { ; } while (0)
+#endif
+
+/*
+ * Replace the value at "ptr" with "value" if it is still "old".  Returns
+ * non-zero if the value was replaced.
+ */
+#if JIT_THREADS_SUPPORTED && defined(__GNUC__)
+#define	jit_atomic_cas(ptr, old, value)	(__sync_bool_compare_and_swap((ptr), (old), (value)))
+#else
+#define	jit_atomic_cas(ptr, old, value)	\
+		(*(ptr) == (old) ? (*(ptr) = (value), 1) : 0)
+#endif
+
+/*
+ * Epoch-based reclamation of memory that is read without locks.  Readers
+ * stay between "_jit_epoch_enter" and "_jit_epoch_leave", which nest on
+ * each thread.  A writer unlinks an object, notes the epoch returned by
+ * "_jit_epoch_get", and frees the object once "_jit_epoch_is_safe"
+ * returns non-zero for that epoch: by then every reader that may have
+ * seen the object has left.  "_jit_epoch_restore" leaves the sections
+ * that an exception unwinds, down to the depth noted at its catch point.
+ * "_jit_epoch_is_inside" returns non-zero if the current thread is in a
+ * section.
+ */
+void _jit_epoch_enter(void);
+void _jit_epoch_leave(void);
+void _jit_epoch_restore(unsigned int depth);
+int _jit_epoch_is_inside(void);
+unsigned long _jit_epoch_get(void);
+int _jit_epoch_is_safe(unsigned long epoch);
+
 /*
  * Define the primitive monitor operations.
  */
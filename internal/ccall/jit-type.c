@@ -104,8 +104,30 @@ precision supported on the native platform.
 @item jit_type_void_ptr
 Represents the system's @code{void *} type.  This can be used wherever
 a native pointer type is required.
+
+@vindex jit_type_v4i32
+@item jit_type_v4i32
+Represents a 128-bit vector of four signed 32-bit integers.
+
+@vindex jit_type_v2i64
+@item jit_type_v2i64
+Represents a 128-bit vector of two signed 64-bit integers.
+
+@vindex jit_type_v4f32
+@item jit_type_v4f32
+Represents a 128-bit vector of four 32-bit floating point values.
+
+@vindex jit_type_v2f64
+@item jit_type_v2f64
+Represents a 128-bit vector of two 64-bit floating point values.
 @end table
 
+Vector values live in the SSE registers and may only be operated on with
+the @code{jit_insn_v*} instructions, loaded and stored through pointers,
+and copied between local variables.  They cannot be passed to or returned
+from functions, and there are no vector constants; use
+@code{jit_insn_vbroadcast} instead.
+
 Type descriptors are reference counted.  You can make a copy of a type
 descriptor using the @code{jit_type_copy} function, and free the copy with
 @code{jit_type_free}.
@@ -237,6 +259,22 @@ struct _jit_type const _jit_type_void_ptr_def =
 	{1, JIT_TYPE_PTR, 0, 1, 0, sizeof(void *), JIT_ALIGN_PTR,
 	 (jit_type_t)&_jit_type_void_def};
 jit_type_t const jit_type_void_ptr = (jit_type_t)&_jit_type_void_ptr_def;
+struct _jit_type const _jit_type_v4i32_def =
+	{1, JIT_TYPE_VECTOR, 0, 1, 0, 16, 16,
+	 (jit_type_t)&_jit_type_int_def};
+jit_type_t const jit_type_v4i32 = (jit_type_t)&_jit_type_v4i32_def;
+struct _jit_type const _jit_type_v2i64_def =
+	{1, JIT_TYPE_VECTOR, 0, 1, 0, 16, 16,
+	 (jit_type_t)&_jit_type_long_def};
+jit_type_t const jit_type_v2i64 = (jit_type_t)&_jit_type_v2i64_def;
+struct _jit_type const _jit_type_v4f32_def =
+	{1, JIT_TYPE_VECTOR, 0, 1, 0, 16, 16,
+	 (jit_type_t)&_jit_type_float32_def};
+jit_type_t const jit_type_v4f32 = (jit_type_t)&_jit_type_v4f32_def;
+struct _jit_type const _jit_type_v2f64_def =
+	{1, JIT_TYPE_VECTOR, 0, 1, 0, 16, 16,
+	 (jit_type_t)&_jit_type_float64_def};
+jit_type_t const jit_type_v2f64 = (jit_type_t)&_jit_type_v2f64_def;
 
 /*
  * Type descriptors for the system "char", "int", "long", etc types.
@@ -433,7 +471,7 @@ jit_type_t jit_type_copy(jit_type_t type)
 	{
 		return type;
 	}
-	++(type->ref_count);
+	jit_atomic_inc(&type->ref_count);
 	return type;
 }
 
@@ -451,7 +489,7 @@ void jit_type_free(jit_type_t type)
 	{
 		return;
 	}
-	if(--(type->ref_count) != 0)
+	if(jit_atomic_dec(&type->ref_count) != 0)
 	{
 		return;
 	}
@@ -976,6 +1014,11 @@ void jit_type_set_offset(jit_type_t type, unsigned int field_index,
  * @vindex JIT_TYPE_PTR
  * @item JIT_TYPE_PTR
  * The type is the result of calling @code{jit_type_create_pointer}.
+ *
+ * @vindex JIT_TYPE_VECTOR
+ * @item JIT_TYPE_VECTOR
+ * The type is one of the predefined vector types, such as
+ * @code{jit_type_v4f32}.
  * @end table
  *
  * @vindex JIT_TYPE_FIRST_TAGGED
@@ -1474,6 +1517,41 @@ int jit_type_is_tagged(jit_type_t type)
 	}
 }
 
+/*@
+ * @deftypefun int jit_type_is_vector (jit_type_t @var{type})
+ * Determine if a type is a vector type.
+ * @end deftypefun
+@*/
+int jit_type_is_vector(jit_type_t type)
+{
+	if(type)
+	{
+		return (type->kind == JIT_TYPE_VECTOR);
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+/*@
+ * @deftypefun jit_type_t jit_type_get_lane_type (jit_type_t @var{type})
+ * Get the type of the elements of a vector type.  Returns NULL
+ * if not a vector type.
+ * @end deftypefun
+@*/
+jit_type_t jit_type_get_lane_type(jit_type_t type)
+{
+	if(type)
+	{
+		if(type->kind == JIT_TYPE_VECTOR)
+		{
+			return type->sub_type;
+		}
+	}
+	return 0;
+}
+
 /*@
  * @deftypefun jit_type_t jit_type_remove_tags (jit_type_t @var{type})
  * Remove tags from a type, and return the underlying type.
@@ -175,20 +175,16 @@ jit_unwind_get_function(jit_unwind_context_t *unwind)
 		return 0;
 	}
 
-	if(!unwind->cache)
-	{
-		void *pc = jit_unwind_get_pc(unwind);
-		unwind->cache = _jit_memory_find_function_info(unwind->context, pc);
-	}
-
-	return _jit_memory_get_function(unwind->context, unwind->cache);
+	return _jit_memory_find_function(unwind->context, jit_unwind_get_pc(unwind));
 }
 
 unsigned int
 jit_unwind_get_offset(jit_unwind_context_t *unwind)
 {
 	void *pc;
+	void *func_info;
 	jit_function_t func;
+	unsigned int offset = JIT_NO_OFFSET;
 
 	if(!unwind || !unwind->frame || !unwind->context)
 	{
@@ -201,15 +197,15 @@ jit_unwind_get_offset(jit_unwind_context_t *unwind)
 		return JIT_NO_OFFSET;
 	}
 
-	if(!unwind->cache)
-	{
-		unwind->cache = _jit_memory_find_function_info(unwind->context, pc);
-	}
-	func = _jit_memory_get_function(unwind->context, unwind->cache);
-	if(!func)
+	/* The function info is not kept between calls, because the code
+	   may be freed once the epoch section is left */
+	_jit_epoch_enter();
+	func_info = _jit_memory_find_function_info(unwind->context, pc);
+	func = func_info ? _jit_memory_get_function(unwind->context, func_info) : 0;
+	if(func)
 	{
-		return JIT_NO_OFFSET;
+		offset = _jit_function_get_bytecode(func, func_info, pc, 0);
 	}
-
-	return _jit_function_get_bytecode(func, unwind->cache, pc, 0);
+	_jit_epoch_leave();
+	return offset;
 }
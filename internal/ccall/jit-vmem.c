@@ -31,6 +31,14 @@
 # include <unistd.h>
 #endif
 
+#if defined(JIT_VMEM_MMAP) && defined(JIT_LINUX_PLATFORM)
+# include <stdio.h>
+# include <sys/syscall.h>
+# if defined(SYS_memfd_create)
+#  define JIT_VMEM_SHARED	1
+# endif
+#endif
+
 /*
  * Define getpagesize() if not provided
  */
@@ -52,8 +60,32 @@
 # define MAP_ANONYMOUS        MAP_ANON
 #endif
 
+/*
+ * Huge pages are used through madvise() or MAP_HUGETLB on Linux, which
+ * uses 2M pages for both on the common platforms.
+ */
+#if defined(JIT_VMEM_MMAP) && defined(JIT_LINUX_PLATFORM) && \
+	(defined(MADV_HUGEPAGE) || defined(MAP_HUGETLB))
+# define JIT_VMEM_HUGE_PAGE_SIZE	(2 * 1024 * 1024)
+#endif
+
 static jit_uint page_size;
 
+/*
+ * Value that jit_vmem_reserve_near() gets when a reservation fails.
+ */
+#if defined(JIT_VMEM_WIN32)
+# define MAP_FAILED_NEAR	((void *) 0)
+#elif defined(JIT_VMEM_MMAP)
+# define MAP_FAILED_NEAR	MAP_FAILED
+#endif
+
+/*
+ * Number of places that jit_vmem_reserve_near() tries on each side of
+ * the address that it is given.
+ */
+#define JIT_VMEM_NEAR_PROBES	32
+
 #if defined(JIT_VMEM_WIN32)
 static DWORD
 convert_prot(jit_prot_t prot)
@@ -125,13 +157,13 @@ jit_vmem_page_size(void)
 jit_nuint
 jit_vmem_round_up(jit_nuint value)
 {
-	return (value + page_size - 1) & ~(page_size - 1);
+	return (value + page_size - 1) & ~((jit_nuint) page_size - 1);
 }
 
 jit_nuint
 jit_vmem_round_down(jit_nuint value)
 {
-	return ((jit_nuint) value) & ~(page_size - 1);
+	return ((jit_nuint) value) & ~((jit_nuint) page_size - 1);
 }
 
 void *
@@ -157,6 +189,98 @@ jit_vmem_reserve(jit_uint size)
 #endif
 }
 
+/*@
+ * @deftypefun {void *} jit_vmem_reserve_near (void *@var{near}, jit_uint @var{size}, jit_nuint @var{range})
+ * Reserve @var{size} bytes of address space like @code{jit_vmem_reserve},
+ * but so that every byte of the reservation is at most @var{range} bytes
+ * away from @var{near}.  Code that is placed in such a region can reach
+ * @var{near} with 32-bit relative branches if @var{range} is less than
+ * 2GB.  Only a few places on each side of @var{near} are tried.
+ * Returns NULL if none of them is free.
+ * @end deftypefun
+@*/
+void *
+jit_vmem_reserve_near(void *near, jit_uint size, jit_nuint range)
+{
+#if defined(JIT_VMEM_WIN32) || defined(JIT_VMEM_MMAP)
+
+	jit_nuint anchor;
+	jit_nuint low;
+	jit_nuint high;
+	jit_nuint hint;
+	jit_nuint addr;
+	jit_nuint step;
+	int above;
+	int probes;
+
+	size = (jit_uint) jit_vmem_round_up(size);
+	if(size == 0 || range < size)
+	{
+		return (void *) 0;
+	}
+	anchor = (jit_nuint) near;
+	low = anchor > range ? jit_vmem_round_up(anchor - range) : page_size;
+	high = anchor + (range - size);
+	if(high < anchor)
+	{
+		high = ~((jit_nuint) 0) - size;
+	}
+	high = jit_vmem_round_down(high);
+	if(high < low)
+	{
+		return (void *) 0;
+	}
+
+	/* Step by the size of the reservation, or by more if the window
+	   would take more than a few probes on each side */
+	step = (high - low) / (2 * JIT_VMEM_NEAR_PROBES);
+	step = step > size ? jit_vmem_round_up(step) : size;
+
+	/* Try the places furthest away first, which leaves the space next to
+	   "near" to the heap of the program and to other libraries.  The
+	   system may pick a different address than the hint, and that is
+	   fine as long as it is still in range */
+	for(above = 1; above >= 0; --above)
+	{
+		hint = above ? high : low;
+		for(probes = 0; probes < JIT_VMEM_NEAR_PROBES
+			&& (above ? hint > anchor : hint + size <= anchor); ++probes)
+		{
+#if defined(JIT_VMEM_WIN32)
+			addr = (jit_nuint) VirtualAlloc((void *) hint, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+			addr = (jit_nuint) mmap((void *) hint, size, PROT_NONE,
+						MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+#endif
+			if(addr != (jit_nuint) MAP_FAILED_NEAR)
+			{
+				if(addr >= low && addr <= high)
+				{
+					return (void *) addr;
+				}
+				jit_vmem_release((void *) addr, size);
+			}
+			if(above)
+			{
+				if(hint < low + step)
+				{
+					break;
+				}
+				hint -= step;
+			}
+			else
+			{
+				hint += step;
+			}
+		}
+	}
+	return (void *) 0;
+
+#else
+	return (void *) 0;
+#endif
+}
+
 void *
 jit_vmem_reserve_committed(jit_uint size, jit_prot_t prot)
 {
@@ -243,29 +367,220 @@ jit_vmem_decommit(void *addr, jit_uint size)
 #elif defined(JIT_VMEM_MMAP)
 # if defined(MADV_FREE)
 
-	int result = madvise(addr, size, MADV_FREE);
-	if(result < 0)
+	/* This fails for pages committed with jit_vmem_commit_huge,
+	   which are dropped by the mapping below all the same */
+	madvise(addr, size, MADV_FREE);
+
+# elif defined(MADV_DONTNEED) && defined(JIT_LINUX_PLATFORM)
+
+	madvise(addr, size, MADV_DONTNEED);
+
+# endif
+
+	addr = mmap(addr, size, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if(addr == MAP_FAILED)
 	{
 		return 0;
 	}
+	return 1;
 
-# elif defined(MADV_DONTNEED) && defined(JIT_LINUX_PLATFORM)
+#else
+	return 0;
+#endif
+}
+
+/*@
+ * @deftypefun jit_nuint jit_vmem_huge_page_size (void)
+ * Get the size of the huge pages that @code{jit_vmem_commit_huge} and
+ * @code{jit_vmem_advise_huge} use, or zero if the system does not
+ * support huge pages.
+ * @end deftypefun
+@*/
+jit_nuint
+jit_vmem_huge_page_size(void)
+{
+#if defined(JIT_VMEM_HUGE_PAGE_SIZE)
+	return JIT_VMEM_HUGE_PAGE_SIZE;
+#else
+	return 0;
+#endif
+}
+
+/*@
+ * @deftypefun int jit_vmem_commit_huge (void *@var{addr}, jit_uint @var{size}, jit_prot_t @var{prot})
+ * Commit reserved memory like @code{jit_vmem_commit}, but with explicit
+ * huge pages.  The address and size must be multiples of the huge page
+ * size.  This fails if the system has no huge pages set aside for
+ * @code{MAP_HUGETLB}, which is the default on most systems.
+ * @end deftypefun
+@*/
+int
+jit_vmem_commit_huge(void *addr, jit_uint size, jit_prot_t prot)
+{
+#if defined(JIT_VMEM_HUGE_PAGE_SIZE) && defined(MAP_HUGETLB)
+
+	void *raddr;
+
+	raddr = mmap(addr, size, convert_prot(prot),
+		     MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	return raddr == addr;
 
-	int result = madvise(addr, size, MADV_DONTNEED);
-	if(result < 0)
+#else
+	return 0;
+#endif
+}
+
+/*@
+ * @deftypefun int jit_vmem_advise_huge (void *@var{addr}, jit_uint @var{size})
+ * Ask the system to back committed memory with transparent huge pages.
+ * The address and size should be multiples of the huge page size.
+ * Returns zero if the system does not support transparent huge pages.
+ * Even if it does, it may still use small pages, for example when it
+ * is low on memory.
+ * @end deftypefun
+@*/
+int
+jit_vmem_advise_huge(void *addr, jit_uint size)
+{
+#if defined(JIT_VMEM_HUGE_PAGE_SIZE) && defined(MADV_HUGEPAGE)
+	return madvise(addr, size, MADV_HUGEPAGE) == 0;
+#else
+	return 0;
+#endif
+}
+
+/*@
+ * @deftypefun jit_nuint jit_vmem_count_huge (void *@var{addr}, jit_nuint @var{size})
+ * Get the number of transparent huge pages that currently back the
+ * memory between @var{addr} and @var{addr} + @var{size}, as reported by
+ * the system.  Pages committed with @code{jit_vmem_commit_huge} are not
+ * included.
+ * @end deftypefun
+@*/
+jit_nuint
+jit_vmem_count_huge(void *addr, jit_nuint size)
+{
+#if defined(JIT_VMEM_HUGE_PAGE_SIZE)
+
+	FILE *file;
+	char line[256];
+	unsigned long start;
+	unsigned long end;
+	unsigned long kbytes;
+	jit_nuint bytes;
+	int overlaps;
+
+	file = fopen("/proc/self/smaps", "r");
+	if(!file)
 	{
 		return 0;
 	}
+	bytes = 0;
+	overlaps = 0;
+	while(fgets(line, sizeof(line), file))
+	{
+		if(sscanf(line, "%lx-%lx ", &start, &end) == 2)
+		{
+			overlaps = (start < (jit_nuint) addr + size && end > (jit_nuint) addr);
+		}
+		else if(overlaps && sscanf(line, "AnonHugePages: %lu kB", &kbytes) == 1)
+		{
+			bytes += (jit_nuint) kbytes * 1024;
+		}
+	}
+	fclose(file);
+	return bytes / JIT_VMEM_HUGE_PAGE_SIZE;
 
-# endif
+#else
+	return 0;
+#endif
+}
 
-	addr = mmap(addr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
-	if(addr == MAP_FAILED)
+/*@
+ * @deftypefun int jit_vmem_shared_create (jit_nuint @var{size})
+ * Create an anonymous shared memory object of @var{size} bytes that
+ * @code{jit_vmem_commit_shared} can map at more than one address, and
+ * return its file descriptor.  Memory is only used for the parts that
+ * are mapped and touched.  Returns -1 if the system does not support
+ * anonymous shared memory objects (only Linux is supported so far).
+ * @end deftypefun
+@*/
+int
+jit_vmem_shared_create(jit_nuint size)
+{
+#if defined(JIT_VMEM_SHARED)
+
+	int fd;
+
+	fd = (int) syscall(SYS_memfd_create, "jit-code", 0);
+	if(fd < 0)
 	{
-		return 0;
+		return -1;
 	}
-	return 1;
+	if(ftruncate(fd, (off_t) size) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+
+#else
+	return -1;
+#endif
+}
+
+/*@
+ * @deftypefun void jit_vmem_shared_destroy (int @var{fd})
+ * Destroy a shared memory object created by @code{jit_vmem_shared_create}.
+ * Its memory is freed once it is no longer mapped anywhere.
+ * @end deftypefun
+@*/
+void
+jit_vmem_shared_destroy(int fd)
+{
+#if defined(JIT_VMEM_SHARED)
+	if(fd >= 0)
+	{
+		close(fd);
+	}
+#endif
+}
 
+/*@
+ * @deftypefun int jit_vmem_commit_shared (void *@var{addr}, jit_uint @var{size}, jit_prot_t @var{prot}, int @var{fd}, jit_nuint @var{offset})
+ * Commit reserved memory like @code{jit_vmem_commit}, but backed by the
+ * bytes of the shared memory object @var{fd} at @var{offset}.  The same
+ * bytes may be committed at several addresses with different protection,
+ * for example once writable and once executable.
+ * @end deftypefun
+@*/
+int
+jit_vmem_commit_shared(void *addr, jit_uint size, jit_prot_t prot, int fd, jit_nuint offset)
+{
+#if defined(JIT_VMEM_SHARED)
+
+	void *raddr;
+
+	raddr = mmap(addr, size, convert_prot(prot), MAP_FIXED | MAP_SHARED, fd, (off_t) offset);
+	return raddr == addr;
+
+#else
+	return 0;
+#endif
+}
+
+/*@
+ * @deftypefun int jit_vmem_discard_shared (void *@var{addr}, jit_uint @var{size})
+ * Free the bytes of a shared memory object that are committed between
+ * @var{addr} and @var{addr} + @var{size}, at every address they are
+ * committed at.  They read as zero afterwards.
+ * @end deftypefun
+@*/
+int
+jit_vmem_discard_shared(void *addr, jit_uint size)
+{
+#if defined(JIT_VMEM_SHARED) && defined(MADV_REMOVE)
+	return madvise(addr, size, MADV_REMOVE) == 0;
 #else
 	return 0;
 #endif
@@ -0,0 +1,53 @@
+package ccall
+
+/*
+#cgo CFLAGS: -I../
+#cgo CFLAGS: -Iinclude
+
+#include <jit/jit.h>
+*/
+import "C"
+import (
+	"errors"
+
+	"github.com/goccy/go-jit/internal/leafcall"
+)
+
+var (
+	ErrLeafUnsupported   = errors.New("leaf call: not supported on this platform")
+	ErrLeafNotCompiled   = errors.New("leaf call: function is not compiled")
+	ErrLeafRecompilable  = errors.New("leaf call: function is recompilable")
+	ErrLeafEvictable     = errors.New("leaf call: function is evictable")
+	ErrLeafNotLeaf       = errors.New("leaf call: function may call out or throw")
+	ErrLeafFrameTooLarge = errors.New("leaf call: function frame is too large")
+)
+
+func (f *Function) LeafStackSize() uint {
+	return uint(C.jit_function_get_leaf_stack_size(f.c))
+}
+
+// LeafEntry returns the native entry point of f if it is a verified leaf
+// function that the leafcall trampolines can enter directly on the goroutine
+// stack, without a cgo transition.
+func (f *Function) LeafEntry() (uintptr, error) {
+	if !leafcall.Supported {
+		return 0, ErrLeafUnsupported
+	}
+	if !f.IsCompiled() {
+		return 0, ErrLeafNotCompiled
+	}
+	if f.IsRecompilable() {
+		return 0, ErrLeafRecompilable
+	}
+	if f.IsEvictable() {
+		return 0, ErrLeafEvictable
+	}
+	size := f.LeafStackSize()
+	if size == 0 {
+		return 0, ErrLeafNotLeaf
+	}
+	if size > leafcall.StackLimit {
+		return 0, ErrLeafFrameTooLarge
+	}
+	return uintptr(C.jit_function_to_closure(f.c)), nil
+}
@@ -0,0 +1,71 @@
+#include "jit-internal.h"
+#include "_cgo_export.h"
+
+/*
+ * Tiered compilation from Go.
+ *
+ * The first tier of a function is compiled without optimization and
+ * starts with a call counter:
+ *
+ *	if(++counter == threshold)
+ *		tier_request(func);
+ *
+ * The request is handed to Go, which rebuilds the body and compiles it
+ * again with full optimization on a background worker.  The function is
+ * recompilable, so callers reach it through its indirector, which jumps
+ * through "func->entry_point": storing the new entry point redirects
+ * every caller at once, while calls already running in the first tier
+ * finish there.
+ *
+ * The counter is updated without atomics.  Racing threads can lose
+ * increments and report the threshold more than once, but never skip it,
+ * so Go ignores the repeated requests.  The counter stays in the metadata
+ * of the function for as long as the first tier code may still run.
+ */
+
+static void tier_request(jit_nuint func)
+{
+	goTierUp(func);
+}
+
+int tier_start(jit_nuint handle, jit_nuint threshold)
+{
+	jit_function_t func = (jit_function_t)handle;
+	jit_nuint *counter;
+	jit_type_t signature;
+	jit_type_t param_type = jit_type_nuint;
+	jit_value_t addr, count, arg;
+	jit_label_t label = jit_label_undefined;
+
+	counter = jit_cnew(jit_nuint);
+	if(!counter)
+	{
+		return 0;
+	}
+	if(!jit_function_set_meta(func, JIT_META_TIER_COUNTER, counter, jit_free, 0))
+	{
+		jit_free(counter);
+		return 0;
+	}
+	signature = jit_type_create_signature
+		(jit_abi_cdecl, jit_type_void, &param_type, 1, 1);
+	if(!signature)
+	{
+		return 0;
+	}
+
+	jit_function_set_recompilable(func);
+	jit_function_set_optimization_level(func, JIT_OPTLEVEL_NONE);
+
+	addr = jit_value_create_nint_constant(func, jit_type_void_ptr, (jit_nint)counter);
+	count = jit_insn_load_relative(func, addr, 0, jit_type_nuint);
+	count = jit_insn_add(func, count, jit_value_create_nint_constant(func, jit_type_nuint, 1));
+	jit_insn_store_relative(func, addr, 0, count);
+	jit_insn_branch_if_not(func, jit_insn_eq
+		(func, count, jit_value_create_nint_constant(func, jit_type_nuint, (jit_nint)threshold)), &label);
+	arg = jit_value_create_nint_constant(func, jit_type_nuint, (jit_nint)handle);
+	jit_insn_call_native(func, "tier_request", (void *)tier_request,
+			     signature, &arg, 1, JIT_CALL_NOTHROW);
+	jit_type_free(signature);
+	return jit_insn_label(func, &label);
+}
@@ -0,0 +1,121 @@
+package ccall
+
+/*
+#cgo CFLAGS: -I../
+#cgo CFLAGS: -Iinclude
+
+#include <jit/jit.h>
+
+extern int tier_start(jit_nuint, jit_nuint);
+*/
+import "C"
+import (
+	"runtime"
+	"sync"
+)
+
+const defaultTierUpThreshold = 1000
+
+// tierUpPriority queues promotions ahead of ordinary background compiles.
+const tierUpPriority = 1 << 30
+
+type tierFunction struct {
+	f     *Function
+	ctx   C.jit_context_t
+	build func(*Function) error
+}
+
+var (
+	tiersMu  sync.Mutex
+	tiersMap = map[C.jit_nuint]*tierFunction{}
+)
+
+// SetTierUpThreshold sets the number of calls after which a function
+// compiled with CompileTiered is promoted to optimized code.
+func (c *Context) SetTierUpThreshold(calls uint) {
+	if calls < 1 {
+		calls = 1
+	}
+	q := contextCompiler(c.c)
+	q.mu.Lock()
+	q.tierUpThreshold = calls
+	q.mu.Unlock()
+}
+
+// CompileTiered builds f with build and compiles it quickly, without
+// optimization.  Once f has been called as many times as the tier-up
+// threshold of its context, build is run again on a background worker and
+// f is recompiled with full optimization.  Callers are switched over to
+// the new code when it is ready, and f is no longer recompilable after
+// that.
+func (f *Function) CompileTiered(build func(*Function) error) error {
+	ctx := C.jit_function_get_context(f.c)
+	q := contextCompiler(ctx)
+	q.mu.Lock()
+	threshold := q.tierUpThreshold
+	q.mu.Unlock()
+
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	f.BuildStart()
+	defer f.BuildEnd()
+	if C.tier_start(f.handle(), C.jit_nuint(threshold)) == 0 {
+		return ErrCompileFailed
+	}
+	if err := build(f); err != nil {
+		return err
+	}
+	tiersMu.Lock()
+	tiersMap[f.handle()] = &tierFunction{f: f, ctx: ctx, build: build}
+	tiersMu.Unlock()
+	if !f.Compile() {
+		releaseTier(f.handle())
+		return ErrCompileFailed
+	}
+	return nil
+}
+
+// promote rebuilds f with full optimization.  If build fails, the first
+// tier code is kept.
+func (f *Function) promote(build func(*Function) error) error {
+	f.BuildStart()
+	defer f.BuildEnd()
+	f.SetOptimizationLevel(MaxOptimizationLevel())
+	if err := build(f); err != nil {
+		f.Abandon()
+		return err
+	}
+	if !f.Compile() {
+		f.Abandon()
+		return ErrCompileFailed
+	}
+	f.ClearRecompilable()
+	return nil
+}
+
+//export goTierUp
+func goTierUp(handle C.jit_nuint) {
+	t := releaseTier(handle)
+	if t == nil {
+		return
+	}
+	contextCompiler(t.ctx).push(t.f, tierUpPriority, t.build)
+}
+
+func releaseTier(handle C.jit_nuint) *tierFunction {
+	tiersMu.Lock()
+	defer tiersMu.Unlock()
+	t := tiersMap[handle]
+	delete(tiersMap, handle)
+	return t
+}
+
+func releaseTiers(ctx C.jit_context_t) {
+	tiersMu.Lock()
+	defer tiersMu.Unlock()
+	for handle, t := range tiersMap {
+		if t.ctx == ctx {
+			delete(tiersMap, handle)
+		}
+	}
+}
@@ -52,6 +52,7 @@ var (
 	JIT_TYPE_UNION         = C.JIT_TYPE_UNION
 	JIT_TYPE_SIGNATURE     = C.JIT_TYPE_SIGNATURE
 	JIT_TYPE_PTR           = C.JIT_TYPE_PTR
+	JIT_TYPE_VECTOR        = C.JIT_TYPE_VECTOR
 	JIT_TYPE_FIRST_TAGGED  = C.JIT_TYPE_FIRST_TAGGED
 )
 
@@ -94,6 +95,10 @@ var (
 	TypeVoid        = &Type{C.jit_type_void}
 	TypeFloat32     = &Type{C.jit_type_float32}
 	TypeFloat64     = &Type{C.jit_type_float64}
+	TypeV4I32       = &Type{C.jit_type_v4i32}
+	TypeV2I64       = &Type{C.jit_type_v2i64}
+	TypeV4F32       = &Type{C.jit_type_v4f32}
+	TypeV2F64       = &Type{C.jit_type_v2f64}
 )
 
 func toType(c C.jit_type_t) *Type {
@@ -240,6 +245,14 @@ func (t *Type) IsTagged() bool {
 	return int(C.jit_type_is_tagged(t.c)) == 1
 }
 
+func (t *Type) IsVector() bool {
+	return int(C.jit_type_is_vector(t.c)) == 1
+}
+
+func (t *Type) LaneType() *Type {
+	return toType(C.jit_type_get_lane_type(t.c))
+}
+
 func (t *Type) RemoveTags() *Type {
 	return toType(C.jit_type_remove_tags(t.c))
 }
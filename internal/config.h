@@ -181,6 +181,9 @@
 /* Define to 1 if you have the `m' library (-lm). */
 #define HAVE_LIBM 1
 
+/* Define to 1 if you have the `pthread' library (-lpthread). */
+#define HAVE_LIBPTHREAD 1
+
 /* Define to 1 if you have the `log' function. */
 #define HAVE_LOG 1
 
@@ -241,6 +244,9 @@
 /* Define to 1 if you have the `powl' function. */
 #define HAVE_POWL 1
 
+/* Define to 1 if you have the <pthread.h> header file. */
+#define HAVE_PTHREAD_H 1
+
 /* Define to 1 if you have the `remainder' function. */
 #define HAVE_REMAINDER 1
 
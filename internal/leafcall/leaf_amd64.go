@@ -0,0 +1,17 @@
+package leafcall
+
+import "unsafe"
+
+const Supported = true
+
+// The Call* trampolines call entry with the C calling convention on the
+// current goroutine stack.  Only entry points of verified leaf functions may be
+// passed to them.
+
+func CallInt64(entry uintptr, a1, a2, a3, a4 int64) int64
+
+func CallFloat32(entry uintptr, a1, a2, a3, a4 float32) float32
+
+func CallFloat64(entry uintptr, a1, a2, a3, a4 float64) float64
+
+func CallPointer(entry uintptr, a1, a2, a3, a4 unsafe.Pointer) unsafe.Pointer
@@ -0,0 +1,65 @@
+#include "textflag.h"
+#include "funcdata.h"
+
+// Each trampoline reserves LEAF_STACK bytes of goroutine stack as its own
+// frame, so the regular stack check in the Go prologue guarantees the space.
+// The stack pointer is moved to the 16-byte aligned top of that frame and the
+// entry point is called with the System V calling convention.  BX is
+// callee-saved in that convention and keeps the Go stack pointer.
+// LEAF_STACK must match StackLimit.
+#define LEAF_STACK 2048
+
+#define LEAF_CALL		\
+	MOVQ	SP, BX;		\
+	ADDQ	$LEAF_STACK, SP;	\
+	ANDQ	$~15, SP;	\
+	CALL	AX;		\
+	MOVQ	BX, SP
+
+// func CallInt64(entry uintptr, a1, a2, a3, a4 int64) int64
+TEXT ·CallInt64(SB), 0, $2048-48
+	NO_LOCAL_POINTERS
+	MOVQ	entry+0(FP), AX
+	MOVQ	a1+8(FP), DI
+	MOVQ	a2+16(FP), SI
+	MOVQ	a3+24(FP), DX
+	MOVQ	a4+32(FP), CX
+	LEAF_CALL
+	MOVQ	AX, ret+40(FP)
+	RET
+
+// func CallFloat32(entry uintptr, a1, a2, a3, a4 float32) float32
+TEXT ·CallFloat32(SB), 0, $2048-28
+	NO_LOCAL_POINTERS
+	MOVQ	entry+0(FP), AX
+	MOVSS	a1+8(FP), X0
+	MOVSS	a2+12(FP), X1
+	MOVSS	a3+16(FP), X2
+	MOVSS	a4+20(FP), X3
+	LEAF_CALL
+	MOVSS	X0, ret+24(FP)
+	RET
+
+// func CallFloat64(entry uintptr, a1, a2, a3, a4 float64) float64
+TEXT ·CallFloat64(SB), 0, $2048-48
+	NO_LOCAL_POINTERS
+	MOVQ	entry+0(FP), AX
+	MOVSD	a1+8(FP), X0
+	MOVSD	a2+16(FP), X1
+	MOVSD	a3+24(FP), X2
+	MOVSD	a4+32(FP), X3
+	LEAF_CALL
+	MOVSD	X0, ret+40(FP)
+	RET
+
+// func CallPointer(entry uintptr, a1, a2, a3, a4 unsafe.Pointer) unsafe.Pointer
+TEXT ·CallPointer(SB), 0, $2048-48
+	NO_LOCAL_POINTERS
+	MOVQ	entry+0(FP), AX
+	MOVQ	a1+8(FP), DI
+	MOVQ	a2+16(FP), SI
+	MOVQ	a3+24(FP), DX
+	MOVQ	a4+32(FP), CX
+	LEAF_CALL
+	MOVQ	AX, ret+40(FP)
+	RET
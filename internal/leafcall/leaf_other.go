@@ -0,0 +1,24 @@
+//go:build !amd64
+// +build !amd64
+
+package leafcall
+
+import "unsafe"
+
+const Supported = false
+
+func CallInt64(entry uintptr, a1, a2, a3, a4 int64) int64 {
+	panic("leafcall: not supported on this platform")
+}
+
+func CallFloat32(entry uintptr, a1, a2, a3, a4 float32) float32 {
+	panic("leafcall: not supported on this platform")
+}
+
+func CallFloat64(entry uintptr, a1, a2, a3, a4 float64) float64 {
+	panic("leafcall: not supported on this platform")
+}
+
+func CallPointer(entry uintptr, a1, a2, a3, a4 unsafe.Pointer) unsafe.Pointer {
+	panic("leafcall: not supported on this platform")
+}
@@ -0,0 +1,7 @@
+// Package leafcall calls native leaf functions directly on the goroutine
+// stack, without a cgo transition.
+package leafcall
+
+// StackLimit is the stack space that the trampolines reserve on the
+// goroutine stack for the called function.
+const StackLimit = 2048
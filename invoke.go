@@ -0,0 +1,119 @@
+package jit
+
+import (
+	"fmt"
+	"unsafe"
+
+	"github.com/goccy/go-jit/internal/ccall"
+)
+
+// The As* helpers convert a function into a typed Go function value.
+// The returned function passes its arguments straight to the native entry
+// point, so calling it does not allocate.
+// They panic if the signature of f does not match the requested Go type.
+
+func (f *Function) mustInvokeSignature(kind int, numParams uint, name string) {
+	if !f.Function.IsInvokeSignature(kind, numParams) {
+		panic(fmt.Sprintf("jit: %s: function signature does not match", name))
+	}
+}
+
+func AsInt64x0(f *Function) func() int64 {
+	f.mustInvokeSignature(ccall.InvokeInt64, 0, "AsInt64x0")
+	return f.Function.InvokeInt64x0
+}
+
+func AsInt64x1(f *Function) func(int64) int64 {
+	f.mustInvokeSignature(ccall.InvokeInt64, 1, "AsInt64x1")
+	return f.Function.InvokeInt64x1
+}
+
+func AsInt64x2(f *Function) func(int64, int64) int64 {
+	f.mustInvokeSignature(ccall.InvokeInt64, 2, "AsInt64x2")
+	return f.Function.InvokeInt64x2
+}
+
+func AsInt64x3(f *Function) func(int64, int64, int64) int64 {
+	f.mustInvokeSignature(ccall.InvokeInt64, 3, "AsInt64x3")
+	return f.Function.InvokeInt64x3
+}
+
+func AsInt64x4(f *Function) func(int64, int64, int64, int64) int64 {
+	f.mustInvokeSignature(ccall.InvokeInt64, 4, "AsInt64x4")
+	return f.Function.InvokeInt64x4
+}
+
+func AsFloat32x0(f *Function) func() float32 {
+	f.mustInvokeSignature(ccall.InvokeFloat32, 0, "AsFloat32x0")
+	return f.Function.InvokeFloat32x0
+}
+
+func AsFloat32x1(f *Function) func(float32) float32 {
+	f.mustInvokeSignature(ccall.InvokeFloat32, 1, "AsFloat32x1")
+	return f.Function.InvokeFloat32x1
+}
+
+func AsFloat32x2(f *Function) func(float32, float32) float32 {
+	f.mustInvokeSignature(ccall.InvokeFloat32, 2, "AsFloat32x2")
+	return f.Function.InvokeFloat32x2
+}
+
+func AsFloat32x3(f *Function) func(float32, float32, float32) float32 {
+	f.mustInvokeSignature(ccall.InvokeFloat32, 3, "AsFloat32x3")
+	return f.Function.InvokeFloat32x3
+}
+
+func AsFloat32x4(f *Function) func(float32, float32, float32, float32) float32 {
+	f.mustInvokeSignature(ccall.InvokeFloat32, 4, "AsFloat32x4")
+	return f.Function.InvokeFloat32x4
+}
+
+func AsFloat64x0(f *Function) func() float64 {
+	f.mustInvokeSignature(ccall.InvokeFloat64, 0, "AsFloat64x0")
+	return f.Function.InvokeFloat64x0
+}
+
+func AsFloat64x1(f *Function) func(float64) float64 {
+	f.mustInvokeSignature(ccall.InvokeFloat64, 1, "AsFloat64x1")
+	return f.Function.InvokeFloat64x1
+}
+
+func AsFloat64x2(f *Function) func(float64, float64) float64 {
+	f.mustInvokeSignature(ccall.InvokeFloat64, 2, "AsFloat64x2")
+	return f.Function.InvokeFloat64x2
+}
+
+func AsFloat64x3(f *Function) func(float64, float64, float64) float64 {
+	f.mustInvokeSignature(ccall.InvokeFloat64, 3, "AsFloat64x3")
+	return f.Function.InvokeFloat64x3
+}
+
+func AsFloat64x4(f *Function) func(float64, float64, float64, float64) float64 {
+	f.mustInvokeSignature(ccall.InvokeFloat64, 4, "AsFloat64x4")
+	return f.Function.InvokeFloat64x4
+}
+
+func AsPointerx0(f *Function) func() unsafe.Pointer {
+	f.mustInvokeSignature(ccall.InvokePointer, 0, "AsPointerx0")
+	return f.Function.InvokePointerx0
+}
+
+func AsPointerx1(f *Function) func(unsafe.Pointer) unsafe.Pointer {
+	f.mustInvokeSignature(ccall.InvokePointer, 1, "AsPointerx1")
+	return f.Function.InvokePointerx1
+}
+
+func AsPointerx2(f *Function) func(unsafe.Pointer, unsafe.Pointer) unsafe.Pointer {
+	f.mustInvokeSignature(ccall.InvokePointer, 2, "AsPointerx2")
+	return f.Function.InvokePointerx2
+}
+
+func AsPointerx3(f *Function) func(unsafe.Pointer, unsafe.Pointer, unsafe.Pointer) unsafe.Pointer {
+	f.mustInvokeSignature(ccall.InvokePointer, 3, "AsPointerx3")
+	return f.Function.InvokePointerx3
+}
+
+func AsPointerx4(f *Function) func(unsafe.Pointer, unsafe.Pointer, unsafe.Pointer, unsafe.Pointer) unsafe.Pointer {
+	f.mustInvokeSignature(ccall.InvokePointer, 4, "AsPointerx4")
+	return f.Function.InvokePointerx4
+}
@@ -5,5 +5,14 @@ import (
 )
 
 var (
-	TypeInt = &Type{ccall.TypeGoInt}
+	TypeInt     = &Type{ccall.TypeGoInt}
+	TypeFloat32 = &Type{ccall.TypeFloat32}
+	TypeFloat64 = &Type{ccall.TypeFloat64}
+	TypeVoidPtr = &Type{ccall.TypeVoidPtr}
+
+	// 128-bit vector types for the V* instructions.
+	TypeV4I32 = &Type{ccall.TypeV4I32}
+	TypeV2I64 = &Type{ccall.TypeV2I64}
+	TypeV4F32 = &Type{ccall.TypeV4F32}
+	TypeV2F64 = &Type{ccall.TypeV2F64}
 )
@@ -0,0 +1,239 @@
+package jit
+
+import (
+	"errors"
+	"unsafe"
+
+	"github.com/goccy/go-jit/internal/ccall"
+	"github.com/goccy/go-jit/internal/leafcall"
+)
+
+// The AsLeaf* helpers are like the As* helpers, but the returned function
+// enters the native code directly on the goroutine stack instead of going
+// through cgo.  This is only allowed for compiled, non-recompilable leaf
+// functions: code that never calls out, cannot throw an exception, and whose
+// frame fits into LeafStackLimit bytes.  This is verified when the
+// function is compiled, and an error is returned for any other function.
+//
+// Leaf code runs without exception blocking and cannot be preempted by the
+// Go scheduler, so it is meant for short kernels.
+
+// LeafStackLimit is the largest stack usage accepted for leaf functions.
+const LeafStackLimit = leafcall.StackLimit
+
+var (
+	ErrLeafSignature     = errors.New("leaf call: function signature does not match")
+	ErrLeafUnsupported   = ccall.ErrLeafUnsupported
+	ErrLeafNotCompiled   = ccall.ErrLeafNotCompiled
+	ErrLeafRecompilable  = ccall.ErrLeafRecompilable
+	ErrLeafEvictable     = ccall.ErrLeafEvictable
+	ErrLeafNotLeaf       = ccall.ErrLeafNotLeaf
+	ErrLeafFrameTooLarge = ccall.ErrLeafFrameTooLarge
+)
+
+func (f *Function) leafEntry(kind int, numParams uint) (uintptr, error) {
+	if !f.Function.IsInvokeSignature(kind, numParams) {
+		return 0, ErrLeafSignature
+	}
+	return f.Function.LeafEntry()
+}
+
+func AsLeafInt64x0(f *Function) (func() int64, error) {
+	entry, err := f.leafEntry(ccall.InvokeInt64, 0)
+	if err != nil {
+		return nil, err
+	}
+	return func() int64 {
+		return leafcall.CallInt64(entry, 0, 0, 0, 0)
+	}, nil
+}
+
+func AsLeafInt64x1(f *Function) (func(int64) int64, error) {
+	entry, err := f.leafEntry(ccall.InvokeInt64, 1)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1 int64) int64 {
+		return leafcall.CallInt64(entry, a1, 0, 0, 0)
+	}, nil
+}
+
+func AsLeafInt64x2(f *Function) (func(int64, int64) int64, error) {
+	entry, err := f.leafEntry(ccall.InvokeInt64, 2)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2 int64) int64 {
+		return leafcall.CallInt64(entry, a1, a2, 0, 0)
+	}, nil
+}
+
+func AsLeafInt64x3(f *Function) (func(int64, int64, int64) int64, error) {
+	entry, err := f.leafEntry(ccall.InvokeInt64, 3)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2, a3 int64) int64 {
+		return leafcall.CallInt64(entry, a1, a2, a3, 0)
+	}, nil
+}
+
+func AsLeafInt64x4(f *Function) (func(int64, int64, int64, int64) int64, error) {
+	entry, err := f.leafEntry(ccall.InvokeInt64, 4)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2, a3, a4 int64) int64 {
+		return leafcall.CallInt64(entry, a1, a2, a3, a4)
+	}, nil
+}
+
+func AsLeafFloat32x0(f *Function) (func() float32, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat32, 0)
+	if err != nil {
+		return nil, err
+	}
+	return func() float32 {
+		return leafcall.CallFloat32(entry, 0, 0, 0, 0)
+	}, nil
+}
+
+func AsLeafFloat32x1(f *Function) (func(float32) float32, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat32, 1)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1 float32) float32 {
+		return leafcall.CallFloat32(entry, a1, 0, 0, 0)
+	}, nil
+}
+
+func AsLeafFloat32x2(f *Function) (func(float32, float32) float32, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat32, 2)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2 float32) float32 {
+		return leafcall.CallFloat32(entry, a1, a2, 0, 0)
+	}, nil
+}
+
+func AsLeafFloat32x3(f *Function) (func(float32, float32, float32) float32, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat32, 3)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2, a3 float32) float32 {
+		return leafcall.CallFloat32(entry, a1, a2, a3, 0)
+	}, nil
+}
+
+func AsLeafFloat32x4(f *Function) (func(float32, float32, float32, float32) float32, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat32, 4)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2, a3, a4 float32) float32 {
+		return leafcall.CallFloat32(entry, a1, a2, a3, a4)
+	}, nil
+}
+
+func AsLeafFloat64x0(f *Function) (func() float64, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat64, 0)
+	if err != nil {
+		return nil, err
+	}
+	return func() float64 {
+		return leafcall.CallFloat64(entry, 0, 0, 0, 0)
+	}, nil
+}
+
+func AsLeafFloat64x1(f *Function) (func(float64) float64, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat64, 1)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1 float64) float64 {
+		return leafcall.CallFloat64(entry, a1, 0, 0, 0)
+	}, nil
+}
+
+func AsLeafFloat64x2(f *Function) (func(float64, float64) float64, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat64, 2)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2 float64) float64 {
+		return leafcall.CallFloat64(entry, a1, a2, 0, 0)
+	}, nil
+}
+
+func AsLeafFloat64x3(f *Function) (func(float64, float64, float64) float64, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat64, 3)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2, a3 float64) float64 {
+		return leafcall.CallFloat64(entry, a1, a2, a3, 0)
+	}, nil
+}
+
+func AsLeafFloat64x4(f *Function) (func(float64, float64, float64, float64) float64, error) {
+	entry, err := f.leafEntry(ccall.InvokeFloat64, 4)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2, a3, a4 float64) float64 {
+		return leafcall.CallFloat64(entry, a1, a2, a3, a4)
+	}, nil
+}
+
+func AsLeafPointerx0(f *Function) (func() unsafe.Pointer, error) {
+	entry, err := f.leafEntry(ccall.InvokePointer, 0)
+	if err != nil {
+		return nil, err
+	}
+	return func() unsafe.Pointer {
+		return leafcall.CallPointer(entry, nil, nil, nil, nil)
+	}, nil
+}
+
+func AsLeafPointerx1(f *Function) (func(unsafe.Pointer) unsafe.Pointer, error) {
+	entry, err := f.leafEntry(ccall.InvokePointer, 1)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1 unsafe.Pointer) unsafe.Pointer {
+		return leafcall.CallPointer(entry, a1, nil, nil, nil)
+	}, nil
+}
+
+func AsLeafPointerx2(f *Function) (func(unsafe.Pointer, unsafe.Pointer) unsafe.Pointer, error) {
+	entry, err := f.leafEntry(ccall.InvokePointer, 2)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2 unsafe.Pointer) unsafe.Pointer {
+		return leafcall.CallPointer(entry, a1, a2, nil, nil)
+	}, nil
+}
+
+func AsLeafPointerx3(f *Function) (func(unsafe.Pointer, unsafe.Pointer, unsafe.Pointer) unsafe.Pointer, error) {
+	entry, err := f.leafEntry(ccall.InvokePointer, 3)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2, a3 unsafe.Pointer) unsafe.Pointer {
+		return leafcall.CallPointer(entry, a1, a2, a3, nil)
+	}, nil
+}
+
+func AsLeafPointerx4(f *Function) (func(unsafe.Pointer, unsafe.Pointer, unsafe.Pointer, unsafe.Pointer) unsafe.Pointer, error) {
+	entry, err := f.leafEntry(ccall.InvokePointer, 4)
+	if err != nil {
+		return nil, err
+	}
+	return func(a1, a2, a3, a4 unsafe.Pointer) unsafe.Pointer {
+		return leafcall.CallPointer(entry, a1, a2, a3, a4)
+	}, nil
+}
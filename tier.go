@@ -0,0 +1,20 @@
+package jit
+
+import (
+	"github.com/goccy/go-jit/internal/ccall"
+)
+
+// CompileTiered builds f with build and compiles it without optimization,
+// which is cheap and good enough for functions that are rarely called.
+// Once f has been called as often as the tier-up threshold of its context
+// (see SetTierUpThreshold), build is run again on a background compiler
+// thread and f is recompiled with full optimization.  Callers switch to
+// the optimized code as soon as it is ready.
+//
+// build is called with the build lock of f held, so it must not lock f
+// itself.
+func (f *Function) CompileTiered(build func(*Function) error) error {
+	return f.Function.CompileTiered(func(*ccall.Function) error {
+		return build(f)
+	})
+}
@@ -149,6 +149,14 @@ func (t *Type) IsTagged() bool {
 	return t.Type.IsTagged()
 }
 
+func (t *Type) IsVector() bool {
+	return t.Type.IsVector()
+}
+
+func (t *Type) LaneType() *Type {
+	return toType(t.Type.LaneType())
+}
+
 func (t *Type) RemoveTags() *Type {
 	return toType(t.Type.RemoveTags())
 }